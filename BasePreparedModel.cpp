@@ -19,8 +19,18 @@
 #include <android/log.h>
 #include <cutils/properties.h>
 #include <log/log.h>
+#include <unistd.h>
+#include <algorithm>
+#include <future>
+#include <stdexcept>
 #include <thread>
+#include "BlobAllocator.h"
+#include "CpuTopology.h"
 #include "ExecutionBurstServer.h"
+#include "NetworkCache.h"
+#include "RequestCapture.h"
+#include "ResidencyManager.h"
+#include "Tracer.h"
 #include "Utils.h"
 #include "ValidateHal.h"
 
@@ -36,10 +46,51 @@ namespace nnhal {
 using namespace android::nn;
 
 static const Timing kNoTiming = {.timeOnDevice = UINT64_MAX, .timeInDriver = UINT64_MAX};
+// Opt-in: keep LSTM/RNN state resident in the plugin instead of the request buffers
+static const char* kStatefulModeProperty = "vendor.nn.hal.stateful";
+// Number of input shape specializations kept compiled for models with unspecified input dims
+static const char* kShapeCacheSizeProperty = "vendor.nn.hal.shape_cache_size";
+static const int32_t kDefaultShapeCacheSize = 4;
+// Opt-in batching of concurrent executions: largest batch stacked into one inference, and how
+// long the oldest pending execution waits for others to join it
+static const char* kBatchSizeProperty = "vendor.nn.hal.batch.max_size";
+static const char* kBatchWindowProperty = "vendor.nn.hal.batch.window_us";
+static const int32_t kDefaultBatchWindowUs = 2000;
+// NNAPI bounds on how long the WHILE loops of an execution may run
+static constexpr std::chrono::nanoseconds kDefaultLoopTimeout = std::chrono::seconds(2);
+static constexpr std::chrono::nanoseconds kMaxLoopTimeout = std::chrono::seconds(15);
+// Opt-in: collect plugin performance counters and aggregate them per NNAPI operation
+static const char* kProfilingProperty = "vendor.nn.hal.profiling";
+// Opt-in capture of the model and its requests for offline replay: every how manyth execution is
+// captured, and how many executions at most
+static const char* kCaptureProperty = "vendor.nn.hal.capture";
+static const char* kCaptureIntervalProperty = "vendor.nn.hal.capture.interval";
+static const char* kCaptureMaxRequestsProperty = "vendor.nn.hal.capture.max_requests";
+static const int32_t kDefaultCaptureMaxRequests = 1000;
+// Where captures and the networks of evicted models are written
+#if __ANDROID__
+static const char* kDataDirectory = "/data/vendor/neuralnetworks";
+#else
+static const char* kDataDirectory = "/tmp";
+#endif
+
+BasePreparedModel::~BasePreparedModel() {
+    if (mResidencyManaged) ResidencyManager::get().remove(this);
+    if (!mEvictedPath.empty()) unlink(mEvictedPath.c_str());
+    // Pending batched executions still use the model, drain them first
+    mBatchScheduler.reset();
+    deinitialize();
+}
 
 void BasePreparedModel::deinitialize() {
     ALOGV("Entering %s", __func__);
     mModelInfo->unmapRuntimeMemPools();
+    if (mShapeCache) {
+        std::lock_guard<std::mutex> lock(mShapeCacheMutex);
+        mShapeCache->forEach([](const std::vector<uint32_t>&, const CompiledNetwork& network) {
+            network.modelInfo->unmapRuntimeMemPools();
+        });
+    }
 
     ALOGV("Exiting %s", __func__);
 }
@@ -53,9 +104,393 @@ T getScalarData(const RunTimeOperandInfo& info) {
 
 bool BasePreparedModel::initialize() {
     ALOGV("Entering %s", __func__);
+    if (!mModelInfo->initRuntimeInfo()) {
+        ALOGE("Failed to initialize Model runtime parameters!!");
+        return false;
+    }
+    mStatefulMode = property_get_bool(kStatefulModeProperty, false);
+    mHasLoops = mModelInfo->hasLoops();
+    if (property_get_bool(kProfilingProperty, false)) {
+        std::vector<OperationType> operationTypes;
+        for (size_t i = 0; i < mModelInfo->getOperationsSize(); i++)
+            operationTypes.push_back(mModelInfo->getOperationType(i));
+        mProfiler = std::make_unique<OperationProfiler>(std::move(operationTypes));
+    }
+    if (property_get_bool(kCaptureProperty, false)) startCapture();
+
+    mDynamicInputs = mModelInfo->hasUnspecifiedInputDims();
+    if (mDynamicInputs) {
+        // Operations derive shapes of their constants from operand dimensions while the graph is
+        // created, so compilation waits for the dimensions carried by the requests
+        auto cacheSize = property_get_int32(kShapeCacheSizeProperty, kDefaultShapeCacheSize);
+        mShapeCache = std::make_unique<LruCache<std::vector<uint32_t>, CompiledNetwork>>(
+            std::max(cacheSize, 1));
+        ALOGI("%s Unspecified input dimensions, compiling per request shape", __func__);
+        return true;
+    }
+
+    CompiledNetwork network = {mModelInfo, nullptr, nullptr};
+    if (!compileNetwork(network)) return false;
+    mBindings = network.bindings;
+    mPlugin = network.plugin;
+
+    auto maxBatchSize = property_get_int32(kBatchSizeProperty, 0);
+    // Batched executions bypass the per request paths requests are captured from
+    if (maxBatchSize > 1 && !mStatefulMode && !mHasLoops && !mCapture) {
+        // Every input and output needs a leading batch dimension to stack executions along
+        auto hasBatchDimension = [this](uint32_t operandIndex) {
+            const auto& operand = mModelInfo->getOperand(operandIndex);
+            return operand.dimensions.size() > 0 &&
+                   !android::nn::tensorHasUnspecifiedDimensions(operand);
+        };
+        const auto& inputIndexes = mModelInfo->getModelInputIndexes();
+        bool batchable = std::all_of(inputIndexes.begin(), inputIndexes.end(), hasBatchDimension);
+        for (size_t i = 0; i < mModelInfo->getModelOutputsSize(); i++)
+            batchable = batchable && hasBatchDimension(mModelInfo->getModelOutputIndex(i));
+
+        if (batchable) {
+            auto window = std::chrono::microseconds(
+                property_get_int32(kBatchWindowProperty, kDefaultBatchWindowUs));
+            mBatchScheduler = std::make_unique<BatchScheduler>(
+                maxBatchSize, window, [this](std::vector<BatchJob>& jobs) { executeBatch(jobs); },
+                mPreference);
+        } else {
+            ALOGI("%s Model inputs and outputs have no batch dimension, batching disabled",
+                  __func__);
+        }
+    }
+
+    // The plugin holds its own copy of the constants, only models compiled again later for other
+    // shapes still read them
+    if (!mBatchScheduler) {
+        const size_t constantBytes = mModelInfo->getConstantBytes();
+        mModelInfo->releaseConstants();
+        // Recurrent state lives in the infer request, which an eviction would lose
+        auto& residency = ResidencyManager::get();
+        if (residency.isEnabled() && !mStatefulMode) {
+            mLastUse = std::chrono::steady_clock::now().time_since_epoch().count();
+            mResidencyManaged = true;
+            residency.add(this, mBindings.get(), constantBytes);
+        }
+    }
+
+    ALOGV("Exiting %s", __func__);
     return true;
 }
 
+// Precision the plugin consumes and produces a tensor of an NNAPI operand type in, so that
+// request memory is used as is
+static InferenceEngine::Precision nativePrecision(OperandType operandType) {
+    switch (operandType) {
+        case OperandType::TENSOR_FLOAT16:
+            return InferenceEngine::Precision::FP16;
+        case OperandType::TENSOR_INT32:
+            return InferenceEngine::Precision::I32;
+        // One byte per element either way
+        case OperandType::TENSOR_BOOL8:
+        case OperandType::TENSOR_QUANT8_ASYMM:
+            return InferenceEngine::Precision::U8;
+        case OperandType::TENSOR_QUANT8_SYMM:
+        case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
+        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
+            return InferenceEngine::Precision::I8;
+        case OperandType::TENSOR_QUANT16_SYMM:
+            return InferenceEngine::Precision::I16;
+        case OperandType::TENSOR_QUANT16_ASYMM:
+            return InferenceEngine::Precision::U16;
+        default:
+            return InferenceEngine::Precision::FP32;
+    }
+}
+
+// IENetwork loads every network on the CPU plugin, whatever the target device of the driver, which
+// takes inputs and outputs in each of the native precisions
+static void setNativePrecisions(InferenceEngine::CNNNetwork& cnnNetwork,
+                                const std::shared_ptr<NnapiModelInfo>& modelInfo,
+                                const IoBindings& bindings) {
+    auto inputsInfo = cnnNetwork.getInputsInfo();
+    for (auto index : modelInfo->getModelInputIndexes()) {
+        auto it = inputsInfo.find(bindings.getNodeName(index));
+        if (it != inputsInfo.end())
+            it->second->setPrecision(nativePrecision(modelInfo->getOperandType(index)));
+    }
+    auto outputsInfo = cnnNetwork.getOutputsInfo();
+    for (size_t i = 0; i < modelInfo->getModelOutputsSize(); i++) {
+        auto index = modelInfo->getModelOutputIndex(i);
+        auto it = outputsInfo.find(bindings.getNodeName(index));
+        if (it != outputsInfo.end())
+            it->second->setPrecision(nativePrecision(modelInfo->getOperandType(index)));
+    }
+}
+
+bool BasePreparedModel::compileNetwork(CompiledNetwork& network) {
+    auto& cache = NetworkCache::get();
+    NetworkCacheKey cacheKey;
+    size_t constantBytes = 0;
+    if (cache.isEnabled()) {
+        cacheKey = NetworkCache::makeKey(*network.modelInfo, mTargetDevice, mPreference,
+                                         mStatefulMode, mProfiler != nullptr, constantBytes);
+        CachedNetwork cached;
+        if (cache.lookup(cacheKey, cached)) {
+            ALOGD("%s Reusing a network loaded before", __func__);
+            if (network.modelInfo == mModelInfo) mNetworkCacheKey = cacheKey;
+            network.bindings = cached.bindings;
+            try {
+                network.plugin =
+                    std::make_shared<IENetwork>(cached.executable, mProfiler != nullptr);
+                return network.plugin->loadNetwork();
+            } catch (const std::exception& ex) {
+                ALOGE("%s Exception !!! %s", __func__, ex.what());
+                return false;
+            }
+        }
+    }
+
+    mMetrics.compilations++;
+    // The graph and the CNNNetwork only live while compiling, the plugin copies the constants so
+    // their weight store buffers are released once it loaded the network
+    std::shared_ptr<ngraph::Function> ngraph_function;
+    {
+        // The creator serializes translations, it is released before the plugin compiles
+        NgraphNetworkCreator ngraphNetCreator(network.modelInfo, mTargetDevice);
+
+        if (!ngraphNetCreator.validateOperations()) return false;
+        if (mStatefulMode) ngraphNetCreator.enableStatefulMode();
+        ALOGI("Generating IR Graph");
+        ngraph_function = ngraphNetCreator.generateGraph();
+        if (ngraph_function == nullptr) {
+            ALOGE("%s ngraph generation failed", __func__);
+            return false;
+        }
+
+        network.bindings = std::make_shared<IoBindings>();
+        for (auto index : network.modelInfo->getModelInputIndexes())
+            network.bindings->nodeNames[index] = ngraphNetCreator.getNodeName(index);
+        for (size_t i = 0; i < network.modelInfo->getModelOutputsSize(); i++) {
+            auto index = network.modelInfo->getModelOutputIndex(i);
+            network.bindings->nodeNames[index] = ngraphNetCreator.getNodeName(index);
+        }
+        if (mProfiler) network.bindings->nodeOperations = ngraphNetCreator.getNodeOperations();
+    }
+
+    try {
+        auto cnnNetwork = std::make_shared<InferenceEngine::CNNNetwork>(ngraph_function);
+        // Without, 8 and 16 bit outputs come back as FP32 and FP16 inputs are expected as FP32
+        setNativePrecisions(*cnnNetwork, network.modelInfo, *network.bindings);
+#if __ANDROID__
+        cnnNetwork->serialize("/data/vendor/neuralnetworks/ngraph_ir.xml",
+                              "/data/vendor/neuralnetworks/ngraph_ir.bin");
+#else
+        cnnNetwork->serialize("/tmp/ngraph_ir.xml", "/tmp/ngraph_ir.bin");
+#endif
+        network.plugin = std::make_shared<IENetwork>(
+            cnnNetwork, mProfiler != nullptr,
+            network.modelInfo->getModel().relaxComputationFloat32toFloat16, mPreference);
+        if (!network.plugin->loadNetwork()) return false;
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+        return false;
+    }
+    if (cache.isEnabled()) {
+        cache.insert(cacheKey, {network.plugin->getExecutableNetwork(), network.bindings},
+                     constantBytes);
+        if (network.modelInfo == mModelInfo) mNetworkCacheKey = cacheKey;
+    }
+    return true;
+}
+
+bool BasePreparedModel::evict() {
+    std::lock_guard<std::mutex> lock(mResidencyMutex);
+    if (!mPlugin) return true;
+    // The network never changes, the export of an earlier eviction is still valid
+    if (mEvictedPath.empty()) {
+        static std::atomic<uint32_t> sExports{0};
+        const std::string path = std::string(kDataDirectory) + "/evicted_" +
+                                 std::to_string(getpid()) + "_" + std::to_string(sExports++) +
+                                 ".blob";
+        try {
+            std::ofstream file(path, std::ios::binary);
+            mPlugin->getExecutableNetwork().Export(file);
+            file.close();
+            if (!file) throw std::runtime_error("Failed to write " + path);
+        } catch (const std::exception& ex) {
+            ALOGE("%s Exception !!! %s", __func__, ex.what());
+            unlink(path.c_str());
+            return false;
+        }
+        mEvictedPath = path;
+    }
+    mPlugin.reset();
+    // Executions in flight hold the network until they complete
+    NetworkCache::get().erase(mNetworkCacheKey);
+    mMetrics.evictions++;
+    ALOGD("%s Network released, exported to %s", __func__, mEvictedPath.c_str());
+    return true;
+}
+
+bool BasePreparedModel::reload() {
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        std::ifstream file(mEvictedPath, std::ios::binary);
+        auto plugin = std::make_shared<IENetwork>(
+            IENetwork::importNetwork(file, mProfiler != nullptr,
+                                     mModelInfo->getModel().relaxComputationFloat32toFloat16,
+                                     mPreference),
+            mProfiler != nullptr);
+        if (!plugin->loadNetwork()) return false;
+        mPlugin = plugin;
+        // Bindings identify the loaded network, which the imported one is not shared with
+        mBindings = std::make_shared<IoBindings>(*mBindings);
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+        return false;
+    }
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    mMetrics.reloads++;
+    mMetrics.reloadLatency.record(latency.count());
+    ALOGD("%s Network imported from %s in %lld us", __func__, mEvictedPath.c_str(),
+          static_cast<long long>(latency.count()));
+    return true;
+}
+
+bool BasePreparedModel::getCompiledNetwork(const hidl_vec<V1_0::RequestArgument>& inputs,
+                                           CompiledNetwork& network) {
+    if (!mDynamicInputs) {
+        if (!mResidencyManaged) {
+            network = {mModelInfo, mBindings, mPlugin};
+            return true;
+        }
+        mLastUse.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                       std::memory_order_relaxed);
+        bool reloaded = false;
+        {
+            std::lock_guard<std::mutex> lock(mResidencyMutex);
+            if (!mPlugin) {
+                if (!reload()) return false;
+                reloaded = true;
+            }
+            network = {mModelInfo, mBindings, mPlugin};
+        }
+        // May evict other idle models to make room
+        if (reloaded) ResidencyManager::get().reloaded(this, network.bindings.get());
+        return true;
+    }
+
+    std::vector<uint32_t> shapeKey;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const auto& modelDims =
+            mModelInfo->getOperand(mModelInfo->getModelInputIndex(i)).dimensions;
+        const auto& dims = (inputs[i].dimensions.size() > 0) ? inputs[i].dimensions : modelDims;
+        shapeKey.push_back(dims.size());
+        shapeKey.insert(shapeKey.end(), dims.begin(), dims.end());
+    }
+
+    std::lock_guard<std::mutex> lock(mShapeCacheMutex);
+    if (mShapeCache->get(shapeKey, network)) return true;
+
+    ALOGD("%s Compiling for new input shapes, %zu specializations cached", __func__,
+          mShapeCache->size());
+    network = {std::make_shared<NnapiModelInfo>(mModelInfo->getModel()), nullptr, nullptr};
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (inputs[i].dimensions.size() > 0)
+            network.modelInfo->setInputDimensions(i, inputs[i].dimensions);
+    }
+    if (!network.modelInfo->initRuntimeInfo()) {
+        ALOGE("Failed to initialize Model runtime parameters!!");
+        return false;
+    }
+    if (!compileNetwork(network)) return false;
+
+    mShapeCache->put(shapeKey, network);
+    return true;
+}
+
+void BasePreparedModel::recordProfile(const CompiledNetwork& network) {
+    if (!mProfiler) return;
+    // A missing profile does not fail the execution
+    try {
+        mProfiler->record(network.plugin->getPerformanceCounts(),
+                          network.bindings->nodeOperations);
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+    }
+}
+
+std::string BasePreparedModel::dumpProfile(bool json) {
+    if (!mProfiler) return json ? "null" : "profiling disabled\n";
+    return mProfiler->dump(json);
+}
+
+void BasePreparedModel::startCapture() {
+    static std::atomic<uint32_t> sCaptures{0};
+    const std::string path = std::string(kDataDirectory) + "/capture_" +
+                             std::to_string(getpid()) + "_" + std::to_string(sCaptures++) +
+                             ".nnhc";
+    const auto model = mModelInfo->getModel();
+    std::vector<std::vector<uint8_t>> poolContents;
+    for (const auto& poolInfo : mModelInfo->getModelPoolInfos()) {
+        poolContents.emplace_back(poolInfo.buffer, poolInfo.buffer + poolInfo.hidlMemory.size());
+    }
+    auto capture = std::make_unique<CaptureWriter>();
+    if (!capture->open(path, model, poolContents)) return;
+    mCapture = std::move(capture);
+    mCaptureStart = std::chrono::steady_clock::now();
+    mCaptureInterval = std::max(property_get_int32(kCaptureIntervalProperty, 1), 1);
+    mCaptureMaxRequests = std::max(
+        property_get_int32(kCaptureMaxRequestsProperty, kDefaultCaptureMaxRequests), 0);
+}
+
+void BasePreparedModel::captureRequest(const Request& request,
+                                       const std::shared_ptr<NnapiModelInfo>& modelInfo,
+                                       std::chrono::steady_clock::time_point start) {
+    if (!mCapture) return;
+    if (mCaptureExecutions++ % mCaptureInterval != 0) return;
+    if (mCapturedRequests++ >= mCaptureMaxRequests) return;
+
+    const auto end = std::chrono::steady_clock::now();
+    CapturedRequest captured;
+    captured.offsetNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - mCaptureStart).count();
+    captured.latencyUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    for (size_t i = 0; i < request.inputs.size(); i++) {
+        uint32_t length = 0;
+        auto* data = static_cast<uint8_t*>(modelInfo->getBlobFromMemoryPoolIn(request, i, length));
+        const auto& dimensions = request.inputs[i].dimensions.size() > 0
+                                     ? request.inputs[i].dimensions
+                                     : modelInfo->getOperand(modelInfo->getModelInputIndex(i))
+                                           .dimensions;
+        captured.inputs.push_back({dimensions, std::vector<uint8_t>(data, data + length)});
+    }
+    const auto outputShapes = modelInfo->getOutputShapes();
+    for (size_t i = 0; i < request.outputs.size(); i++) {
+        uint32_t length = 0;
+        auto* data =
+            static_cast<uint8_t*>(modelInfo->getBlobFromMemoryPoolOut(request, i, length));
+        std::vector<uint32_t> dimensions;
+        if (i < outputShapes.size()) dimensions = outputShapes[i].dimensions;
+        captured.outputs.push_back({dimensions, std::vector<uint8_t>(data, data + length)});
+    }
+    mCapture->write(captured);
+}
+
+void BasePreparedModel::resetState() {
+    ALOGV("Entering %s", __func__);
+    if (!mStatefulMode) return;
+    try {
+        if (mPlugin) mPlugin->resetState();
+        if (mShapeCache) {
+            std::lock_guard<std::mutex> lock(mShapeCacheMutex);
+            mShapeCache->forEach([](const std::vector<uint32_t>&, const CompiledNetwork& network) {
+                network.plugin->resetState();
+            });
+        }
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+    }
+}
+
 static Return<void> notify(const sp<V1_0::IExecutionCallback>& callback, const ErrorStatus& status,
                            const hidl_vec<OutputShape>&, Timing) {
     return callback->notify(status);
@@ -71,39 +506,136 @@ static Return<void> notify(const sp<V1_3::IExecutionCallback>& callback, const E
     return callback->notify_1_3(convertToV1_3(status), outputShapes, timing);
 }
 
-static void floatToUint8(const float* src, uint8_t* dst, size_t size) {
-    for (uint32_t i = 0; i < size; ++i) {
-        dst[i] = static_cast<uint8_t>(src[i]);
-        ALOGV("%s input: %f output: %d ", __func__, src[i], dst[i]);
-    }
+// Whether blob holds the tensor of an operand of operandType in the layout of request memory,
+// rather than converted to FP32
+static bool isNativeBlob(const InferenceEngine::Blob::Ptr& blob, OperandType operandType) {
+    return blob->getTensorDesc().getPrecision() == nativePrecision(operandType);
 }
 
-static void floatToint8(const float* src, int8_t* dst, size_t size) {
-    for (uint32_t i = 0; i < size; ++i) {
-        dst[i] = static_cast<int8_t>(src[i]);
-        ALOGV("%s input: %f output: %d ", __func__, src[i], dst[i]);
+// Bytes an element of a tensor of operandType takes in request memory
+static size_t requestElementSize(OperandType operandType) {
+    switch (operandType) {
+        case OperandType::TENSOR_BOOL8:
+        case OperandType::TENSOR_QUANT8_ASYMM:
+        case OperandType::TENSOR_QUANT8_SYMM:
+        case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
+        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
+            return 1;
+        case OperandType::TENSOR_FLOAT16:
+        case OperandType::TENSOR_QUANT16_SYMM:
+        case OperandType::TENSOR_QUANT16_ASYMM:
+            return 2;
+        default:
+            return 4;
     }
 }
 
-static void floatToFloat16(const float* src, _Float16* dst, size_t size) {
-    for (uint32_t i = 0; i < size; ++i) {
-        dst[i] = src[i];
-        ALOGV("%s input: %f output: %f ", __func__, src[i], dst[i]);
+// Bytes of request memory the tensor held by blob takes
+static size_t requestLength(const InferenceEngine::Blob::Ptr& blob, OperandType operandType) {
+    if (isNativeBlob(blob, operandType)) return blob->byteSize();
+    return blob->size() * requestElementSize(operandType);
+}
+
+template <typename T>
+static void widenToFloat(const void* src, float* dst, size_t count) {
+    const T* values = static_cast<const T*>(src);
+    for (size_t i = 0; i < count; i++) dst[i] = static_cast<float>(values[i]);
+}
+
+template <typename T>
+static void narrowFromFloat(const float* src, void* dst, size_t count) {
+    T* values = static_cast<T*>(dst);
+    for (size_t i = 0; i < count; i++) values[i] = static_cast<T>(src[i]);
+}
+
+// Copies count elements of request memory into blob from element offset on
+static void copyToBlob(OperandType operandType, const void* src,
+                       const InferenceEngine::Blob::Ptr& blob, size_t offset, size_t count) {
+    if (isNativeBlob(blob, operandType)) {
+        const size_t elementSize = blob->element_size();
+        std::memcpy(blob->buffer().as<uint8_t*>() + offset * elementSize, src,
+                    count * elementSize);
+        return;
+    }
+    float* dst = blob->buffer().as<float*>() + offset;
+    switch (operandType) {
+        case OperandType::TENSOR_FLOAT16:
+            return widenToFloat<_Float16>(src, dst, count);
+        case OperandType::TENSOR_INT32:
+            return widenToFloat<int32_t>(src, dst, count);
+        case OperandType::TENSOR_BOOL8:
+        case OperandType::TENSOR_QUANT8_ASYMM:
+            return widenToFloat<uint8_t>(src, dst, count);
+        case OperandType::TENSOR_QUANT8_SYMM:
+        case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
+        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
+            return widenToFloat<int8_t>(src, dst, count);
+        case OperandType::TENSOR_QUANT16_SYMM:
+            return widenToFloat<int16_t>(src, dst, count);
+        case OperandType::TENSOR_QUANT16_ASYMM:
+            return widenToFloat<uint16_t>(src, dst, count);
+        default:
+            std::memcpy(dst, src, count * sizeof(float));
     }
 }
 
-static void floatToInt16(const float* src, int16_t* dst, size_t size) {
-    for (uint32_t i = 0; i < size; ++i) {
-        dst[i] = static_cast<int16_t>(src[i]);
-        ALOGV("%s input: %f output: %hd ", __func__, src[i], dst[i]);
+// Copies count elements of blob from element offset on into request memory
+static void copyFromBlob(OperandType operandType, const InferenceEngine::Blob::Ptr& blob,
+                         size_t offset, size_t count, void* dst) {
+    if (isNativeBlob(blob, operandType)) {
+        const size_t elementSize = blob->element_size();
+        std::memcpy(dst, blob->buffer().as<uint8_t*>() + offset * elementSize,
+                    count * elementSize);
+        return;
+    }
+    const float* src = blob->buffer().as<float*>() + offset;
+    switch (operandType) {
+        case OperandType::TENSOR_FLOAT16:
+            return narrowFromFloat<_Float16>(src, dst, count);
+        case OperandType::TENSOR_INT32:
+            return narrowFromFloat<int32_t>(src, dst, count);
+        case OperandType::TENSOR_BOOL8:
+        case OperandType::TENSOR_QUANT8_ASYMM:
+            return narrowFromFloat<uint8_t>(src, dst, count);
+        case OperandType::TENSOR_QUANT8_SYMM:
+        case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
+        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
+            return narrowFromFloat<int8_t>(src, dst, count);
+        case OperandType::TENSOR_QUANT16_SYMM:
+            return narrowFromFloat<int16_t>(src, dst, count);
+        case OperandType::TENSOR_QUANT16_ASYMM:
+            return narrowFromFloat<uint16_t>(src, dst, count);
+        default:
+            std::memcpy(dst, src, count * sizeof(float));
     }
 }
 
-static void floatToUInt16(const float* src, uint16_t* dst, size_t size) {
-    for (uint32_t i = 0; i < size; ++i) {
-        dst[i] = static_cast<uint16_t>(src[i]);
-        ALOGV("%s input: %f output: %hu ", __func__, src[i], dst[i]);
+// Inputs are read by the plugin in place in the request memory. An input not of the size of the
+// network input, or which the plugin does not take in its native precision, is copied into the
+// blob the input had when the network was loaded instead, never into the blob bound before,
+// which may still point into the memory of an earlier request. Returns false if the input can't
+// be set, the inference would read stale data otherwise.
+static bool setInputBlob(IIENetwork& plugin, const std::string& name, OperandType operandType,
+                         void* srcPtr, uint32_t length, ModelMetrics& metrics) {
+    auto blob = plugin.getInputBlob(name);
+    if (blob == nullptr) {
+        ALOGE("%s No blob for input %s", __func__, name.c_str());
+        return false;
+    }
+    auto wrapped = makeBlob(blob->getTensorDesc(), srcPtr);
+    if (wrapped == nullptr) {
+        ALOGE("%s Unexpected precision of input %s", __func__, name.c_str());
+        return false;
+    }
+    if (isNativeBlob(wrapped, operandType) && wrapped->byteSize() == length) {
+        blob = wrapped;
+    } else {
+        copyToBlob(operandType, srcPtr, blob, 0,
+                   std::min<size_t>(length / requestElementSize(operandType), blob->size()));
+        metrics.bytesCopied += length;
     }
+    plugin.setBlob(name, blob);
+    return true;
 }
 
 namespace {
@@ -114,121 +646,119 @@ auto microsecondsDuration(decltype(now()) end, decltype(now()) start) {
 };
 }  // namespace
 
-template <typename T_IExecutionCallback>
-Return<ErrorStatus> executeBase(const Request& request, MeasureTiming measure,
-                                BasePreparedModel* preparedModel,
-                                const sp<T_IExecutionCallback>& callback) {
-    ALOGV("Entering %s", __func__);
-
-    time_point driverStart;
-    if (measure == MeasureTiming::YES) driverStart = now();
+static std::chrono::nanoseconds getLoopTimeout(const V1_3::OptionalTimeoutDuration& duration) {
+    if (duration.getDiscriminator() == V1_3::OptionalTimeoutDuration::hidl_discriminator::none)
+        return kDefaultLoopTimeout;
+    return std::min<std::chrono::nanoseconds>(std::chrono::nanoseconds(duration.nanoseconds()),
+                                              kMaxLoopTimeout);
+}
 
-    if (callback.get() == nullptr) {
-        ALOGE("invalid callback passed to execute");
-        return ErrorStatus::INVALID_ARGUMENT;
-    }
-    if (!validateRequest(request, convertToV1_2(preparedModel->getModelInfo()->getModel()))) {
-        notify(callback, ErrorStatus::INVALID_ARGUMENT, {}, kNoTiming);
-        return ErrorStatus::INVALID_ARGUMENT;
+// A WHILE loop may not terminate, inference of models with loops is cancelled once the loop
+// timeout expires. Returns false on timeout.
+static bool runInference(BasePreparedModel* preparedModel, const CompiledNetwork& network,
+                         std::chrono::nanoseconds loopTimeout) {
+    if (!preparedModel->hasLoops()) {
+        network.plugin->infer();
+    } else if (!network.plugin->inferWithTimeout(
+                   std::chrono::duration_cast<std::chrono::milliseconds>(loopTimeout))) {
+        return false;
     }
+    preparedModel->recordProfile(network);
+    return true;
+}
 
-    // This thread is intentionally detached because the driver service
-    // is expected to live forever.
-    std::thread([preparedModel, request, measure, driverStart, callback] {
-        asyncExecute(request, measure, preparedModel, driverStart, callback);
-    }).detach();
-    ALOGV("Exiting %s", __func__);
-    return ErrorStatus::NONE;
+// Models with control flow reference subgraphs, which only exist from V1_3 on
+static bool validateRequestForModel(const Request& request, const Model& model) {
+    if (model.referenced.size() > 0) return validateRequest(convertToV1_3(request), model);
+    return validateRequest(request, convertToV1_2(model));
 }
 
+// State of an asynchronous execution, handed from its dispatch to the completion of its inference
 template <typename T_IExecutionCallback>
-void asyncExecute(const Request& request, MeasureTiming measure, BasePreparedModel* preparedModel,
-                  time_point driverStart, const sp<T_IExecutionCallback>& callback) {
-    ALOGV("Entering %s", __func__);
-    auto modelInfo = preparedModel->getModelInfo();
-    auto plugin = preparedModel->getPlugin();
-    auto ngraphNw = preparedModel->getNgraphNwCreator();
-    time_point driverEnd, deviceStart, deviceEnd;
-    std::vector<RunTimePoolInfo> requestPoolInfos;
-    auto errorStatus = modelInfo->setRunTimePoolInfosFromHidlMemories(request.pools);
-    if (errorStatus != ErrorStatus::NONE) {
-        ALOGE("Failed to set runtime pool info from HIDL memories");
-        notify(callback, ErrorStatus::GENERAL_FAILURE, {}, kNoTiming);
-        return;
-    }
-
-    for (size_t i = 0; i < request.inputs.size(); i++) {
-        uint32_t len;
-        auto inIndex = modelInfo->getModelInputIndex(i);
-        void* srcPtr = modelInfo->getBlobFromMemoryPoolIn(request, i, len);
-
-        const std::string& inputNodeName = ngraphNw->getNodeName(inIndex);
-        if (inputNodeName == "") {
-            ALOGD("Ignorning input at index(%d), since it is invalid", inIndex);
-            continue;
-        }
-        ALOGD("Input index: %d layername : %s", inIndex, inputNodeName.c_str());
-        auto destBlob = plugin->getBlob(inputNodeName);
-        if (modelInfo->getOperandType(inIndex) == OperandType::TENSOR_FLOAT16) {
-            float* dest = destBlob->buffer().as<float*>();
-            _Float16* src = (_Float16*)srcPtr;
+struct AsyncExecution {
+    AsyncExecution(const Request& request, MeasureTiming measure, BasePreparedModel* preparedModel,
+                   time_point driverStart, const sp<T_IExecutionCallback>& callback,
+                   std::chrono::nanoseconds loopTimeout)
+        : request(request),
+          measure(measure),
+          preparedModel(preparedModel),
+          driverStart(driverStart),
+          executionStart(now()),
+          callback(callback),
+          loopTimeout(loopTimeout),
+          counter(preparedModel->getMetrics()),
+          execution(ExecutionStage::EXECUTION, &preparedModel->getMetrics(), true),
+          trace(ExecutionStage::QUEUE_WAIT, &preparedModel->getMetrics(), true) {}
+
+    const Request request;
+    const MeasureTiming measure;
+    // Keeps the model alive until the execution finished, the client may release it once notified
+    const sp<BasePreparedModel> preparedModel;
+    const time_point driverStart;
+    const time_point executionStart;
+    time_point deviceStart;
+    time_point deviceEnd;
+    const sp<T_IExecutionCallback> callback;
+    const std::chrono::nanoseconds loopTimeout;
+    CompiledNetwork network;
+    ExecutionCounter counter;
+    ScopedTrace execution;
+    ScopedTrace trace;
+};
 
-            for (unsigned int i = 0; i < len / 2; i++) {
-                dest[i] = src[i];
-            }
-        } else {
-            uint8_t* dest = destBlob->buffer().as<uint8_t*>();
-            std::memcpy(dest, (uint8_t*)srcPtr, len);
-        }
-    }
-    ALOGD("%s Run", __func__);
+template <typename T_IExecutionCallback>
+using AsyncExecutionPtr = std::shared_ptr<AsyncExecution<T_IExecutionCallback>>;
 
-    if (measure == MeasureTiming::YES) deviceStart = now();
-    try {
-        plugin->infer();
-    } catch (const std::exception& ex) {
-        ALOGE("%s Exception !!! %s", __func__, ex.what());
-        notify(callback, ErrorStatus::GENERAL_FAILURE, {}, kNoTiming);
-        return;
+// Ends the execution and releases the execution gate, then notifies the client which may release
+// the prepared model right after. The execution the gate was handed to runs on the dispatcher.
+template <typename T_IExecutionCallback>
+static void finishExecution(AsyncExecutionPtr<T_IExecutionCallback> execution, ErrorStatus status,
+                            hidl_vec<OutputShape> outputShapes, Timing timing) {
+    sp<BasePreparedModel> preparedModel = execution->preparedModel;
+    const auto callback = execution->callback;
+    // Ends the counter and traces of the execution, which account into the model metrics
+    execution.reset();
+    auto next = preparedModel->getExecutionGate().release();
+    Return<void> returned = notify(callback, status, outputShapes, timing);
+    if (!returned.isOk()) {
+        ALOGE("hidl callback failed to return properly: %s", returned.description().c_str());
     }
-    if (measure == MeasureTiming::YES) deviceEnd = now();
+    // This usually runs on the plugin thread completing the inference, which must not be held
+    // up by the next execution and the network compile it may take, nor destroy the infer request
+    // it runs for when this was the last reference to the model
+    const auto preference = preparedModel->getExecutionPreference();
+    ExecutionDispatcher::get().post(
+        [preparedModel = std::move(preparedModel), preference, next = std::move(next)]() {
+            if (!next) return;
+            CpuTopology::get().pinThread(preference);
+            next();
+        });
+}
 
+// Copies the outputs of a completed inference into the request pools, throws when the plugin does
+static ErrorStatus copyOutputs(const Request& request, const CompiledNetwork& network,
+                               ModelMetrics& metrics) {
+    auto modelInfo = network.modelInfo;
+    auto plugin = network.plugin;
+    auto bindings = network.bindings;
     for (size_t i = 0; i < request.outputs.size(); i++) {
         auto outIndex = modelInfo->getModelOutputIndex(i);
         ALOGI("OutputIndex: %d", outIndex);
-        const std::string& outputNodeName = ngraphNw->getNodeName(outIndex);
+        const std::string& outputNodeName = bindings->getNodeName(outIndex);
         if (outputNodeName == "") {
             ALOGD("Ignorning output at index(%d), since it is invalid", outIndex);
             continue;
         }
         ALOGD("Output index: %d layername : %s", outIndex, outputNodeName.c_str());
         auto srcBlob = plugin->getBlob(outputNodeName);
-        auto operandType = modelInfo->getOperandType(outIndex);
-        uint32_t actualLength = srcBlob->byteSize();
+        const auto operandType = modelInfo->getOperandType(outIndex);
+        uint32_t actualLength = requestLength(srcBlob, operandType);
         uint32_t expectedLength = 0;
         void* destPtr = modelInfo->getBlobFromMemoryPoolOut(request, i, expectedLength);
         auto outputBlobDims = srcBlob->getTensorDesc().getDims();
 
         ALOGD("output precision: %d", static_cast<int>(srcBlob->getTensorDesc().getPrecision()));
 
-        switch (operandType) {
-            case OperandType::TENSOR_BOOL8:
-            case OperandType::TENSOR_QUANT8_ASYMM:
-            case OperandType::TENSOR_QUANT8_SYMM:
-            case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
-            case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-                actualLength /= 4;
-                break;
-            case OperandType::TENSOR_FLOAT16:
-            case OperandType::TENSOR_QUANT16_SYMM:
-            case OperandType::TENSOR_QUANT16_ASYMM:
-                actualLength /= 2;
-                break;
-            default:
-                ALOGV("Operand type is 4 bytes !!");
-                break;
-        }
-
         bool outputSizeMismatch = false;
         if (actualLength != expectedLength) {
             ALOGE("%s Invalid length at outIndex(%d) Actual:%d Expected:%d", __func__, outIndex,
@@ -248,224 +778,270 @@ void asyncExecute(const Request& request, MeasureTiming measure, BasePreparedMod
             ALOGE(
                 "Mismatch in actual and exepcted output sizes. Return with "
                 "OUTPUT_INSUFFICIENT_SIZE error");
-            notify(callback, ErrorStatus::OUTPUT_INSUFFICIENT_SIZE, modelInfo->getOutputShapes(),
-                   kNoTiming);
-            return;
+            return ErrorStatus::OUTPUT_INSUFFICIENT_SIZE;
         }
 
-        switch (operandType) {
-            case OperandType::TENSOR_INT32:
-            case OperandType::TENSOR_FLOAT32: {
-                std::memcpy((uint8_t*)destPtr, srcBlob->buffer().as<uint8_t*>(),
-                            srcBlob->byteSize());
-                break;
-            }
-            case OperandType::TENSOR_BOOL8: {
-                floatToUint8(srcBlob->buffer().as<float*>(), (uint8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT8_ASYMM: {
-                floatToUint8(srcBlob->buffer().as<float*>(), (uint8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT8_SYMM:
-            case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
-            case OperandType::TENSOR_QUANT8_ASYMM_SIGNED: {
-                floatToint8(srcBlob->buffer().as<float*>(), (int8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_FLOAT16: {
-                floatToFloat16(srcBlob->buffer().as<float*>(), (_Float16*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT16_SYMM: {
-                floatToInt16(srcBlob->buffer().as<float*>(), (int16_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT16_ASYMM: {
-                floatToUInt16(srcBlob->buffer().as<float*>(), (uint16_t*)destPtr, srcBlob->size());
-                break;
-            }
-            default:
-                std::memcpy((uint8_t*)destPtr, srcBlob->buffer().as<uint8_t*>(),
-                            srcBlob->byteSize());
-                break;
-        }
+        copyFromBlob(operandType, srcBlob, 0, srcBlob->size(), destPtr);
+        metrics.bytesCopied += actualLength;
+    }
+    return ErrorStatus::NONE;
+}
+
+// Continuation of an inference which completed, copies the outputs into the request pools
+template <typename T_IExecutionCallback>
+static void completeInference(AsyncExecutionPtr<T_IExecutionCallback> execution) {
+    ALOGV("Entering %s", __func__);
+    const auto& request = execution->request;
+    auto preparedModel = execution->preparedModel;
+    auto& trace = execution->trace;
+    auto modelInfo = execution->network.modelInfo;
+
+    trace.next(ExecutionStage::OUTPUT_CONVERT);
+    auto status = ErrorStatus::GENERAL_FAILURE;
+    try {
+        status = copyOutputs(request, execution->network, preparedModel->getMetrics());
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+    }
+    if (status == ErrorStatus::OUTPUT_INSUFFICIENT_SIZE) {
+        finishExecution(std::move(execution), status, modelInfo->getOutputShapes(), kNoTiming);
+        return;
+    }
+    if (status != ErrorStatus::NONE) {
+        finishExecution(std::move(execution), status, {}, kNoTiming);
+        return;
     }
 
+    trace.next(ExecutionStage::POOL_SYNC);
     if (!modelInfo->updateRequestPoolInfos()) {
         ALOGE("Failed to update the request pool infos");
     }
 
-    Return<void> returned;
-    if (measure == MeasureTiming::YES) {
-        driverEnd = now();
-        Timing timing = {.timeOnDevice = uint64_t(microsecondsDuration(deviceEnd, deviceStart)),
-                         .timeInDriver = uint64_t(microsecondsDuration(driverEnd, driverStart))};
-        returned = notify(callback, ErrorStatus::NONE, modelInfo->getOutputShapes(), timing);
-    } else {
-        returned = notify(callback, ErrorStatus::NONE, modelInfo->getOutputShapes(), kNoTiming);
-    }
-    if (!returned.isOk()) {
-        ALOGE("hidl callback failed to return properly: %s", returned.description().c_str());
+    preparedModel->captureRequest(request, modelInfo, execution->executionStart);
+    execution->counter.succeeded();
+    trace.next(ExecutionStage::CALLBACK);
+    Timing timing = kNoTiming;
+    if (execution->measure == MeasureTiming::YES) {
+        const auto driverEnd = now();
+        const auto deviceTime = microsecondsDuration(execution->deviceEnd, execution->deviceStart);
+        const auto driverTime = microsecondsDuration(driverEnd, execution->driverStart);
+        timing = {.timeOnDevice = uint64_t(deviceTime), .timeInDriver = uint64_t(driverTime)};
     }
+    finishExecution(std::move(execution), ErrorStatus::NONE, modelInfo->getOutputShapes(), timing);
     ALOGV("Exiting %s", __func__);
 }
 
-static std::tuple<ErrorStatus, hidl_vec<V1_2::OutputShape>, Timing> executeSynchronouslyBase(
-    const Request& request, MeasureTiming measure, BasePreparedModel* preparedModel,
-    time_point driverStart) {
-    ALOGV("Entering %s", __func__);
-    auto modelInfo = preparedModel->getModelInfo();
-    auto plugin = preparedModel->getPlugin();
-    auto ngraphNw = preparedModel->getNgraphNwCreator();
-    time_point driverEnd, deviceStart, deviceEnd;
-    std::vector<RunTimePoolInfo> requestPoolInfos;
+// Looks up the network for the request input shapes, maps the request pools and sets the inputs.
+// Runs with the execution gate held, throws when the plugin does.
+static bool prepareInference(BasePreparedModel* preparedModel, const Request& request,
+                             ScopedTrace& trace, CompiledNetwork& network) {
+    auto& metrics = preparedModel->getMetrics();
+    trace.next(ExecutionStage::NETWORK_LOOKUP);
+    if (!preparedModel->getCompiledNetwork(request.inputs, network)) {
+        ALOGE("Failed to get a network compiled for the request input shapes");
+        return false;
+    }
+    auto modelInfo = network.modelInfo;
+    auto plugin = network.plugin;
+    auto bindings = network.bindings;
+    trace.next(ExecutionStage::POOL_MAP);
     auto errorStatus = modelInfo->setRunTimePoolInfosFromHidlMemories(request.pools);
+    metrics.poolMaps += request.pools.size();
     if (errorStatus != ErrorStatus::NONE) {
         ALOGE("Failed to set runtime pool info from HIDL memories");
-        return {ErrorStatus::GENERAL_FAILURE, {}, kNoTiming};
+        return false;
     }
 
+    trace.next(ExecutionStage::INPUT_COPY);
     for (size_t i = 0; i < request.inputs.size(); i++) {
         uint32_t len;
         auto inIndex = modelInfo->getModelInputIndex(i);
         void* srcPtr = modelInfo->getBlobFromMemoryPoolIn(request, i, len);
 
-        const std::string& inputNodeName = ngraphNw->getNodeName(inIndex);
+        const std::string& inputNodeName = bindings->getNodeName(inIndex);
         if (inputNodeName == "") {
             ALOGD("Ignorning input at index(%d), since it is invalid", inIndex);
             continue;
         }
         ALOGD("Input index: %d layername : %s", inIndex, inputNodeName.c_str());
-        auto destBlob = plugin->getBlob(inputNodeName);
-        if (modelInfo->getOperandType(inIndex) == OperandType::TENSOR_FLOAT16) {
-            float* dest = destBlob->buffer().as<float*>();
-            _Float16* src = (_Float16*)srcPtr;
-
-            for (unsigned int i = 0; i < len / 2; i++) {
-                dest[i] = src[i];
-            }
-        } else {
-            uint8_t* dest = destBlob->buffer().as<uint8_t*>();
-            std::memcpy(dest, (uint8_t*)srcPtr, len);
+        if (!setInputBlob(*plugin, inputNodeName, modelInfo->getOperandType(inIndex), srcPtr, len,
+                          metrics)) {
+            return false;
         }
     }
+    return true;
+}
 
-    ALOGD("%s Run", __func__);
-
-    if (measure == MeasureTiming::YES) deviceStart = now();
+// Runs with the execution gate held. The inference completes on a plugin thread, which converts
+// the outputs and notifies the client, so no driver thread waits for it.
+template <typename T_IExecutionCallback>
+static void asyncExecute(AsyncExecutionPtr<T_IExecutionCallback> execution) {
+    ALOGV("Entering %s", __func__);
+    auto preparedModel = execution->preparedModel;
+    auto& trace = execution->trace;
+    bool prepared = false;
     try {
-        plugin->infer();
+        prepared =
+            prepareInference(preparedModel.get(), execution->request, trace, execution->network);
     } catch (const std::exception& ex) {
         ALOGE("%s Exception !!! %s", __func__, ex.what());
-        return {ErrorStatus::GENERAL_FAILURE, {}, kNoTiming};
     }
-    if (measure == MeasureTiming::YES) deviceEnd = now();
+    if (!prepared) {
+        finishExecution(std::move(execution), ErrorStatus::GENERAL_FAILURE, {}, kNoTiming);
+        return;
+    }
+    auto plugin = execution->network.plugin;
+    ALOGD("%s Run", __func__);
 
-    for (size_t i = 0; i < request.outputs.size(); i++) {
-        auto outIndex = modelInfo->getModelOutputIndex(i);
-        ALOGI("OutputIndex: %d", outIndex);
-        const std::string& outputNodeName = ngraphNw->getNodeName(outIndex);
-        if (outputNodeName == "") {
-            ALOGD("Ignorning output at index(%d), since it is invalid", outIndex);
-            continue;
+    trace.next(ExecutionStage::INFER);
+    if (execution->measure == MeasureTiming::YES) execution->deviceStart = now();
+    if (preparedModel->hasLoops()) {
+        // An inference still running when the loop timeout expires is cancelled, which takes a
+        // thread waiting for it
+        bool completed = false;
+        try {
+            completed =
+                runInference(preparedModel.get(), execution->network, execution->loopTimeout);
+            if (!completed) ALOGE("%s Loop timeout expired", __func__);
+        } catch (const std::exception& ex) {
+            ALOGE("%s Exception !!! %s", __func__, ex.what());
         }
-        ALOGD("Output index: %d layername : %s", outIndex, outputNodeName.c_str());
-        auto srcBlob = plugin->getBlob(outputNodeName);
-        auto operandType = modelInfo->getOperandType(outIndex);
-        uint32_t actualLength = srcBlob->byteSize();
-        uint32_t expectedLength = 0;
-        void* destPtr = modelInfo->getBlobFromMemoryPoolOut(request, i, expectedLength);
-        auto outputBlobDims = srcBlob->getTensorDesc().getDims();
+        if (!completed) {
+            finishExecution(std::move(execution), ErrorStatus::GENERAL_FAILURE, {}, kNoTiming);
+            return;
+        }
+        if (execution->measure == MeasureTiming::YES) execution->deviceEnd = now();
+        completeInference(std::move(execution));
+        return;
+    }
 
-        ALOGD("output precision: %d", static_cast<int>(srcBlob->getTensorDesc().getPrecision()));
+    std::function<void(InferenceEngine::StatusCode)> completion =
+        [execution](InferenceEngine::StatusCode status) mutable {
+            if (execution->measure == MeasureTiming::YES) execution->deviceEnd = now();
+            if (status != InferenceEngine::StatusCode::OK) {
+                finishExecution(std::move(execution), ErrorStatus::GENERAL_FAILURE, {},
+                                kNoTiming);
+                return;
+            }
+            execution->preparedModel->recordProfile(execution->network);
+            completeInference(std::move(execution));
+        };
+    // The completion owns the execution from here on, it may run before inferAsync returns
+    execution.reset();
+    plugin->inferAsync(std::move(completion));
+    ALOGV("Exiting %s", __func__);
+}
 
-        switch (operandType) {
-            case OperandType::TENSOR_BOOL8:
-            case OperandType::TENSOR_QUANT8_ASYMM:
-            case OperandType::TENSOR_QUANT8_SYMM:
-            case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
-            case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-                actualLength /= 4;
-                break;
-            case OperandType::TENSOR_FLOAT16:
-            case OperandType::TENSOR_QUANT16_SYMM:
-            case OperandType::TENSOR_QUANT16_ASYMM:
-                actualLength /= 2;
-                break;
-            default:
-                ALOGV("Operand type is 4 bytes !!");
-                break;
-        }
+template <typename T_IExecutionCallback>
+Return<ErrorStatus> executeBase(const Request& request, MeasureTiming measure,
+                                BasePreparedModel* preparedModel,
+                                const sp<T_IExecutionCallback>& callback,
+                                std::chrono::nanoseconds loopTimeout = kDefaultLoopTimeout) {
+    ALOGV("Entering %s", __func__);
 
-        bool outputSizeMismatch = false;
-        if (actualLength != expectedLength) {
-            ALOGE("%s Invalid length at outIndex(%d) Actual:%d Expected:%d", __func__, outIndex,
-                  actualLength, expectedLength);
-            outputSizeMismatch = true;
-        }
+    time_point driverStart;
+    if (measure == MeasureTiming::YES) driverStart = now();
 
-        // TODO: bug identified with OV2021.4 where for Pad operation, if the output dimensions is 1
-        // output dimension is coming as 0
-        if ((outputBlobDims.size() == 0) && (actualLength != 0)) {
-            std::vector<size_t> rdims = {1};
-            modelInfo->updateOutputshapes(i, rdims, outputSizeMismatch ? false : true);
-        } else
-            modelInfo->updateOutputshapes(i, outputBlobDims, outputSizeMismatch ? false : true);
+    if (callback.get() == nullptr) {
+        ALOGE("invalid callback passed to execute");
+        return ErrorStatus::INVALID_ARGUMENT;
+    }
+    ScopedTrace trace(ExecutionStage::VALIDATE, &preparedModel->getMetrics());
+    if (!validateRequestForModel(request, preparedModel->getModelInfo()->getModel())) {
+        notify(callback, ErrorStatus::INVALID_ARGUMENT, {}, kNoTiming);
+        return ErrorStatus::INVALID_ARGUMENT;
+    }
 
-        if (outputSizeMismatch) {
-            ALOGE(
-                "Mismatch in actual and exepcted output sizes. Return with "
-                "OUTPUT_INSUFFICIENT_SIZE error");
-            return {ErrorStatus::OUTPUT_INSUFFICIENT_SIZE, modelInfo->getOutputShapes(), kNoTiming};
+    trace.next(ExecutionStage::DISPATCH);
+    if (preparedModel->isBatchable(request)) {
+        preparedModel->getBatchScheduler()->submit(
+            {request, measure, driverStart,
+             [callback](ErrorStatus status, const hidl_vec<OutputShape>& outputShapes,
+                        Timing timing) {
+                 Return<void> returned = notify(callback, status, outputShapes, timing);
+                 if (!returned.isOk()) {
+                     ALOGE("hidl callback failed to return properly: %s",
+                           returned.description().c_str());
+                 }
+             }});
+        ALOGV("Exiting %s", __func__);
+        return ErrorStatus::NONE;
+    }
+
+    auto execution = std::make_shared<AsyncExecution<T_IExecutionCallback>>(
+        request, measure, preparedModel, driverStart, callback, loopTimeout);
+    std::function<void()> task;
+    if (preparedModel->hasLoops()) {
+        // Inferences with a loop timeout are waited for, on a thread of their own once the gate
+        // was handed to the execution. This thread is intentionally detached because the driver
+        // service is expected to live forever.
+        task = [execution]() mutable {
+            std::thread(
+                [](AsyncExecutionPtr<T_IExecutionCallback> execution) {
+                    CpuTopology::get().pinThread(
+                        execution->preparedModel->getExecutionPreference());
+                    asyncExecute(std::move(execution));
+                },
+                std::move(execution))
+                .detach();
+        };
+    } else {
+        task = [execution]() mutable { asyncExecute(std::move(execution)); };
+    }
+    execution.reset();
+    // Runs right away unless an execution holds the gate, in which case the execution releasing
+    // it dispatches this one
+    preparedModel->getExecutionGate().async(std::move(task));
+    ALOGV("Exiting %s", __func__);
+    return ErrorStatus::NONE;
+}
+
+static std::tuple<ErrorStatus, hidl_vec<V1_2::OutputShape>, Timing> executeSynchronouslyBase(
+    const Request& request, MeasureTiming measure, BasePreparedModel* preparedModel,
+    time_point driverStart, std::chrono::nanoseconds loopTimeout = kDefaultLoopTimeout) {
+    ALOGV("Entering %s", __func__);
+    const auto executionStart = now();
+    auto& metrics = preparedModel->getMetrics();
+    ExecutionCounter counter(metrics);
+    ScopedTrace execution(ExecutionStage::EXECUTION, &metrics);
+    // A network has a single infer request, and the model info keeps per request pool state
+    ScopedTrace trace(ExecutionStage::QUEUE_WAIT, &metrics);
+    std::lock_guard<ExecutionGate> executionLock(preparedModel->getExecutionGate());
+    CompiledNetwork network;
+    time_point driverEnd, deviceStart, deviceEnd;
+    try {
+        if (!prepareInference(preparedModel, request, trace, network)) {
+            return {ErrorStatus::GENERAL_FAILURE, {}, kNoTiming};
         }
+        ALOGD("%s Run", __func__);
 
-        switch (operandType) {
-            case OperandType::TENSOR_INT32:
-            case OperandType::TENSOR_FLOAT32: {
-                std::memcpy((uint8_t*)destPtr, srcBlob->buffer().as<uint8_t*>(),
-                            srcBlob->byteSize());
-                break;
-            }
-            case OperandType::TENSOR_BOOL8: {
-                floatToUint8(srcBlob->buffer().as<float*>(), (uint8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT8_ASYMM: {
-                floatToUint8(srcBlob->buffer().as<float*>(), (uint8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT8_SYMM:
-            case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
-            case OperandType::TENSOR_QUANT8_ASYMM_SIGNED: {
-                floatToint8(srcBlob->buffer().as<float*>(), (int8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_FLOAT16: {
-                floatToFloat16(srcBlob->buffer().as<float*>(), (_Float16*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT16_SYMM: {
-                floatToInt16(srcBlob->buffer().as<float*>(), (int16_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT16_ASYMM: {
-                floatToUInt16(srcBlob->buffer().as<float*>(), (uint16_t*)destPtr, srcBlob->size());
-                break;
-            }
-            default:
-                std::memcpy((uint8_t*)destPtr, srcBlob->buffer().as<uint8_t*>(),
-                            srcBlob->byteSize());
-                break;
+        trace.next(ExecutionStage::INFER);
+        if (measure == MeasureTiming::YES) deviceStart = now();
+        if (!runInference(preparedModel, network, loopTimeout)) {
+            ALOGE("%s Loop timeout expired", __func__);
+            return {ErrorStatus::GENERAL_FAILURE, {}, kNoTiming};
         }
+        if (measure == MeasureTiming::YES) deviceEnd = now();
+
+        trace.next(ExecutionStage::OUTPUT_CONVERT);
+        const auto status = copyOutputs(request, network, metrics);
+        if (status != ErrorStatus::NONE) {
+            return {status, network.modelInfo->getOutputShapes(), kNoTiming};
+        }
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+        return {ErrorStatus::GENERAL_FAILURE, {}, kNoTiming};
     }
+    auto modelInfo = network.modelInfo;
 
+    trace.next(ExecutionStage::POOL_SYNC);
     if (!modelInfo->updateRequestPoolInfos()) {
         ALOGE("Failed to update the request pool infos");
         return {ErrorStatus::GENERAL_FAILURE, {}, kNoTiming};
     }
 
+    preparedModel->captureRequest(request, modelInfo, executionStart);
+    counter.succeeded();
     if (measure == MeasureTiming::YES) {
         driverEnd = now();
         Timing timing = {.timeOnDevice = uint64_t(microsecondsDuration(deviceEnd, deviceStart)),
@@ -476,38 +1052,265 @@ static std::tuple<ErrorStatus, hidl_vec<V1_2::OutputShape>, Timing> executeSynch
     return {ErrorStatus::NONE, modelInfo->getOutputShapes(), kNoTiming};
 }
 
+static std::tuple<ErrorStatus, hidl_vec<V1_2::OutputShape>, Timing> executeBatched(
+    const Request& request, MeasureTiming measure, BasePreparedModel* preparedModel,
+    time_point driverStart) {
+    std::promise<std::tuple<ErrorStatus, hidl_vec<V1_2::OutputShape>, Timing>> result;
+    auto future = result.get_future();
+    preparedModel->getBatchScheduler()->submit(
+        {request, measure, driverStart,
+         [&result](ErrorStatus status, const hidl_vec<OutputShape>& outputShapes, Timing timing) {
+             result.set_value({status, outputShapes, timing});
+         }});
+    return future.get();
+}
+
+static bool mapRequestPools(const hidl_vec<hidl_memory>& pools,
+                            std::vector<RunTimePoolInfo>& poolInfos) {
+    poolInfos.resize(pools.size());
+    for (size_t i = 0; i < pools.size(); i++) {
+        if (!poolInfos[i].set(pools[i])) {
+            ALOGE("Could not map memory pool !!!");
+            return false;
+        }
+    }
+    return true;
+}
+
+static void unmapRequestPools(std::vector<RunTimePoolInfo>& poolInfos) {
+    for (auto& poolInfo : poolInfos) {
+        poolInfo.update();
+        poolInfo.unmap_mem();
+    }
+}
+
+bool BasePreparedModel::isBatchable(const Request& request) {
+    if (!mBatchScheduler) return false;
+    auto hasModelShape = [this](const V1_0::RequestArgument& arg, uint32_t operandIndex) {
+        return !arg.hasNoValue &&
+               (arg.dimensions.size() == 0 ||
+                arg.dimensions == mModelInfo->getOperand(operandIndex).dimensions);
+    };
+    for (size_t i = 0; i < request.inputs.size(); i++) {
+        if (!hasModelShape(request.inputs[i], mModelInfo->getModelInputIndex(i))) return false;
+    }
+    for (size_t i = 0; i < request.outputs.size(); i++) {
+        if (!hasModelShape(request.outputs[i], mModelInfo->getModelOutputIndex(i))) return false;
+    }
+    return true;
+}
+
+bool BasePreparedModel::getBatchedNetwork(size_t batchSize, CompiledNetwork& network) {
+    auto it = mBatchedNetworks.find(batchSize);
+    if (it != mBatchedNetworks.end()) {
+        network = it->second;
+        return network.plugin != nullptr;
+    }
+
+    // Failures leave an empty entry behind, so a batch size is only attempted once
+    auto& batchedNetwork = mBatchedNetworks[batchSize];
+    CompiledNetwork candidate = {std::make_shared<NnapiModelInfo>(mModelInfo->getModel()), nullptr,
+                                 nullptr};
+    for (size_t i = 0; i < mModelInfo->getModelInputIndexes().size(); i++) {
+        auto dims = mModelInfo->getOperand(mModelInfo->getModelInputIndex(i)).dimensions;
+        dims[0] *= batchSize;
+        candidate.modelInfo->setInputDimensions(i, dims);
+    }
+    if (!candidate.modelInfo->initRuntimeInfo() || !compileNetwork(candidate)) {
+        ALOGE("%s Failed to compile for batch size %zu", __func__, batchSize);
+        return false;
+    }
+
+    // Operations folding the batch into other dimensions make outputs impossible to scatter
+    for (size_t i = 0; i < mModelInfo->getModelOutputsSize(); i++) {
+        auto outIndex = mModelInfo->getModelOutputIndex(i);
+        const std::string& outputNodeName = candidate.bindings->getNodeName(outIndex);
+        if (outputNodeName == "") return false;
+        auto dims = candidate.plugin->getBlob(outputNodeName)->getTensorDesc().getDims();
+        const auto& modelDims = mModelInfo->getOperand(outIndex).dimensions;
+        if (dims.size() != modelDims.size() || dims[0] != modelDims[0] * batchSize ||
+            !std::equal(dims.begin() + 1, dims.end(), modelDims.begin() + 1)) {
+            ALOGI("%s Output %zu does not scale with the batch, batch size %zu not used",
+                  __func__, i, batchSize);
+            return false;
+        }
+    }
+
+    batchedNetwork = candidate;
+    network = candidate;
+    return true;
+}
+
+void BasePreparedModel::executeBatch(std::vector<BatchJob>& jobs) {
+    ALOGV("Entering %s", __func__);
+    const size_t batchSize = jobs.size();
+    auto executeIndividually = [this, &jobs]() {
+        for (auto& job : jobs) {
+            auto [status, outputShapes, timing] =
+                executeSynchronouslyBase(job.request, job.measure, this, job.driverStart);
+            job.notify(status, outputShapes, timing);
+        }
+    };
+
+    CompiledNetwork network;
+    if (batchSize == 1 || !getBatchedNetwork(batchSize, network)) {
+        executeIndividually();
+        return;
+    }
+    auto modelInfo = network.modelInfo;
+    auto plugin = network.plugin;
+    auto bindings = network.bindings;
+
+    // Executions which fall back to running individually are counted on their own
+    ScopedTrace execution(ExecutionStage::EXECUTION, &mMetrics);
+    ScopedTrace trace(ExecutionStage::POOL_MAP, &mMetrics);
+    mMetrics.inFlight += batchSize;
+    auto countExecutions = [this, &jobs](const std::vector<ErrorStatus>& status) {
+        mMetrics.inFlight -= jobs.size();
+        mMetrics.executions += jobs.size();
+        mMetrics.failures += std::count_if(status.begin(), status.end(),
+                                           [](ErrorStatus s) { return s != ErrorStatus::NONE; });
+    };
+
+    // Pools are mapped per execution, the model info only tracks the pools of one request
+    std::vector<std::vector<RunTimePoolInfo>> jobPools(batchSize);
+    auto releasePools = [this, &jobPools]() {
+        for (auto& poolInfos : jobPools) {
+            mMetrics.poolUnmaps += poolInfos.size();
+            unmapRequestPools(poolInfos);
+        }
+    };
+    for (size_t j = 0; j < batchSize; j++) {
+        mMetrics.poolMaps += jobs[j].request.pools.size();
+        if (!mapRequestPools(jobs[j].request.pools, jobPools[j])) {
+            releasePools();
+            mMetrics.inFlight -= batchSize;
+            executeIndividually();
+            return;
+        }
+    }
+
+    time_point deviceStart, deviceEnd;
+    std::vector<hidl_vec<OutputShape>> outputShapes(batchSize);
+    std::vector<ErrorStatus> status(batchSize, ErrorStatus::NONE);
+    try {
+        trace.next(ExecutionStage::INPUT_COPY);
+        for (size_t i = 0; i < modelInfo->getModelInputIndexes().size(); i++) {
+            auto inIndex = modelInfo->getModelInputIndex(i);
+            const std::string& inputNodeName = bindings->getNodeName(inIndex);
+            if (inputNodeName == "") continue;
+
+            auto destBlob = plugin->getBlob(inputNodeName);
+            const auto operandType = modelInfo->getOperandType(inIndex);
+            const size_t jobElements = destBlob->size() / batchSize;
+            for (size_t j = 0; j < batchSize; j++) {
+                const auto& location = jobs[j].request.inputs[i].location;
+                uint8_t* srcPtr = jobPools[j][location.poolIndex].buffer + location.offset;
+                copyToBlob(operandType, srcPtr, destBlob, j * jobElements,
+                           std::min<size_t>(jobElements,
+                                            location.length / requestElementSize(operandType)));
+                mMetrics.bytesCopied += location.length;
+            }
+        }
+
+        trace.next(ExecutionStage::INFER);
+        deviceStart = now();
+        plugin->infer();
+        deviceEnd = now();
+        recordProfile(network);
+
+        trace.next(ExecutionStage::OUTPUT_CONVERT);
+        for (auto& shapes : outputShapes) shapes.resize(jobs[0].request.outputs.size());
+        for (size_t i = 0; i < jobs[0].request.outputs.size(); i++) {
+            auto outIndex = modelInfo->getModelOutputIndex(i);
+            const std::string& outputNodeName = bindings->getNodeName(outIndex);
+            if (outputNodeName == "") continue;
+
+            auto srcBlob = plugin->getBlob(outputNodeName);
+            const auto operandType = modelInfo->getOperandType(outIndex);
+            auto dims = srcBlob->getTensorDesc().getDims();
+            dims[0] /= batchSize;
+            const size_t jobElements = srcBlob->size() / batchSize;
+            const uint32_t jobLength = requestLength(srcBlob, operandType) / batchSize;
+            for (size_t j = 0; j < batchSize; j++) {
+                const auto& location = jobs[j].request.outputs[i].location;
+                outputShapes[j][i].dimensions = std::vector<uint32_t>(dims.begin(), dims.end());
+                outputShapes[j][i].isSufficient = location.length >= jobLength;
+                if (!outputShapes[j][i].isSufficient) {
+                    status[j] = ErrorStatus::OUTPUT_INSUFFICIENT_SIZE;
+                    continue;
+                }
+                uint8_t* destPtr = jobPools[j][location.poolIndex].buffer + location.offset;
+                copyFromBlob(operandType, srcBlob, j * jobElements, jobElements, destPtr);
+                mMetrics.bytesCopied += jobLength;
+            }
+        }
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+        releasePools();
+        countExecutions(std::vector<ErrorStatus>(batchSize, ErrorStatus::GENERAL_FAILURE));
+        for (auto& job : jobs) job.notify(ErrorStatus::GENERAL_FAILURE, {}, kNoTiming);
+        return;
+    }
+    trace.next(ExecutionStage::POOL_SYNC);
+    releasePools();
+
+    countExecutions(status);
+    trace.next(ExecutionStage::CALLBACK);
+    const auto driverEnd = now();
+    for (size_t j = 0; j < batchSize; j++) {
+        Timing timing = kNoTiming;
+        if (jobs[j].measure == MeasureTiming::YES && status[j] == ErrorStatus::NONE) {
+            auto driverStart = jobs[j].driverStart;
+            timing = {.timeOnDevice = uint64_t(microsecondsDuration(deviceEnd, deviceStart)),
+                      .timeInDriver = uint64_t(microsecondsDuration(driverEnd, driverStart))};
+        }
+        jobs[j].notify(status[j], outputShapes[j], timing);
+    }
+    ALOGV("Exiting %s", __func__);
+}
+
 Return<void> BasePreparedModel::executeSynchronously(const Request& request, MeasureTiming measure,
                                                      executeSynchronously_cb cb) {
     ALOGV("Entering %s", __func__);
     time_point driverStart;
     if (measure == MeasureTiming::YES) driverStart = now();
 
-    if (!validateRequest(request, convertToV1_2(mModelInfo->getModel()))) {
+    ScopedTrace trace(ExecutionStage::VALIDATE, &mMetrics);
+    if (!validateRequestForModel(request, mModelInfo->getModel())) {
         cb(ErrorStatus::INVALID_ARGUMENT, {}, kNoTiming);
         return Void();
     }
+    trace.next(ExecutionStage::DISPATCH);
     auto [status, outputShapes, timing] =
-        executeSynchronouslyBase(request, measure, this, driverStart);
+        isBatchable(request) ? executeBatched(request, measure, this, driverStart)
+                             : executeSynchronouslyBase(request, measure, this, driverStart);
+    trace.next(ExecutionStage::CALLBACK);
     cb(status, std::move(outputShapes), timing);
     ALOGV("Exiting %s", __func__);
     return Void();
 }
 
-Return<void> BasePreparedModel::executeSynchronously_1_3(const V1_3::Request& request,
-                                                         V1_2::MeasureTiming measure,
-                                                         const V1_3::OptionalTimePoint&,
-                                                         const V1_3::OptionalTimeoutDuration&,
-                                                         executeSynchronously_1_3_cb cb) {
+Return<void> BasePreparedModel::executeSynchronously_1_3(
+    const V1_3::Request& request, V1_2::MeasureTiming measure, const V1_3::OptionalTimePoint&,
+    const V1_3::OptionalTimeoutDuration& loopTimeoutDuration, executeSynchronously_1_3_cb cb) {
     ALOGV("Entering %s", __func__);
     time_point driverStart;
     if (measure == MeasureTiming::YES) driverStart = now();
 
-    if (!validateRequest(convertToV1_0(request), convertToV1_2(mModelInfo->getModel()))) {
+    ScopedTrace trace(ExecutionStage::VALIDATE, &mMetrics);
+    if (!validateRequest(request, mModelInfo->getModel())) {
         cb(V1_3::ErrorStatus::INVALID_ARGUMENT, {}, kNoTiming);
         return Void();
     }
+    trace.next(ExecutionStage::DISPATCH);
+    auto request1_0 = convertToV1_0(request);
     auto [status, outputShapes, timing] =
-        executeSynchronouslyBase(convertToV1_0(request), measure, this, driverStart);
+        isBatchable(request1_0)
+            ? executeBatched(request1_0, measure, this, driverStart)
+            : executeSynchronouslyBase(request1_0, measure, this, driverStart,
+                                       getLoopTimeout(loopTimeoutDuration));
+    trace.next(ExecutionStage::CALLBACK);
     cb(convertToV1_3(status), std::move(outputShapes), timing);
     ALOGV("Exiting %s", __func__);
     return Void();
@@ -546,26 +1349,30 @@ Return<ErrorStatus> BasePreparedModel::execute_1_2(const Request& request, Measu
 
 Return<V1_3::ErrorStatus> BasePreparedModel::execute_1_3(
     const V1_3::Request& request, V1_2::MeasureTiming measure, const V1_3::OptionalTimePoint&,
-    const V1_3::OptionalTimeoutDuration&, const sp<V1_3::IExecutionCallback>& callback) {
+    const V1_3::OptionalTimeoutDuration& loopTimeoutDuration,
+    const sp<V1_3::IExecutionCallback>& callback) {
     ALOGV("Entering %s", __func__);
-    return convertToV1_3(executeBase(convertToV1_0(request), measure, this, callback));
+    return convertToV1_3(executeBase(convertToV1_0(request), measure, this, callback,
+                                     getLoopTimeout(loopTimeoutDuration)));
 }
 
-Return<void> BasePreparedModel::executeFenced(const V1_3::Request& request1_3,
-                                              const hidl_vec<hidl_handle>& waitFor,
-                                              V1_2::MeasureTiming measure,
-                                              const V1_3::OptionalTimePoint& halDeadline,
-                                              const V1_3::OptionalTimeoutDuration&,
-                                              const V1_3::OptionalTimeoutDuration& duration,
-                                              executeFenced_cb cb) {
+Return<void> BasePreparedModel::executeFenced(
+    const V1_3::Request& request1_3, const hidl_vec<hidl_handle>& waitFor,
+    V1_2::MeasureTiming measure, const V1_3::OptionalTimePoint& halDeadline,
+    const V1_3::OptionalTimeoutDuration& loopTimeoutDuration,
+    const V1_3::OptionalTimeoutDuration& duration, executeFenced_cb cb) {
     ALOGV("Entering %s", __func__);
 
     time_point driverStart, driverEnd;
     if (measure == MeasureTiming::YES) driverStart = now();
 
-    if (!validateRequest(request1_3, mModelInfo->getModel(), /*allowUnspecifiedOutput=*/false)) {
-        cb(V1_3::ErrorStatus::INVALID_ARGUMENT, hidl_handle(nullptr), nullptr);
-        return Void();
+    {
+        ScopedTrace trace(ExecutionStage::VALIDATE, &mMetrics);
+        if (!validateRequest(request1_3, mModelInfo->getModel(),
+                             /*allowUnspecifiedOutput=*/false)) {
+            cb(V1_3::ErrorStatus::INVALID_ARGUMENT, hidl_handle(nullptr), nullptr);
+            return Void();
+        }
     }
 
     const auto deadline = makeDeadline(halDeadline);
@@ -588,12 +1395,14 @@ Return<void> BasePreparedModel::executeFenced(const V1_3::Request& request1_3,
         }
     }
 
-    auto errorStatus = mModelInfo->setRunTimePoolInfosFromHidlMemories(request1_3.pools);
-    if (errorStatus != V1_3::ErrorStatus::NONE) {
-        ALOGE("Failed to set runtime pool info from HIDL memories");
-        cb(errorStatus, hidl_handle(nullptr), nullptr);
-        return Void();
-    }
+    const auto executionStart = now();
+    auto& metrics = mMetrics;
+    ExecutionCounter counter(metrics);
+    ScopedTrace execution(ExecutionStage::EXECUTION, &metrics);
+    // Like the other paths, the network lookup may reload an evicted network or compile one,
+    // which must not race with the execution holding the gate
+    ScopedTrace trace(ExecutionStage::QUEUE_WAIT, &metrics);
+    std::lock_guard<ExecutionGate> executionLock(mExecutionGate);
 
     // rest of the interfaces are based on 1.0 request
     auto request = convertToV1_0(request1_3);
@@ -601,127 +1410,38 @@ Return<void> BasePreparedModel::executeFenced(const V1_3::Request& request1_3,
     time_point driverAfterFence;
     if (measure == MeasureTiming::YES) driverAfterFence = now();
 
-    for (size_t i = 0; i < request.inputs.size(); i++) {
-        uint32_t len;
-        auto inIndex = mModelInfo->getModelInputIndex(i);
-        void* srcPtr = mModelInfo->getBlobFromMemoryPoolIn(request, i, len);
-
-        const std::string& inputNodeName = mNgraphNetCreator->getNodeName(inIndex);
-        if (inputNodeName == "") {
-            ALOGD("Ignorning input at index(%d), since it is invalid", inIndex);
-            continue;
-        }
-        ALOGD("Input index: %d layername : %s", inIndex, inputNodeName.c_str());
-        auto destBlob = mPlugin->getBlob(inputNodeName);
-        if (mModelInfo->getOperandType(inIndex) == OperandType::TENSOR_FLOAT16) {
-            float* dest = destBlob->buffer().as<float*>();
-            _Float16* src = (_Float16*)srcPtr;
-
-            for (unsigned int i = 0; i < len / 2; i++) {
-                dest[i] = src[i];
-            }
-        } else {
-            uint8_t* dest = destBlob->buffer().as<uint8_t*>();
-            std::memcpy(dest, (uint8_t*)srcPtr, len);
-        }
-    }
-
-    ALOGD("%s Run", __func__);
-
+    CompiledNetwork network;
     time_point deviceStart, deviceEnd;
-    if (measure == MeasureTiming::YES) deviceStart = now();
     try {
-        mPlugin->infer();
-    } catch (const std::exception& ex) {
-        ALOGE("%s Exception !!! %s", __func__, ex.what());
-        cb(V1_3::ErrorStatus::GENERAL_FAILURE, hidl_handle(nullptr), nullptr);
-        return Void();
-    }
-    if (measure == MeasureTiming::YES) deviceEnd = now();
-
-    for (size_t i = 0; i < request.outputs.size(); i++) {
-        auto outIndex = mModelInfo->getModelOutputIndex(i);
-        ALOGI("OutputIndex: %d", outIndex);
-        const std::string& outputNodeName = mNgraphNetCreator->getNodeName(outIndex);
-        if (outputNodeName == "") {
-            ALOGD("Ignorning output at index(%d), since it is invalid", outIndex);
-            continue;
+        if (!prepareInference(this, request, trace, network)) {
+            cb(V1_3::ErrorStatus::GENERAL_FAILURE, hidl_handle(nullptr), nullptr);
+            return Void();
         }
-        ALOGD("Output index: %d layername : %s", outIndex, outputNodeName.c_str());
-        auto srcBlob = mPlugin->getBlob(outputNodeName);
-        auto operandType = mModelInfo->getOperandType(outIndex);
-        uint32_t actualLength = srcBlob->byteSize();
-        uint32_t expectedLength = 0;
-        void* destPtr = mModelInfo->getBlobFromMemoryPoolOut(request, i, expectedLength);
-        auto outDims = srcBlob->getTensorDesc().getDims();
-        switch (operandType) {
-            case OperandType::TENSOR_BOOL8:
-            case OperandType::TENSOR_QUANT8_ASYMM:
-            case OperandType::TENSOR_QUANT8_SYMM:
-            case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
-            case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-                actualLength /= 4;
-                break;
-            case OperandType::TENSOR_FLOAT16:
-            case OperandType::TENSOR_QUANT16_SYMM:
-            case OperandType::TENSOR_QUANT16_ASYMM:
-                actualLength /= 2;
-                break;
-            default:
-                ALOGV("Operand type is 4 bytes !!");
-                break;
+        ALOGD("%s Run", __func__);
+
+        trace.next(ExecutionStage::INFER);
+        if (measure == MeasureTiming::YES) deviceStart = now();
+        if (!runInference(this, network, getLoopTimeout(loopTimeoutDuration))) {
+            ALOGE("%s Loop timeout expired", __func__);
+            cb(V1_3::ErrorStatus::MISSED_DEADLINE_TRANSIENT, hidl_handle(nullptr), nullptr);
+            return Void();
         }
+        if (measure == MeasureTiming::YES) deviceEnd = now();
 
-        if (actualLength != expectedLength) {
-            ALOGE("%s Invalid length(%d) at outIndex(%d)", __func__, actualLength, outIndex);
-            // Notify Insufficient Buffer Length to modelInfo
-            mModelInfo->updateOutputshapes(i, outDims, false);
+        trace.next(ExecutionStage::OUTPUT_CONVERT);
+        if (copyOutputs(request, network, metrics) != ErrorStatus::NONE) {
             cb(V1_3::ErrorStatus::OUTPUT_INSUFFICIENT_SIZE, hidl_handle(nullptr), nullptr);
             return Void();
-        } else {
-            mModelInfo->updateOutputshapes(i, outDims);
-        }
-        switch (operandType) {
-            case OperandType::TENSOR_INT32:
-            case OperandType::TENSOR_FLOAT32: {
-                std::memcpy((uint8_t*)destPtr, srcBlob->buffer().as<uint8_t*>(),
-                            srcBlob->byteSize());
-                break;
-            }
-            case OperandType::TENSOR_BOOL8: {
-                floatToUint8(srcBlob->buffer().as<float*>(), (uint8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT8_ASYMM: {
-                floatToUint8(srcBlob->buffer().as<float*>(), (uint8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT8_SYMM:
-            case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
-            case OperandType::TENSOR_QUANT8_ASYMM_SIGNED: {
-                floatToint8(srcBlob->buffer().as<float*>(), (int8_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_FLOAT16: {
-                floatToFloat16(srcBlob->buffer().as<float*>(), (_Float16*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT16_SYMM: {
-                floatToInt16(srcBlob->buffer().as<float*>(), (int16_t*)destPtr, srcBlob->size());
-                break;
-            }
-            case OperandType::TENSOR_QUANT16_ASYMM: {
-                floatToUInt16(srcBlob->buffer().as<float*>(), (uint16_t*)destPtr, srcBlob->size());
-                break;
-            }
-            default:
-                std::memcpy((uint8_t*)destPtr, srcBlob->buffer().as<uint8_t*>(),
-                            srcBlob->byteSize());
-                break;
         }
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+        cb(V1_3::ErrorStatus::GENERAL_FAILURE, hidl_handle(nullptr), nullptr);
+        return Void();
     }
+    auto modelInfo = network.modelInfo;
 
-    if (!mModelInfo->updateRequestPoolInfos()) {
+    trace.next(ExecutionStage::POOL_SYNC);
+    if (!modelInfo->updateRequestPoolInfos()) {
         ALOGE("Failed to update the request pool infos");
     }
 
@@ -738,6 +1458,9 @@ Return<void> BasePreparedModel::executeFenced(const V1_3::Request& request1_3,
             .timeInDriver = uint64_t(microsecondsDuration(driverEnd, driverAfterFence))};
     }
 
+    captureRequest(request, modelInfo, executionStart);
+    counter.succeeded();
+    trace.next(ExecutionStage::CALLBACK);
     sp<BaseFencedExecutionCallback> fencedExecutionCallback = new BaseFencedExecutionCallback(
         timingSinceLaunch, timingAfterFence, V1_3::ErrorStatus::NONE);
     cb(V1_3::ErrorStatus::NONE, hidl_handle(nullptr), fencedExecutionCallback);
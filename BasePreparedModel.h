@@ -26,13 +26,23 @@
 #include <android/hidl/memory/1.0/IMemory.h>
 #include <hidlmemory/mapping.h>
 #include <sys/mman.h>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <mutex>
 #include <string>
 
 #include <NgraphNetworkCreator.hpp>
+#include "BatchScheduler.h"
 #include "Driver.h"
+#include "ExecutionGate.h"
 #include "IENetwork.h"
+#include "LruCache.h"
+#include "Metrics.h"
 #include "ModelManager.h"
+#include "NetworkCache.h"
+#include "OperationProfiler.h"
+#include "RequestCapture.h"
 #include "utils.h"
 
 #if __ANDROID__
@@ -52,6 +62,29 @@ template <class T>
 using vec = std::vector<T>;
 typedef uint8_t* memory;
 
+// What executions need from the graph a network was compiled from: the plugin blob names of the
+// model inputs and outputs, and for profiling the NNAPI operation of every node. The graph itself
+// is released once the network is loaded.
+struct IoBindings {
+    // Operand index -> blob name
+    std::map<uint32_t, std::string> nodeNames;
+    std::map<std::string, uint32_t> nodeOperations;
+
+    // Empty for operands without a blob
+    const std::string& getNodeName(uint32_t operandIndex) const {
+        static const std::string kNoName;
+        auto it = nodeNames.find(operandIndex);
+        return it == nodeNames.end() ? kNoName : it->second;
+    }
+};
+
+// Network compiled for one set of concrete model input shapes
+struct CompiledNetwork {
+    std::shared_ptr<NnapiModelInfo> modelInfo;
+    std::shared_ptr<IoBindings> bindings;
+    std::shared_ptr<IIENetwork> plugin;
+};
+
 class BasePreparedModel : public V1_3::IPreparedModel {
 public:
     BasePreparedModel(const Model& model) : mTargetDevice(IntelDeviceType::CPU) {
@@ -61,7 +94,7 @@ public:
         mModelInfo = std::make_shared<NnapiModelInfo>(model);
     }
 
-    virtual ~BasePreparedModel() { deinitialize(); }
+    virtual ~BasePreparedModel();
 
     Return<ErrorStatus> execute(const Request& request,
                                 const sp<V1_0::IExecutionCallback>& callback) override;
@@ -90,21 +123,102 @@ public:
 
     virtual bool initialize();
 
-    std::shared_ptr<NnapiModelInfo> getModelInfo() { return mModelInfo; }
+    // Part of what identifies the network in the driver wide network cache. Set before
+    // initialize.
+    void setExecutionPreference(V1_1::ExecutionPreference preference) { mPreference = preference; }
+    V1_1::ExecutionPreference getExecutionPreference() { return mPreference; }
 
-    std::shared_ptr<NgraphNetworkCreator> getNgraphNwCreator() { return mNgraphNetCreator; }
+    std::shared_ptr<NnapiModelInfo> getModelInfo() { return mModelInfo; }
 
     std::shared_ptr<IIENetwork> getPlugin() { return mPlugin; }
 
-    std::shared_ptr<InferenceEngine::CNNNetwork> cnnNetworkPtr;
+    // Network to run a request with. Models leaving input dimensions unspecified are compiled
+    // per concrete request shape, with the most recently used specializations kept around.
+    bool getCompiledNetwork(const hidl_vec<V1_0::RequestArgument>& inputs,
+                            CompiledNetwork& network);
+
+    // Under the driver memory budget an idle model exports its loaded network to a file and
+    // releases it, getCompiledNetwork imports it again. False if the plugin can't export it.
+    bool evict();
+    std::chrono::steady_clock::time_point getLastUse() {
+        return std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(mLastUse.load(std::memory_order_relaxed)));
+    }
+
+    // Serializes executions sharing the infer request and request pool state of a network
+    ExecutionGate& getExecutionGate() { return mExecutionGate; }
+
+    // Models with WHILE loops run with the loop timeout of the execution
+    bool hasLoops() { return mHasLoops; }
+
+    // Opt-in batching of concurrent executions with the shapes the model was prepared for
+    bool isBatchable(const Request& request);
+    BatchScheduler* getBatchScheduler() { return mBatchScheduler.get(); }
+
+    // Stateful mode keeps recurrent state inside the infer request between executions. There is
+    // no NNAPI hook to start a new sequence, so clients of the driver call this explicitly.
+    bool isStateful() { return mStatefulMode; }
+    void resetState();
+
+    // Opt-in per operation profiling, fed with the counters of every inference
+    void recordProfile(const CompiledNetwork& network);
+    std::string dumpProfile(bool json);
+
+    // Counters and per stage latencies, updated by every execution
+    ModelMetrics& getMetrics() { return mMetrics; }
+
+    // Opt-in capture of the model and a sample of its requests, see RequestCapture.h. Called
+    // with the execution lock held once the outputs are in the request pools.
+    void captureRequest(const Request& request, const std::shared_ptr<NnapiModelInfo>& modelInfo,
+                        std::chrono::steady_clock::time_point start);
 
 protected:
     virtual void deinitialize();
+    bool compileNetwork(CompiledNetwork& network);
+    bool reload();
+    bool getBatchedNetwork(size_t batchSize, CompiledNetwork& network);
+    void startCapture();
+    void executeBatch(std::vector<BatchJob>& jobs);
 
     IntelDeviceType mTargetDevice;
+    V1_1::ExecutionPreference mPreference = V1_1::ExecutionPreference::FAST_SINGLE_ANSWER;
+    bool mStatefulMode = false;
     std::shared_ptr<NnapiModelInfo> mModelInfo;
-    std::shared_ptr<NgraphNetworkCreator> mNgraphNetCreator;
+    std::shared_ptr<IoBindings> mBindings;
     std::shared_ptr<IIENetwork> mPlugin;
+    // Key of mPlugin in the network cache
+    NetworkCacheKey mNetworkCacheKey;
+    std::unique_ptr<OperationProfiler> mProfiler;
+    ModelMetrics mMetrics;
+
+    std::unique_ptr<CaptureWriter> mCapture;
+    std::chrono::steady_clock::time_point mCaptureStart;
+    uint32_t mCaptureInterval = 1;
+    uint32_t mCaptureMaxRequests = 0;
+    std::atomic<uint64_t> mCaptureExecutions{0};
+    std::atomic<uint64_t> mCapturedRequests{0};
+
+    // Set when the ResidencyManager accounts the model. mPlugin is then null while evicted and
+    // guarded by mResidencyMutex.
+    bool mResidencyManaged = false;
+    std::mutex mResidencyMutex;
+    std::atomic<std::chrono::steady_clock::rep> mLastUse{0};
+    // Export of the network, written by the first eviction
+    std::string mEvictedPath;
+
+    bool mDynamicInputs = false;
+    std::mutex mShapeCacheMutex;
+    // Key is the rank followed by the dimensions of every model input
+    std::unique_ptr<LruCache<std::vector<uint32_t>, CompiledNetwork>> mShapeCache;
+
+    ExecutionGate mExecutionGate;
+    bool mHasLoops = false;
+    // Networks compiled with the batch dimension scaled by the number of stacked executions,
+    // an entry without plugin marks a batch size which can't be compiled. Only used from the
+    // scheduler thread.
+    std::map<size_t, CompiledNetwork> mBatchedNetworks;
+    // Declared last so that it is destroyed before the state its thread uses
+    std::unique_ptr<BatchScheduler> mBatchScheduler;
 };
 
 class BaseFencedExecutionCallback : public V1_3::IFencedExecutionCallback {
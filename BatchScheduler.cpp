@@ -0,0 +1,73 @@
+#include "BatchScheduler.h"
+
+#include <android/log.h>
+#include <log/log.h>
+
+#include "CpuTopology.h"
+#include "Tracer.h"
+
+#undef LOG_TAG
+#define LOG_TAG "BatchScheduler"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+BatchScheduler::BatchScheduler(size_t maxBatch, std::chrono::microseconds window,
+                               BatchRunner runner, V1_1::ExecutionPreference preference)
+    : mMaxBatch(maxBatch), mWindow(window), mRunner(std::move(runner)), mPreference(preference) {
+    mThread = std::thread([this] { run(); });
+    ALOGD("%s maxBatch %zu window %lld us", __func__, mMaxBatch,
+          static_cast<long long>(mWindow.count()));
+}
+
+BatchScheduler::~BatchScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    if (mThread.joinable()) mThread.join();
+}
+
+void BatchScheduler::submit(BatchJob&& job) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending.emplace_back(std::chrono::steady_clock::now(), std::move(job));
+    }
+    mCondition.notify_all();
+}
+
+void BatchScheduler::run() {
+    CpuTopology::get().pinThread(mPreference);
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this] { return mStopping || !mPending.empty(); });
+        if (mPending.empty()) break;
+
+        // Pending executions are drained before stopping, so every callback gets notified
+        const auto deadline = mPending.front().first + mWindow;
+        {
+            ScopedTrace trace(ExecutionStage::QUEUE_WAIT);
+            mCondition.wait_until(lock, deadline,
+                                  [this] { return mStopping || mPending.size() >= mMaxBatch; });
+        }
+
+        std::vector<BatchJob> batch;
+        while (!mPending.empty() && batch.size() < mMaxBatch) {
+            batch.push_back(std::move(mPending.front().second));
+            mPending.pop_front();
+        }
+
+        lock.unlock();
+        ALOGV("%s running batch of %zu", __func__, batch.size());
+        mRunner(batch);
+        lock.lock();
+    }
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,60 @@
+#ifndef ANDROID_ML_NN_BATCH_SCHEDULER_H
+#define ANDROID_ML_NN_BATCH_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Driver.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// One execution waiting to be folded into a batch
+struct BatchJob {
+    Request request;
+    MeasureTiming measure;
+    std::chrono::steady_clock::time_point driverStart;
+    std::function<void(ErrorStatus, const hidl_vec<OutputShape>&, Timing)> notify;
+};
+
+// Collects executions submitted to one prepared model and hands them to the runner in groups of
+// up to maxBatch, waiting at most window after the oldest pending execution for the group to
+// fill up. The scheduler thread is pinned next to the streams of the model's execution preference.
+class BatchScheduler {
+public:
+    using BatchRunner = std::function<void(std::vector<BatchJob>&)>;
+
+    BatchScheduler(size_t maxBatch, std::chrono::microseconds window, BatchRunner runner,
+                   V1_1::ExecutionPreference preference);
+    ~BatchScheduler();
+
+    void submit(BatchJob&& job);
+
+private:
+    void run();
+
+    const size_t mMaxBatch;
+    const std::chrono::microseconds mWindow;
+    BatchRunner mRunner;
+    const V1_1::ExecutionPreference mPreference;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::pair<std::chrono::steady_clock::time_point, BatchJob>> mPending;
+    bool mStopping = false;
+    std::thread mThread;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_BATCH_SCHEDULER_H
@@ -0,0 +1,187 @@
+#include "BlobAllocator.h"
+
+#include <android/log.h>
+#include <cutils/properties.h>
+#include <log/log.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#undef LOG_TAG
+#define LOG_TAG "BlobAllocator"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// On unless set to false, freed blocks kept for reuse, and opt-in explicit huge pages, which need
+// pages reserved through /proc/sys/vm/nr_hugepages
+static const char* kArenaProperty = "vendor.nn.hal.arena";
+static const char* kMaxCachedProperty = "vendor.nn.hal.arena.max_cached_mb";
+static const int32_t kDefaultMaxCachedMb = 64;
+static const char* kHugeTlbProperty = "vendor.nn.hal.arena.hugetlb";
+
+static const size_t kAlignment = 64;
+static const size_t kPageSize = 4096;
+static const size_t kHugePageSize = 2 << 20;
+
+// Capacities are rounded so that blocks of close sizes can be reused for each other: to whole
+// pages, and to eighths of the power of two below the size once that is more, so that no block is
+// more than an eighth larger than it needs to be
+static size_t capacityFor(size_t size) {
+    if (size >= kHugePageSize) return (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    size_t power = kPageSize;
+    while (power * 2 <= size) power <<= 1;
+    const size_t step = std::max(kPageSize, power / 8);
+    return std::max(kPageSize, (size + step - 1) / step * step);
+}
+
+std::shared_ptr<BlobAllocator> BlobAllocator::get() {
+    // Never destroyed, so that blobs outliving static destruction still free into it
+    static auto* sAllocator = new std::shared_ptr<BlobAllocator>(new BlobAllocator());
+    return *sAllocator;
+}
+
+BlobAllocator::BlobAllocator()
+    : mEnabled(property_get_bool(kArenaProperty, true)),
+      mHugeTlb(property_get_bool(kHugeTlbProperty, false)),
+      mMaxCachedBytes(size_t(std::max(property_get_int32(kMaxCachedProperty, kDefaultMaxCachedMb),
+                                      0))
+                      << 20) {}
+
+void* BlobAllocator::allocateBlock(size_t capacity, Block& block) {
+    block = {capacity, false, false};
+    if (capacity < kHugePageSize) {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, kAlignment, capacity) != 0) return nullptr;
+        return ptr;
+    }
+
+    block.mapped = true;
+    void* ptr = MAP_FAILED;
+    if (mHugeTlb) {
+        ptr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (ptr == MAP_FAILED) ALOGD("%s No huge pages reserved for %zu bytes", __func__, capacity);
+        block.hugeTlb = ptr != MAP_FAILED;
+    }
+    if (ptr == MAP_FAILED) {
+        ptr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) return nullptr;
+        // Advised before the pages are faulted in, so that the kernel backs them with huge pages
+        madvise(ptr, capacity, MADV_HUGEPAGE);
+    }
+    return ptr;
+}
+
+void BlobAllocator::releaseBlock(void* ptr, const Block& block) {
+    if (block.mapped) {
+        munmap(ptr, block.capacity);
+    } else {
+        std::free(ptr);
+    }
+}
+
+void* BlobAllocator::alloc(size_t size) noexcept {
+    const size_t capacity = capacityFor(size);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mFree.find(capacity);
+        if (it != mFree.end() && !it->second.empty()) {
+            void* ptr = it->second.back();
+            it->second.pop_back();
+            mCachedBytes -= capacity;
+            mUsedBytes += capacity;
+            mReuses++;
+            return ptr;
+        }
+    }
+
+    // Outside the lock, populating a large block takes a while
+    Block block;
+    void* ptr = allocateBlock(capacity, block);
+    if (ptr == nullptr) {
+        ALOGE("%s Failed to allocate %zu bytes", __func__, capacity);
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBlocks[ptr] = block;
+    mUsedBytes += capacity;
+    if (block.mapped) mHugePageBytes += capacity;
+    mAllocations++;
+    return ptr;
+}
+
+bool BlobAllocator::free(void* handle) noexcept {
+    Block block;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mBlocks.find(handle);
+        if (it == mBlocks.end()) return false;
+        block = it->second;
+        mUsedBytes -= block.capacity;
+        if (mCachedBytes + block.capacity <= mMaxCachedBytes) {
+            mFree[block.capacity].push_back(handle);
+            mCachedBytes += block.capacity;
+            return true;
+        }
+        mBlocks.erase(it);
+        if (block.mapped) mHugePageBytes -= block.capacity;
+    }
+    releaseBlock(handle, block);
+    return true;
+}
+
+std::string BlobAllocator::dump(bool json) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::ostringstream out;
+    if (json) {
+        out << "{\"enabled\": " << (mEnabled ? "true" : "false")
+            << ", \"usedBytes\": " << mUsedBytes << ", \"cachedBytes\": " << mCachedBytes
+            << ", \"hugePageBytes\": " << mHugePageBytes << ", \"allocations\": " << mAllocations
+            << ", \"reuses\": " << mReuses << "}";
+    } else {
+        out << "blob arena " << (mEnabled ? "enabled" : "disabled") << " used " << mUsedBytes
+            << " cached " << mCachedBytes << " huge page " << mHugePageBytes
+            << " bytes, allocations " << mAllocations << " reuses " << mReuses << "\n";
+    }
+    return out.str();
+}
+
+template <typename T>
+static InferenceEngine::Blob::Ptr makeTypedBlob(const InferenceEngine::TensorDesc& desc,
+                                                void* data) {
+    if (data != nullptr) return InferenceEngine::make_shared_blob<T>(desc, static_cast<T*>(data));
+    auto allocator = BlobAllocator::get();
+    auto blob = allocator->isEnabled() ? InferenceEngine::make_shared_blob<T>(desc, allocator)
+                                       : InferenceEngine::make_shared_blob<T>(desc);
+    blob->allocate();
+    return blob;
+}
+
+InferenceEngine::Blob::Ptr makeBlob(const InferenceEngine::TensorDesc& desc, void* data) {
+    switch (desc.getPrecision()) {
+        case InferenceEngine::Precision::FP32:
+            return makeTypedBlob<float>(desc, data);
+        case InferenceEngine::Precision::FP16:
+        case InferenceEngine::Precision::I16:
+            return makeTypedBlob<int16_t>(desc, data);
+        case InferenceEngine::Precision::U16:
+            return makeTypedBlob<uint16_t>(desc, data);
+        case InferenceEngine::Precision::I32:
+            return makeTypedBlob<int32_t>(desc, data);
+        case InferenceEngine::Precision::U8:
+            return makeTypedBlob<uint8_t>(desc, data);
+        case InferenceEngine::Precision::I8:
+            return makeTypedBlob<int8_t>(desc, data);
+        default:
+            return nullptr;
+    }
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
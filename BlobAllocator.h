@@ -0,0 +1,76 @@
+#ifndef ANDROID_ML_NN_BLOB_ALLOCATOR_H
+#define ANDROID_ML_NN_BLOB_ALLOCATOR_H
+
+#include <ie_allocator.hpp>
+#include <ie_blob.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Driver wide arena for the blobs the driver binds to infer requests. Blocks are 64 byte aligned
+// and blocks of 2 MB and more are backed by transparent or, opt-in, explicit huge pages. Blocks are
+// not cleared, every blob is written before it is read, by the plugin or by the copy of a request
+// input, which faults the pages in local to the NUMA node of the writing thread. Freed blocks are
+// kept for reuse up to a bound, which spares later executions the page faults.
+class BlobAllocator : public InferenceEngine::IAllocator {
+public:
+    static std::shared_ptr<BlobAllocator> get();
+
+    void* lock(void* handle, InferenceEngine::LockOp) noexcept override { return handle; }
+    void unlock(void*) noexcept override {}
+    void* alloc(size_t size) noexcept override;
+    bool free(void* handle) noexcept override;
+
+    bool isEnabled() const { return mEnabled; }
+
+    std::string dump(bool json);
+
+private:
+    BlobAllocator();
+
+    struct Block {
+        size_t capacity;
+        // Mapped, and with huge pages explicitly, rather than from the heap
+        bool mapped;
+        bool hugeTlb;
+    };
+
+    void* allocateBlock(size_t capacity, Block& block);
+    void releaseBlock(void* ptr, const Block& block);
+
+    const bool mEnabled;
+    const bool mHugeTlb;
+    const size_t mMaxCachedBytes;
+
+    std::mutex mMutex;
+    std::unordered_map<void*, Block> mBlocks;
+    // Free blocks by capacity
+    std::map<size_t, std::vector<void*>> mFree;
+    size_t mCachedBytes = 0;
+    size_t mUsedBytes = 0;
+    // Blocks of huge page size, backed by huge pages where the kernel could
+    size_t mHugePageBytes = 0;
+    uint64_t mAllocations = 0;
+    uint64_t mReuses = 0;
+};
+
+// Blob described by desc over data, or from the arena when data is null. Null for precisions the
+// driver never binds.
+InferenceEngine::Blob::Ptr makeBlob(const InferenceEngine::TensorDesc& desc,
+                                    void* data = nullptr);
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_BLOB_ALLOCATOR_H
@@ -0,0 +1,445 @@
+#include "Calibration.h"
+
+#include <android/log.h>
+#include <cutils/properties.h>
+#include <hidlmemory/mapping.h>
+#include <ie_version.hpp>
+#include <log/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "CpuExecutor.h"
+#include "Driver.h"
+#include "Utils.h"
+
+#undef LOG_TAG
+#define LOG_TAG "Calibration"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Calibration runs in the background when the service starts unless disabled, and is stored per
+// device in the calibration directory. Removing the file forces a new calibration.
+static const char* kCalibrationProperty = "vendor.nn.hal.calibration";
+#if __ANDROID__
+static const char* kCalibrationDirectory = "/data/vendor/neuralnetworks";
+#else
+static const char* kCalibrationDirectory = "/tmp";
+#endif
+static const uint32_t kCalibrationVersion = 1;
+static const int kWarmupRuns = 3;
+static const int kMeasuredRuns = 15;
+// Keeps the reported numbers sane when a measurement is off by orders of magnitude
+static const float kMinRatio = 0.01f;
+static const float kMaxRatio = 100.f;
+
+namespace {
+
+enum class Precision { FLOAT32, FLOAT16, QUANT8 };
+
+const char* precisionName(Precision precision) {
+    switch (precision) {
+        case Precision::FLOAT32:
+            return "float32";
+        case Precision::FLOAT16:
+            return "float16";
+        case Precision::QUANT8:
+            return "quant8";
+    }
+    return "unknown";
+}
+
+size_t elementSize(OperandType type) {
+    switch (type) {
+        case OperandType::TENSOR_FLOAT16:
+            return 2;
+        case OperandType::TENSOR_QUANT8_ASYMM:
+            return 1;
+        default:
+            return 4;
+    }
+}
+
+// Builds the single operation models the device is measured with. Constants are copied into the
+// model so the reference implementation needs no model pools.
+class MicroModelBuilder {
+public:
+    explicit MicroModelBuilder(Precision precision) : mPrecision(precision) {
+        mTensorType = precision == Precision::FLOAT32   ? OperandType::TENSOR_FLOAT32
+                      : precision == Precision::FLOAT16 ? OperandType::TENSOR_FLOAT16
+                                                        : OperandType::TENSOR_QUANT8_ASYMM;
+    }
+
+    uint32_t addInput(const std::vector<uint32_t>& dimensions) {
+        const uint32_t index = addTensor(mTensorType, dimensions, 1.f / 128, 128);
+        mOperands[index].lifetime = OperandLifeTime::SUBGRAPH_INPUT;
+        mInputs.push_back(index);
+        return index;
+    }
+
+    uint32_t addOutput(const std::vector<uint32_t>& dimensions) {
+        const uint32_t index = addTensor(mTensorType, dimensions, 0.25f, 128);
+        mOperands[index].lifetime = OperandLifeTime::SUBGRAPH_OUTPUT;
+        mOutputs.push_back(index);
+        return index;
+    }
+
+    uint32_t addWeights(const std::vector<uint32_t>& dimensions) {
+        return addRandomConstant(mTensorType, dimensions, 1.f / 128, 128);
+    }
+
+    // Quantized biases are INT32 with the scale of the input times the scale of the weights
+    uint32_t addBias(uint32_t size) {
+        return mPrecision == Precision::QUANT8
+                   ? addRandomConstant(OperandType::TENSOR_INT32, {size}, 1.f / (128 * 128), 0)
+                   : addRandomConstant(mTensorType, {size}, 0.f, 0);
+    }
+
+    uint32_t addInt32(int32_t value) {
+        const uint32_t index = addOperand(OperandType::INT32, {}, 0.f, 0);
+        setConstant(index, &value, sizeof(value));
+        return index;
+    }
+
+    void addOperation(OperationType type, const std::vector<uint32_t>& inputs, uint32_t output) {
+        for (uint32_t input : inputs) mOperands[input].numberOfConsumers++;
+        mOperations.push_back({.type = type, .inputs = inputs, .outputs = {output}});
+    }
+
+    Model build() {
+        Model model;
+        model.main.operands = mOperands;
+        model.main.operations = mOperations;
+        model.main.inputIndexes = mInputs;
+        model.main.outputIndexes = mOutputs;
+        model.operandValues = mValues;
+        return model;
+    }
+
+private:
+    uint32_t addOperand(OperandType type, const std::vector<uint32_t>& dimensions, float scale,
+                        int32_t zeroPoint) {
+        Operand operand;
+        operand.type = type;
+        operand.dimensions = dimensions;
+        operand.numberOfConsumers = 0;
+        operand.scale = scale;
+        operand.zeroPoint = zeroPoint;
+        operand.lifetime = OperandLifeTime::TEMPORARY_VARIABLE;
+        operand.location = {.poolIndex = 0, .offset = 0, .length = 0};
+        mOperands.push_back(operand);
+        return mOperands.size() - 1;
+    }
+
+    uint32_t addTensor(OperandType type, const std::vector<uint32_t>& dimensions, float scale,
+                       int32_t zeroPoint) {
+        return addOperand(type, dimensions, type == OperandType::TENSOR_QUANT8_ASYMM ? scale : 0.f,
+                          type == OperandType::TENSOR_QUANT8_ASYMM ? zeroPoint : 0);
+    }
+
+    uint32_t addRandomConstant(OperandType type, const std::vector<uint32_t>& dimensions,
+                               float scale, int32_t zeroPoint) {
+        const uint32_t index = type == OperandType::TENSOR_INT32
+                                   ? addOperand(type, dimensions, scale, zeroPoint)
+                                   : addTensor(type, dimensions, scale, zeroPoint);
+        size_t count = 1;
+        for (uint32_t dimension : dimensions) count *= dimension;
+        std::vector<uint8_t> data(count * elementSize(type));
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        for (size_t i = 0; i < count; i++) {
+            const float value = distribution(mRandom);
+            if (type == OperandType::TENSOR_FLOAT32) {
+                std::memcpy(data.data() + i * 4, &value, 4);
+            } else if (type == OperandType::TENSOR_FLOAT16) {
+                const _Float16 half = value;
+                std::memcpy(data.data() + i * 2, &half, 2);
+            } else if (type == OperandType::TENSOR_INT32) {
+                const int32_t bias = static_cast<int32_t>(value * 1024);
+                std::memcpy(data.data() + i * 4, &bias, 4);
+            } else {
+                data[i] = static_cast<uint8_t>(128 + value * 127);
+            }
+        }
+        setConstant(index, data.data(), data.size());
+        return index;
+    }
+
+    void setConstant(uint32_t index, const void* data, size_t length) {
+        // Keep values 4 byte aligned
+        const size_t offset = (mValues.size() + 3) & ~size_t(3);
+        mValues.resize(offset + length);
+        std::memcpy(mValues.data() + offset, data, length);
+        mOperands[index].lifetime = OperandLifeTime::CONSTANT_COPY;
+        mOperands[index].location = {.poolIndex = 0,
+                                     .offset = static_cast<uint32_t>(offset),
+                                     .length = static_cast<uint32_t>(length)};
+    }
+
+    Precision mPrecision;
+    OperandType mTensorType;
+    std::vector<Operand> mOperands;
+    std::vector<Operation> mOperations;
+    std::vector<uint32_t> mInputs;
+    std::vector<uint32_t> mOutputs;
+    std::vector<uint8_t> mValues;
+    std::mt19937 mRandom{42};
+};
+
+// One of the convolution, fully connected and elementwise workloads that dominate real models
+Model buildMicroModel(Precision precision, OperationType type) {
+    MicroModelBuilder builder(precision);
+    if (type == OperationType::CONV_2D) {
+        const uint32_t input = builder.addInput({1, 32, 32, 16});
+        const uint32_t filter = builder.addWeights({16, 3, 3, 16});
+        const uint32_t bias = builder.addBias(16);
+        const uint32_t output = builder.addOutput({1, 32, 32, 16});
+        builder.addOperation(type,
+                             {input, filter, bias, builder.addInt32(ANEURALNETWORKS_PADDING_SAME),
+                              builder.addInt32(1), builder.addInt32(1),
+                              builder.addInt32(ANEURALNETWORKS_FUSED_NONE)},
+                             output);
+    } else if (type == OperationType::FULLY_CONNECTED) {
+        const uint32_t input = builder.addInput({1, 1024});
+        const uint32_t weights = builder.addWeights({256, 1024});
+        const uint32_t bias = builder.addBias(256);
+        const uint32_t output = builder.addOutput({1, 256});
+        builder.addOperation(
+            type, {input, weights, bias, builder.addInt32(ANEURALNETWORKS_FUSED_NONE)}, output);
+    } else {
+        const uint32_t lhs = builder.addInput({1, 64, 64, 16});
+        const uint32_t rhs = builder.addInput({1, 64, 64, 16});
+        const uint32_t output = builder.addOutput({1, 64, 64, 16});
+        builder.addOperation(type, {lhs, rhs, builder.addInt32(ANEURALNETWORKS_FUSED_NONE)},
+                             output);
+    }
+    return builder.build();
+}
+
+// Request with the inputs and outputs of the model laid out in one shared memory pool, filled
+// with random inputs
+struct MicroRequest {
+    Request request;
+    sp<hidl::memory::V1_0::IMemory> memory;
+
+    bool create(const Model& model) {
+        std::vector<RequestArgument> inputs, outputs;
+        uint32_t offset = 0;
+        auto addArgument = [&](uint32_t operandIndex, std::vector<RequestArgument>& arguments) {
+            const auto& operand = model.main.operands[operandIndex];
+            uint32_t length = elementSize(operand.type);
+            for (uint32_t dimension : operand.dimensions) length *= dimension;
+            arguments.push_back({.hasNoValue = false,
+                                 .location = {.poolIndex = 0, .offset = offset, .length = length},
+                                 .dimensions = {}});
+            offset += length;
+        };
+        for (uint32_t index : model.main.inputIndexes) addArgument(index, inputs);
+        for (uint32_t index : model.main.outputIndexes) addArgument(index, outputs);
+
+        hidl_memory pool = nn::allocateSharedMemory(offset);
+        memory = mapMemory(pool);
+        if (memory == nullptr) return false;
+        auto* data = static_cast<uint8_t*>(static_cast<void*>(memory->getPointer()));
+        std::mt19937 random(7);
+        memory->update();
+        for (uint32_t i = 0; i < offset; i++) data[i] = static_cast<uint8_t>(random() & 0x3f);
+        memory->commit();
+
+        request.inputs = inputs;
+        request.outputs = outputs;
+        request.pools = {pool};
+        return true;
+    }
+
+    uint8_t* data() { return static_cast<uint8_t*>(static_cast<void*>(memory->getPointer())); }
+};
+
+// Median duration of the runs after the warmup, zero if any run fails
+template <typename Run>
+uint64_t measure(Run run) {
+    std::vector<uint64_t> durations;
+    for (int i = 0; i < kWarmupRuns + kMeasuredRuns; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!run()) return 0;
+        const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+        if (i >= kWarmupRuns) durations.push_back(duration);
+    }
+    std::nth_element(durations.begin(), durations.begin() + durations.size() / 2,
+                     durations.end());
+    return std::max<uint64_t>(durations[durations.size() / 2], 1);
+}
+
+// Execution time on the device relative to the reference implementation, zero when either
+// can't run the model
+float measureRatio(const Model& model, const CalibrationModelFactory& factory) {
+    MicroRequest request;
+    if (!request.create(model)) return 0.f;
+
+    auto run = factory(model, request.request);
+    if (!run) return 0.f;
+    const uint64_t deviceNs = measure(run);
+
+    const auto referenceRequest = nn::convertToV1_3(request.request);
+    const std::vector<nn::RunTimePoolInfo> modelPools;
+    const std::vector<nn::RunTimePoolInfo> requestPools = {
+        nn::RunTimePoolInfo::createFromExistingBuffer(request.data(),
+                                                      request.request.pools[0].size())};
+    const uint64_t referenceNs = measure([&]() {
+        nn::CpuExecutor executor;
+        return executor.run(model, referenceRequest, modelPools, requestPools) ==
+               ANEURALNETWORKS_NO_ERROR;
+    });
+
+    if (deviceNs == 0 || referenceNs == 0) return 0.f;
+    return std::min(std::max(float(deviceNs) / referenceNs, kMinRatio), kMaxRatio);
+}
+
+// Geometric mean of the ratios of the convolution, fully connected and elementwise workloads
+// of a precision, zero when the device runs none of them
+float measurePrecision(Precision precision, const CalibrationModelFactory& factory) {
+    double logSum = 0;
+    int count = 0;
+    for (auto type : {OperationType::CONV_2D, OperationType::FULLY_CONNECTED, OperationType::ADD}) {
+        const float ratio = measureRatio(buildMicroModel(precision, type), factory);
+        ALOGD("%s %s %s ratio %f", __func__, precisionName(precision), toString(type).c_str(),
+              ratio);
+        if (ratio <= 0.f) continue;
+        logSum += std::log(ratio);
+        count++;
+    }
+    return count ? std::exp(logSum / count) : 0.f;
+}
+
+std::string calibrationHeader(const std::string& deviceName) {
+    const auto* version = InferenceEngine::GetInferenceEngineVersion();
+    return "nnhal-calibration " + std::to_string(kCalibrationVersion) + " " + deviceName + " " +
+           (version ? version->buildNumber : "unknown");
+}
+
+bool loadCalibration(const std::string& path, const std::string& header,
+                     DevicePerformance& performance) {
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line) || line != header) return false;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        float ratio = 0.f;
+        if (!(fields >> name >> ratio)) return false;
+        if (name == precisionName(Precision::FLOAT32)) {
+            performance.float32 = ratio;
+        } else if (name == precisionName(Precision::FLOAT16)) {
+            performance.float16 = ratio;
+        } else if (name == precisionName(Precision::QUANT8)) {
+            performance.quant8 = ratio;
+        }
+    }
+    return true;
+}
+
+void storeCalibration(const std::string& path, const std::string& header,
+                      const DevicePerformance& performance) {
+    // Written aside and renamed so a crash never leaves a truncated file behind
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath);
+        file << header << "\n"
+             << precisionName(Precision::FLOAT32) << " " << performance.float32 << "\n"
+             << precisionName(Precision::FLOAT16) << " " << performance.float16 << "\n"
+             << precisionName(Precision::QUANT8) << " " << performance.quant8 << "\n";
+        if (!file) {
+            ALOGW("%s failed to write %s", __func__, temporaryPath.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        ALOGW("%s failed to rename %s", __func__, temporaryPath.c_str());
+    }
+}
+
+}  // namespace
+
+V1_0::PerformanceInfo DevicePerformance::get(OperandType type) const {
+    float ratio = 0.f;
+    switch (type) {
+        case OperandType::FLOAT32:
+        case OperandType::TENSOR_FLOAT32:
+            ratio = float32;
+            break;
+        case OperandType::FLOAT16:
+        case OperandType::TENSOR_FLOAT16:
+            ratio = float16;
+            break;
+        case OperandType::TENSOR_QUANT8_ASYMM:
+        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
+        case OperandType::TENSOR_QUANT8_SYMM:
+        case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
+            ratio = quant8;
+            break;
+        default:
+            break;
+    }
+    if (ratio <= 0.f) return defaults;
+    return {.execTime = ratio, .powerUsage = ratio * defaults.powerUsage / defaults.execTime};
+}
+
+V1_0::PerformanceInfo DevicePerformance::relaxed() const {
+    return float16 > 0.f ? get(OperandType::TENSOR_FLOAT16) : get(OperandType::TENSOR_FLOAT32);
+}
+
+V1_0::PerformanceInfo DevicePerformance::controlFlow() const {
+    return get(OperandType::TENSOR_FLOAT32);
+}
+
+std::string DevicePerformance::dump() const {
+    std::ostringstream out;
+    out << "float32 " << float32 << ", float16 " << float16 << ", quant8 " << quant8
+        << " (defaults " << defaults.execTime << "/" << defaults.powerUsage << ")";
+    return out.str();
+}
+
+static std::string calibrationPath(const std::string& deviceName) {
+    return std::string(kCalibrationDirectory) + "/calibration_" + deviceName + ".txt";
+}
+
+bool loadDevicePerformance(const std::string& deviceName, DevicePerformance& performance) {
+    // Nothing to measure, the defaults are reported
+    if (!property_get_bool(kCalibrationProperty, true)) return true;
+    const std::string path = calibrationPath(deviceName);
+    if (!loadCalibration(path, calibrationHeader(deviceName), performance)) {
+        performance.float32 = performance.float16 = performance.quant8 = 0.f;
+        return false;
+    }
+    ALOGI("%s loaded %s: %s", __func__, path.c_str(), performance.dump().c_str());
+    return true;
+}
+
+void measureDevicePerformance(const std::string& deviceName,
+                              const CalibrationModelFactory& factory,
+                              DevicePerformance& performance) {
+    const auto start = std::chrono::steady_clock::now();
+    performance.float32 = measurePrecision(Precision::FLOAT32, factory);
+    performance.float16 = measurePrecision(Precision::FLOAT16, factory);
+    performance.quant8 = measurePrecision(Precision::QUANT8, factory);
+    ALOGI("%s measured %s in %lld ms: %s", __func__, deviceName.c_str(),
+          static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count()),
+          performance.dump().c_str());
+    storeCalibration(calibrationPath(deviceName), calibrationHeader(deviceName), performance);
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
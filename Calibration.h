@@ -0,0 +1,56 @@
+#ifndef ANDROID_ML_NN_CALIBRATION_H
+#define ANDROID_ML_NN_CALIBRATION_H
+
+#include <android/hardware/neuralnetworks/1.3/types.h>
+#include <functional>
+#include <string>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Performance of the device relative to the NNAPI reference CPU implementation, which is what
+// the capabilities report. Lower is better, 1.0 is as fast as the reference.
+struct DevicePerformance {
+    // Reported for the operand types that are not measured and when calibration is unavailable.
+    // Power usage can't be measured, it is scaled from the measured execution time by the ratio
+    // of these.
+    V1_0::PerformanceInfo defaults;
+    // Measured execution time ratios per precision, zero when not measured
+    float float32 = 0.f;
+    float float16 = 0.f;
+    float quant8 = 0.f;
+
+    V1_0::PerformanceInfo get(V1_3::OperandType type) const;
+    // For FLOAT32 models allowed to run in FLOAT16
+    V1_0::PerformanceInfo relaxed() const;
+    // For IF and WHILE, which run their bodies the way the FLOAT32 operations are run
+    V1_0::PerformanceInfo controlFlow() const;
+    std::string dump() const;
+};
+
+// Runs one inference on the device, false when it failed
+using CalibrationRun = std::function<bool()>;
+// Compiles a model for the device with its inputs read from the memory of request, returning an
+// empty run when the device can't run it
+using CalibrationModelFactory =
+    std::function<CalibrationRun(const V1_3::Model&, const V1_0::Request&)>;
+
+// Loads the performance of the device from its calibration file. Returns false when it has to be
+// measured, the file being missing or written by another driver or OpenVINO version, in which
+// case performance holds the defaults.
+bool loadDevicePerformance(const std::string& deviceName, DevicePerformance& performance);
+
+// Measures the performance of the device with micro benchmarks against the reference
+// implementation and stores it in the calibration file. Takes seconds.
+void measureDevicePerformance(const std::string& deviceName,
+                              const CalibrationModelFactory& factory,
+                              DevicePerformance& performance);
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_CALIBRATION_H
@@ -0,0 +1,141 @@
+#ifndef ANDROID_ML_NN_CONTENT_HASH_H
+#define ANDROID_ML_NN_CONTENT_HASH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <android/hardware/neuralnetworks/1.3/types.h>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Streaming MurmurHash3 x64 128, fast enough to hash the weights of every prepared model
+class ContentHash {
+public:
+    template <typename T>
+    void update(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+        update(&value, sizeof(value));
+    }
+    template <typename Vector>
+    void updateVector(const Vector& values) {
+        update<uint64_t>(values.size());
+        if (values.size() > 0) update(values.data(), values.size() * sizeof(values[0]));
+    }
+
+    void update(const void* data, size_t length) {
+        auto* bytes = static_cast<const uint8_t*>(data);
+        mLength += length;
+        if (mTailSize > 0) {
+            const size_t count = std::min(length, sizeof(mTail) - mTailSize);
+            std::memcpy(mTail + mTailSize, bytes, count);
+            mTailSize += count;
+            bytes += count;
+            length -= count;
+            if (mTailSize < sizeof(mTail)) return;
+            block(mTail);
+            mTailSize = 0;
+        }
+        for (; length >= sizeof(mTail); bytes += sizeof(mTail), length -= sizeof(mTail)) {
+            block(bytes);
+        }
+        std::memcpy(mTail, bytes, length);
+        mTailSize = length;
+    }
+
+    void finish(uint64_t& low, uint64_t& high) {
+        if (mTailSize > 0) {
+            std::memset(mTail + mTailSize, 0, sizeof(mTail) - mTailSize);
+            block(mTail);
+        }
+        mH1 ^= mLength;
+        mH2 ^= mLength;
+        mH1 += mH2;
+        mH2 += mH1;
+        mH1 = mix(mH1);
+        mH2 = mix(mH2);
+        mH1 += mH2;
+        mH2 += mH1;
+        low = mH1;
+        high = mH2;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t mix(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    void block(const uint8_t* bytes) {
+        static const uint64_t c1 = 0x87c37b91114253d5ULL;
+        static const uint64_t c2 = 0x4cf5ad432745937fULL;
+        uint64_t k1, k2;
+        std::memcpy(&k1, bytes, sizeof(k1));
+        std::memcpy(&k2, bytes + sizeof(k1), sizeof(k2));
+        mH1 ^= rotl(k1 * c1, 31) * c2;
+        mH1 = (rotl(mH1, 27) + mH2) * 5 + 0x52dce729;
+        mH2 ^= rotl(k2 * c2, 33) * c1;
+        mH2 = (rotl(mH2, 31) + mH1) * 5 + 0x38495ab5;
+    }
+
+    uint64_t mH1 = 0;
+    uint64_t mH2 = 0;
+    uint64_t mLength = 0;
+    uint8_t mTail[16];
+    size_t mTailSize = 0;
+};
+
+inline void hashSubgraph(ContentHash& hash, const V1_3::Subgraph& subgraph) {
+    hash.update<uint64_t>(subgraph.operands.size());
+    for (const auto& operand : subgraph.operands) {
+        hash.update(operand.type);
+        hash.updateVector(operand.dimensions);
+        hash.update(operand.scale);
+        hash.update(operand.zeroPoint);
+        hash.update(operand.lifetime);
+        hash.update(operand.location);
+        using Discriminator = V1_2::Operand::ExtraParams::hidl_discriminator;
+        const auto discriminator = operand.extraParams.getDiscriminator();
+        hash.update(discriminator);
+        if (discriminator == Discriminator::channelQuant) {
+            hash.updateVector(operand.extraParams.channelQuant().scales);
+            hash.update(operand.extraParams.channelQuant().channelDim);
+        } else if (discriminator == Discriminator::extension) {
+            hash.updateVector(operand.extraParams.extension());
+        }
+    }
+    hash.update<uint64_t>(subgraph.operations.size());
+    for (const auto& operation : subgraph.operations) {
+        hash.update(operation.type);
+        hash.updateVector(operation.inputs);
+        hash.updateVector(operation.outputs);
+    }
+    hash.updateVector(subgraph.inputIndexes);
+    hash.updateVector(subgraph.outputIndexes);
+}
+
+// Hashes the operands, operations and inline constants of a model. The contents of its memory
+// pools are left to callers, which map them.
+inline void hashModel(ContentHash& hash, const V1_3::Model& model) {
+    hashSubgraph(hash, model.main);
+    hash.update<uint64_t>(model.referenced.size());
+    for (const auto& subgraph : model.referenced) hashSubgraph(hash, subgraph);
+    hash.updateVector(model.operandValues);
+    hash.update(model.relaxComputationFloat32toFloat16);
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_CONTENT_HASH_H
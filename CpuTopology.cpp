@@ -0,0 +1,207 @@
+#include "CpuTopology.h"
+
+#include <android/log.h>
+#include <ie_plugin_config.hpp>
+#include <log/log.h>
+#include <sched.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#undef LOG_TAG
+#define LOG_TAG "CpuTopology"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+static const char* kSysfsCpu = "/sys/devices/system/cpu/";
+// Lists the efficient cores of hybrid Intel hosts, missing elsewhere
+static const char* kEfficientCpus = "/sys/devices/cpu_atom/cpus";
+
+// Parses a sysfs CPU list such as "0-3,8,10-11"
+static std::vector<int> readCpuList(const std::string& path) {
+    std::vector<int> cpus;
+    std::ifstream file(path);
+    std::string list;
+    if (!std::getline(file, list)) return cpus;
+    std::istringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        int first = 0, last = 0;
+        const int parsed = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (parsed < 1) continue;
+        if (parsed == 1) last = first;
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+static int readInt(const std::string& path, int defaultValue) {
+    std::ifstream file(path);
+    int value;
+    return file >> value ? value : defaultValue;
+}
+
+CpuTopology& CpuTopology::get() {
+    static CpuTopology sTopology;
+    return sTopology;
+}
+
+CpuTopology::CpuTopology() {
+    auto online = readCpuList(std::string(kSysfsCpu) + "online");
+    if (online.empty()) {
+        ALOGE("%s Failed to read the online CPUs, assuming one core per CPU", __func__);
+        for (unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++) {
+            online.push_back(cpu);
+        }
+    }
+    const auto efficientList = readCpuList(kEfficientCpus);
+    const std::set<int> efficient(efficientList.begin(), efficientList.end());
+
+    std::set<int> sockets;
+    // Core ids are only unique within their socket
+    std::map<std::pair<int, int>, size_t> coreIndexes;
+    for (int cpu : online) {
+        const std::string topology = kSysfsCpu + ("cpu" + std::to_string(cpu)) + "/topology/";
+        const int socket = std::max(readInt(topology + "physical_package_id", 0), 0);
+        const int coreId = readInt(topology + "core_id", cpu);
+        sockets.insert(socket);
+        auto inserted = coreIndexes.emplace(std::make_pair(socket, coreId), mCores.size());
+        if (inserted.second) {
+            mCores.push_back({socket, {cpu}, efficient.count(cpu) > 0});
+        } else {
+            mCores[inserted.first->second].cpus.push_back(cpu);
+        }
+    }
+    mSockets = static_cast<int>(sockets.size());
+    const size_t efficientCores = std::count_if(
+        mCores.begin(), mCores.end(), [](const Core& core) { return core.efficient; });
+    mHybrid = efficientCores > 0 && efficientCores < mCores.size();
+    ALOGD("%s %d sockets, %zu cores, %zu CPUs%s", __func__, mSockets, mCores.size(), online.size(),
+          mHybrid ? ", hybrid" : "");
+}
+
+void CpuTopology::setOverrides(int32_t threads, int32_t streams, const std::string& bind) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mThreadsOverride = threads;
+    mStreamsOverride = streams;
+    mBindOverride = bind;
+}
+
+std::vector<const CpuTopology::Core*> CpuTopology::performanceCores(int socket) const {
+    std::vector<const Core*> cores;
+    for (const auto& core : mCores) {
+        if (core.socket == socket && !(mHybrid && core.efficient)) cores.push_back(&core);
+    }
+    return cores;
+}
+
+CpuStreamConfig CpuTopology::streamConfig(V1_1::ExecutionPreference preference) {
+    CpuStreamConfig config;
+    // The socket of the first CPU, where the plugin binds its first stream
+    const int firstSocket = mCores.empty() ? 0 : mCores.front().socket;
+    switch (preference) {
+        case V1_1::ExecutionPreference::LOW_POWER:
+            config.streams = 1;
+            // Binding would place the threads on the first cores, which are performance cores
+            config.bind = CONFIG_VALUE(NO);
+            if (mHybrid) {
+                for (const auto& core : mCores) {
+                    if (!core.efficient) continue;
+                    config.threads++;
+                    config.cpus.insert(config.cpus.end(), core.cpus.begin(), core.cpus.end());
+                }
+            } else {
+                config.threads = static_cast<int32_t>(performanceCores(firstSocket).size() / 2);
+            }
+            break;
+        case V1_1::ExecutionPreference::SUSTAINED_SPEED:
+            // A stream per socket, each with the memory of its own node
+            config.streams = mSockets;
+            config.bind = CONFIG_VALUE(NUMA);
+            for (const auto& core : mCores) {
+                if (!(mHybrid && core.efficient)) config.threads++;
+            }
+            break;
+        case V1_1::ExecutionPreference::FAST_SINGLE_ANSWER:
+        default:
+            // One thread per physical core of one socket, SMT siblings share the execution units
+            config.streams = 1;
+            config.bind = CONFIG_VALUE(YES);
+            for (const auto* core : performanceCores(firstSocket)) {
+                config.threads++;
+                config.cpus.insert(config.cpus.end(), core->cpus.begin(), core->cpus.end());
+            }
+            break;
+    }
+    config.threads = std::max(config.threads, 1);
+    config.streams = std::max(config.streams, 1);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mThreadsOverride > 0) config.threads = mThreadsOverride;
+    if (mStreamsOverride > 0) config.streams = mStreamsOverride;
+    if (!mBindOverride.empty() && mBindOverride != config.bind) {
+        config.bind = mBindOverride;
+        // The streams no longer run where they were derived to
+        config.cpus.clear();
+    }
+    return config;
+}
+
+void CpuTopology::pinThread(V1_1::ExecutionPreference preference) {
+    const auto cpus = streamConfig(preference).cpus;
+    if (cpus.empty()) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        ALOGE("%s Failed to pin the thread: %s", __func__, strerror(errno));
+    }
+}
+
+std::string CpuTopology::dump(bool json) {
+    size_t efficient = std::count_if(mCores.begin(), mCores.end(),
+                                     [](const Core& core) { return core.efficient; });
+    size_t cpus = 0;
+    for (const auto& core : mCores) cpus += core.cpus.size();
+    const std::pair<const char*, V1_1::ExecutionPreference> preferences[] = {
+        {"fastSingleAnswer", V1_1::ExecutionPreference::FAST_SINGLE_ANSWER},
+        {"sustainedSpeed", V1_1::ExecutionPreference::SUSTAINED_SPEED},
+        {"lowPower", V1_1::ExecutionPreference::LOW_POWER}};
+
+    std::ostringstream out;
+    if (json) {
+        out << "{\"sockets\": " << mSockets << ", \"cores\": " << mCores.size()
+            << ", \"efficientCores\": " << efficient << ", \"cpus\": " << cpus;
+        for (const auto& preference : preferences) {
+            const auto config = streamConfig(preference.second);
+            out << ", \"" << preference.first << "\": {\"threads\": " << config.threads
+                << ", \"streams\": " << config.streams << ", \"bind\": \"" << config.bind
+                << "\", \"pinnedCpus\": " << config.cpus.size() << "}";
+        }
+        out << "}";
+    } else {
+        out << "cpu topology sockets " << mSockets << " cores " << mCores.size() << " efficient "
+            << efficient << " cpus " << cpus << "\n";
+        for (const auto& preference : preferences) {
+            const auto config = streamConfig(preference.second);
+            out << "  " << preference.first << " threads " << config.threads << " streams "
+                << config.streams << " bind " << config.bind << " pinned cpus "
+                << config.cpus.size() << "\n";
+        }
+    }
+    return out.str();
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
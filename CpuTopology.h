@@ -0,0 +1,70 @@
+#ifndef ANDROID_ML_NN_CPU_TOPOLOGY_H
+#define ANDROID_ML_NN_CPU_TOPOLOGY_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Driver.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// How the CPU plugin runs a network, CPU_THREADS_NUM, CPU_THROUGHPUT_STREAMS and CPU_BIND_THREAD
+struct CpuStreamConfig {
+    int32_t threads = 0;
+    int32_t streams = 0;
+    // YES, NUMA or NO
+    std::string bind;
+    // Where driver threads serving the streams are pinned, empty when the streams move around
+    std::vector<int> cpus;
+};
+
+// Sockets, cores, SMT siblings and hybrid performance and efficient cores of the host, read from
+// sysfs once. Networks are configured from it per execution preference instead of the generic
+// defaults of the plugin, so that their threads neither migrate across sockets nor mix core types.
+class CpuTopology {
+public:
+    static CpuTopology& get();
+
+    // Replaces the values derived from the topology when set, for the device of the service
+    void setOverrides(int32_t threads, int32_t streams, const std::string& bind);
+
+    CpuStreamConfig streamConfig(V1_1::ExecutionPreference preference);
+    // Pins the calling thread next to the streams of networks prepared with preference
+    void pinThread(V1_1::ExecutionPreference preference);
+
+    std::string dump(bool json);
+
+private:
+    CpuTopology();
+
+    struct Core {
+        int socket;
+        // Logical CPUs of the core, more than one with SMT
+        std::vector<int> cpus;
+        bool efficient;
+    };
+
+    // Physical cores of socket, performance cores only on hybrid hosts
+    std::vector<const Core*> performanceCores(int socket) const;
+
+    std::vector<Core> mCores;
+    int mSockets = 1;
+    bool mHybrid = false;
+
+    std::mutex mMutex;
+    int32_t mThreadsOverride = 0;
+    int32_t mStreamsOverride = 0;
+    std::string mBindOverride;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_CPU_TOPOLOGY_H
@@ -17,13 +17,27 @@
 #include "Driver.h"
 #include <string>
 
+#include <android-base/file.h>
 #include <android-base/logging.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <thread>
 #include "BasePreparedModel.h"
+#include "BlobAllocator.h"
+#include "Calibration.h"
+#include "CpuTopology.h"
 #include "CpuPreparedModel.h"
 #include "GnaPreparedModel.h"
+#include "IENetwork.h"
 #include "ModelManager.h"
+#include "NetworkCache.h"
+#include "NgraphNetworkCreator.hpp"
+#include "ResidencyManager.h"
+#include "SupportChecker.hpp"
+#include "Tracer.h"
 #include "ValidateHal.h"
+#include "WeightStore.hpp"
 
 #undef LOG_TAG
 #define LOG_TAG "Driver"
@@ -35,25 +49,6 @@ namespace nnhal {
 
 using namespace android::nn;
 
-hidl_vec<V1_2::Capabilities::OperandPerformance> nonExtensionOperandPerformanceV1_2(
-    V1_0::PerformanceInfo perf) {
-    using OpPerf = V1_2::Capabilities::OperandPerformance;
-
-    // Note: range presents enumerators in declaration order, not in numerical order.
-    static constexpr ::android::hardware::hidl_enum_range<V1_2::OperandType> kOperandTypeRange;
-
-    hidl_vec<OpPerf> ret(kOperandTypeRange.end() - kOperandTypeRange.begin());
-
-    std::transform(kOperandTypeRange.begin(), kOperandTypeRange.end(), ret.begin(),
-                   [perf](V1_2::OperandType type) {
-                       return V1_2::Capabilities::OperandPerformance{(type), perf};
-                   });
-    std::sort(ret.begin(), ret.end(),
-              [](const OpPerf& a, const OpPerf& b) { return a.type < b.type; });
-
-    return ret;
-}
-
 hidl_vec<Capabilities::OperandPerformance> nonExtensionOperandPerformance(
     V1_0::PerformanceInfo perf) {
     using OpPerf = Capabilities::OperandPerformance;
@@ -76,6 +71,21 @@ hidl_vec<Capabilities::OperandPerformance> nonExtensionOperandPerformance(
     return ret1;
 }
 
+static const char* deviceName(IntelDeviceType deviceType) {
+    switch (deviceType) {
+        case IntelDeviceType::CPU:
+            return "CPU";
+        case IntelDeviceType::GPU:
+            return "GPU";
+        case IntelDeviceType::GNA:
+            return "GNA";
+        case IntelDeviceType::VPU:
+            return "VPU";
+        default:
+            return "OTHER";
+    }
+}
+
 static sp<BasePreparedModel> ModelFactory(IntelDeviceType deviceType, const Model& model) {
     sp<BasePreparedModel> driverPreparedModel = NULL;
 
@@ -126,12 +136,13 @@ Return<ErrorStatus> Driver::prepareModel(const V1_0_Model& model,
     }
     for (auto opn : model.operations) dumpOperation(opn);
 
-    if (!driverPreparedModel->initialize()) {
+    if (!initializePreparedModel(driverPreparedModel)) {
         ALOGE("failed to initialize preparedmodel");
         callback->notify(ErrorStatus::INVALID_ARGUMENT, nullptr);
         return ErrorStatus::NONE;
     }
 
+    registerPreparedModel(driverPreparedModel);
     callback->notify(ErrorStatus::NONE, driverPreparedModel);
     ALOGV("Exiting %s", __func__);
     return ErrorStatus::NONE;
@@ -181,12 +192,13 @@ Return<ErrorStatus> Driver::prepareModel_1_1(const V1_1_Model& model,
     }
     for (auto opn : model.operations) dumpOperation(opn);
 
-    if (!driverPreparedModel->initialize()) {
+    if (!initializePreparedModel(driverPreparedModel, preference)) {
         ALOGE("failed to initialize preparedmodel");
         callback->notify(ErrorStatus::INVALID_ARGUMENT, nullptr);
         return ErrorStatus::NONE;
     }
 
+    registerPreparedModel(driverPreparedModel);
     callback->notify(ErrorStatus::NONE, driverPreparedModel);
     ALOGV("Exiting %s", __func__);
     return ErrorStatus::NONE;
@@ -195,49 +207,10 @@ Return<ErrorStatus> Driver::prepareModel_1_1(const V1_1_Model& model,
 // For HAL-1.2 version
 Return<void> Driver::getCapabilities_1_2(getCapabilities_1_2_cb cb) {
     ALOGV("Entering %s", __func__);
-    if (mDeviceType == IntelDeviceType::CPU) {
-        ALOGI("CPU driver getCapabilities()");
-        // Setting operandPerformance value to base value for all operand types
-        V1_2::Capabilities capabilities = {
-            .relaxedFloat32toFloat16PerformanceScalar = {.execTime = 0.9f, .powerUsage = 0.9f},
-            .relaxedFloat32toFloat16PerformanceTensor = {.execTime = 0.9f, .powerUsage = 0.9f},
-            .operandPerformance = nonExtensionOperandPerformanceV1_2({0.9f, 0.9f})};
-
-        ALOGI("CPU MKLDNN driver Capabilities .execTime = 0.9f, .powerUsage = 0.9f");
-        cb(ErrorStatus::NONE, capabilities);
-    } else if (mDeviceType == IntelDeviceType::GPU) {
-        ALOGI("GPU driver getCapabilities()");
-        V1_2::Capabilities capabilities = {
-            .relaxedFloat32toFloat16PerformanceScalar = {.execTime = 0.95f, .powerUsage = 0.85f},
-            .relaxedFloat32toFloat16PerformanceTensor = {.execTime = 0.95f, .powerUsage = 0.85f},
-            .operandPerformance = nonExtensionOperandPerformanceV1_2({0.95f, 0.95f})};
-
-        ALOGI("GPU clDNN driver Capabilities .execTime = 0.95f, .powerUsage = 0.85f");
-        cb(ErrorStatus::NONE, capabilities);
-    } else if (mDeviceType == IntelDeviceType::GNA) {
-        ALOGI("GPU driver getCapabilities()");
-        V1_2::Capabilities capabilities = {
-            .relaxedFloat32toFloat16PerformanceScalar = {.execTime = 0.8f, .powerUsage = 0.8f},
-            .relaxedFloat32toFloat16PerformanceTensor = {.execTime = 0.8f, .powerUsage = 0.8f},
-            .operandPerformance = nonExtensionOperandPerformanceV1_2({0.8f, 0.8f})};
-
-        ALOGI("GPU clDNN driver Capabilities .execTime = 0.95f, .powerUsage = 0.85f");
-        cb(ErrorStatus::NONE, capabilities);
-    } else if (mDeviceType == IntelDeviceType::VPU) {
-        ALOGI("Myriad driver getCapabilities()");
-        V1_2::Capabilities capabilities = {
-            .relaxedFloat32toFloat16PerformanceScalar = {.execTime = 1.1f, .powerUsage = 1.1f},
-            .relaxedFloat32toFloat16PerformanceTensor = {.execTime = 1.1f, .powerUsage = 1.1f},
-            .operandPerformance = nonExtensionOperandPerformanceV1_2({1.1f, 1.1f})};
-
-        ALOGI("Driver Capabilities .execTime = 1.1f, .powerUsage = 1.1f");
-        cb(ErrorStatus::NONE, capabilities);
-    } else {
-        V1_2::Capabilities capabilities;
-        cb(ErrorStatus::DEVICE_UNAVAILABLE, capabilities);
-    }
-    ALOGV("Exiting %s", __func__);
-    return Void();
+    return getCapabilities_1_3(
+        [&](V1_3::ErrorStatus error, const V1_3::Capabilities& capabilities) {
+            cb(convertToV1_0(error), convertToV1_2(capabilities));
+        });
 }
 
 Return<void> Driver::getSupportedOperations_1_2(const V1_2_Model& model,
@@ -253,9 +226,7 @@ Return<void> Driver::getSupportedOperations_1_2(const V1_2_Model& model,
         return Void();
     }
 
-    auto modelInfo = std::make_shared<NnapiModelInfo>(convertToV1_3(model));
-    NgraphNetworkCreator ngraphCreatorInst(modelInfo, mDeviceType);
-    ngraphCreatorInst.getSupportedOperations(supported);
+    supported = SupportChecker::get().getSupportedOperations(convertToV1_3(model), mDeviceType);
 
     cb(ErrorStatus::NONE, supported);
     ALOGV("Exiting %s", __func__);
@@ -286,12 +257,13 @@ Return<ErrorStatus> Driver::prepareModel_1_2(const V1_2_Model& model,
     }
     for (auto opn : model.operations) dumpOperation(opn);
 
-    if (!driverPreparedModel->initialize()) {
+    if (!initializePreparedModel(driverPreparedModel, preference)) {
         ALOGE("failed to initialize preparedmodel");
         callback->notify(ErrorStatus::INVALID_ARGUMENT, nullptr);
         return ErrorStatus::NONE;
     }
 
+    registerPreparedModel(driverPreparedModel);
     callback->notify(ErrorStatus::NONE, driverPreparedModel);
     ALOGV("Exiting %s", __func__);
     return ErrorStatus::NONE;
@@ -315,55 +287,23 @@ Return<ErrorStatus> Driver::prepareModelFromCache(
 // For HAL-1.3 version
 Return<void> Driver::getCapabilities_1_3(getCapabilities_1_3_cb cb) {
     ALOGV("Entering %s", __func__);
-    if (mDeviceType == IntelDeviceType::CPU) {
-        ALOGI("CPU driver getCapabilities()");
-        // Setting operandPerformance value to base value for all operand types
-        Capabilities capabilities = {
-            .relaxedFloat32toFloat16PerformanceScalar = {.execTime = 0.9f, .powerUsage = 0.9f},
-            .relaxedFloat32toFloat16PerformanceTensor = {.execTime = 0.9f, .powerUsage = 0.9f},
-            .operandPerformance = nonExtensionOperandPerformance({0.9f, 0.9f}),
-            .ifPerformance = {.execTime = 0.9f, .powerUsage = 0.9f},
-            .whilePerformance = {.execTime = 0.9f, .powerUsage = 0.9f}};
-
-        ALOGI("CPU MKLDNN driver Capabilities .execTime = 0.9f, .powerUsage = 0.9f");
-        cb(V1_3::ErrorStatus::NONE, capabilities);
-    } else if (mDeviceType == IntelDeviceType::GPU) {
-        ALOGI("GPU driver getCapabilities()");
-        V1_3::Capabilities capabilities = {
-            .relaxedFloat32toFloat16PerformanceScalar = {.execTime = 0.95f, .powerUsage = 0.85f},
-            .relaxedFloat32toFloat16PerformanceTensor = {.execTime = 0.95f, .powerUsage = 0.85f},
-            .operandPerformance = nonExtensionOperandPerformance({0.95f, 0.95f}),
-            .ifPerformance = {.execTime = 0.95f, .powerUsage = 0.85f},
-            .whilePerformance = {.execTime = 0.95f, .powerUsage = 0.85f}};
-
-        ALOGI("GPU clDNN driver Capabilities .execTime = 0.95f, .powerUsage = 0.85f");
-        cb(V1_3::ErrorStatus::NONE, capabilities);
-    } else if (mDeviceType == IntelDeviceType::GNA) {
-        ALOGI("GNA driver getCapabilities()");
-        Capabilities capabilities = {
-            .relaxedFloat32toFloat16PerformanceScalar = {.execTime = 0.8f, .powerUsage = 0.8f},
-            .relaxedFloat32toFloat16PerformanceTensor = {.execTime = 0.8f, .powerUsage = 0.8f},
-            .operandPerformance = nonExtensionOperandPerformance({0.8f, 0.8f}),
-            .ifPerformance = {.execTime = 0.8f, .powerUsage = 0.8f},
-            .whilePerformance = {.execTime = 0.8f, .powerUsage = 0.8f}};
-
-        ALOGI("GNA driver Capabilities .execTime = 0.95f, .powerUsage = 0.85f");
-        cb(V1_3::ErrorStatus::NONE, capabilities);
-    } else if (mDeviceType == IntelDeviceType::VPU) {
-        ALOGI("Driver getCapabilities()");
-        Capabilities capabilities = {
-            .relaxedFloat32toFloat16PerformanceScalar = {.execTime = 1.1f, .powerUsage = 1.1f},
-            .relaxedFloat32toFloat16PerformanceTensor = {.execTime = 1.1f, .powerUsage = 1.1f},
-            .operandPerformance = nonExtensionOperandPerformance({1.1f, 1.1f}),
-            .ifPerformance = {.execTime = 1.1f, .powerUsage = 1.1f},
-            .whilePerformance = {.execTime = 1.1f, .powerUsage = 1.1f}};
-
-        ALOGI("Driver Capabilities .execTime = 1.1f, .powerUsage = 1.1f");
-        cb(V1_3::ErrorStatus::NONE, capabilities);
-    } else {
+    if (mDeviceType == IntelDeviceType::OTHER) {
         Capabilities capabilities;
         cb(V1_3::ErrorStatus::DEVICE_UNAVAILABLE, capabilities);
+        return Void();
     }
+
+    const DevicePerformance performance = getDevicePerformance();
+    auto operandPerformance = nonExtensionOperandPerformance(performance.defaults);
+    for (auto& entry : operandPerformance) entry.info = performance.get(entry.type);
+    Capabilities capabilities = {.relaxedFloat32toFloat16PerformanceScalar = performance.relaxed(),
+                                 .relaxedFloat32toFloat16PerformanceTensor = performance.relaxed(),
+                                 .operandPerformance = operandPerformance,
+                                 .ifPerformance = performance.controlFlow(),
+                                 .whilePerformance = performance.controlFlow()};
+
+    ALOGI("%s driver capabilities %s", deviceName(mDeviceType), performance.dump().c_str());
+    cb(V1_3::ErrorStatus::NONE, capabilities);
     ALOGV("Exiting %s", __func__);
     return Void();
 }
@@ -381,9 +321,7 @@ Return<void> Driver::getSupportedOperations_1_3(const Model& model,
         return Void();
     }
 
-    auto modelInfo = std::make_shared<NnapiModelInfo>(model);
-    NgraphNetworkCreator ngraphCreatorInst(modelInfo, mDeviceType);
-    ngraphCreatorInst.getSupportedOperations(supported);
+    supported = SupportChecker::get().getSupportedOperations(model, mDeviceType);
 
     cb(V1_3::ErrorStatus::NONE, supported);
     ALOGV("Exiting %s", __func__);
@@ -412,11 +350,12 @@ Return<V1_3::ErrorStatus> Driver::prepareModel_1_3(
 
     // TODO: make asynchronous later
     sp<BasePreparedModel> driverPreparedModel = ModelFactory(mDeviceType, model);
-    if (!driverPreparedModel->initialize()) {
+    if (!initializePreparedModel(driverPreparedModel, preference)) {
         ALOGI("Failed to initialize prepared model");
         cb->notify_1_3(convertToV1_3(ErrorStatus::INVALID_ARGUMENT), nullptr);
         return V1_3::ErrorStatus::NONE;
     }
+    registerPreparedModel(driverPreparedModel);
     cb->notify_1_3((V1_3::ErrorStatus::NONE), driverPreparedModel);
     ALOGV("Exiting %s", __func__);
 
@@ -453,6 +392,190 @@ Return<void> Driver::allocate(const V1_3::BufferDesc&, const hidl_vec<sp<V1_3::I
     return Void();
 }
 
+// Reported when calibration is disabled, and for the operand types calibration doesn't measure
+static V1_0::PerformanceInfo defaultPerformance(IntelDeviceType deviceType) {
+    switch (deviceType) {
+        case IntelDeviceType::CPU:
+            return {.execTime = 0.9f, .powerUsage = 0.9f};
+        case IntelDeviceType::GPU:
+            return {.execTime = 0.95f, .powerUsage = 0.85f};
+        case IntelDeviceType::GNA:
+            return {.execTime = 0.8f, .powerUsage = 0.8f};
+        default:
+            return {.execTime = 1.1f, .powerUsage = 1.1f};
+    }
+}
+
+// Micro models are compiled straight on the plugin. Prepared models would go through the network
+// cache and the memory budget, and capture or profile the calibration runs when enabled.
+static CalibrationRun compileForCalibration(IntelDeviceType deviceType, const Model& model,
+                                            const Request& request) {
+    const auto supported = SupportChecker::get().getSupportedOperations(model, deviceType);
+    if (std::find(supported.begin(), supported.end(), false) != supported.end()) return nullptr;
+    auto modelInfo = std::make_shared<NnapiModelInfo>(model);
+    if (!modelInfo->initRuntimeInfo()) return nullptr;
+
+    std::shared_ptr<IENetwork> plugin;
+    try {
+        std::shared_ptr<ngraph::Function> function;
+        std::vector<std::string> inputNames;
+        {
+            NgraphNetworkCreator creator(modelInfo, deviceType);
+            if (!creator.validateOperations()) return nullptr;
+            function = creator.generateGraph();
+            if (function == nullptr) return nullptr;
+            for (auto index : modelInfo->getModelInputIndexes())
+                inputNames.push_back(creator.getNodeName(index));
+        }
+        plugin = std::make_shared<IENetwork>(
+            std::make_shared<InferenceEngine::CNNNetwork>(function));
+        if (!plugin->loadNetwork()) return nullptr;
+
+        // The inputs are set once, every run reads the same values
+        if (modelInfo->setRunTimePoolInfosFromHidlMemories(request.pools) != ErrorStatus::NONE)
+            return nullptr;
+        for (size_t i = 0; i < inputNames.size(); i++) {
+            uint32_t length = 0;
+            void* srcPtr = modelInfo->getBlobFromMemoryPoolIn(request, i, length);
+            auto blob = plugin->getBlob(inputNames[i]);
+            std::memcpy(blob->buffer().as<uint8_t*>(), srcPtr,
+                        std::min<size_t>(length, blob->byteSize()));
+        }
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+        return nullptr;
+    }
+    return [plugin]() {
+        try {
+            plugin->infer();
+            return true;
+        } catch (const std::exception& ex) {
+            ALOGE("%s Exception !!! %s", __func__, ex.what());
+            return false;
+        }
+    };
+}
+
+void Driver::startCalibration() {
+    std::call_once(mCalibrationOnce, [this]() {
+        DevicePerformance performance;
+        performance.defaults = defaultPerformance(mDeviceType);
+        const bool loaded = loadDevicePerformance(deviceName(mDeviceType), performance);
+        {
+            std::lock_guard<std::mutex> lock(mPerformanceMutex);
+            mPerformance = performance;
+        }
+        if (loaded) return;
+
+        // Takes seconds, capabilities report the defaults meanwhile. The thread holds a reference
+        // to the driver, which outlives it in the service anyway.
+        sp<Driver> driver = this;
+        std::thread([driver, performance]() mutable {
+            const auto deviceType = driver->mDeviceType;
+            measureDevicePerformance(deviceName(deviceType),
+                                     [deviceType](const Model& model, const Request& request) {
+                                         return compileForCalibration(deviceType, model, request);
+                                     },
+                                     performance);
+            std::lock_guard<std::mutex> lock(driver->mPerformanceMutex);
+            driver->mPerformance = performance;
+        }).detach();
+    });
+}
+
+DevicePerformance Driver::getDevicePerformance() {
+    startCalibration();
+    std::lock_guard<std::mutex> lock(mPerformanceMutex);
+    return mPerformance;
+}
+
+bool Driver::initializePreparedModel(const sp<BasePreparedModel>& preparedModel,
+                                     V1_1::ExecutionPreference preference) {
+    preparedModel->setExecutionPreference(preference);
+    const auto start = std::chrono::steady_clock::now();
+    const bool initialized = preparedModel->initialize();
+    mMetrics.compileLatency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                                       std::chrono::steady_clock::now() - start)
+                                       .count());
+    mMetrics.compilations++;
+    if (!initialized) mMetrics.compilationFailures++;
+    return initialized;
+}
+
+void Driver::registerPreparedModel(const sp<BasePreparedModel>& preparedModel) {
+    std::lock_guard<std::mutex> lock(mPreparedModelsMutex);
+    // Drop the entries of prepared models the clients released
+    mPreparedModels.erase(std::remove_if(mPreparedModels.begin(), mPreparedModels.end(),
+                                         [](const wp<BasePreparedModel>& entry) {
+                                             return entry.promote() == nullptr;
+                                         }),
+                          mPreparedModels.end());
+    mPreparedModels.push_back(preparedModel);
+}
+
+// lshal debug <service> [--json] dumps the driver, network cache, memory budget, weight store and
+// support cache metrics, the CPU topology, the blob arena and the metrics and per operation
+// profiles of the live prepared models, lshal debug <service> --trace the recorded execution
+// stages in Chrome trace format
+Return<void> Driver::debug(const hidl_handle& fd, const hidl_vec<hidl_string>& options) {
+    ALOGV("Entering %s", __func__);
+    if (fd.getNativeHandle() == nullptr || fd->numFds < 1) {
+        ALOGE("%s Invalid file descriptor", __func__);
+        return Void();
+    }
+    auto hasOption = [&options](const char* name) {
+        return std::any_of(options.begin(), options.end(),
+                           [name](const hidl_string& option) { return option == name; });
+    };
+    if (hasOption("--trace")) {
+        if (!android::base::WriteStringToFd(Tracer::exportChromeJson(), fd->data[0])) {
+            ALOGE("%s Failed to write the trace", __func__);
+        }
+        return Void();
+    }
+    const bool json = hasOption("--json");
+
+    std::vector<sp<BasePreparedModel>> preparedModels;
+    {
+        std::lock_guard<std::mutex> lock(mPreparedModelsMutex);
+        for (const auto& entry : mPreparedModels) {
+            auto preparedModel = entry.promote();
+            if (preparedModel != nullptr) preparedModels.push_back(preparedModel);
+        }
+    }
+
+    std::string dump = json ? "{\"driver\": " + mMetrics.dump(true) +
+                                  ", \"networkCache\": " + NetworkCache::get().dump(true) +
+                                  ", \"memoryBudget\": " + ResidencyManager::get().dump(true) +
+                                  ", \"weightStore\": " + WeightStore::get().dump(true) +
+                                  ", \"supportCache\": " + SupportChecker::get().dump(true) +
+                                  ", \"cpuTopology\": " + CpuTopology::get().dump(true) +
+                                  ", \"blobArena\": " + BlobAllocator::get()->dump(true) +
+                                  ", \"preparedModels\": ["
+                            : "driver: " + mMetrics.dump(false) + NetworkCache::get().dump(false) +
+                                  ResidencyManager::get().dump(false) +
+                                  WeightStore::get().dump(false) +
+                                  SupportChecker::get().dump(false) +
+                                  CpuTopology::get().dump(false) +
+                                  BlobAllocator::get()->dump(false);
+    for (size_t i = 0; i < preparedModels.size(); i++) {
+        if (json) {
+            dump += std::string(i ? ", " : "") +
+                    "{\"metrics\": " + preparedModels[i]->getMetrics().dump(true) +
+                    ", \"profile\": " + preparedModels[i]->dumpProfile(true) + "}";
+        } else {
+            dump += "prepared model " + std::to_string(i) + ": " +
+                    preparedModels[i]->getMetrics().dump(false) +
+                    preparedModels[i]->dumpProfile(false);
+        }
+    }
+    if (json) dump += "]}\n";
+    if (!android::base::WriteStringToFd(dump, fd->data[0])) {
+        ALOGE("%s Failed to write the dump", __func__);
+    }
+    return Void();
+}
+
 Return<DeviceStatus> Driver::getStatus() {
     ALOGI("DeviceStatus::AVAILABLE");
     return DeviceStatus::AVAILABLE;
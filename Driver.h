@@ -35,7 +35,11 @@
 #include <android/hardware/neuralnetworks/1.3/IPreparedModelCallback.h>
 #include <android/hardware/neuralnetworks/1.3/types.h>
 
+#include <mutex>
 #include <string>
+#include <vector>
+#include "Calibration.h"
+#include "Metrics.h"
 #include "Utils.h"
 
 namespace android {
@@ -81,6 +85,8 @@ using Capabilities = ::android::hardware::neuralnetworks::V1_3::Capabilities;
 using ::android::hardware::MQDescriptorSync;
 using HidlToken = android::hardware::hidl_array<uint8_t, 32>;
 
+class BasePreparedModel;
+
 // Base class used to create vpu drivers for the NN HAL.  This class
 // provides some implementation of the more common functions.
 //
@@ -146,8 +152,30 @@ public:
     Return<void> getSupportedExtensions(getSupportedExtensions_cb) override;
     Return<void> getNumberOfCacheFilesNeeded(getNumberOfCacheFilesNeeded_cb cb) override;
 
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& options) override;
+
+    const DriverMetrics& getMetrics() const { return mMetrics; }
+    // Loads the calibration of the device, or measures it on a background thread when there is
+    // none. Called when the service starts, and on first use otherwise.
+    void startCalibration();
+
 protected:
+    // Initializes a prepared model, counting the compilation and its latency
+    bool initializePreparedModel(const sp<BasePreparedModel>& preparedModel,
+                                 V1_1::ExecutionPreference preference =
+                                     V1_1::ExecutionPreference::FAST_SINGLE_ANSWER);
+    // The defaults until a calibration running in the background completes
+    DevicePerformance getDevicePerformance();
+    void registerPreparedModel(const sp<BasePreparedModel>& preparedModel);
+
     IntelDeviceType mDeviceType;
+    DriverMetrics mMetrics;
+    std::once_flag mCalibrationOnce;
+    std::mutex mPerformanceMutex;
+    DevicePerformance mPerformance;
+    // Prepared models handed out to clients, for debug dumps
+    std::mutex mPreparedModelsMutex;
+    std::vector<wp<BasePreparedModel>> mPreparedModels;
 };
 
 }  // namespace nnhal
@@ -0,0 +1,90 @@
+#include "ExecutionGate.h"
+
+#include <thread>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+void ExecutionGate::lock() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWaiters++;
+    mCondition.wait(lock, [this] { return !mHeld; });
+    mWaiters--;
+    mHeld = true;
+}
+
+void ExecutionGate::unlock() {
+    auto next = release();
+    // A blocking execution returns to its caller right away
+    if (next) ExecutionDispatcher::get().post(std::move(next));
+}
+
+void ExecutionGate::async(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Tasks queued behind blocked executions keep their order
+        if (mHeld || !mPending.empty()) {
+            mPending.push_back(std::move(task));
+            return;
+        }
+        mHeld = true;
+    }
+    task();
+}
+
+std::function<void()> ExecutionGate::release() {
+    std::function<void()> next;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Blocked executions go first, a stream of asynchronous ones would starve them otherwise
+        if (mWaiters == 0 && !mPending.empty()) {
+            next = std::move(mPending.front());
+            mPending.pop_front();
+            return next;
+        }
+        mHeld = false;
+    }
+    mCondition.notify_one();
+    return next;
+}
+
+ExecutionDispatcher& ExecutionDispatcher::get() {
+    // Never destroyed, its thread runs for the lifetime of the driver service
+    static auto* sDispatcher = new ExecutionDispatcher();
+    return *sDispatcher;
+}
+
+ExecutionDispatcher::ExecutionDispatcher() {
+    // This thread is intentionally detached because the driver service is expected to live
+    // forever
+    std::thread([this] { run(); }).detach();
+}
+
+void ExecutionDispatcher::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push_back(std::move(task));
+    }
+    mCondition.notify_one();
+}
+
+void ExecutionDispatcher::run() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this] { return !mTasks.empty(); });
+        auto task = std::move(mTasks.front());
+        mTasks.pop_front();
+        lock.unlock();
+        task();
+        // Whatever the task captured is released before waiting for the next one
+        task = nullptr;
+        lock.lock();
+    }
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
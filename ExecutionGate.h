@@ -0,0 +1,64 @@
+#ifndef ANDROID_ML_NN_EXECUTION_GATE_H
+#define ANDROID_ML_NN_EXECUTION_GATE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Serializes the executions sharing the infer request and request pool state of a prepared model.
+// Unlike a mutex the gate may be released by another thread than the one which acquired it, an
+// asynchronous execution holds it from dispatch until the completion callback of its inference
+// ran, without a thread waiting for the inference in between.
+class ExecutionGate {
+public:
+    // BasicLockable, for the executions which block until they completed
+    void lock();
+    void unlock();
+
+    // Runs task with the gate held, on the calling thread if the gate is free or else once the
+    // gate is handed to it by release(). task must release the gate once the execution completed,
+    // whether it succeeded or not.
+    void async(std::function<void()> task);
+
+    // Releases the gate. If an asynchronous task was waiting for it, the gate is handed to that
+    // task instead, which the caller has to run, preferably on a thread of its own.
+    std::function<void()> release();
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mHeld = false;
+    size_t mWaiters = 0;
+    std::deque<std::function<void()>> mPending;
+};
+
+// Runs the tasks an execution gate was handed to, in order, on one thread of the process. The
+// threads completing inferences and the blocking executions releasing a gate post the next task
+// here instead of running it, or starting a thread for each of them.
+class ExecutionDispatcher {
+public:
+    static ExecutionDispatcher& get();
+
+    void post(std::function<void()> task);
+
+private:
+    ExecutionDispatcher();
+    void run();
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::function<void()>> mTasks;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_EXECUTION_GATE_H
@@ -1,10 +1,14 @@
 #include "IENetwork.h"
+#include "BlobAllocator.h"
+#include "CpuTopology.h"
 #include "ie_common.h"
 
 #include <android-base/logging.h>
 #include <android/log.h>
+#include <cutils/properties.h>
 #include <ie_blob.h>
 #include <log/log.h>
+#include <algorithm>
 
 #undef LOG_TAG
 #define LOG_TAG "IENetwork"
@@ -14,47 +18,98 @@ namespace hardware {
 namespace neuralnetworks {
 namespace nnhal {
 
-bool IENetwork::loadNetwork() {
-    ALOGD("%s", __func__);
+// Computes models allowing relaxed precision in BF16 where the CPU supports it. Off until the
+// accuracy of BF16 has been validated on the target workloads.
+static const char* kBf16Property = "vendor.nn.hal.bf16";
 
+static InferenceEngine::Core createCore() {
 #if __ANDROID__
-    InferenceEngine::Core ie(std::string("/vendor/etc/openvino/plugins.xml"));
+    return InferenceEngine::Core(std::string("/vendor/etc/openvino/plugins.xml"));
 #else
-    InferenceEngine::Core ie(std::string("/usr/local/lib64/plugins.xml"));
+    return InferenceEngine::Core(std::string("/usr/local/lib64/plugins.xml"));
 #endif
+}
+
+// Whether the CPU computes BF16 natively, AVX512_BF16 or AMX
+static bool supportsBf16() {
+    static const bool supported = [] {
+        try {
+            auto capabilities = createCore()
+                                    .GetMetric("CPU", METRIC_KEY(OPTIMIZATION_CAPABILITIES))
+                                    .as<std::vector<std::string>>();
+            return std::find(capabilities.begin(), capabilities.end(), METRIC_VALUE(BF16)) !=
+                   capabilities.end();
+        } catch (const std::exception& ex) {
+            ALOGE("%s Exception !!! %s", __func__, ex.what());
+            return false;
+        }
+    }();
+    return supported;
+}
+
+static std::map<std::string, std::string> networkConfig(bool profiling, bool relaxed,
+                                                        V1_1::ExecutionPreference preference) {
     std::map<std::string, std::string> config;
+    if (profiling) config[CONFIG_KEY(PERF_COUNT)] = CONFIG_VALUE(YES);
+    const auto streams = CpuTopology::get().streamConfig(preference);
+    config[CONFIG_KEY(CPU_THREADS_NUM)] = std::to_string(streams.threads);
+    config[CONFIG_KEY(CPU_THROUGHPUT_STREAMS)] = std::to_string(streams.streams);
+    config[CONFIG_KEY(CPU_BIND_THREAD)] = streams.bind;
+    // The CPU plugin defaults to BF16 where it is native, which only models allowing FP32 to be
+    // computed with the range and precision of FP16 may run with. BF16 has the range of FP32 and
+    // less precision than FP16.
+    static const bool bf16Enabled = property_get_bool(kBf16Property, false);
+    const bool bf16 = bf16Enabled && relaxed && supportsBf16();
+    config[CONFIG_KEY(ENFORCE_BF16)] = bf16 ? CONFIG_VALUE(YES) : CONFIG_VALUE(NO);
+    if (bf16) ALOGD("%s Relaxed model computed in BF16", __func__);
+    return config;
+}
+
+bool IENetwork::loadNetwork() {
+    ALOGD("%s", __func__);
 
     if (mNetwork) {
-        mExecutableNw = ie.LoadNetwork(*mNetwork, "CPU");
+        auto ie = createCore();
+        mExecutableNw =
+            ie.LoadNetwork(*mNetwork, "CPU", networkConfig(mProfiling, mRelaxed, mPreference));
         ALOGD("LoadNetwork is done....");
-        mInferRequest = mExecutableNw.CreateInferRequest();
-        ALOGD("CreateInfereRequest is done....");
-
-        mInputInfo = mNetwork->getInputsInfo();
-        mOutputInfo = mNetwork->getOutputsInfo();
-    } else {
+        // The executable network has its own copy of the weights
+        mNetwork.reset();
+    } else if (!mExecutableNw) {
         ALOGE("Invalid Network pointer");
         return false;
     }
 
+    mInferRequest = mExecutableNw.CreateInferRequest();
+    ALOGD("CreateInfereRequest is done....");
+    if (BlobAllocator::get()->isEnabled()) bindArenaBlobs();
+    mInputBlobs.clear();
+    for (const auto& input : mExecutableNw.GetInputsInfo())
+        mInputBlobs[input.first] = mInferRequest.GetBlob(input.first);
     return true;
 }
 
-// Need to be called before loadnetwork.. But not sure whether need to be called for
-// all the inputs in case multiple input / output
-void IENetwork::prepareInput(InferenceEngine::Precision precision, InferenceEngine::Layout layout) {
-    ALOGE("%s", __func__);
-
-    auto inputInfoItem = *mInputInfo.begin();
-    inputInfoItem.second->setPrecision(precision);
-    inputInfoItem.second->setLayout(layout);
+void IENetwork::bindArenaBlobs() {
+    std::vector<std::pair<std::string, InferenceEngine::TensorDesc>> blobs;
+    for (const auto& input : mExecutableNw.GetInputsInfo())
+        blobs.emplace_back(input.first, input.second->getTensorDesc());
+    for (const auto& output : mExecutableNw.GetOutputsInfo())
+        blobs.emplace_back(output.first, output.second->getTensorDesc());
+    for (const auto& blob : blobs) {
+        try {
+            auto arenaBlob = makeBlob(blob.second);
+            if (arenaBlob != nullptr) mInferRequest.SetBlob(blob.first, arenaBlob);
+        } catch (const std::exception& ex) {
+            // The plugin keeps the blob it allocated
+            ALOGD("%s %s not bound: %s", __func__, blob.first.c_str(), ex.what());
+        }
+    }
 }
 
-void IENetwork::prepareOutput(InferenceEngine::Precision precision,
-                              InferenceEngine::Layout layout) {
-    InferenceEngine::DataPtr& output = mOutputInfo.begin()->second;
-    output->setPrecision(precision);
-    output->setLayout(layout);
+InferenceEngine::ExecutableNetwork IENetwork::importNetwork(
+    std::istream& stream, bool profiling, bool relaxed, V1_1::ExecutionPreference preference) {
+    auto ie = createCore();
+    return ie.ImportNetwork(stream, "CPU", networkConfig(profiling, relaxed, preference));
 }
 
 void IENetwork::setBlob(const std::string& inName, const InferenceEngine::Blob::Ptr& inputBlob) {
@@ -62,19 +117,85 @@ void IENetwork::setBlob(const std::string& inName, const InferenceEngine::Blob::
     mInferRequest.SetBlob(inName, inputBlob);
 }
 
-InferenceEngine::TBlob<float>::Ptr IENetwork::getBlob(const std::string& outName) {
-    InferenceEngine::Blob::Ptr outputBlob;
-    outputBlob = mInferRequest.GetBlob(outName);
-    return android::hardware::neuralnetworks::nnhal::As<InferenceEngine::TBlob<float>>(outputBlob);
+InferenceEngine::Blob::Ptr IENetwork::getBlob(const std::string& name) {
+    return mInferRequest.GetBlob(name);
+}
+
+InferenceEngine::Blob::Ptr IENetwork::getInputBlob(const std::string& name) {
+    auto it = mInputBlobs.find(name);
+    return it != mInputBlobs.end() ? it->second : nullptr;
+}
+
+std::vector<InferenceEngine::VariableState> IENetwork::queryState() {
+    return mInferRequest.QueryState();
+}
+
+void IENetwork::resetState() {
+    for (auto&& state : mInferRequest.QueryState()) {
+        ALOGD("%s resetting state %s", __func__, state.GetName().c_str());
+        state.Reset();
+    }
+}
+
+std::map<std::string, InferenceEngine::InferenceEngineProfileInfo>
+IENetwork::getPerformanceCounts() {
+    if (!mProfiling) return {};
+    return mInferRequest.GetPerformanceCounts();
 }
 
 void IENetwork::infer() {
     ALOGI("Infer Network\n");
+    // Clears the completion of an earlier asynchronous inference
+    mInferRequest.SetCompletionCallback([] {});
     mInferRequest.StartAsync();
-    mInferRequest.Wait(10000);
+    mInferRequest.Wait(InferenceEngine::InferRequest::WaitMode::RESULT_READY);
     ALOGI("infer request completed");
 }
 
+void IENetwork::inferAsync(std::function<void(InferenceEngine::StatusCode)> completion) {
+    ALOGI("Infer Network asynchronously\n");
+    // The infer request keeps its callback until another one is set, the completion is moved out
+    // when it runs so that what it captures is released right after
+    auto pending = std::make_shared<std::function<void(InferenceEngine::StatusCode)>>(
+        std::move(completion));
+    std::function<void(InferenceEngine::InferRequest, InferenceEngine::StatusCode)> callback =
+        [pending](InferenceEngine::InferRequest, InferenceEngine::StatusCode status) {
+            auto done = std::move(*pending);
+            *pending = nullptr;
+            if (status != InferenceEngine::StatusCode::OK) {
+                ALOGE("infer request failed with status %d", static_cast<int>(status));
+            }
+            if (done) done(status);
+        };
+    try {
+        mInferRequest.SetCompletionCallback(callback);
+        mInferRequest.StartAsync();
+    } catch (const std::exception& ex) {
+        ALOGE("%s Exception !!! %s", __func__, ex.what());
+        callback(mInferRequest, InferenceEngine::StatusCode::GENERAL_ERROR);
+    }
+}
+
+bool IENetwork::inferWithTimeout(std::chrono::milliseconds timeout) {
+    ALOGI("Infer Network with timeout %lld ms\n", static_cast<long long>(timeout.count()));
+    mInferRequest.SetCompletionCallback([] {});
+    mInferRequest.StartAsync();
+    if (mInferRequest.Wait(timeout.count()) != InferenceEngine::StatusCode::RESULT_NOT_READY) {
+        ALOGI("infer request completed");
+        return true;
+    }
+
+    ALOGE("%s infer request did not complete in time, cancelling", __func__);
+    mInferRequest.Cancel();
+    try {
+        mInferRequest.Wait(InferenceEngine::InferRequest::WaitMode::RESULT_READY);
+    } catch (const std::exception& ex) {
+        // Waiting on a cancelled request reports the cancellation
+        ALOGD("%s %s", __func__, ex.what());
+    }
+    return false;
+}
+
 }  // namespace nnhal
 }  // namespace neuralnetworks
 }  // namespace hardware
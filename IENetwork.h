@@ -1,11 +1,16 @@
 #ifndef __DEVICE_PLUGIN_H
 #define __DEVICE_PLUGIN_H
 
+#include <android/hardware/neuralnetworks/1.1/types.h>
 #include <ie_cnn_network.h>
 #include <ie_core.hpp>
 #include <ie_executable_network.hpp>
 #include <ie_infer_request.hpp>
 #include <ie_input_info.hpp>
+#include <chrono>
+#include <functional>
+#include <istream>
+#include <map>
 #include <vector>
 
 #include "utils.h"
@@ -24,15 +29,24 @@ public:
     virtual ~IIENetwork() {}
     virtual bool loadNetwork() = 0;
     virtual InferenceEngine::InferRequest getInferRequest() = 0;
+    virtual InferenceEngine::ExecutableNetwork getExecutableNetwork() = 0;
     virtual void infer() = 0;
-    virtual void queryState() = 0;
-    virtual InferenceEngine::TBlob<float>::Ptr getBlob(const std::string& outName) = 0;
-    virtual void prepareInput(InferenceEngine::Precision precision,
-                              InferenceEngine::Layout layout) = 0;
-    virtual void prepareOutput(InferenceEngine::Precision precision,
-                               InferenceEngine::Layout layout) = 0;
+    // Starts the inference and returns, completion runs on a plugin thread once it finished. When
+    // the inference can't be started completion runs on the calling thread with the error.
+    virtual void inferAsync(std::function<void(InferenceEngine::StatusCode)> completion) = 0;
+    // Returns false if the inference was cancelled for not completing within timeout
+    virtual bool inferWithTimeout(std::chrono::milliseconds timeout) = 0;
+    virtual std::vector<InferenceEngine::VariableState> queryState() = 0;
+    virtual void resetState() = 0;
+    // Per layer counters of the last inference, empty unless the network was loaded for profiling
+    virtual std::map<std::string, InferenceEngine::InferenceEngineProfileInfo>
+    getPerformanceCounts() = 0;
+    // Blobs hold the precision of the NNAPI operand type, set before the network was loaded
+    virtual InferenceEngine::Blob::Ptr getBlob(const std::string& name) = 0;
     virtual void setBlob(const std::string& inName,
                          const InferenceEngine::Blob::Ptr& inputBlob) = 0;
+    // Blob the input had when the network was loaded, which setBlob does not replace
+    virtual InferenceEngine::Blob::Ptr getInputBlob(const std::string& name) = 0;
 };
 
 // Abstract this class for all accelerators
@@ -41,21 +55,43 @@ private:
     std::shared_ptr<InferenceEngine::CNNNetwork> mNetwork;
     InferenceEngine::ExecutableNetwork mExecutableNw;
     InferenceEngine::InferRequest mInferRequest;
-    InferenceEngine::InputsDataMap mInputInfo;
-    InferenceEngine::OutputsDataMap mOutputInfo;
+    bool mProfiling;
+    // Model::relaxComputationFloat32toFloat16, the network may then run in reduced precision
+    bool mRelaxed = false;
+    // Selects the streams, threads and binding derived from the CPU topology
+    V1_1::ExecutionPreference mPreference = V1_1::ExecutionPreference::FAST_SINGLE_ANSWER;
+    std::map<std::string, InferenceEngine::Blob::Ptr> mInputBlobs;
+
+    // Replaces the blobs the plugin allocated for the inputs and outputs with blobs of the driver
+    // arena
+    void bindArenaBlobs();
 
 public:
     IENetwork() : IENetwork(nullptr) {}
-    IENetwork(std::shared_ptr<InferenceEngine::CNNNetwork> network) : mNetwork(network) {}
+    IENetwork(std::shared_ptr<InferenceEngine::CNNNetwork> network, bool profiling = false,
+              bool relaxed = false,
+              V1_1::ExecutionPreference preference = V1_1::ExecutionPreference::FAST_SINGLE_ANSWER)
+        : mNetwork(network), mProfiling(profiling), mRelaxed(relaxed), mPreference(preference) {}
+    // Shares a network loaded before, loadNetwork only creates the infer request of this instance
+    IENetwork(const InferenceEngine::ExecutableNetwork& executableNetwork, bool profiling = false)
+        : mExecutableNw(executableNetwork), mProfiling(profiling) {}
 
     virtual bool loadNetwork();
-    void prepareInput(InferenceEngine::Precision precision, InferenceEngine::Layout layout);
-    void prepareOutput(InferenceEngine::Precision precision, InferenceEngine::Layout layout);
+    // Loads a network written by ExecutableNetwork::Export, throws when the plugin can't
+    static InferenceEngine::ExecutableNetwork importNetwork(
+        std::istream& stream, bool profiling = false, bool relaxed = false,
+        V1_1::ExecutionPreference preference = V1_1::ExecutionPreference::FAST_SINGLE_ANSWER);
     void setBlob(const std::string& inName, const InferenceEngine::Blob::Ptr& inputBlob);
-    InferenceEngine::TBlob<float>::Ptr getBlob(const std::string& outName);
+    InferenceEngine::Blob::Ptr getBlob(const std::string& name);
+    InferenceEngine::Blob::Ptr getInputBlob(const std::string& name);
     InferenceEngine::InferRequest getInferRequest() { return mInferRequest; }
-    void queryState() {}
+    InferenceEngine::ExecutableNetwork getExecutableNetwork() { return mExecutableNw; }
+    std::vector<InferenceEngine::VariableState> queryState();
+    void resetState();
+    std::map<std::string, InferenceEngine::InferenceEngineProfileInfo> getPerformanceCounts();
     void infer();
+    void inferAsync(std::function<void(InferenceEngine::StatusCode)> completion);
+    bool inferWithTimeout(std::chrono::milliseconds timeout);
 };
 
 }  // namespace nnhal
@@ -0,0 +1,62 @@
+#ifndef ANDROID_ML_NN_LATENCY_HISTOGRAM_H
+#define ANDROID_ML_NN_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Latencies in microseconds counted into power of two buckets, bucket i holding values below
+// 2^i. Percentiles resolve to the upper bound of their bucket, capped by the largest value seen.
+// Not thread safe, callers serialize access.
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 40;
+
+    void record(uint64_t us) {
+        size_t bucket = 0;
+        while (bucket < kBuckets - 1 && (us >> bucket) != 0) bucket++;
+        mBuckets[bucket]++;
+        mCount++;
+        mTotal += us;
+        mMin = mCount == 1 ? us : std::min(mMin, us);
+        mMax = std::max(mMax, us);
+    }
+
+    uint64_t percentile(double fraction) const {
+        if (mCount == 0) return 0;
+        const uint64_t rank = std::max<uint64_t>(1, fraction * mCount + 0.5);
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < kBuckets; bucket++) {
+            seen += mBuckets[bucket];
+            if (seen >= rank) return std::min(mMax, (uint64_t(1) << bucket) - 1);
+        }
+        return mMax;
+    }
+
+    void clear() { *this = LatencyHistogram(); }
+
+    uint64_t count() const { return mCount; }
+    uint64_t total() const { return mTotal; }
+    uint64_t min() const { return mMin; }
+    uint64_t max() const { return mMax; }
+    uint64_t mean() const { return mCount ? mTotal / mCount : 0; }
+
+private:
+    std::array<uint64_t, kBuckets> mBuckets = {};
+    uint64_t mCount = 0;
+    uint64_t mTotal = 0;
+    uint64_t mMin = 0;
+    uint64_t mMax = 0;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_LATENCY_HISTOGRAM_H
@@ -0,0 +1,89 @@
+#ifndef ANDROID_ML_NN_LRU_CACHE_H
+#define ANDROID_ML_NN_LRU_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <utility>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Least recently used cache bounded by the summed cost of its entries. Entries default to a cost
+// of one, which bounds the cache by entry count. Not thread safe, callers serialize access.
+template <typename Key, typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : mCapacity(capacity) {}
+
+    bool get(const Key& key, Value& value) {
+        auto it = mIndex.find(key);
+        if (it == mIndex.end()) return false;
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        value = it->second->value;
+        return true;
+    }
+
+    void put(const Key& key, const Value& value, size_t cost = 1) {
+        erase(key);
+        mEntries.push_front({key, value, cost});
+        mIndex[key] = mEntries.begin();
+        mCost += cost;
+        // Keep at least the newest entry even if it alone exceeds the capacity
+        while (mCost > mCapacity && mEntries.size() > 1) {
+            auto& last = mEntries.back();
+            mCost -= last.cost;
+            mIndex.erase(last.key);
+            mEntries.pop_back();
+            mEvictions++;
+        }
+    }
+
+    bool erase(const Key& key) {
+        auto it = mIndex.find(key);
+        if (it == mIndex.end()) return false;
+        mCost -= it->second->cost;
+        mEntries.erase(it->second);
+        mIndex.erase(it);
+        return true;
+    }
+
+    void clear() {
+        mEntries.clear();
+        mIndex.clear();
+        mCost = 0;
+    }
+
+    // Visits entries from the most to the least recently used
+    template <typename Visitor>
+    void forEach(Visitor visitor) const {
+        for (const auto& entry : mEntries) visitor(entry.key, entry.value);
+    }
+
+    size_t size() const { return mEntries.size(); }
+    size_t cost() const { return mCost; }
+    size_t capacity() const { return mCapacity; }
+    size_t evictions() const { return mEvictions; }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t cost;
+    };
+
+    size_t mCapacity;
+    size_t mCost = 0;
+    size_t mEvictions = 0;
+    std::list<Entry> mEntries;
+    std::map<Key, typename std::list<Entry>::iterator> mIndex;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_LRU_CACHE_H
@@ -0,0 +1,151 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+size_t ConcurrentHistogram::bucketOf(uint64_t us) {
+    if (us < kSubBuckets) return us;
+    uint32_t exponent = 63 - __builtin_clzll(us);
+    const uint64_t subBucket = (us >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    const size_t bucket = (exponent - kSubBucketBits + 1) * kSubBuckets + subBucket;
+    return std::min(bucket, kBuckets - 1);
+}
+
+uint64_t ConcurrentHistogram::bucketUpperBound(size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    const uint32_t shift = bucket / kSubBuckets - 1;
+    const uint64_t lower = (kSubBuckets + bucket % kSubBuckets) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+void ConcurrentHistogram::record(uint64_t us) {
+    mBuckets[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mTotal.fetch_add(us, std::memory_order_relaxed);
+    uint64_t max = mMax.load(std::memory_order_relaxed);
+    while (us > max && !mMax.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+}
+
+// Buckets are read one by one while other threads record, the result is that of a snapshot
+// taken somewhere during the call
+uint64_t ConcurrentHistogram::percentile(double fraction) const {
+    std::array<uint64_t, kBuckets> buckets;
+    uint64_t count = 0;
+    for (size_t bucket = 0; bucket < kBuckets; bucket++) {
+        buckets[bucket] = mBuckets[bucket].load(std::memory_order_relaxed);
+        count += buckets[bucket];
+    }
+    if (count == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, fraction * count + 0.5);
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < kBuckets; bucket++) {
+        seen += buckets[bucket];
+        if (seen >= rank) return std::min(max(), bucketUpperBound(bucket));
+    }
+    return max();
+}
+
+const char* executionStageName(ExecutionStage stage) {
+    switch (stage) {
+        case ExecutionStage::VALIDATE:
+            return "validate";
+        case ExecutionStage::DISPATCH:
+            return "dispatch";
+        case ExecutionStage::QUEUE_WAIT:
+            return "queue wait";
+        case ExecutionStage::NETWORK_LOOKUP:
+            return "network lookup";
+        case ExecutionStage::POOL_MAP:
+            return "pool map";
+        case ExecutionStage::INPUT_COPY:
+            return "input copy";
+        case ExecutionStage::INFER:
+            return "infer";
+        case ExecutionStage::OUTPUT_CONVERT:
+            return "output convert";
+        case ExecutionStage::POOL_SYNC:
+            return "pool sync";
+        case ExecutionStage::CALLBACK:
+            return "callback";
+        case ExecutionStage::EXECUTION:
+            return "execution";
+        default:
+            return "unknown";
+    }
+}
+
+static void dumpHistogram(std::ostringstream& out, const ConcurrentHistogram& histogram,
+                          bool json) {
+    if (json) {
+        out << "{\"count\": " << histogram.count() << ", \"meanUs\": " << histogram.mean()
+            << ", \"p50Us\": " << histogram.percentile(0.5)
+            << ", \"p99Us\": " << histogram.percentile(0.99)
+            << ", \"p999Us\": " << histogram.percentile(0.999)
+            << ", \"maxUs\": " << histogram.max() << "}";
+    } else {
+        out << " count " << histogram.count() << " mean " << histogram.mean() << " us p50 "
+            << histogram.percentile(0.5) << " p99 " << histogram.percentile(0.99) << " p999 "
+            << histogram.percentile(0.999) << " max " << histogram.max() << "\n";
+    }
+}
+
+std::string ModelMetrics::dump(bool json) const {
+    std::ostringstream out;
+    if (json) {
+        out << "{\"executions\": " << executions << ", \"failures\": " << failures
+            << ", \"inFlight\": " << inFlight << ", \"compilations\": " << compilations
+            << ", \"bytesCopied\": " << bytesCopied << ", \"poolMaps\": " << poolMaps
+            << ", \"poolUnmaps\": " << poolUnmaps << ", \"evictions\": " << evictions
+            << ", \"reloads\": " << reloads << ", \"reloadLatency\": ";
+        dumpHistogram(out, reloadLatency, true);
+        out << ", \"stages\": {";
+    } else {
+        out << "executions " << executions << " failures " << failures << " in flight "
+            << inFlight << " compilations " << compilations << " bytes copied " << bytesCopied
+            << " pool maps " << poolMaps << " pool unmaps " << poolUnmaps << " evictions "
+            << evictions << " reloads " << reloads << "\n";
+        if (reloads > 0) {
+            out << "  reload";
+            dumpHistogram(out, reloadLatency, false);
+        }
+    }
+    bool first = true;
+    for (size_t i = 0; i < stages.size(); i++) {
+        if (stages[i].count() == 0) continue;
+        const char* name = executionStageName(static_cast<ExecutionStage>(i));
+        if (json) {
+            out << (first ? "" : ", ") << "\"" << name << "\": ";
+        } else {
+            out << "  " << name;
+        }
+        dumpHistogram(out, stages[i], json);
+        first = false;
+    }
+    if (json) out << "}}";
+    return out.str();
+}
+
+std::string DriverMetrics::dump(bool json) const {
+    std::ostringstream out;
+    if (json) {
+        out << "{\"compilations\": " << compilations
+            << ", \"compilationFailures\": " << compilationFailures << ", \"compileLatency\": ";
+    } else {
+        out << "compilations " << compilations << " failures " << compilationFailures << "\n"
+            << "  compile latency";
+    }
+    dumpHistogram(out, compileLatency, json);
+    if (json) out << "}";
+    return out.str();
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
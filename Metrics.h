@@ -0,0 +1,117 @@
+#ifndef ANDROID_ML_NN_METRICS_H
+#define ANDROID_ML_NN_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Latencies in microseconds recorded by concurrent threads without locking. Values below
+// kSubBuckets count exactly, larger values fall into power of two ranges split into kSubBuckets
+// linear buckets each. A percentile so resolves to within 1/kSubBuckets of the recorded value.
+class ConcurrentHistogram {
+public:
+    static constexpr uint32_t kSubBucketBits = 3;
+    static constexpr uint64_t kSubBuckets = 1 << kSubBucketBits;
+    // Ranges up to 2^40 us, larger values count into the last bucket
+    static constexpr size_t kBuckets = (40 - kSubBucketBits + 1) * kSubBuckets;
+
+    void record(uint64_t us);
+    uint64_t percentile(double fraction) const;
+
+    uint64_t count() const { return mCount.load(std::memory_order_relaxed); }
+    uint64_t total() const { return mTotal.load(std::memory_order_relaxed); }
+    uint64_t max() const { return mMax.load(std::memory_order_relaxed); }
+    uint64_t mean() const { return count() ? total() / count() : 0; }
+
+private:
+    static size_t bucketOf(uint64_t us);
+    static uint64_t bucketUpperBound(size_t bucket);
+
+    std::array<std::atomic<uint64_t>, kBuckets> mBuckets = {};
+    std::atomic<uint64_t> mCount{0};
+    std::atomic<uint64_t> mTotal{0};
+    std::atomic<uint64_t> mMax{0};
+};
+
+enum class ExecutionStage {
+    VALIDATE,
+    DISPATCH,
+    QUEUE_WAIT,
+    NETWORK_LOOKUP,
+    POOL_MAP,
+    INPUT_COPY,
+    INFER,
+    OUTPUT_CONVERT,
+    POOL_SYNC,
+    CALLBACK,
+    // Whole execution, from picking up the request to notifying its result
+    EXECUTION,
+    COUNT
+};
+
+const char* executionStageName(ExecutionStage stage);
+
+// Counters and stage latencies of one prepared model
+struct ModelMetrics {
+    std::atomic<uint64_t> executions{0};
+    std::atomic<uint64_t> failures{0};
+    // Executions picked up and not yet completed, including those waiting for the network
+    std::atomic<uint64_t> inFlight{0};
+    std::atomic<uint64_t> compilations{0};
+    std::atomic<uint64_t> bytesCopied{0};
+    std::atomic<uint64_t> poolMaps{0};
+    std::atomic<uint64_t> poolUnmaps{0};
+    // Networks released under memory pressure, and imported again by the next execution
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> reloads{0};
+    ConcurrentHistogram reloadLatency;
+    std::array<ConcurrentHistogram, static_cast<size_t>(ExecutionStage::COUNT)> stages;
+
+    void recordStage(ExecutionStage stage, uint64_t durationNs) {
+        stages[static_cast<size_t>(stage)].record(durationNs / 1000);
+    }
+    std::string dump(bool json) const;
+};
+
+// Counters of the driver service
+struct DriverMetrics {
+    std::atomic<uint64_t> compilations{0};
+    std::atomic<uint64_t> compilationFailures{0};
+    ConcurrentHistogram compileLatency;
+
+    std::string dump(bool json) const;
+};
+
+// Counts one execution in flight for its lifetime. Executions which do not reach succeeded(), as
+// those leaving on an error path, count as failures.
+class ExecutionCounter {
+public:
+    explicit ExecutionCounter(ModelMetrics& metrics) : mMetrics(metrics) { mMetrics.inFlight++; }
+    ~ExecutionCounter() {
+        mMetrics.inFlight--;
+        mMetrics.executions++;
+        if (!mSucceeded) mMetrics.failures++;
+    }
+
+    ExecutionCounter(const ExecutionCounter&) = delete;
+    ExecutionCounter& operator=(const ExecutionCounter&) = delete;
+
+    void succeeded() { mSucceeded = true; }
+
+private:
+    ModelMetrics& mMetrics;
+    bool mSucceeded = false;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_METRICS_H
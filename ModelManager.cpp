@@ -1,5 +1,7 @@
 #include "ModelManager.h"
 
+#include <algorithm>
+
 #undef LOG_TAG
 #define LOG_TAG "ModelManager"
 
@@ -12,6 +14,13 @@ bool NnapiModelInfo::updateOutputshapes(size_t outputIndex, std::vector<size_t>&
                                         bool isLengthSufficient) {
     auto& outputShapeDims = mOutputShapes[outputIndex].dimensions;
     mOutputShapes[outputIndex].isSufficient = isLengthSufficient;
+    // Tensor output of unknown rank, take the shape produced by the network as is
+    const auto& operand = mModel.main.operands[mModel.main.outputIndexes[outputIndex]];
+    if (outputShapeDims.size() == 0 &&
+        !android::nn::nonExtensionOperandTypeIsScalar(static_cast<int>(operand.type))) {
+        outputShapeDims = std::vector<uint32_t>(outputDims.begin(), outputDims.end());
+        return true;
+    }
     if (outputDims.size() < outputShapeDims.size()) {
         return false;
     }
@@ -75,6 +84,9 @@ bool NnapiModelInfo::initializeRunTimeOperandInfo() {
             case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
                 to.type = from.type;
                 break;
+            case OperandType::SUBGRAPH:
+                to.type = from.type;
+                break;
             default:
                 ALOGE("wrong operand type %d", from.type);
                 return false;
@@ -105,6 +117,7 @@ bool NnapiModelInfo::initializeRunTimeOperandInfo() {
             case OperandLifeTime::SUBGRAPH_INPUT:
             case OperandLifeTime::SUBGRAPH_OUTPUT:
             case OperandLifeTime::NO_VALUE:
+            case OperandLifeTime::SUBGRAPH:
                 to.buffer = nullptr;
                 to.numberOfUsesLeft = 0;
                 break;
@@ -124,6 +137,49 @@ bool NnapiModelInfo::initializeRunTimeOperandInfo() {
     return true;
 }
 
+void NnapiModelInfo::releaseConstants() {
+    for (auto& operand : mOperands) {
+        if (operand.lifetime == OperandLifeTime::CONSTANT_COPY ||
+            operand.lifetime == OperandLifeTime::CONSTANT_REFERENCE) {
+            operand.buffer = nullptr;
+        }
+    }
+    for (auto& poolInfo : mPoolInfos) poolInfo.unmap_mem();
+    mPoolInfos.clear();
+    mModel.operandValues = hidl_vec<uint8_t>();
+    mModel.pools = hidl_vec<hidl_memory>();
+}
+
+std::shared_ptr<NnapiModelInfo> NnapiModelInfo::createSubgraphInfo(uint32_t operandIndex) {
+    const auto& operand = mModel.main.operands[operandIndex];
+    if (operand.lifetime != OperandLifeTime::SUBGRAPH ||
+        operand.location.offset >= mModel.referenced.size()) {
+        ALOGE("%s Operand %d does not reference a subgraph", __func__, operandIndex);
+        return nullptr;
+    }
+
+    // Referenced subgraphs are kept so that nested control flow resolves against the same list
+    Model subgraphModel = mModel;
+    subgraphModel.main = mModel.referenced[operand.location.offset];
+    auto subgraphInfo = std::make_shared<NnapiModelInfo>(subgraphModel);
+    subgraphInfo->mPoolInfos = mPoolInfos;
+    if (!subgraphInfo->initializeRunTimeOperandInfo()) return nullptr;
+    return subgraphInfo;
+}
+
+bool NnapiModelInfo::hasLoops() {
+    auto isLoop = [](const V1_3::Operation& operation) {
+        return operation.type == OperationType::WHILE;
+    };
+    if (std::any_of(mModel.main.operations.begin(), mModel.main.operations.end(), isLoop))
+        return true;
+    for (const auto& subgraph : mModel.referenced) {
+        if (std::any_of(subgraph.operations.begin(), subgraph.operations.end(), isLoop))
+            return true;
+    }
+    return false;
+}
+
 // TODO: Move it to Utils class
 template <typename T>
 T NnapiModelInfo::GetConstFromBuffer(const uint8_t* buf, uint32_t len) {
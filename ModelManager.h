@@ -49,6 +49,28 @@ public:
 
     size_t getModelOutputsSize() { return mModel.main.outputIndexes.size(); }
 
+    // True if the rank or any dimension of a model input is left to the request
+    bool hasUnspecifiedInputDims() {
+        for (auto index : mModel.main.inputIndexes) {
+            if (android::nn::tensorHasUnspecifiedDimensions(mModel.main.operands[index]))
+                return true;
+        }
+        return false;
+    }
+
+    // Specializes a model input to the dimensions carried by a request. Only valid before
+    // initRuntimeInfo()
+    void setInputDimensions(uint32_t index, const hidl_vec<uint32_t>& dims) {
+        mModel.main.operands[mModel.main.inputIndexes[index]].dimensions = dims;
+    }
+
+    // Model info viewing the referenced subgraph held by a SUBGRAPH operand, sharing operand
+    // values and constant pools with this model
+    std::shared_ptr<NnapiModelInfo> createSubgraphInfo(uint32_t operandIndex);
+
+    // True if the model or any of its referenced subgraphs contains a WHILE operation
+    bool hasLoops();
+
     // Index into the operand vector
     V1_3::OperandLifeTime getOperandLifetime(uint32_t operandIdx) {
         auto tmpOperand = mModel.main.operands[operandIdx];
@@ -170,7 +192,8 @@ public:
     void* getBlobFromMemoryPoolIn(const Request& request, uint32_t index, uint32_t& rBufferLength);
     void* getBlobFromMemoryPoolOut(const Request& request, uint32_t index, uint32_t& rBufferLength);
 
-    Model getModel() { return mModel; }
+    const Model& getModel() { return mModel; }
+    const std::vector<RunTimePoolInfo>& getModelPoolInfos() { return mPoolInfos; }
 
     ErrorStatus setRunTimePoolInfosFromHidlMemories(const hidl_vec<hidl_memory>& pools);
     V1_3::ErrorStatus setRunTimePoolInfosFromHidlMemories(
@@ -186,6 +209,18 @@ public:
 
     std::vector<V1_2::OutputShape> getOutputShapes() { return mOutputShapes; }
 
+    // Bytes of the constant operand values, inline in the model and in its pools
+    size_t getConstantBytes() {
+        size_t bytes = mModel.operandValues.size();
+        for (const auto& poolInfo : mPoolInfos) bytes += poolInfo.hidlMemory.size();
+        return bytes;
+    }
+
+    // Drops the constant operand values and unmaps the model pools once a network holding its
+    // own copy of the constants is loaded. Operand metadata stays for binding requests, but the
+    // model can't be translated to a graph again.
+    void releaseConstants();
+
     void unmapRuntimeMemPools() {
         for (auto runtimeInfo : mRequestPoolInfos) {
             runtimeInfo.unmap_mem();
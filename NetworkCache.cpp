@@ -0,0 +1,105 @@
+#include "NetworkCache.h"
+
+#include <android/log.h>
+#include <cutils/properties.h>
+#include <log/log.h>
+#include <algorithm>
+#include <sstream>
+
+#include "ContentHash.h"
+#include "ModelManager.h"
+
+#undef LOG_TAG
+#define LOG_TAG "NetworkCache"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Bound of the cache in MB of model constants, 0 disables it. Off by default, cached networks stay
+// loaded once their prepared models were released, outside of the memory budget.
+static const char* kNetworkCacheSizeProperty = "vendor.nn.hal.network_cache_mb";
+static const int32_t kDefaultNetworkCacheSizeMb = 0;
+
+namespace {
+
+size_t capacityBytes() {
+    const int32_t megabytes =
+        property_get_int32(kNetworkCacheSizeProperty, kDefaultNetworkCacheSizeMb);
+    return size_t(std::max(megabytes, 0)) << 20;
+}
+
+}  // namespace
+
+NetworkCache& NetworkCache::get() {
+    static NetworkCache sCache;
+    return sCache;
+}
+
+NetworkCache::NetworkCache() : mCache(capacityBytes()) { mEnabled = mCache.capacity() > 0; }
+
+NetworkCacheKey NetworkCache::makeKey(NnapiModelInfo& modelInfo, IntelDeviceType device,
+                                      V1_1::ExecutionPreference preference, bool stateful,
+                                      bool profiling, size_t& constantBytes) {
+    ContentHash hash;
+    hashModel(hash, modelInfo.getModel());
+    for (const auto& poolInfo : modelInfo.getModelPoolInfos()) {
+        const size_t size = poolInfo.hidlMemory.size();
+        hash.update<uint64_t>(size);
+        hash.update(poolInfo.buffer, size);
+    }
+    constantBytes = modelInfo.getConstantBytes();
+
+    NetworkCacheKey key;
+    hash.finish(key.hashLow, key.hashHigh);
+    key.device = device;
+    key.preference = preference;
+    key.stateful = stateful;
+    key.profiling = profiling;
+    return key;
+}
+
+bool NetworkCache::lookup(const NetworkCacheKey& key, CachedNetwork& network) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mCache.get(key, network)) {
+        mHits++;
+        return true;
+    }
+    mMisses++;
+    return false;
+}
+
+void NetworkCache::insert(const NetworkCacheKey& key, const CachedNetwork& network,
+                          size_t constantBytes) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Networks larger than the whole cache would only evict everything else
+    if (constantBytes > mCache.capacity()) return;
+    mCache.put(key, network, std::max<size_t>(constantBytes, 1));
+}
+
+void NetworkCache::erase(const NetworkCacheKey& key) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCache.erase(key);
+}
+
+std::string NetworkCache::dump(bool json) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::ostringstream out;
+    if (json) {
+        out << "{\"hits\": " << mHits << ", \"misses\": " << mMisses
+            << ", \"entries\": " << mCache.size() << ", \"bytes\": " << mCache.cost()
+            << ", \"capacityBytes\": " << mCache.capacity()
+            << ", \"evictions\": " << mCache.evictions() << "}";
+    } else {
+        out << "network cache hits " << mHits << " misses " << mMisses << " entries "
+            << mCache.size() << " bytes " << mCache.cost() << "/" << mCache.capacity()
+            << " evictions " << mCache.evictions() << "\n";
+    }
+    return out.str();
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
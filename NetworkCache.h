@@ -0,0 +1,81 @@
+#ifndef ANDROID_ML_NN_NETWORK_CACHE_H
+#define ANDROID_ML_NN_NETWORK_CACHE_H
+
+#include <ie_executable_network.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "Driver.h"
+#include "LruCache.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+class NnapiModelInfo;
+struct IoBindings;
+
+// Identifies a compiled network: a 128 bit hash of the model content, constants and pool contents
+// included, and everything besides the model that changes the compiled network
+struct NetworkCacheKey {
+    uint64_t hashLow = 0;
+    uint64_t hashHigh = 0;
+    IntelDeviceType device = IntelDeviceType::CPU;
+    V1_1::ExecutionPreference preference = V1_1::ExecutionPreference::FAST_SINGLE_ANSWER;
+    bool stateful = false;
+    bool profiling = false;
+
+    bool operator<(const NetworkCacheKey& other) const {
+        return std::tie(hashLow, hashHigh, device, preference, stateful, profiling) <
+               std::tie(other.hashLow, other.hashHigh, other.device, other.preference,
+                        other.stateful, other.profiling);
+    }
+};
+
+struct CachedNetwork {
+    InferenceEngine::ExecutableNetwork executable;
+    std::shared_ptr<IoBindings> bindings;
+};
+
+// Driver wide cache of loaded networks, so preparing a model that was prepared before, by the same
+// or another client, skips graph creation and LoadNetwork. Every prepared model creates infer
+// requests of its own on the shared executable network. Bounded by the summed size of the
+// constants of the cached models, which approximates the weights the plugin keeps per network.
+class NetworkCache {
+public:
+    static NetworkCache& get();
+
+    bool isEnabled() const { return mEnabled; }
+
+    // Hashes the model of modelInfo, which needs its constants and model pools mapped
+    static NetworkCacheKey makeKey(NnapiModelInfo& modelInfo, IntelDeviceType device,
+                                   V1_1::ExecutionPreference preference, bool stateful,
+                                   bool profiling, size_t& constantBytes);
+
+    bool lookup(const NetworkCacheKey& key, CachedNetwork& network);
+    void insert(const NetworkCacheKey& key, const CachedNetwork& network, size_t constantBytes);
+    // Drops the reference of the cache, so that the network is released with its last user
+    void erase(const NetworkCacheKey& key);
+
+    std::string dump(bool json);
+
+private:
+    NetworkCache();
+
+    bool mEnabled;
+    std::mutex mMutex;
+    LruCache<NetworkCacheKey, CachedNetwork> mCache;
+    std::atomic<uint64_t> mHits{0};
+    std::atomic<uint64_t> mMisses{0};
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_NETWORK_CACHE_H
@@ -0,0 +1,107 @@
+#include "OperationProfiler.h"
+
+#include <android/log.h>
+#include <log/log.h>
+#include <sstream>
+
+#undef LOG_TAG
+#define LOG_TAG "OperationProfiler"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+OperationProfiler::OperationProfiler(std::vector<OperationType> operationTypes)
+    : mOperationTypes(std::move(operationTypes)), mOperations(mOperationTypes.size()) {}
+
+// Plugins name the layers they derive from a node after it, with a '/' separated suffix
+static const uint32_t* findOperation(std::string name,
+                                     const std::map<std::string, uint32_t>& nodeOperations) {
+    while (true) {
+        auto it = nodeOperations.find(name);
+        if (it != nodeOperations.end()) return &it->second;
+        auto separator = name.rfind('/');
+        if (separator == std::string::npos) return nullptr;
+        name.resize(separator);
+    }
+}
+
+void OperationProfiler::record(
+    const std::map<std::string, InferenceEngine::InferenceEngineProfileInfo>& counts,
+    const std::map<std::string, uint32_t>& nodeOperations) {
+    std::vector<uint64_t> operationTimes(mOperationTypes.size(), 0);
+    std::vector<bool> executed(mOperationTypes.size(), false);
+    uint64_t unattributed = 0;
+    for (const auto& [layer, info] : counts) {
+        if (info.status != InferenceEngine::InferenceEngineProfileInfo::EXECUTED) continue;
+        const auto* operation = findOperation(layer, nodeOperations);
+        if (operation == nullptr || *operation >= operationTimes.size()) {
+            ALOGV("%s layer %s (%s) not attributed", __func__, layer.c_str(), info.layer_type);
+            unattributed += info.realTime_uSec;
+            continue;
+        }
+        operationTimes[*operation] += info.realTime_uSec;
+        executed[*operation] = true;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (size_t i = 0; i < operationTimes.size(); i++) {
+        if (executed[i]) mOperations[i].record(operationTimes[i]);
+    }
+    mUnattributed.record(unattributed);
+    mInferences++;
+}
+
+std::string OperationProfiler::dump(bool json) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::ostringstream out;
+    auto stats = [&](const LatencyHistogram& histogram) {
+        if (json) {
+            out << "\"count\": " << histogram.count() << ", \"totalUs\": " << histogram.total()
+                << ", \"meanUs\": " << histogram.mean() << ", \"p50Us\": "
+                << histogram.percentile(0.5) << ", \"p90Us\": " << histogram.percentile(0.9)
+                << ", \"p99Us\": " << histogram.percentile(0.99)
+                << ", \"maxUs\": " << histogram.max();
+        } else {
+            out << " count " << histogram.count() << " total " << histogram.total() << " us mean "
+                << histogram.mean() << " p50 " << histogram.percentile(0.5) << " p90 "
+                << histogram.percentile(0.9) << " p99 " << histogram.percentile(0.99) << " max "
+                << histogram.max() << "\n";
+        }
+    };
+
+    if (json) {
+        out << "{\"inferences\": " << mInferences << ", \"operations\": [";
+    } else {
+        out << "inferences " << mInferences << "\n";
+    }
+    bool first = true;
+    for (size_t i = 0; i < mOperations.size(); i++) {
+        const auto type = toString(mOperationTypes[i]);
+        if (json) {
+            out << (first ? "" : ", ") << "{\"index\": " << i << ", \"type\": \"" << type
+                << "\", ";
+            stats(mOperations[i]);
+            out << "}";
+        } else {
+            out << "  #" << i << " " << type;
+            stats(mOperations[i]);
+        }
+        first = false;
+    }
+    if (json) {
+        out << "], \"unattributed\": {";
+        stats(mUnattributed);
+        out << "}}";
+    } else {
+        out << "  unattributed";
+        stats(mUnattributed);
+    }
+    return out.str();
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
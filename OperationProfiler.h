@@ -0,0 +1,44 @@
+#ifndef ANDROID_ML_NN_OPERATION_PROFILER_H
+#define ANDROID_ML_NN_OPERATION_PROFILER_H
+
+#include <ie_common.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Driver.h"
+#include "LatencyHistogram.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Aggregates the per layer performance counters of a network's inferences into latency
+// histograms per NNAPI operation.
+class OperationProfiler {
+public:
+    explicit OperationProfiler(std::vector<OperationType> operationTypes);
+
+    // Adds one inference. nodeOperations maps the nodes of the network which ran to operation
+    // indices; layers the plugin added on its own count as unattributed.
+    void record(const std::map<std::string, InferenceEngine::InferenceEngineProfileInfo>& counts,
+                const std::map<std::string, uint32_t>& nodeOperations);
+
+    std::string dump(bool json);
+
+private:
+    std::mutex mMutex;
+    const std::vector<OperationType> mOperationTypes;
+    std::vector<LatencyHistogram> mOperations;
+    LatencyHistogram mUnattributed;
+    uint64_t mInferences = 0;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_OPERATION_PROFILER_H
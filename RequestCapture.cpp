@@ -0,0 +1,307 @@
+#include "RequestCapture.h"
+
+#include <android/log.h>
+#include <log/log.h>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#undef LOG_TAG
+#define LOG_TAG "RequestCapture"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'N', 'H', 'A', 'L', 'C', 'A', 'P'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kModelTag = 1;
+constexpr uint32_t kRequestTag = 2;
+
+enum ExtraParamsKind : uint8_t { kNoExtraParams, kChannelQuant, kExtension };
+
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : mOut(out) {}
+
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+        putBytes(&value, sizeof(value));
+    }
+    void putBytes(const void* data, size_t length) {
+        auto* bytes = static_cast<const uint8_t*>(data);
+        mOut.insert(mOut.end(), bytes, bytes + length);
+    }
+    template <typename Vector>
+    void putVector(const Vector& values) {
+        put<uint32_t>(values.size());
+        if (values.size() > 0) putBytes(values.data(), values.size() * sizeof(values[0]));
+    }
+
+private:
+    std::vector<uint8_t>& mOut;
+};
+
+// Reads past the end fail once and leave every later read failing as well
+class ByteReader {
+public:
+    explicit ByteReader(const std::vector<uint8_t>& in) : mIn(in) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        getBytes(&value, sizeof(value));
+        return value;
+    }
+    void getBytes(void* data, size_t length) {
+        if (!mOk || mIn.size() - mOffset < length) {
+            mOk = false;
+            return;
+        }
+        std::memcpy(data, mIn.data() + mOffset, length);
+        mOffset += length;
+    }
+    template <typename Vector>
+    void getVector(Vector& values) {
+        const uint32_t count = get<uint32_t>();
+        if (!mOk || (mIn.size() - mOffset) / std::max<size_t>(sizeof(values[0]), 1) < count) {
+            mOk = false;
+            return;
+        }
+        values.resize(count);
+        if (count > 0) getBytes(&values[0], count * sizeof(values[0]));
+    }
+    bool ok() const { return mOk; }
+
+private:
+    const std::vector<uint8_t>& mIn;
+    size_t mOffset = 0;
+    bool mOk = true;
+};
+
+void writeSubgraph(ByteWriter& writer, const V1_3::Subgraph& subgraph) {
+    writer.put<uint32_t>(subgraph.operands.size());
+    for (const auto& operand : subgraph.operands) {
+        writer.put(operand.type);
+        writer.putVector(operand.dimensions);
+        writer.put(operand.numberOfConsumers);
+        writer.put(operand.scale);
+        writer.put(operand.zeroPoint);
+        writer.put(operand.lifetime);
+        writer.put(operand.location);
+        using Discriminator = V1_2::Operand::ExtraParams::hidl_discriminator;
+        switch (operand.extraParams.getDiscriminator()) {
+            case Discriminator::channelQuant:
+                writer.put(kChannelQuant);
+                writer.putVector(operand.extraParams.channelQuant().scales);
+                writer.put(operand.extraParams.channelQuant().channelDim);
+                break;
+            case Discriminator::extension:
+                writer.put(kExtension);
+                writer.putVector(operand.extraParams.extension());
+                break;
+            default:
+                writer.put(kNoExtraParams);
+                break;
+        }
+    }
+    writer.put<uint32_t>(subgraph.operations.size());
+    for (const auto& operation : subgraph.operations) {
+        writer.put(operation.type);
+        writer.putVector(operation.inputs);
+        writer.putVector(operation.outputs);
+    }
+    writer.putVector(subgraph.inputIndexes);
+    writer.putVector(subgraph.outputIndexes);
+}
+
+void readSubgraph(ByteReader& reader, V1_3::Subgraph& subgraph) {
+    subgraph.operands.resize(reader.ok() ? reader.get<uint32_t>() : 0);
+    for (auto& operand : subgraph.operands) {
+        if (!reader.ok()) return;
+        operand.type = reader.get<OperandType>();
+        reader.getVector(operand.dimensions);
+        operand.numberOfConsumers = reader.get<uint32_t>();
+        operand.scale = reader.get<float>();
+        operand.zeroPoint = reader.get<int32_t>();
+        operand.lifetime = reader.get<OperandLifeTime>();
+        operand.location = reader.get<V1_0::DataLocation>();
+        switch (reader.get<uint8_t>()) {
+            case kChannelQuant: {
+                V1_2::SymmPerChannelQuantParams params;
+                reader.getVector(params.scales);
+                params.channelDim = reader.get<uint32_t>();
+                operand.extraParams.channelQuant(params);
+                break;
+            }
+            case kExtension: {
+                hidl_vec<uint8_t> data;
+                reader.getVector(data);
+                operand.extraParams.extension(data);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    subgraph.operations.resize(reader.ok() ? reader.get<uint32_t>() : 0);
+    for (auto& operation : subgraph.operations) {
+        if (!reader.ok()) return;
+        operation.type = reader.get<OperationType>();
+        reader.getVector(operation.inputs);
+        reader.getVector(operation.outputs);
+    }
+    reader.getVector(subgraph.inputIndexes);
+    reader.getVector(subgraph.outputIndexes);
+}
+
+void writeTensors(ByteWriter& writer, const std::vector<CapturedTensor>& tensors) {
+    writer.put<uint32_t>(tensors.size());
+    for (const auto& tensor : tensors) {
+        writer.putVector(tensor.dimensions);
+        writer.putVector(tensor.data);
+    }
+}
+
+void readTensors(ByteReader& reader, std::vector<CapturedTensor>& tensors) {
+    tensors.resize(reader.ok() ? reader.get<uint32_t>() : 0);
+    for (auto& tensor : tensors) {
+        if (!reader.ok()) return;
+        reader.getVector(tensor.dimensions);
+        reader.getVector(tensor.data);
+    }
+}
+
+}  // namespace
+
+CaptureWriter::~CaptureWriter() {
+    if (mFile != nullptr) fclose(mFile);
+}
+
+bool CaptureWriter::writeRecord(uint32_t tag, const std::vector<uint8_t>& payload) {
+    const uint64_t length = payload.size();
+    return fwrite(&tag, sizeof(tag), 1, mFile) == 1 &&
+           fwrite(&length, sizeof(length), 1, mFile) == 1 &&
+           fwrite(payload.data(), 1, payload.size(), mFile) == payload.size();
+}
+
+bool CaptureWriter::open(const std::string& path, const Model& model,
+                         const std::vector<std::vector<uint8_t>>& poolContents) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFile = fopen(path.c_str(), "wb");
+    if (mFile == nullptr) {
+        ALOGE("%s Failed to create %s", __func__, path.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> payload;
+    ByteWriter writer(payload);
+    writeSubgraph(writer, model.main);
+    writer.put<uint32_t>(model.referenced.size());
+    for (const auto& subgraph : model.referenced) writeSubgraph(writer, subgraph);
+    writer.putVector(model.operandValues);
+    writer.put<uint32_t>(poolContents.size());
+    for (const auto& contents : poolContents) writer.putVector(contents);
+    writer.put<uint8_t>(model.relaxComputationFloat32toFloat16);
+
+    if (fwrite(kMagic, sizeof(kMagic), 1, mFile) != 1 ||
+        fwrite(&kVersion, sizeof(kVersion), 1, mFile) != 1 || !writeRecord(kModelTag, payload)) {
+        ALOGE("%s Failed to write the model to %s", __func__, path.c_str());
+        fclose(mFile);
+        mFile = nullptr;
+        return false;
+    }
+    fflush(mFile);
+    ALOGI("%s Capturing requests to %s", __func__, path.c_str());
+    return true;
+}
+
+bool CaptureWriter::write(const CapturedRequest& request) {
+    std::vector<uint8_t> payload;
+    ByteWriter writer(payload);
+    writer.put(request.offsetNs);
+    writer.put(request.latencyUs);
+    writer.put(request.status);
+    writeTensors(writer, request.inputs);
+    writeTensors(writer, request.outputs);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mFile == nullptr) return false;
+    if (!writeRecord(kRequestTag, payload)) {
+        ALOGE("%s Failed to write, capture stopped", __func__);
+        fclose(mFile);
+        mFile = nullptr;
+        return false;
+    }
+    fflush(mFile);
+    return true;
+}
+
+CaptureReader::~CaptureReader() {
+    if (mFile != nullptr) fclose(mFile);
+}
+
+bool CaptureReader::open(const std::string& path) {
+    mFile = fopen(path.c_str(), "rb");
+    if (mFile == nullptr) return false;
+    char magic[sizeof(kMagic)];
+    uint32_t version = 0;
+    if (fread(magic, sizeof(magic), 1, mFile) != 1 || memcmp(magic, kMagic, sizeof(magic)) ||
+        fread(&version, sizeof(version), 1, mFile) != 1 || version != kVersion) {
+        ALOGE("%s %s is not a capture of version %u", __func__, path.c_str(), kVersion);
+        return false;
+    }
+    return true;
+}
+
+bool CaptureReader::readRecord(uint32_t& tag, std::vector<uint8_t>& payload) {
+    uint64_t length = 0;
+    if (mFile == nullptr || fread(&tag, sizeof(tag), 1, mFile) != 1 ||
+        fread(&length, sizeof(length), 1, mFile) != 1) {
+        return false;
+    }
+    payload.resize(length);
+    return fread(payload.data(), 1, length, mFile) == length;
+}
+
+bool CaptureReader::readModel(Model& model, std::vector<std::vector<uint8_t>>& poolContents) {
+    uint32_t tag = 0;
+    std::vector<uint8_t> payload;
+    if (!readRecord(tag, payload) || tag != kModelTag) return false;
+
+    ByteReader reader(payload);
+    readSubgraph(reader, model.main);
+    model.referenced.resize(reader.ok() ? reader.get<uint32_t>() : 0);
+    for (auto& subgraph : model.referenced) readSubgraph(reader, subgraph);
+    reader.getVector(model.operandValues);
+    poolContents.resize(reader.ok() ? reader.get<uint32_t>() : 0);
+    for (auto& contents : poolContents) reader.getVector(contents);
+    model.relaxComputationFloat32toFloat16 = reader.get<uint8_t>();
+    return reader.ok();
+}
+
+bool CaptureReader::next(CapturedRequest& request) {
+    uint32_t tag = 0;
+    std::vector<uint8_t> payload;
+    // Records of kinds this reader doesn't know are skipped
+    do {
+        if (!readRecord(tag, payload)) return false;
+    } while (tag != kRequestTag);
+
+    ByteReader reader(payload);
+    request.offsetNs = reader.get<uint64_t>();
+    request.latencyUs = reader.get<uint64_t>();
+    request.status = reader.get<int32_t>();
+    readTensors(reader, request.inputs);
+    readTensors(reader, request.outputs);
+    return reader.ok();
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,73 @@
+#ifndef ANDROID_ML_NN_REQUEST_CAPTURE_H
+#define ANDROID_ML_NN_REQUEST_CAPTURE_H
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Driver.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Capture files hold a model followed by a sample of the requests executed with it, for
+// reproducing the traffic of a prepared model offline. After an 8 byte magic and a 32 bit
+// version, the file is a sequence of records, each a 32 bit tag and a 64 bit payload length
+// followed by the payload. The model record comes first and carries the contents of the model
+// pools, request records carry the input and output tensors. Integers are in host byte order.
+
+struct CapturedTensor {
+    std::vector<uint32_t> dimensions;
+    std::vector<uint8_t> data;
+};
+
+struct CapturedRequest {
+    // Since the capture started, to replay at the original pace
+    uint64_t offsetNs = 0;
+    uint64_t latencyUs = 0;
+    int32_t status = 0;
+    std::vector<CapturedTensor> inputs;
+    std::vector<CapturedTensor> outputs;
+};
+
+class CaptureWriter {
+public:
+    ~CaptureWriter();
+
+    // poolContents holds the bytes of every model pool, as those can't be serialized as handles
+    bool open(const std::string& path, const Model& model,
+              const std::vector<std::vector<uint8_t>>& poolContents);
+    bool write(const CapturedRequest& request);
+
+private:
+    bool writeRecord(uint32_t tag, const std::vector<uint8_t>& payload);
+
+    std::mutex mMutex;
+    FILE* mFile = nullptr;
+};
+
+class CaptureReader {
+public:
+    ~CaptureReader();
+
+    bool open(const std::string& path);
+    // The model comes back without pools, the pool contents are returned separately
+    bool readModel(Model& model, std::vector<std::vector<uint8_t>>& poolContents);
+    // False at the end of the file or on a malformed record
+    bool next(CapturedRequest& request);
+
+private:
+    bool readRecord(uint32_t& tag, std::vector<uint8_t>& payload);
+
+    FILE* mFile = nullptr;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_REQUEST_CAPTURE_H
@@ -0,0 +1,169 @@
+#include "ResidencyManager.h"
+
+#include <android/log.h>
+#include <cutils/properties.h>
+#include <log/log.h>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "BasePreparedModel.h"
+
+#undef LOG_TAG
+#define LOG_TAG "ResidencyManager"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Opt-in budget in MB for the networks of all prepared models, and how long a model has to be
+// unused before it may be evicted
+static const char* kMemoryBudgetProperty = "vendor.nn.hal.memory_budget_mb";
+static const char* kMinIdleProperty = "vendor.nn.hal.memory_budget.min_idle_ms";
+static const int32_t kDefaultMinIdleMs = 1000;
+
+ResidencyManager& ResidencyManager::get() {
+    static ResidencyManager sManager;
+    return sManager;
+}
+
+ResidencyManager::ResidencyManager()
+    : mBudgetBytes(size_t(std::max(property_get_int32(kMemoryBudgetProperty, 0), 0)) << 20),
+      mMinIdle(std::max(property_get_int32(kMinIdleProperty, kDefaultMinIdleMs), 0)) {}
+
+void ResidencyManager::add(BasePreparedModel* preparedModel, const void* network,
+                           size_t footprintBytes) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& entry = mEntries[preparedModel];
+        entry = {preparedModel, network, footprintBytes, false, true};
+        acquire(entry);
+    }
+    enforceBudget(preparedModel);
+}
+
+void ResidencyManager::remove(BasePreparedModel* preparedModel) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mEntries.find(preparedModel);
+    if (it == mEntries.end()) return;
+    if (it->second.resident) release(it->second);
+    mEntries.erase(it);
+}
+
+void ResidencyManager::reloaded(BasePreparedModel* preparedModel, const void* network) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mEntries.find(preparedModel);
+        if (it == mEntries.end() || it->second.resident) return;
+        it->second.network = network;
+        acquire(it->second);
+        mReloads++;
+    }
+    enforceBudget(preparedModel);
+}
+
+void ResidencyManager::acquire(Entry& entry) {
+    entry.resident = true;
+    if (mNetworkUsers[entry.network]++ == 0) mResidentBytes += entry.footprintBytes;
+}
+
+void ResidencyManager::release(Entry& entry) {
+    entry.resident = false;
+    auto it = mNetworkUsers.find(entry.network);
+    if (--it->second > 0) return;
+    mNetworkUsers.erase(it);
+    mResidentBytes -= entry.footprintBytes;
+}
+
+void ResidencyManager::enforceBudget(BasePreparedModel* keep) {
+    using time_point = std::chrono::steady_clock::time_point;
+    // Strong references keep the victims alive while they export their network outside the lock
+    std::vector<sp<BasePreparedModel>> victims;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mResidentBytes <= mBudgetBytes) return;
+
+        // Entries are removed by the destructor of their model, so the model of every entry is
+        // still there to read its last use from. Evicting a model only frees its network along
+        // with the other models resident on it, so networks are evicted as a whole, once all of
+        // their models are idle, ordered by the last use of any of them.
+        const auto idleBefore = std::chrono::steady_clock::now() - mMinIdle;
+        struct Candidate {
+            time_point lastUse = time_point::min();
+            std::vector<BasePreparedModel*> models;
+        };
+        std::map<const void*, Candidate> networks;
+        for (const auto& entry : mEntries) {
+            if (!entry.second.resident) continue;
+            auto& candidate = networks[entry.second.network];
+            const auto lastUse = entry.first->getLastUse();
+            if (entry.first == keep || !entry.second.evictable || lastUse > idleBefore) {
+                candidate.lastUse = time_point::max();
+                continue;
+            }
+            candidate.lastUse = std::max(candidate.lastUse, lastUse);
+            candidate.models.push_back(entry.first);
+        }
+        std::vector<std::pair<time_point, const void*>> idle;
+        for (const auto& network : networks) {
+            if (network.second.lastUse != time_point::max())
+                idle.emplace_back(network.second.lastUse, network.first);
+        }
+        std::sort(idle.begin(), idle.end());
+
+        for (const auto& candidate : idle) {
+            if (mResidentBytes <= mBudgetBytes) break;
+            for (auto* model : networks[candidate.second].models) {
+                auto& entry = mEntries[model];
+                sp<BasePreparedModel> preparedModel = entry.preparedModel.promote();
+                // Being destroyed, which releases the network anyway and the entry with it
+                if (preparedModel == nullptr) continue;
+                release(entry);
+                victims.push_back(preparedModel);
+            }
+        }
+        if (mResidentBytes > mBudgetBytes) {
+            ALOGD("%s %zu bytes resident over a budget of %zu, no more idle models", __func__,
+                  mResidentBytes, mBudgetBytes);
+        }
+    }
+
+    for (const auto& victim : victims) {
+        const bool evicted = victim->evict();
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& entry = mEntries[victim.get()];
+        if (evicted) {
+            mEvictions++;
+            continue;
+        }
+        mEvictionFailures++;
+        entry.evictable = false;
+        if (!entry.resident) acquire(entry);
+    }
+    // Dropping the last reference to a victim destroys it, which takes the lock
+    victims.clear();
+}
+
+std::string ResidencyManager::dump(bool json) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t resident = std::count_if(mEntries.begin(), mEntries.end(),
+                                    [](const auto& entry) { return entry.second.resident; });
+    std::ostringstream out;
+    if (json) {
+        out << "{\"budgetBytes\": " << mBudgetBytes << ", \"residentBytes\": " << mResidentBytes
+            << ", \"models\": " << mEntries.size() << ", \"residentModels\": " << resident
+            << ", \"evictions\": " << mEvictions << ", \"evictionFailures\": " << mEvictionFailures
+            << ", \"reloads\": " << mReloads << "}";
+    } else {
+        out << "memory budget " << mResidentBytes << "/" << mBudgetBytes << " bytes resident, "
+            << resident << "/" << mEntries.size() << " models resident, evictions " << mEvictions
+            << " failures " << mEvictionFailures << " reloads " << mReloads << "\n";
+    }
+    return out.str();
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
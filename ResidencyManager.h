@@ -0,0 +1,77 @@
+#ifndef ANDROID_ML_NN_RESIDENCY_MANAGER_H
+#define ANDROID_ML_NN_RESIDENCY_MANAGER_H
+
+#include <utils/RefBase.h>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+class BasePreparedModel;
+
+// Keeps the loaded networks of the prepared models within a driver wide memory budget. Clients
+// prepare eagerly and rarely release, so when the footprint of the resident networks exceeds the
+// budget the least recently used models idle for long enough export their network to a file and
+// release it. Their next execution imports it again, see BasePreparedModel::evict. Models sharing
+// a network of the network cache only free it together, the footprint is accounted once per
+// network and credited when its last model was evicted.
+class ResidencyManager {
+public:
+    static ResidencyManager& get();
+
+    bool isEnabled() const { return mBudgetBytes > 0; }
+
+    // Starts accounting a prepared model whose network was just loaded, footprintBytes being
+    // what releasing the network frees. network identifies the loaded network, the same for all
+    // the models sharing it.
+    void add(BasePreparedModel* preparedModel, const void* network, size_t footprintBytes);
+    void remove(BasePreparedModel* preparedModel);
+    // Called once the network of an evicted model was imported again, into a network of its own
+    void reloaded(BasePreparedModel* preparedModel, const void* network);
+
+    std::string dump(bool json);
+
+private:
+    ResidencyManager();
+
+    // Evicts idle models, least recently used first, until the resident networks fit the budget.
+    // keep was just used and stays resident.
+    void enforceBudget(BasePreparedModel* keep);
+
+    struct Entry {
+        wp<BasePreparedModel> preparedModel;
+        const void* network;
+        size_t footprintBytes;
+        bool resident;
+        // Cleared when the model can't export its network
+        bool evictable;
+    };
+
+    // Count the entry as a resident user of its network, or stop to, with mMutex held
+    void acquire(Entry& entry);
+    void release(Entry& entry);
+
+    size_t mBudgetBytes;
+    std::chrono::milliseconds mMinIdle;
+    std::mutex mMutex;
+    std::map<BasePreparedModel*, Entry> mEntries;
+    // Resident models per network, mResidentBytes has the footprint of each network counted once
+    std::map<const void*, size_t> mNetworkUsers;
+    size_t mResidentBytes = 0;
+    uint64_t mEvictions = 0;
+    uint64_t mEvictionFailures = 0;
+    uint64_t mReloads = 0;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_RESIDENCY_MANAGER_H
@@ -0,0 +1,168 @@
+#include "Tracer.h"
+
+#include <cutils/properties.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#if __ANDROID__
+#define ATRACE_TAG ATRACE_TAG_NNAPI
+#include <cutils/trace.h>
+#endif
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+namespace {
+
+static const char* kTraceProperty = "vendor.nn.hal.trace";
+
+// Slots are overwritten while the exporting thread may read them, fields are atomics so that
+// torn reads are detected by the sequence check in exportChromeJson instead of being undefined
+struct Span {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> startNs{0};
+    std::atomic<uint64_t> endNs{0};
+};
+
+struct ThreadBuffer {
+    int tid = 0;
+    std::array<Span, Tracer::kCapacity> spans;
+    std::atomic<uint64_t> written{0};
+};
+
+// Buffers outlive their threads so that spans of finished executions can still be exported
+std::mutex sBuffersMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> sBuffers;
+
+ThreadBuffer* threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->tid = static_cast<int>(syscall(SYS_gettid));
+        std::lock_guard<std::mutex> lock(sBuffersMutex);
+        sBuffers.push_back(buffer);
+    }
+    return buffer.get();
+}
+
+}  // namespace
+
+bool Tracer::isEnabled() {
+    static const bool enabled = property_get_bool(kTraceProperty, true);
+    return enabled;
+}
+
+uint64_t Tracer::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void Tracer::record(const char* name, uint64_t startNs, uint64_t endNs) {
+    auto* buffer = threadBuffer();
+    const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    auto& span = buffer->spans[index % kCapacity];
+    span.name.store(name, std::memory_order_relaxed);
+    span.startNs.store(startNs, std::memory_order_relaxed);
+    span.endNs.store(endNs, std::memory_order_relaxed);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+std::string Tracer::exportChromeJson() {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(sBuffersMutex);
+        buffers = sBuffers;
+    }
+
+    std::ostringstream out;
+    out << "{\"traceEvents\": [";
+    bool first = true;
+    const int pid = getpid();
+    for (const auto& buffer : buffers) {
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t begin = written > kCapacity ? written - kCapacity : 0;
+        std::vector<std::array<uint64_t, 2>> times;
+        std::vector<const char*> names;
+        for (uint64_t i = begin; i < written; i++) {
+            const auto& span = buffer->spans[i % kCapacity];
+            names.push_back(span.name.load(std::memory_order_relaxed));
+            times.push_back({span.startNs.load(std::memory_order_relaxed),
+                             span.endNs.load(std::memory_order_relaxed)});
+        }
+        // Spans the owning thread overwrote while they were read are dropped
+        const uint64_t rewritten = buffer->written.load(std::memory_order_acquire);
+        const uint64_t valid = rewritten > kCapacity ? rewritten - kCapacity : 0;
+        for (uint64_t i = std::max(begin, valid); i < written; i++) {
+            const auto& time = times[i - begin];
+            out << (first ? "" : ",") << "\n{\"name\": \"" << names[i - begin]
+                << "\", \"ph\": \"X\", \"pid\": " << pid << ", \"tid\": " << buffer->tid
+                << ", \"ts\": " << time[0] / 1000.0 << ", \"dur\": " << (time[1] - time[0]) / 1000.0
+                << "}";
+            first = false;
+        }
+    }
+    out << "\n], \"displayTimeUnit\": \"ms\"}\n";
+    return out.str();
+}
+
+static int32_t nextCookie() {
+    static std::atomic<int32_t> sCookie{0};
+    // Never 0, which marks a scope on one thread
+    return (sCookie.fetch_add(1, std::memory_order_relaxed) & 0x7fffffff) + 1;
+}
+
+ScopedTrace::ScopedTrace(ExecutionStage stage, ModelMetrics* metrics, bool async)
+    : mStage(stage),
+      mMetrics(metrics),
+      mTracing(Tracer::isEnabled()),
+      mCookie(async ? nextCookie() : 0) {
+    if (mTracing || mMetrics) begin(Tracer::nowNs());
+}
+
+ScopedTrace::~ScopedTrace() {
+    if (mTracing || mMetrics) end(Tracer::nowNs());
+}
+
+void ScopedTrace::next(ExecutionStage stage) {
+    if (!mTracing && !mMetrics) {
+        mStage = stage;
+        return;
+    }
+    const uint64_t nowNs = Tracer::nowNs();
+    end(nowNs);
+    mStage = stage;
+    begin(nowNs);
+}
+
+void ScopedTrace::begin(uint64_t nowNs) {
+    mStartNs = nowNs;
+#if __ANDROID__
+    if (mTracing && mCookie) ATRACE_ASYNC_BEGIN(executionStageName(mStage), mCookie);
+    if (mTracing && !mCookie) ATRACE_BEGIN(executionStageName(mStage));
+#endif
+}
+
+void ScopedTrace::end(uint64_t nowNs) {
+#if __ANDROID__
+    if (mTracing && mCookie) ATRACE_ASYNC_END(executionStageName(mStage), mCookie);
+    if (mTracing && !mCookie) ATRACE_END();
+#endif
+    if (mTracing) Tracer::record(executionStageName(mStage), mStartNs, nowNs);
+    if (mMetrics) mMetrics->recordStage(mStage, nowNs - mStartNs);
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
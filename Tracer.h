@@ -0,0 +1,63 @@
+#ifndef ANDROID_ML_NN_TRACER_H
+#define ANDROID_ML_NN_TRACER_H
+
+#include <cstdint>
+#include <string>
+
+#include "Metrics.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Spans of the execution pipeline, recorded into a ring buffer owned by the recording thread.
+// Recording takes no locks and every thread keeps its most recent kCapacity spans. On Android
+// the spans also go to atrace. Recording is on unless vendor.nn.hal.trace is set to false.
+class Tracer {
+public:
+    static constexpr size_t kCapacity = 4096;
+
+    static bool isEnabled();
+    // name must outlive the tracer, spans keep the pointer
+    static void record(const char* name, uint64_t startNs, uint64_t endNs);
+    static uint64_t nowNs();
+
+    // Chrome trace event JSON of the spans currently held, for chrome://tracing or Perfetto
+    static std::string exportChromeJson();
+};
+
+// Traces the enclosing scope as an execution stage. The stage latency also goes into metrics when
+// given, whether or not tracing is enabled. next() ends the current stage and starts the next
+// one, which lets a straight pipeline be traced stage by stage without restructuring it.
+// Stages of an asynchronous execution may end on another thread than the one they began on,
+// they are traced as async atrace slices.
+class ScopedTrace {
+public:
+    explicit ScopedTrace(ExecutionStage stage, ModelMetrics* metrics = nullptr,
+                         bool async = false);
+    ~ScopedTrace();
+
+    void next(ExecutionStage stage);
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    void begin(uint64_t nowNs);
+    void end(uint64_t nowNs);
+
+    ExecutionStage mStage;
+    ModelMetrics* mMetrics;
+    const bool mTracing;
+    // Cookie of the async slices, 0 for a scope on one thread
+    const int32_t mCookie;
+    uint64_t mStartNs = 0;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_TRACER_H
@@ -37,7 +37,6 @@ public:
     CpuPreparedModel(const Model& model) : BasePreparedModel(IntelDeviceType::CPU, model) {}
     ~CpuPreparedModel() { deinitialize(); }
 
-    bool initialize() override;
     Return<void> configureExecutionBurst(
         const sp<V1_2::IBurstCallback>& callback,
         const MQDescriptorSync<V1_2::FmqRequestDatum>& requestChannel,
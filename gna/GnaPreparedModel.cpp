@@ -24,35 +24,6 @@ void GnaPreparedModel::deinitialize() {
     ALOGV("Exiting %s", __func__);
 }
 
-bool GnaPreparedModel::initialize() {
-    ALOGV("Entering %s", __func__);
-    if (!mModelInfo->initRuntimeInfo()) {
-        ALOGE("Failed to initialize Model runtime parameters!!");
-        return false;
-    }
-    mNgraphNetCreator = std::make_shared<NgraphNetworkCreator>(mModelInfo, mTargetDevice);
-
-    if (!mNgraphNetCreator->validateOperations()) return false;
-    ALOGI("Generating IR Graph");
-    auto ngraph_function = mNgraphNetCreator->generateGraph();
-    if (ngraph_function == nullptr) {
-        ALOGE("%s ngraph generation failed", __func__);
-        return false;
-    }
-    auto ngraph_net = std::make_shared<InferenceEngine::CNNNetwork>(ngraph_function);
-#if __ANDROID__
-    ngraph_net->serialize("/data/vendor/neuralnetworks/ngraph_ir.xml",
-                          "/data/vendor/neuralnetworks/ngraph_ir.bin");
-#else
-    ngraph_net->serialize("/tmp/ngraph_ir.xml", "/tmp/ngraph_ir.bin");
-#endif
-    mPlugin = std::make_shared<IENetwork>(ngraph_net);
-    mPlugin->loadNetwork();
-
-    ALOGV("Exiting %s", __func__);
-    return true;
-}
-
 Return<void> GnaPreparedModel::configureExecutionBurst(
     const sp<V1_2::IBurstCallback>& callback,
     const MQDescriptorSync<V1_2::FmqRequestDatum>& requestChannel,
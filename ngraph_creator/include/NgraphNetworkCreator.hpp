@@ -11,24 +11,51 @@ namespace hardware {
 namespace neuralnetworks {
 namespace nnhal {
 
+// Only one model is translated at a time, a creator holds the translation lock of its
+// OperationsFactory from construction until it is destroyed
 class NgraphNetworkCreator {
 private:
     std::shared_ptr<NnapiModelInfo> mModelInfo;
     std::vector<std::shared_ptr<OperationsBase>> mOperationNodes;
     std::shared_ptr<NgraphNodes> mNgraphNodes;
     OperationsFactory mOpFactoryInstance;
+    // Recurrent state input operand index -> output operand index carrying its next value.
+    // Only populated when stateful mode is enabled.
+    std::map<uint32_t, uint32_t> mStateOperands;
+    // Friendly name of every node created for an operation -> NNAPI operation index
+    std::map<std::string, uint32_t> mNodeOperations;
     bool createInputParams();
+    bool createStateNode(uint32_t inputIndex);
+    void connectStateNodes();
+    void findStateOperands();
+    bool connectOperations();
+    void mapOperationNodes(uint32_t operationIndex);
     bool initializeModel();
+    bool createSubgraph(const std::vector<ngraph::Output<ngraph::Node>>& inputs,
+                        std::vector<ngraph::Output<ngraph::Node>>& outputs);
 
 public:
     NgraphNetworkCreator(std::shared_ptr<NnapiModelInfo> modelInfo, IntelDeviceType deviceType);
     ~NgraphNetworkCreator();
-    void getSupportedOperations(std::vector<bool>& supportedOperations);
     bool validateOperations();
+    // Keeps recurrent state of LSTM/RNN operations resident in the plugin across executions,
+    // using ReadValue/Assign pairs instead of round-tripping it through request memory.
+    void enableStatefulMode();
+    bool isStateInput(uint32_t index) { return mStateOperands.count(index) != 0; }
 
     const std::string& getNodeName(uint32_t index);
+    // Lets plugin layer names, derived from node names, be attributed to NNAPI operations
+    const std::map<std::string, uint32_t>& getNodeOperations() { return mNodeOperations; }
 
     std::shared_ptr<ngraph::Function> generateGraph();
+
+    // Control flow support. Translates the referenced subgraph held by SUBGRAPH operand
+    // operandIndex of the model currently being translated, with the subgraph inputs bound to
+    // nodes of the enclosing graph. Outputs are returned in subgraph output order.
+    static bool translateSubgraph(uint32_t operandIndex,
+                                  const std::vector<ngraph::Output<ngraph::Node>>& inputs,
+                                  std::vector<ngraph::Output<ngraph::Node>>& outputs);
+    static bool validateSubgraph(uint32_t operandIndex);
 };
 
 }  // namespace nnhal
@@ -20,6 +20,8 @@ private:
     std::vector<bool> mForcedNchw;
     std::vector<std::shared_ptr<ngraph::opset3::Parameter>> mInputParams;
     std::vector<std::shared_ptr<ngraph::Node>> mResultNodes;
+    // Assign nodes writing back recurrent state, kept alive by the Function as sinks.
+    ngraph::SinkVector mSinkNodes;
     // mNodeNames are only populated when requested, as only Inputs and Result NodeNames are
     // required.
     std::map<int, std::string> mNodeNames;
@@ -32,6 +34,7 @@ public:
     void setOutputAtOperandIndex(size_t index, ngraph::Output<ngraph::Node> output);
     ngraph::Output<ngraph::Node> getOperationOutput(size_t index);
     void setResultNode(size_t outputIndex, std::shared_ptr<ngraph::Node> resultNode);
+    void addSinkNode(std::shared_ptr<ngraph::op::Sink> sinkNode);
 
     const std::string& getNodeName(size_t index);
     void removeInputParameter(std::string name, size_t index);
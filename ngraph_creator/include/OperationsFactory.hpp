@@ -5,8 +5,11 @@
 #include <Argmax.hpp>
 #include <Argmin.hpp>
 #include <AveragePool2D.hpp>
+#include <AxisAlignedBboxTransform.hpp>
 #include <BatchToSpace.hpp>
+#include <BidirectionalSequenceLSTM.hpp>
 #include <BidirectionalSequenceRNN.hpp>
+#include <BoxWithNmsLimit.hpp>
 #include <Cast.hpp>
 #include <ChannelShuffle.hpp>
 #include <Concat.hpp>
@@ -14,24 +17,32 @@
 #include <DepthToSpace.hpp>
 #include <DepthwiseConv2d.hpp>
 #include <Dequantize.hpp>
+#include <DetectionPostprocessing.hpp>
 #include <Div.hpp>
+#include <Elu.hpp>
 #include <EmbeddingLookup.hpp>
 #include <Equal.hpp>
 #include <Exp.hpp>
 #include <ExpandDims.hpp>
+#include <Fill.hpp>
 #include <Floor.hpp>
 #include <FullyConnected.hpp>
 #include <Gather.hpp>
+#include <GenerateProposals.hpp>
 #include <Greater.hpp>
 #include <GreaterEqual.hpp>
 #include <GroupedConv2d.hpp>
 #include <HardSwish.hpp>
+#include <HashtableLookup.hpp>
+#include <HeatmapMaxKeypoint.hpp>
+#include <If.hpp>
 #include <InstanceNormalization.hpp>
 #include <L2Normalization.hpp>
 #include <L2Pooling2D.hpp>
 #include <LSTM.hpp>
 #include <Less.hpp>
 #include <LessEqual.hpp>
+#include <LocalResponseNormalization.hpp>
 #include <Log.hpp>
 #include <LogSoftmax.hpp>
 #include <LogicalAnd.hpp>
@@ -50,10 +61,13 @@
 #include <PadV2.hpp>
 #include <Pow.hpp>
 #include <Quantize.hpp>
+#include <Quantized16BitLSTM.hpp>
+#include <QuantizedLSTM.hpp>
 #include <RNN.hpp>
 #include <ROIAlign.hpp>
 #include <ROIPooling.hpp>
 #include <RSQRT.hpp>
+#include <Rank.hpp>
 #include <ReduceAll.hpp>
 #include <ReduceAny.hpp>
 #include <ReduceMax.hpp>
@@ -67,8 +81,10 @@
 #include <ResizeBilinear.hpp>
 #include <ResizeNearestNeighbor.hpp>
 #include <SQRT.hpp>
+#include <SVDF.hpp>
 #include <Select.hpp>
 #include <Sin.hpp>
+#include <Slice.hpp>
 #include <Softmax.hpp>
 #include <SpaceToBatch.hpp>
 #include <SpaceToDepth.hpp>
@@ -77,10 +93,13 @@
 #include <StridedSlice.hpp>
 #include <Sub.hpp>
 #include <Tanh.hpp>
+#include <Tile.hpp>
 #include <TopkV2.hpp>
 #include <Transpose.hpp>
 #include <TransposeConv2D.hpp>
+#include <UnidirectionalSequenceLSTM.hpp>
 #include <UnidirectionalSequenceRNN.hpp>
+#include <While.hpp>
 
 namespace android {
 namespace hardware {
@@ -90,6 +109,9 @@ namespace nnhal {
 class OperationsFactory {
 private:
     std::shared_ptr<NgraphNodes> mNgraphNodes;
+    // Translations of other models wait until this factory and its operations are done with
+    // the static model info
+    std::unique_lock<std::recursive_mutex> mTranslationLock;
 
 public:
     OperationsFactory(IntelDeviceType deviceType, std::shared_ptr<NnapiModelInfo> modelInfo,
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Driver.h"
+#include "LruCache.h"
+#include "ModelManager.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Answers getSupportedOperations queries. The runtime asks before every compilation, usually
+// about a model it asked about before, so answers are cached per model content and device. New
+// models are checked one operation object at a time, without the nodes and operation objects of
+// a whole network translator.
+class SupportChecker {
+public:
+    static SupportChecker& get();
+
+    // model must be valid
+    std::vector<bool> getSupportedOperations(const Model& model, IntelDeviceType deviceType);
+
+    std::string dump(bool json);
+
+private:
+    SupportChecker();
+
+    static std::vector<bool> checkOperations(const Model& model, IntelDeviceType deviceType);
+
+    struct Key {
+        uint64_t hashLow;
+        uint64_t hashHigh;
+        IntelDeviceType deviceType;
+
+        bool operator<(const Key& other) const {
+            return std::tie(hashLow, hashHigh, deviceType) <
+                   std::tie(other.hashLow, other.hashHigh, other.deviceType);
+        }
+    };
+
+    std::mutex mMutex;
+    LruCache<Key, std::vector<bool>> mCache;
+    uint64_t mHits = 0;
+    uint64_t mMisses = 0;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <ngraph/ngraph.hpp>
+#include <ngraph/runtime/aligned_buffer.hpp>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Process wide store of constant tensors keyed by their content, type and shape. Graphs sharing
+// weights, such as an encoder used by several heads or a model prepared for CPU and GNA at once,
+// create their constants from one read-only buffer instead of a copy each. A buffer lives as long
+// as a Constant created from it, the plugins copy constants when loading a network so buffers are
+// only shared between graphs that exist at the same time.
+class WeightStore {
+public:
+    static WeightStore& get();
+
+    struct Stats {
+        size_t tensors = 0;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t bytesShared = 0;
+    };
+
+    // Constant holding a copy of data, shared with every other constant of the same content
+    std::shared_ptr<ngraph::Node> createConstant(const ngraph::element::Type& elementType,
+                                                 const ngraph::Shape& shape, const uint8_t* data,
+                                                 size_t length);
+
+    Stats getStats();
+    std::string dump(bool json);
+
+private:
+    WeightStore() = default;
+
+    struct Key {
+        uint64_t hashLow;
+        uint64_t hashHigh;
+        ngraph::element::Type elementType;
+        ngraph::Shape shape;
+
+        bool operator<(const Key& other) const {
+            return std::tie(hashLow, hashHigh, elementType, shape) <
+                   std::tie(other.hashLow, other.hashHigh, other.elementType, other.shape);
+        }
+    };
+
+    std::shared_ptr<ngraph::runtime::AlignedBuffer> acquire(const Key& key, const uint8_t* data,
+                                                            size_t length);
+    void release(const Key& key, ngraph::runtime::AlignedBuffer* buffer);
+
+    std::mutex mMutex;
+    std::map<Key, std::weak_ptr<ngraph::runtime::AlignedBuffer>> mBuffers;
+    size_t mBytes = 0;
+    uint64_t mHits = 0;
+    uint64_t mMisses = 0;
+    uint64_t mBytesShared = 0;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
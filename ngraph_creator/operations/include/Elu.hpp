@@ -0,0 +1,19 @@
+#pragma once
+
+#include <OperationsBase.hpp>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+class Elu : public OperationsBase {
+public:
+    Elu(int operationIndex);
+    std::shared_ptr<ngraph::Node> createNode() override;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -12,6 +12,12 @@ public:
     L2Normalization(int operationIndex);
     bool validate() override;
     std::shared_ptr<ngraph::Node> createNode() override;
+    std::shared_ptr<ngraph::Node> createNodeForPlugin() override;
+
+private:
+    int64_t getAxis();
+    // Elementwise expansion for plugins without a NormalizeL2 layer
+    std::shared_ptr<ngraph::Node> createDecomposedNode();
 };
 
 }  // namespace nnhal
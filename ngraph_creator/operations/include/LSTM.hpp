@@ -7,6 +7,29 @@ namespace hardware {
 namespace neuralnetworks {
 namespace nnhal {
 
+// Weights of one LSTM direction. Input gate weights are null with CIFG, projection and layer
+// normalization weights are null when those are not used. Peephole weights are zero constants
+// when peephole connections are not used.
+struct LstmWeights {
+    std::shared_ptr<ngraph::Node> input2input, input2forget, input2cell, input2output;
+    std::shared_ptr<ngraph::Node> recurrent2input, recurrent2forget, recurrent2cell,
+        recurrent2output;
+    std::shared_ptr<ngraph::Node> cell2input, cell2forget, cell2output;
+    std::shared_ptr<ngraph::Node> inputGateBias, forgetGateBias, cellBias, outputGateBias;
+    std::shared_ptr<ngraph::Node> projectionWeights, projectionBias;
+    std::shared_ptr<ngraph::Node> inputLayerNorm, forgetLayerNorm, cellLayerNorm, outputLayerNorm;
+};
+
+struct LstmParams {
+    bool isCIFGenabled = false;
+    bool isPeepholeUsed = false;
+    bool isProjectionUsed = false;
+    bool isLayerNormUsed = false;
+    uint32_t activationFn = 4;  // tanh
+    float cellClip = 0.f;
+    float projClip = 0.f;
+};
+
 class LSTM : public OperationsBase {
 public:
     LSTM(int operationIndex);
@@ -32,6 +55,37 @@ public:
                                             const std::shared_ptr<ngraph::Node>& bias);
 
     bool isValidInputTensor(uint32_t inputIndex);
+
+protected:
+    // Reads the weights of one direction. weightsIndex is the first of 17 inputs laid out as
+    // inputs 1-17 of LSTM, layerNormIndex the first of 4 layer normalization weights or -1.
+    void getLstmWeights(uint32_t weightsIndex, int32_t layerNormIndex,
+                        const ngraph::element::Type& elementType, size_t numUnits,
+                        size_t outputSize, LstmWeights& weights, LstmParams& params);
+    // Biases of quantized LSTMs are INT32 tensors carrying a scale
+    std::shared_ptr<ngraph::Node> getBiasNode(uint32_t inputIndex);
+    float getClipValue(uint32_t inputIndex);
+
+    // One time step. Produces the input gate, used for the scratch buffer of LSTM, and the new
+    // output and cell states.
+    void createLstmCell(const std::shared_ptr<ngraph::Node>& input,
+                        const std::shared_ptr<ngraph::Node>& hiddenState,
+                        const std::shared_ptr<ngraph::Node>& cellState,
+                        const LstmWeights& weights, const LstmParams& params,
+                        std::shared_ptr<ngraph::Node>& inputGate,
+                        std::shared_ptr<ngraph::Node>& outputState,
+                        std::shared_ptr<ngraph::Node>& newCellState);
+    // Unrolls the cell over a time major [maxTime, batch, inputSize] sequence. Returns the
+    // outputs of all steps and leaves the states of the last processed step in hiddenState and
+    // cellState.
+    std::shared_ptr<ngraph::Node> createLstmSequence(const std::shared_ptr<ngraph::Node>& input,
+                                                     uint32_t maxTime,
+                                                     std::shared_ptr<ngraph::Node>& hiddenState,
+                                                     std::shared_ptr<ngraph::Node>& cellState,
+                                                     const LstmWeights& weights,
+                                                     const LstmParams& params, bool reverse);
+    // Sets an output operand, quantizing it to the operand type if required
+    void connectOutput(uint32_t index, std::shared_ptr<ngraph::Node> outputNode);
 };
 
 }  // namespace nnhal
@@ -11,6 +11,14 @@ class LogSoftmax : public OperationsBase {
 public:
     LogSoftmax(int operationIndex);
     std::shared_ptr<ngraph::Node> createNode() override;
+    std::shared_ptr<ngraph::Node> createNodeForPlugin() override;
+
+private:
+    // beta as a constant of the input type, null when it is 1
+    std::shared_ptr<ngraph::Node> createBetaNode(const ngraph::Shape& shape);
+    int64_t getAxis();
+    // Elementwise expansion for plugins without a LogSoftmax layer
+    std::shared_ptr<ngraph::Node> createDecomposedNode();
 };
 
 }  // namespace nnhal
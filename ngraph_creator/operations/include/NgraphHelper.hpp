@@ -1,5 +1,6 @@
 #pragma once
 #include <log/log.h>
+#include <algorithm>
 #include <ngraph/ngraph.hpp>
 #include <ngraph/opsets/opset3.hpp>
 
@@ -63,6 +64,45 @@ static inline void calculateExplicitPadding(int32_t in_size, int32_t stride, int
     }
 }
 
+// First rows of the NonMaxSuppression outputs, split into [count] columns. The outputs hold the
+// valid selections followed by padding up to maxRows rows. Class and box indices of padding rows
+// are clamped to 0, valid masks the real selections.
+struct NmsSelection {
+    std::shared_ptr<ngraph::Node> batchIndex, classIndex, boxIndex, score, valid, numValid;
+};
+
+static inline NmsSelection selectNmsRows(
+    const std::shared_ptr<ngraph::op::v5::NonMaxSuppression>& nms, int32_t count,
+    int32_t maxRows) {
+    std::vector<int32_t> rows;
+    for (int32_t i = 0; i < count; i++) rows.push_back(std::min(i, maxRows - 1));
+    auto rowsNode = ngraph::op::Constant::create(ngraph::element::i32, {rows.size()}, rows);
+    auto axis0 = ngraph::op::Constant::create(ngraph::element::i32, {}, {0});
+    auto axis1 = ngraph::op::Constant::create(ngraph::element::i32, {}, {1});
+    auto zero = ngraph::op::Constant::create(ngraph::element::i32, {}, {0});
+    auto column = [&](const ngraph::Output<ngraph::Node>& output, int32_t index) {
+        auto selected = std::make_shared<ngraph::opset3::Gather>(output, rowsNode, axis0);
+        auto columnIndex = ngraph::op::Constant::create(ngraph::element::i32, {}, {index});
+        return std::make_shared<ngraph::opset3::Gather>(selected, columnIndex, axis1);
+    };
+
+    NmsSelection selection;
+    selection.numValid = std::make_shared<ngraph::opset3::Convert>(nms->output(2),
+                                                                   ngraph::element::i32);
+    std::vector<int32_t> range(count);
+    for (int32_t i = 0; i < count; i++) range[i] = i;
+    selection.valid = std::make_shared<ngraph::opset3::Less>(
+        ngraph::op::Constant::create(ngraph::element::i32, {range.size()}, range),
+        selection.numValid);
+    selection.batchIndex =
+        std::make_shared<ngraph::opset3::Maximum>(column(nms->output(0), 0), zero);
+    selection.classIndex =
+        std::make_shared<ngraph::opset3::Maximum>(column(nms->output(0), 1), zero);
+    selection.boxIndex = std::make_shared<ngraph::opset3::Maximum>(column(nms->output(0), 2), zero);
+    selection.score = column(nms->output(1), 2);
+    return selection;
+}
+
 }  // namespace nnhal
 }  // namespace neuralnetworks
 }  // namespace hardware
@@ -5,8 +5,10 @@
 #include <log/log.h>
 #include <NgraphHelper.hpp>
 #include <NgraphNodes.hpp>
+#include <WeightStore.hpp>
 #include <ngraph/ngraph.hpp>
 #include <ngraph/opsets/opset3.hpp>
+#include <mutex>
 
 #include "ModelManager.h"
 
@@ -60,66 +62,51 @@ protected:
         auto operandIndex = sModelInfo->getOperationInput(mNnapiOperationIndex, inputIndex);
         auto operandType = sModelInfo->getOperandType(operandIndex);
         if (sModelInfo->isOperandLifeTimeConst(operandIndex)) {
-            auto operandDims = getInputOperandDimensions(inputIndex);
             ngraph::element::Type elementType;
             switch (operandType) {
-                case OperandType::TENSOR_FLOAT32: {
+                case OperandType::TENSOR_FLOAT32:
                     elementType = ngraph::element::f32;
-                    auto operandValues = sModelInfo->GetConstVecOperand<float>(operandIndex);
-                    input = createConstNode(elementType, toNgraphShape(operandDims), operandValues);
                     break;
-                }
-                case OperandType::TENSOR_INT32: {
+                case OperandType::TENSOR_INT32:
                     elementType = ngraph::element::i32;
-                    auto operandValues = sModelInfo->GetConstVecOperand<int>(operandIndex);
-                    input = createConstNode(elementType, toNgraphShape(operandDims), operandValues);
                     break;
-                }
-                case OperandType::TENSOR_BOOL8: {
+                case OperandType::TENSOR_BOOL8:
                     elementType = ngraph::element::boolean;
-                    auto operandValues = sModelInfo->GetConstVecOperand<uint8_t>(operandIndex);
-                    input = createConstNode(elementType, toNgraphShape(operandDims), operandValues);
                     break;
-                }
-                case OperandType::TENSOR_QUANT8_ASYMM: {
+                case OperandType::TENSOR_QUANT8_ASYMM:
                     elementType = ngraph::element::u8;
-                    auto operandValues = sModelInfo->GetConstVecOperand<uint8_t>(operandIndex);
-                    input = createConstNode(elementType, toNgraphShape(operandDims), operandValues);
                     break;
-                }
                 case OperandType::TENSOR_QUANT8_SYMM:
                 case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
-                case OperandType::TENSOR_QUANT8_ASYMM_SIGNED: {
+                case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
                     elementType = ngraph::element::i8;
-                    auto operandValues = sModelInfo->GetConstVecOperand<int8_t>(operandIndex);
-                    input = createConstNode(elementType, toNgraphShape(operandDims), operandValues);
                     break;
-                }
-                case OperandType::TENSOR_FLOAT16: {
+                case OperandType::TENSOR_FLOAT16:
                     elementType = ngraph::element::f16;
-                    auto operandValues = sModelInfo->GetConstVecOperand<_Float16>(operandIndex);
-                    input = createConstNode(elementType, toNgraphShape(operandDims), operandValues);
                     break;
-                }
-                case OperandType::TENSOR_QUANT16_SYMM: {
+                case OperandType::TENSOR_QUANT16_SYMM:
                     elementType = ngraph::element::i16;
-                    auto operandValues = sModelInfo->GetConstVecOperand<int16_t>(operandIndex);
-                    input = createConstNode(elementType, toNgraphShape(operandDims), operandValues);
                     break;
-                }
-                case OperandType::TENSOR_QUANT16_ASYMM: {
+                case OperandType::TENSOR_QUANT16_ASYMM:
                     elementType = ngraph::element::u16;
-                    auto operandValues = sModelInfo->GetConstVecOperand<uint16_t>(operandIndex);
-                    input = createConstNode(elementType, toNgraphShape(operandDims), operandValues);
                     break;
-                }
                 default: {
                     ALOGE("Unsupported Tensor type %s inputIndex %d, operandType %d", __func__,
                           inputIndex, operandType);
                     return nullptr;
                 }
             }
-
+            // The operand bytes are laid out as the nGraph element type, constants are created
+            // from them directly through the weight store shared by all models
+            auto shape = toNgraphShape(getInputOperandDimensions(inputIndex));
+            uint32_t length;
+            const uint8_t* operandValues = sModelInfo->GetOperandMemory(operandIndex, length);
+            if (length != ngraph::shape_size(shape) * elementType.size()) {
+                ALOGE("%s Constant operand %d holds %u bytes, expected %zu", __func__,
+                      operandIndex, length, ngraph::shape_size(shape) * elementType.size());
+                return nullptr;
+            }
+            input = WeightStore::get().createConstant(elementType, shape, operandValues, length);
         } else {
             input = mNgraphNodes->getOperationOutput(operandIndex).get_node_shared_ptr();
         }
@@ -187,6 +174,10 @@ protected:
 public:
     static std::shared_ptr<NnapiModelInfo> sModelInfo;
     static IntelDeviceType sPluginType;
+    // Held by OperationsFactory for as long as the operations it creates may read sModelInfo
+    // and sPluginType, so that models are translated one at a time. Recursive as subgraphs are
+    // translated from within the translation of the enclosing model.
+    static std::recursive_mutex sTranslationMutex;
     std::shared_ptr<NgraphNodes> mNgraphNodes;
     OperationsBase(int operationIndex);
     void setNgraphNodes(std::shared_ptr<NgraphNodes> nodes);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <LSTM.hpp>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+class Quantized16BitLSTM : public LSTM {
+public:
+    Quantized16BitLSTM(int operationIndex);
+    bool validate() override;
+    std::shared_ptr<ngraph::Node> createNode() override;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
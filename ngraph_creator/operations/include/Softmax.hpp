@@ -11,6 +11,14 @@ class Softmax : public OperationsBase {
 public:
     Softmax(int operationIndex);
     std::shared_ptr<ngraph::Node> createNode() override;
+    std::shared_ptr<ngraph::Node> createNodeForPlugin() override;
+
+private:
+    // beta as a constant of the input type, null when it is 1
+    std::shared_ptr<ngraph::Node> createBetaNode(const ngraph::Shape& shape);
+    int64_t getAxis();
+    // Elementwise expansion for plugins without a Softmax layer
+    std::shared_ptr<ngraph::Node> createDecomposedNode();
 };
 
 }  // namespace nnhal
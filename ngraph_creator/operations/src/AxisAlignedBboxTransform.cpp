@@ -0,0 +1,120 @@
+#include <AxisAlignedBboxTransform.hpp>
+#undef LOG_TAG
+#define LOG_TAG "AxisAlignedBboxTransform"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+AxisAlignedBboxTransform::AxisAlignedBboxTransform(int operationIndex)
+    : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool AxisAlignedBboxTransform::validate() {
+    ALOGV("%s Entering", __func__);
+
+    if (!checkOutputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT32)) {
+        ALOGE("%s Output operand 0 is not of type FP32. Unsupported operation", __func__);
+        return false;
+    }
+
+    if (!checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT32) ||
+        !checkInputOperandType(1, (int32_t)OperandType::TENSOR_FLOAT32) ||
+        !checkInputOperandType(3, (int32_t)OperandType::TENSOR_FLOAT32)) {
+        ALOGE("%s Only FP32 boxes, deltas and image info are supported", __func__);
+        return false;
+    }
+
+    if (isZeroSizedInput(0) || isZeroSizedInput(1)) {
+        ALOGE("%s Not handling zero sized input for dimension 0", __func__);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+std::shared_ptr<ngraph::Node> AxisAlignedBboxTransform::createNode() {
+    ALOGV("%s Entering", __func__);
+
+    auto rois = getInputNode(0);          // [numRois, 4] as x1, y1, x2, y2
+    auto deltas = getInputNode(1);        // [numRois, numClasses * 4] as dx, dy, dw, dh
+    auto batchIndices = getInputNode(2);  // [numRois]
+    auto imageInfo = getInputNode(3);     // [batches, 2] as height, width
+
+    const auto numRois = getInputOperandDimensions(0)[0];
+    const auto numClasses = getInputOperandDimensions(1)[1] / 4;
+
+    auto lastAxis = createConstNode(ngraph::element::i32, {}, convertToVector(2));
+    auto splitComponents = [&](std::shared_ptr<ngraph::Node> node, size_t classes) {
+        auto shape = createConstNode(ngraph::element::i32, {3},
+                                     std::vector<int32_t>{(int32_t)numRois, (int32_t)classes, 4});
+        node = std::make_shared<ngraph::opset3::Reshape>(node, shape, false);
+        return std::make_shared<ngraph::opset3::Split>(node, lastAxis, 4)->outputs();
+    };
+
+    // Broadcasting [numRois, 1, 1] box components against [numRois, numClasses, 1] deltas
+    auto box = splitComponents(rois, 1);
+    auto delta = splitComponents(deltas, numClasses);
+
+    auto half = createConstNode(ngraph::element::f32, {}, convertToVector(0.5f));
+    auto width = std::make_shared<ngraph::opset3::Subtract>(box[2], box[0]);
+    auto height = std::make_shared<ngraph::opset3::Subtract>(box[3], box[1]);
+    auto centerX = std::make_shared<ngraph::opset3::Add>(
+        box[0], std::make_shared<ngraph::opset3::Multiply>(width, half));
+    auto centerY = std::make_shared<ngraph::opset3::Add>(
+        box[1], std::make_shared<ngraph::opset3::Multiply>(height, half));
+
+    auto newCenterX = std::make_shared<ngraph::opset3::Add>(
+        centerX, std::make_shared<ngraph::opset3::Multiply>(delta[0], width));
+    auto newCenterY = std::make_shared<ngraph::opset3::Add>(
+        centerY, std::make_shared<ngraph::opset3::Multiply>(delta[1], height));
+    auto halfWidth = std::make_shared<ngraph::opset3::Multiply>(
+        std::make_shared<ngraph::opset3::Multiply>(width,
+                                                   std::make_shared<ngraph::opset3::Exp>(delta[2])),
+        half);
+    auto halfHeight = std::make_shared<ngraph::opset3::Multiply>(
+        std::make_shared<ngraph::opset3::Multiply>(height,
+                                                   std::make_shared<ngraph::opset3::Exp>(delta[3])),
+        half);
+
+    // Boxes are clipped to the image each of them belongs to
+    auto axis0 = createConstNode(ngraph::element::i32, {}, convertToVector(0));
+    auto roiImageInfo = std::make_shared<ngraph::opset3::Gather>(imageInfo, batchIndices, axis0);
+    auto imageSize = std::make_shared<ngraph::opset3::Split>(
+        std::make_shared<ngraph::opset3::Reshape>(
+            roiImageInfo,
+            createConstNode(ngraph::element::i32, {3},
+                            std::vector<int32_t>{(int32_t)numRois, 1, 2}),
+            false),
+        lastAxis, 2);
+    auto zero = createConstNode(ngraph::element::f32, {}, convertToVector(0.f));
+    auto clipTo = [&](std::shared_ptr<ngraph::Node> node, const ngraph::Output<ngraph::Node>& max) {
+        auto clipped = std::make_shared<ngraph::opset3::Minimum>(node, max);
+        return std::make_shared<ngraph::opset3::Maximum>(clipped, zero);
+    };
+    const auto& imageHeight = imageSize->output(0);
+    const auto& imageWidth = imageSize->output(1);
+
+    ngraph::OutputVector components = {
+        clipTo(std::make_shared<ngraph::opset3::Subtract>(newCenterX, halfWidth), imageWidth),
+        clipTo(std::make_shared<ngraph::opset3::Subtract>(newCenterY, halfHeight), imageHeight),
+        clipTo(std::make_shared<ngraph::opset3::Add>(newCenterX, halfWidth), imageWidth),
+        clipTo(std::make_shared<ngraph::opset3::Add>(newCenterY, halfHeight), imageHeight)};
+    std::shared_ptr<ngraph::Node> outputNode =
+        std::make_shared<ngraph::opset3::Concat>(components, 2);
+
+    auto outputShape = createConstNode(
+        ngraph::element::i32, {2}, std::vector<int32_t>{(int32_t)numRois, (int32_t)numClasses * 4});
+    outputNode = std::make_shared<ngraph::opset3::Reshape>(outputNode, outputShape, false);
+
+    ALOGV("%s PASSED", __func__);
+    return outputNode;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
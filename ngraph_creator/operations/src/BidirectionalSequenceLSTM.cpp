@@ -0,0 +1,101 @@
+#include <BidirectionalSequenceLSTM.hpp>
+#undef LOG_TAG
+#define LOG_TAG "BidirectionalSequenceLSTM"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+BidirectionalSequenceLSTM::BidirectionalSequenceLSTM(int operationIndex) : LSTM(operationIndex) {}
+
+bool BidirectionalSequenceLSTM::validate() {
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+
+    if (inputsSize != 53 && inputsSize != 61) return false;
+    if (outputsSize < 1 || outputsSize > 6) return false;
+
+    if (getInputOperandDimensions(0).size() != 3) return false;
+    for (uint32_t i = 35; i < 39; i++) {
+        if (getInputOperandDimensions(i).size() != 2) return false;
+    }
+
+    // TODO: Add support for the auxiliary input
+    if (!sModelInfo->isOmittedInput(mNnapiOperationIndex, 39) && !isZeroSizedInput(39)) {
+        ALOGE("%s Auxiliary input not supported", __func__);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+std::shared_ptr<ngraph::Node> BidirectionalSequenceLSTM::createNode() {
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+    const auto& inDims = getInputOperandDimensions(0);
+
+    auto inputNode = getInputNode(0);
+    const auto& elementType = inputNode->get_element_type();
+
+    // Both directions share the activation and clipping parameters
+    LstmWeights fwWeights, bwWeights;
+    LstmParams fwParams, bwParams;
+    getLstmWeights(1, inputsSize == 61 ? 53 : -1, elementType, getInputOperandDimensions(36)[1],
+                   getInputOperandDimensions(35)[1], fwWeights, fwParams);
+    getLstmWeights(18, inputsSize == 61 ? 57 : -1, elementType, getInputOperandDimensions(38)[1],
+                   getInputOperandDimensions(37)[1], bwWeights, bwParams);
+
+    auto fwHiddenState = getInputNode(35);
+    auto fwCellState = getInputNode(36);
+    auto bwHiddenState = getInputNode(37);
+    auto bwCellState = getInputNode(38);
+
+    auto activationFn = sModelInfo->ParseOperationInput<uint32_t>(mNnapiOperationIndex, 48);
+    auto cellClip = getClipValue(49);
+    auto projClip = getClipValue(50);
+    for (auto* params : {&fwParams, &bwParams}) {
+        params->activationFn = activationFn;
+        params->cellClip = cellClip;
+        params->projClip = projClip;
+    }
+    auto mergeOutputs = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 51);
+    auto isTimeMajor = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 52);
+
+    if (!isTimeMajor) inputNode = transpose(BTS_TBS, inputNode);
+    uint32_t maxTime = isTimeMajor ? inDims[0] : inDims[1];
+
+    auto fwOutput = createLstmSequence(inputNode, maxTime, fwHiddenState, fwCellState, fwWeights,
+                                       fwParams, false);
+    auto bwOutput = createLstmSequence(inputNode, maxTime, bwHiddenState, bwCellState, bwWeights,
+                                       bwParams, true);
+    if (!isTimeMajor) {
+        fwOutput = transpose(BTS_TBS, fwOutput);
+        bwOutput = transpose(BTS_TBS, bwOutput);
+    }
+
+    uint32_t stateOutputIndex;
+    if (mergeOutputs) {
+        std::vector<ngraph::Output<ngraph::Node>> outputs = {fwOutput, bwOutput};
+        connectOutput(0, std::make_shared<ngraph::opset3::Concat>(outputs, 2));
+        stateOutputIndex = 1;
+    } else {
+        connectOutput(0, fwOutput);
+        connectOutput(1, bwOutput);
+        stateOutputIndex = 2;
+    }
+
+    if (outputsSize == stateOutputIndex + 4) {
+        connectOutput(stateOutputIndex, fwHiddenState);
+        connectOutput(stateOutputIndex + 1, fwCellState);
+        connectOutput(stateOutputIndex + 2, bwHiddenState);
+        connectOutput(stateOutputIndex + 3, bwCellState);
+    }
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
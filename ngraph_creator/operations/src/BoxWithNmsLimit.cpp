@@ -0,0 +1,174 @@
+#include <BoxWithNmsLimit.hpp>
+#undef LOG_TAG
+#define LOG_TAG "BoxWithNmsLimit"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+namespace {
+enum NmsKernel { HARD = 0, LINEAR = 1, GAUSSIAN = 2 };
+}
+
+BoxWithNmsLimit::BoxWithNmsLimit(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool BoxWithNmsLimit::validate() {
+    ALOGV("%s Entering", __func__);
+
+    if (!checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT32) ||
+        !checkInputOperandType(1, (int32_t)OperandType::TENSOR_FLOAT32)) {
+        ALOGE("%s Only FP32 scores and boxes are supported", __func__);
+        return false;
+    }
+
+    if (isZeroSizedInput(0)) {
+        ALOGE("%s Not handling zero sized input for dimension 0", __func__);
+        return false;
+    }
+
+    // The number of detections is data dependent, the graph produces as many as the model
+    // declares
+    const auto& outputDims = getOutputOperand(0).dimensions;
+    if (outputDims.size() != 1 || outputDims[0] == 0) {
+        ALOGE("%s Number of output boxes must be specified", __func__);
+        return false;
+    }
+
+    // Boxes of all rois are suppressed against each other, which is only right for one image
+    auto batchSplitIndex = sModelInfo->getOperationInput(mNnapiOperationIndex, 2);
+    if (!sModelInfo->isOperandLifeTimeConst(batchSplitIndex)) {
+        ALOGE("%s Batch split must be constant", __func__);
+        return false;
+    }
+    for (auto batch : sModelInfo->GetConstVecOperand<int>(batchSplitIndex)) {
+        if (batch != 0) {
+            ALOGE("%s Only a single image is supported", __func__);
+            return false;
+        }
+    }
+
+    auto kernel = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 5);
+    if (kernel != HARD && kernel != GAUSSIAN) {
+        ALOGE("%s Unsupported NMS kernel %d", __func__, kernel);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+void BoxWithNmsLimit::connectOperationToGraph() { createNode(); }
+
+std::shared_ptr<ngraph::Node> BoxWithNmsLimit::createNode() {
+    ALOGV("%s Entering", __func__);
+
+    auto scores = getInputNode(0);      // [numRois, numClasses]
+    auto boxes = getInputNode(1);       // [numRois, numClasses * 4] as x1, y1, x2, y2
+    auto batchSplit = getInputNode(2);  // [numRois]
+    auto scoreThreshold = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 3);
+    auto kernel = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 5);
+    auto iouThreshold = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 6);
+    auto sigma = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 7);
+    auto nmsScoreThreshold = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 8);
+
+    const int32_t numRois = getInputOperandDimensions(0)[0];
+    const int32_t numClasses = getInputOperandDimensions(0)[1];
+    const int32_t numOutputs = getOutputOperand(0).dimensions[0];
+
+    // Class 0 is the background. The remaining classes have their own boxes, so each one is
+    // suppressed as a separate batch of NonMaxSuppression.
+    std::vector<int32_t> classes;
+    for (int32_t i = 1; i < numClasses; i++) classes.push_back(i);
+    const int32_t numNmsClasses = classes.size();
+    auto classesNode = createConstNode(ngraph::element::i32, {classes.size()}, classes);
+    auto axis1 = createConstNode(ngraph::element::i32, {}, convertToVector(1));
+
+    std::shared_ptr<ngraph::Node> classScores =
+        std::make_shared<ngraph::opset3::Gather>(scores, classesNode, axis1);
+    classScores = transpose(NC_CN, classScores);
+    classScores = std::make_shared<ngraph::opset3::Reshape>(
+        classScores,
+        createConstNode(ngraph::element::i32, {3},
+                        std::vector<int32_t>{numNmsClasses, 1, numRois}),
+        false);
+
+    std::shared_ptr<ngraph::Node> classBoxes = std::make_shared<ngraph::opset3::Reshape>(
+        boxes,
+        createConstNode(ngraph::element::i32, {3}, std::vector<int32_t>{numRois, numClasses, 4}),
+        false);
+    classBoxes = std::make_shared<ngraph::opset3::Gather>(classBoxes, classesNode, axis1);
+    classBoxes = std::make_shared<ngraph::opset3::Transpose>(
+        classBoxes, createConstNode(ngraph::element::i32, {3}, std::vector<int32_t>{1, 0, 2}));
+
+    // The score threshold filters boxes before suppression. With the gaussian kernel the
+    // suppression itself drops boxes whose decayed score falls below the NMS score threshold.
+    float nmsThreshold = scoreThreshold;
+    float softSigma = 0.f;
+    if (kernel == GAUSSIAN) {
+        auto belowThreshold = std::make_shared<ngraph::opset3::Less>(
+            classScores,
+            createConstNode(ngraph::element::f32, {}, convertToVector(scoreThreshold)));
+        classScores = std::make_shared<ngraph::opset3::Select>(
+            belowThreshold, createConstNode(ngraph::element::f32, {}, convertToVector(-1.f)),
+            classScores);
+        nmsThreshold = nmsScoreThreshold;
+        // NonMaxSuppression decays scores by exp(-0.5 * iou^2 / sigma)
+        softSigma = sigma / 2;
+    }
+
+    auto numRoisNode = createConstNode(ngraph::element::i32, {}, convertToVector(numRois));
+    auto nms = std::make_shared<ngraph::op::v5::NonMaxSuppression>(
+        classBoxes, classScores, numRoisNode,
+        createConstNode(ngraph::element::f32, {}, convertToVector(iouThreshold)),
+        createConstNode(ngraph::element::f32, {}, convertToVector(nmsThreshold)),
+        createConstNode(ngraph::element::f32, {}, convertToVector(softSigma)),
+        ngraph::op::v5::NonMaxSuppression::BoxEncodingType::CORNER, true, ngraph::element::i32);
+    auto selection = selectNmsRows(nms, numOutputs, numNmsClasses * numRois);
+
+    auto axis0 = createConstNode(ngraph::element::i32, {}, convertToVector(0));
+    auto flatBoxes = std::make_shared<ngraph::opset3::Reshape>(
+        classBoxes,
+        createConstNode(ngraph::element::i32, {2},
+                        std::vector<int32_t>{numNmsClasses * numRois, 4}),
+        false);
+    auto boxIndex = std::make_shared<ngraph::opset3::Add>(
+        std::make_shared<ngraph::opset3::Multiply>(selection.batchIndex, numRoisNode),
+        selection.boxIndex);
+    auto validBoxes = std::make_shared<ngraph::opset3::Reshape>(
+        selection.valid,
+        createConstNode(ngraph::element::i32, {2}, std::vector<int32_t>{numOutputs, 1}), false);
+    auto zeroF = createConstNode(ngraph::element::f32, {}, convertToVector(0.f));
+    auto zeroI = createConstNode(ngraph::element::i32, {}, convertToVector(0));
+
+    std::shared_ptr<ngraph::Node> outputs[4];
+    outputs[0] = std::make_shared<ngraph::opset3::Select>(selection.valid, selection.score, zeroF);
+    outputs[1] = std::make_shared<ngraph::opset3::Select>(
+        validBoxes, std::make_shared<ngraph::opset3::Gather>(flatBoxes, boxIndex, axis0), zeroF);
+    outputs[2] = std::make_shared<ngraph::opset3::Select>(
+        selection.valid,
+        std::make_shared<ngraph::opset3::Add>(selection.batchIndex,
+                                              createConstNode(ngraph::element::i32, {},
+                                                              convertToVector(1))),
+        zeroI);
+    outputs[3] = std::make_shared<ngraph::opset3::Gather>(batchSplit, selection.boxIndex, axis0);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
+        mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputs[i]);
+        const auto op = sModelInfo->getOperand(outputIndex);
+        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+            addResultNode(outputIndex, outputs[i]);
+        }
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
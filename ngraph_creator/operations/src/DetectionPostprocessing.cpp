@@ -0,0 +1,182 @@
+#include <DetectionPostprocessing.hpp>
+#undef LOG_TAG
+#define LOG_TAG "DetectionPostprocessing"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+DetectionPostprocessing::DetectionPostprocessing(int operationIndex)
+    : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool DetectionPostprocessing::validate() {
+    ALOGV("%s Entering", __func__);
+
+    for (uint32_t i = 0; i < 3; i++) {
+        if (!checkInputOperandType(i, (int32_t)OperandType::TENSOR_FLOAT32)) {
+            ALOGE("%s Input operand %d is not of type FP32. Unsupported operation", __func__, i);
+            return false;
+        }
+    }
+
+    // Detections of all batches come out of one NonMaxSuppression sorted by score, they can only
+    // be split per batch for a single one
+    const auto& scoreDims = getInputOperandDimensions(0);
+    if (scoreDims.size() != 3 || scoreDims[0] != 1) {
+        ALOGE("%s Only a batch size of 1 is supported", __func__);
+        return false;
+    }
+
+    auto useRegularNms = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 7);
+    auto maxClassesPerDetection = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 9);
+    if (!useRegularNms && maxClassesPerDetection != 1) {
+        ALOGE("%s Fast NMS supports a single class per detection, got %d", __func__,
+              maxClassesPerDetection);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+void DetectionPostprocessing::connectOperationToGraph() { createNode(); }
+
+std::shared_ptr<ngraph::Node> DetectionPostprocessing::createNode() {
+    ALOGV("%s Entering", __func__);
+
+    auto scores = getInputNode(0);   // [1, numAnchors, numClasses]
+    auto deltas = getInputNode(1);   // [1, numAnchors, lengthBoxEncoding] as dy, dx, dh, dw, ...
+    auto anchors = getInputNode(2);  // [numAnchors, 4] as ycenter, xcenter, height, width
+    float scaleY = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 3);
+    float scaleX = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 4);
+    float scaleH = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 5);
+    float scaleW = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 6);
+    auto useRegularNms = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 7);
+    auto maxNumDetections = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 8);
+    auto maxDetectionsPerClass = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 10);
+    auto iouThreshold = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 11);
+    auto scoreThreshold = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 12);
+    auto isBGInLabel = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 13);
+
+    const int32_t numAnchors = getInputOperandDimensions(0)[1];
+    const int32_t numClasses = getInputOperandDimensions(0)[2];
+
+    auto f32Const = [&](float value) {
+        return createConstNode(ngraph::element::f32, {}, convertToVector(value));
+    };
+    auto i32Const = [&](int32_t value) {
+        return createConstNode(ngraph::element::i32, {}, convertToVector(value));
+    };
+    auto component = [&](std::shared_ptr<ngraph::Node> node, int32_t index, int32_t axis) {
+        return std::make_shared<ngraph::opset3::Gather>(node, i32Const(index), i32Const(axis));
+    };
+
+    // Decodes the center size encoded boxes of the first batch to [numAnchors] corners
+    auto decode = [&](int32_t index, float scale, bool isSize) -> std::shared_ptr<ngraph::Node> {
+        auto delta = std::make_shared<ngraph::opset3::Divide>(
+            component(component(deltas, 0, 0), index, 1), f32Const(scale));
+        auto anchorSize = component(anchors, isSize ? index : index + 2, 1);
+        if (isSize) {
+            return std::make_shared<ngraph::opset3::Multiply>(
+                std::make_shared<ngraph::opset3::Exp>(delta), anchorSize);
+        }
+        return std::make_shared<ngraph::opset3::Add>(
+            std::make_shared<ngraph::opset3::Multiply>(delta, anchorSize),
+            component(anchors, index, 1));
+    };
+    auto centerY = decode(0, scaleY, false);
+    auto centerX = decode(1, scaleX, false);
+    auto halfHeight = std::make_shared<ngraph::opset3::Multiply>(decode(2, scaleH, true),
+                                                                 f32Const(0.5f));
+    auto halfWidth =
+        std::make_shared<ngraph::opset3::Multiply>(decode(3, scaleW, true), f32Const(0.5f));
+    auto boxes = std::make_shared<ngraph::opset3::Concat>(
+        ngraph::OutputVector{
+            std::make_shared<ngraph::opset3::Unsqueeze>(
+                std::make_shared<ngraph::opset3::Subtract>(centerY, halfHeight), i32Const(1)),
+            std::make_shared<ngraph::opset3::Unsqueeze>(
+                std::make_shared<ngraph::opset3::Subtract>(centerX, halfWidth), i32Const(1)),
+            std::make_shared<ngraph::opset3::Unsqueeze>(
+                std::make_shared<ngraph::opset3::Add>(centerY, halfHeight), i32Const(1)),
+            std::make_shared<ngraph::opset3::Unsqueeze>(
+                std::make_shared<ngraph::opset3::Add>(centerX, halfWidth), i32Const(1))},
+        1);
+
+    // [numAnchors, classes] scores without the background class
+    std::vector<int32_t> classes;
+    for (int32_t i = isBGInLabel ? 1 : 0; i < numClasses; i++) classes.push_back(i);
+    const int32_t numLabels = classes.size();
+    std::shared_ptr<ngraph::Node> classScores = std::make_shared<ngraph::opset3::Gather>(
+        component(scores, 0, 0), createConstNode(ngraph::element::i32, {classes.size()}, classes),
+        i32Const(1));
+
+    // Regular NMS suppresses each class on its own. Fast NMS suppresses the anchors against each
+    // other by their best class, which becomes the label of the detection.
+    std::shared_ptr<ngraph::Node> bestClass;
+    int32_t nmsClasses = numLabels;
+    int32_t maxPerClass = maxDetectionsPerClass;
+    if (!useRegularNms) {
+        auto topk = std::make_shared<ngraph::opset3::TopK>(
+            classScores, i32Const(1), 1, ngraph::opset3::TopK::Mode::MAX,
+            ngraph::opset3::TopK::SortType::NONE, ngraph::element::i32);
+        classScores = std::make_shared<ngraph::opset3::Reshape>(
+            topk->output(0),
+            createConstNode(ngraph::element::i32, {2}, std::vector<int32_t>{numAnchors, 1}),
+            false);
+        bestClass = std::make_shared<ngraph::opset3::Reshape>(
+            topk->output(1),
+            createConstNode(ngraph::element::i32, {1}, convertToVector(numAnchors)), false);
+        nmsClasses = 1;
+        maxPerClass = maxNumDetections;
+    }
+    classScores = std::make_shared<ngraph::opset3::Unsqueeze>(transpose(NC_CN, classScores),
+                                                              i32Const(0));
+
+    auto nms = std::make_shared<ngraph::op::v5::NonMaxSuppression>(
+        std::make_shared<ngraph::opset3::Unsqueeze>(boxes, i32Const(0)), classScores,
+        i32Const(maxPerClass), f32Const(iouThreshold), f32Const(scoreThreshold), f32Const(0.f),
+        ngraph::op::v5::NonMaxSuppression::BoxEncodingType::CORNER, true, ngraph::element::i32);
+    auto selection = selectNmsRows(nms, maxNumDetections, nmsClasses * maxPerClass);
+
+    std::shared_ptr<ngraph::Node> labels = selection.classIndex;
+    if (!useRegularNms) {
+        labels = std::make_shared<ngraph::opset3::Gather>(bestClass, selection.boxIndex,
+                                                          i32Const(0));
+    }
+    auto validBoxes = std::make_shared<ngraph::opset3::Unsqueeze>(selection.valid, i32Const(1));
+
+    std::shared_ptr<ngraph::Node> outputs[4];
+    outputs[0] = std::make_shared<ngraph::opset3::Select>(selection.valid, selection.score,
+                                                          f32Const(0.f));
+    auto detectedBoxes =
+        std::make_shared<ngraph::opset3::Gather>(boxes, selection.boxIndex, i32Const(0));
+    outputs[1] = std::make_shared<ngraph::opset3::Select>(validBoxes, detectedBoxes, f32Const(0.f));
+    outputs[2] = std::make_shared<ngraph::opset3::Select>(selection.valid, labels, i32Const(0));
+    outputs[3] = std::make_shared<ngraph::opset3::Minimum>(selection.numValid,
+                                                           i32Const(maxNumDetections));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        std::shared_ptr<ngraph::Node> outputNode = outputs[i];
+        // Outputs gain back the batch dimension
+        if (i < 3) {
+            outputNode = std::make_shared<ngraph::opset3::Unsqueeze>(outputNode, i32Const(0));
+        }
+        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
+        mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputNode);
+        const auto op = sModelInfo->getOperand(outputIndex);
+        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+            addResultNode(outputIndex, outputNode);
+        }
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,33 @@
+#include <Elu.hpp>
+#undef LOG_TAG
+#define LOG_TAG "Elu"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+Elu::Elu(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+std::shared_ptr<ngraph::Node> Elu::createNode() {
+    // Creating input nodes
+    auto input = getInputNode(0);
+
+    double alpha;
+    if (checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT16)) {
+        alpha = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 1);
+    } else {
+        alpha = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 1);
+    }
+
+    std::shared_ptr<ngraph::Node> outputNode = std::make_shared<ngraph::opset3::Elu>(input, alpha);
+
+    return outputNode;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
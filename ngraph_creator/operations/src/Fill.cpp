@@ -0,0 +1,56 @@
+#include <Fill.hpp>
+#undef LOG_TAG
+#define LOG_TAG "Fill"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+Fill::Fill(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool Fill::validate() {
+    // The output shape comes from the dims input, which has to be known to create the graph
+    const auto& dimsOperandIndex = sModelInfo->getOperationInput(mNnapiOperationIndex, 0);
+    if (!sModelInfo->isOperandLifeTimeConst(dimsOperandIndex)) {
+        ALOGE("%s Only Constant dimensions supported now", __func__);
+        return false;
+    }
+    // The value is read while creating the graph as well
+    const auto& valueOperandIndex = sModelInfo->getOperationInput(mNnapiOperationIndex, 1);
+    if (!sModelInfo->isOperandLifeTimeConst(valueOperandIndex)) {
+        ALOGE("%s Only Constant value supported now", __func__);
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<ngraph::Node> Fill::createNode() {
+    // Creating input nodes
+    auto dims = getInputNode(0);
+
+    std::shared_ptr<ngraph::Node> valueNode;
+    if (checkOutputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT16)) {
+        auto value = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 1);
+        valueNode = createConstNode(ngraph::element::f16, {}, convertToVector(value));
+    } else if (checkOutputOperandType(0, (int32_t)OperandType::TENSOR_INT32)) {
+        auto value = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 1);
+        valueNode = createConstNode(ngraph::element::i32, {}, convertToVector(value));
+    } else {
+        auto value = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 1);
+        valueNode = createConstNode(ngraph::element::f32, {}, convertToVector(value));
+    }
+
+    std::shared_ptr<ngraph::Node> outputNode =
+        std::make_shared<ngraph::opset3::Broadcast>(valueNode, dims);
+
+    return outputNode;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
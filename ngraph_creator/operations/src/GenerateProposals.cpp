@@ -0,0 +1,154 @@
+#include <GenerateProposals.hpp>
+#undef LOG_TAG
+#define LOG_TAG "GenerateProposals"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+GenerateProposals::GenerateProposals(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool GenerateProposals::validate() {
+    ALOGV("%s Entering", __func__);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        if (!checkInputOperandType(i, (int32_t)OperandType::TENSOR_FLOAT32)) {
+            ALOGE("%s Input operand %d is not of type FP32. Unsupported operation", __func__, i);
+            return false;
+        }
+    }
+
+    // ExperimentalDetectronGenerateProposalsSingleImage handles one image
+    const auto& scoreDims = getInputOperandDimensions(0);
+    if (scoreDims.size() != 4 || scoreDims[0] != 1) {
+        ALOGE("%s Only a single image is supported", __func__);
+        return false;
+    }
+
+    const auto& outputDims = getOutputOperand(0).dimensions;
+    if (outputDims.size() != 1 || outputDims[0] == 0) {
+        ALOGE("%s Number of output rois must be specified", __func__);
+        return false;
+    }
+    auto postNmsTopN = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 7);
+    if (postNmsTopN > 0 && outputDims[0] > (uint32_t)postNmsTopN) {
+        ALOGE("%s %d output rois exceed the post NMS limit of %d", __func__, outputDims[0],
+              postNmsTopN);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+void GenerateProposals::connectOperationToGraph() { createNode(); }
+
+std::shared_ptr<ngraph::Node> GenerateProposals::createNode() {
+    ALOGV("%s Entering", __func__);
+
+    auto scores = getInputNode(0);     // [1, height, width, numAnchors]
+    auto deltas = getInputNode(1);     // [1, height, width, numAnchors * 4]
+    auto anchors = getInputNode(2);    // [numAnchors, 4] as x1, y1, x2, y2
+    auto imageInfo = getInputNode(3);  // [1, 2] as height, width
+    auto heightStride = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 4);
+    auto widthStride = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 5);
+    auto preNmsTopN = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 6);
+    auto postNmsTopN = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 7);
+    auto iouThreshold = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 8);
+    auto minSize = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 9);
+    auto layout = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 10);
+
+    if (!layout) {
+        scores = transpose(NHWC_NCHW, scores);
+        deltas = transpose(NHWC_NCHW, deltas);
+    }
+
+    const auto& dims = getInputOperandDimensions(0);
+    const int32_t numAnchors = layout ? dims[1] : dims[3];
+    const int32_t height = layout ? dims[2] : dims[1];
+    const int32_t width = layout ? dims[3] : dims[2];
+    const int32_t numOutputs = getOutputOperand(0).dimensions[0];
+
+    scores = std::make_shared<ngraph::opset3::Reshape>(
+        scores,
+        createConstNode(ngraph::element::i32, {3},
+                        std::vector<int32_t>{numAnchors, height, width}),
+        false);
+    deltas = std::make_shared<ngraph::opset3::Reshape>(
+        deltas,
+        createConstNode(ngraph::element::i32, {3},
+                        std::vector<int32_t>{numAnchors * 4, height, width}),
+        false);
+
+    // Anchors are given for one position of the feature map and shifted by the strides to every
+    // other position, laid out as [height, width, numAnchors, 4]
+    std::vector<float> shifts;
+    for (int32_t h = 0; h < height; h++) {
+        for (int32_t w = 0; w < width; w++) {
+            shifts.insert(shifts.end(), {w * widthStride, h * heightStride, w * widthStride,
+                                         h * heightStride});
+        }
+    }
+    auto shiftsNode = createConstNode(ngraph::element::f32,
+                                      {(size_t)height, (size_t)width, 1, 4}, shifts);
+    anchors = std::make_shared<ngraph::opset3::Add>(
+        shiftsNode,
+        std::make_shared<ngraph::opset3::Reshape>(
+            anchors,
+            createConstNode(ngraph::element::i32, {4}, std::vector<int32_t>{1, 1, numAnchors, 4}),
+            false));
+    anchors = std::make_shared<ngraph::opset3::Reshape>(
+        anchors,
+        createConstNode(ngraph::element::i32, {2},
+                        std::vector<int32_t>{height * width * numAnchors, 4}),
+        false);
+
+    // Image info gets a scale of 1, the minimum box size is already in image pixels
+    auto imInfo = std::make_shared<ngraph::opset3::Concat>(
+        ngraph::OutputVector{
+            std::make_shared<ngraph::opset3::Reshape>(
+                imageInfo, createConstNode(ngraph::element::i32, {1}, convertToVector(2)), false),
+            createConstNode(ngraph::element::f32, {1}, convertToVector(1.f))},
+        0);
+
+    ngraph::op::v6::ExperimentalDetectronGenerateProposalsSingleImage::Attributes attrs;
+    attrs.min_size = minSize;
+    attrs.nms_threshold = iouThreshold;
+    attrs.pre_nms_count = preNmsTopN > 0 ? preNmsTopN : height * width * numAnchors;
+    attrs.post_nms_count = postNmsTopN > 0 ? postNmsTopN : numOutputs;
+    auto proposals =
+        std::make_shared<ngraph::op::v6::ExperimentalDetectronGenerateProposalsSingleImage>(
+            imInfo, anchors, deltas, scores, attrs);
+
+    // Proposals are sorted by score and padded to post_nms_count
+    std::vector<int32_t> rows(numOutputs);
+    for (int32_t i = 0; i < numOutputs; i++) rows[i] = i;
+    auto rowsNode = createConstNode(ngraph::element::i32, {rows.size()}, rows);
+    auto axis0 = createConstNode(ngraph::element::i32, {}, convertToVector(0));
+
+    std::shared_ptr<ngraph::Node> outputs[3];
+    outputs[0] = std::make_shared<ngraph::opset3::Gather>(proposals->output(1), rowsNode, axis0);
+    outputs[1] = std::make_shared<ngraph::opset3::Gather>(proposals->output(0), rowsNode, axis0);
+    outputs[2] = createConstNode(ngraph::element::i32, {rows.size()},
+                                 std::vector<int32_t>(rows.size(), 0));
+
+    for (uint32_t i = 0; i < 3; i++) {
+        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
+        mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputs[i]);
+        const auto op = sModelInfo->getOperand(outputIndex);
+        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+            addResultNode(outputIndex, outputs[i]);
+        }
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,84 @@
+#include <HashtableLookup.hpp>
+#undef LOG_TAG
+#define LOG_TAG "HashtableLookup"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+HashtableLookup::HashtableLookup(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool HashtableLookup::validate() {
+    const auto valuesRank = getInputOperandDimensions(2).size();
+    if (valuesRank < 1 || getInputOperandDimensions(1).size() != 1) {
+        ALOGE("%s Invalid input dimensions size!", __func__);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+void HashtableLookup::connectOperationToGraph() { createNode(); }
+
+std::shared_ptr<ngraph::Node> HashtableLookup::createNode() {
+    // Creating input nodes
+    auto lookups = getInputNode(0);  // [k]
+    auto keys = getInputNode(1);     // [n]
+    // Rows are copied as they are, quantized values keep their quantization
+    auto values = getInputNode(2, false);  // [n, ...]
+
+    const auto& valuesDims = getInputOperandDimensions(2);
+    const int32_t numLookups = getInputOperandDimensions(0)[0];
+    const int32_t numKeys = valuesDims[0];
+
+    // [k, n] matches of every lookup against every key. Keys are unique, so the index of a found
+    // key is the sum of the matching positions.
+    auto matches = std::make_shared<ngraph::opset3::Convert>(
+        std::make_shared<ngraph::opset3::Equal>(
+            std::make_shared<ngraph::opset3::Unsqueeze>(
+                lookups, createConstNode(ngraph::element::i32, {}, convertToVector(1))),
+            keys),
+        ngraph::element::i32);
+    std::vector<int32_t> positions(numKeys);
+    for (int32_t i = 0; i < numKeys; i++) positions[i] = i;
+    auto axis1 = createConstNode(ngraph::element::i32, {1}, convertToVector(1));
+    auto index = std::make_shared<ngraph::opset3::ReduceSum>(
+        std::make_shared<ngraph::opset3::Multiply>(
+            matches, createConstNode(ngraph::element::i32, {positions.size()}, positions)),
+        axis1, false);
+    auto hits = std::make_shared<ngraph::opset3::ReduceMax>(matches, axis1, false);
+
+    // Lookups without a matching key produce rows of zeros
+    std::vector<int32_t> maskShape(valuesDims.size(), 1);
+    maskShape[0] = numLookups;
+    auto hitMask = std::make_shared<ngraph::opset3::Reshape>(
+        std::make_shared<ngraph::opset3::Convert>(hits, ngraph::element::boolean),
+        createConstNode(ngraph::element::i32, {maskShape.size()}, maskShape), false);
+    auto rows = std::make_shared<ngraph::opset3::Gather>(
+        values, index, createConstNode(ngraph::element::i32, {}, convertToVector(0)));
+    auto zero = createConstNode(values->get_element_type(), {}, convertToVector(0));
+
+    std::shared_ptr<ngraph::Node> outputs[2];
+    outputs[0] = std::make_shared<ngraph::opset3::Select>(hitMask, rows, zero);
+    outputs[1] = std::make_shared<ngraph::opset3::Convert>(hits, ngraph::element::u8);
+
+    for (uint32_t i = 0; i < 2; i++) {
+        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
+        mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputs[i]);
+        const auto op = sModelInfo->getOperand(outputIndex);
+        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+            addResultNode(outputIndex, outputs[i]);
+        }
+    }
+
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,200 @@
+#include <HeatmapMaxKeypoint.hpp>
+#undef LOG_TAG
+#define LOG_TAG "HeatmapMaxKeypoint"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+HeatmapMaxKeypoint::HeatmapMaxKeypoint(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool HeatmapMaxKeypoint::validate() {
+    ALOGV("%s Entering", __func__);
+
+    if (!checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT32) ||
+        !checkInputOperandType(1, (int32_t)OperandType::TENSOR_FLOAT32)) {
+        ALOGE("%s Only FP32 heatmaps and boxes are supported", __func__);
+        return false;
+    }
+    for (uint32_t i = 0; i < 2; i++) {
+        if (!checkOutputOperandType(i, (int32_t)OperandType::TENSOR_FLOAT32)) {
+            ALOGE("%s Output operand %d is not of type FP32. Unsupported operation", __func__, i);
+            return false;
+        }
+    }
+
+    if (isZeroSizedInput(0)) {
+        ALOGE("%s Not handling zero sized input for dimension 0", __func__);
+        return false;
+    }
+
+    const auto& dims = getInputOperandDimensions(0);
+    auto layout = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 2);
+    const uint32_t height = layout ? dims[2] : dims[1];
+    const uint32_t width = layout ? dims[3] : dims[2];
+    // The 3x3 neighbourhood of the maximum is mirrored at the heatmap borders
+    if (height < 2 || width < 2) {
+        ALOGE("%s Heatmaps of %ux%u are too small", __func__, height, width);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+void HeatmapMaxKeypoint::connectOperationToGraph() { createNode(); }
+
+std::shared_ptr<ngraph::Node> HeatmapMaxKeypoint::createNode() {
+    ALOGV("%s Entering", __func__);
+
+    auto heatmaps = getInputNode(0);
+    auto boxes = getInputNode(1);  // [numBoxes, 4] as x1, y1, x2, y2
+    auto layout = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 2);
+
+    if (!layout) heatmaps = transpose(NHWC_NCHW, heatmaps);
+
+    const auto& dims = getInputOperandDimensions(0);
+    const int32_t numBoxes = dims[0];
+    const int32_t numKeypoints = layout ? dims[1] : dims[3];
+    const int32_t height = layout ? dims[2] : dims[1];
+    const int32_t width = layout ? dims[3] : dims[2];
+
+    auto i32Const = [&](std::vector<int32_t> values, ngraph::Shape shape = {}) {
+        return createConstNode(ngraph::element::i32, shape, values);
+    };
+    auto f32Const = [&](float value) {
+        return createConstNode(ngraph::element::f32, {}, convertToVector(value));
+    };
+
+    // Location of the maximum of each [height * width] heatmap, as [numBoxes, numKeypoints, 1]
+    auto flatMaps = std::make_shared<ngraph::opset3::Reshape>(
+        heatmaps, i32Const({numBoxes, numKeypoints, height * width}, {3}), false);
+    auto topk = std::make_shared<ngraph::opset3::TopK>(
+        flatMaps, i32Const({1}), 2, ngraph::opset3::TopK::Mode::MAX,
+        ngraph::opset3::TopK::SortType::NONE, ngraph::element::i32);
+    auto maxIndex = topk->output(1);
+    auto maxRow = std::make_shared<ngraph::opset3::Divide>(maxIndex, i32Const({width}));
+    auto maxCol = std::make_shared<ngraph::opset3::FloorMod>(maxIndex, i32Const({width}));
+
+    // Gathers the 3x3 neighbourhood from the flattened heatmaps, mirroring out of range rows and
+    // columns back into the heatmap
+    auto values = std::make_shared<ngraph::opset3::Reshape>(
+        heatmaps, i32Const({numBoxes * numKeypoints * height * width}, {1}), false);
+    std::vector<int32_t> offsets;
+    for (int32_t i = 0; i < numBoxes * numKeypoints; i++) offsets.push_back(i * height * width);
+    auto mapOffsets = i32Const(offsets, {(size_t)numBoxes, (size_t)numKeypoints, 1});
+    auto mirror = [&](std::shared_ptr<ngraph::Node> pos, int32_t size) {
+        auto low = std::make_shared<ngraph::opset3::Less>(pos, i32Const({0}));
+        auto high = std::make_shared<ngraph::opset3::GreaterEqual>(pos, i32Const({size}));
+        auto inner = std::make_shared<ngraph::opset3::Select>(high, i32Const({size - 2}), pos);
+        return std::make_shared<ngraph::opset3::Select>(low, i32Const({1}), inner);
+    };
+    std::shared_ptr<ngraph::Node> grid[3][3];
+    for (int32_t dh = -1; dh <= 1; dh++) {
+        auto row = mirror(std::make_shared<ngraph::opset3::Add>(maxRow, i32Const({dh})), height);
+        for (int32_t dw = -1; dw <= 1; dw++) {
+            auto col =
+                mirror(std::make_shared<ngraph::opset3::Add>(maxCol, i32Const({dw})), width);
+            auto index = std::make_shared<ngraph::opset3::Add>(
+                mapOffsets, std::make_shared<ngraph::opset3::Add>(
+                                std::make_shared<ngraph::opset3::Multiply>(row, i32Const({width})),
+                                col));
+            grid[dh + 1][dw + 1] =
+                std::make_shared<ngraph::opset3::Gather>(values, index, i32Const({0}));
+        }
+    }
+
+    auto add = [](const ngraph::Output<ngraph::Node>& a, const ngraph::Output<ngraph::Node>& b) {
+        return std::make_shared<ngraph::opset3::Add>(a, b);
+    };
+    auto sub = [](const ngraph::Output<ngraph::Node>& a, const ngraph::Output<ngraph::Node>& b) {
+        return std::make_shared<ngraph::opset3::Subtract>(a, b);
+    };
+    auto mul = [](const ngraph::Output<ngraph::Node>& a, const ngraph::Output<ngraph::Node>& b) {
+        return std::make_shared<ngraph::opset3::Multiply>(a, b);
+    };
+
+    // Second order Taylor expansion around the maximum: b = -f'(0), A = f''(0) and the sub pixel
+    // offset solves A * delta = b
+    auto b0 = mul(sub(grid[1][2], grid[1][0]), f32Const(-0.5f));
+    auto b1 = mul(sub(grid[2][1], grid[0][1]), f32Const(-0.5f));
+    auto twiceCenter = mul(grid[1][1], f32Const(2.f));
+    auto a00 = add(sub(grid[1][0], twiceCenter), grid[1][2]);
+    auto a01 = mul(add(sub(sub(grid[2][2], grid[2][0]), grid[0][2]), grid[0][0]), f32Const(0.25f));
+    auto a11 = add(sub(grid[0][1], twiceCenter), grid[2][1]);
+
+    auto crossProd1 = mul(a00, a11);
+    auto crossProd2 = mul(a01, a01);
+    auto det = sub(crossProd1, crossProd2);
+    auto invertible = std::make_shared<ngraph::opset3::GreaterEqual>(
+        std::make_shared<ngraph::opset3::Abs>(det),
+        mul(add(std::make_shared<ngraph::opset3::Abs>(crossProd1),
+                std::make_shared<ngraph::opset3::Abs>(crossProd2)),
+            f32Const(1e-3f)));
+    auto zeros = mul(det, f32Const(0.f));
+    std::shared_ptr<ngraph::Node> delta0 = std::make_shared<ngraph::opset3::Select>(
+        invertible, std::make_shared<ngraph::opset3::Divide>(sub(mul(a11, b0), mul(a01, b1)), det),
+        zeros);
+    std::shared_ptr<ngraph::Node> delta1 = std::make_shared<ngraph::opset3::Select>(
+        invertible, std::make_shared<ngraph::opset3::Divide>(sub(mul(a00, b1), mul(a01, b0)), det),
+        zeros);
+
+    // Offsets are limited to 1.5 pixels, keeping their direction
+    auto maxDelta = std::make_shared<ngraph::opset3::Maximum>(
+        std::make_shared<ngraph::opset3::Abs>(delta0),
+        std::make_shared<ngraph::opset3::Abs>(delta1));
+    auto scale = std::make_shared<ngraph::opset3::Select>(
+        std::make_shared<ngraph::opset3::Greater>(maxDelta, f32Const(1.5f)),
+        std::make_shared<ngraph::opset3::Divide>(f32Const(1.5f), maxDelta), f32Const(1.f));
+    delta0 = mul(delta0, scale);
+    delta1 = mul(delta1, scale);
+
+    auto quadratic = add(mul(add(mul(a00, delta0), mul(a01, delta1)), delta0),
+                         mul(add(mul(a01, delta0), mul(a11, delta1)), delta1));
+    std::shared_ptr<ngraph::Node> scores = add(
+        sub(sub(grid[1][1], mul(b0, delta0)), mul(b1, delta1)), mul(quadratic, f32Const(0.5f)));
+
+    // Keypoints relative to the heatmap are mapped into the boxes, [numBoxes, 1, 1] components
+    auto boxComponents = std::make_shared<ngraph::opset3::Split>(
+        std::make_shared<ngraph::opset3::Reshape>(boxes, i32Const({numBoxes, 1, 4}, {3}), false),
+        i32Const({2}), 4);
+    auto boxSize = [&](size_t start, size_t end) {
+        return std::make_shared<ngraph::opset3::Maximum>(
+            sub(boxComponents->output(end), boxComponents->output(start)), f32Const(1.f));
+    };
+    auto keypoint = [&](const ngraph::Output<ngraph::Node>& pos, std::shared_ptr<ngraph::Node> d,
+                        int32_t size, size_t start, size_t end) {
+        auto relative = std::make_shared<ngraph::opset3::Divide>(
+            add(add(std::make_shared<ngraph::opset3::Convert>(pos, ngraph::element::f32), d),
+                f32Const(0.5f)),
+            f32Const((float)size));
+        return add(mul(relative, boxSize(start, end)), boxComponents->output(start));
+    };
+    std::shared_ptr<ngraph::Node> keypoints = std::make_shared<ngraph::opset3::Concat>(
+        ngraph::OutputVector{keypoint(maxCol, delta0, width, 0, 2),
+                             keypoint(maxRow, delta1, height, 1, 3)},
+        2);
+    scores = std::make_shared<ngraph::opset3::Reshape>(
+        scores, i32Const({numBoxes, numKeypoints}, {2}), false);
+
+    std::shared_ptr<ngraph::Node> outputs[] = {scores, keypoints};
+    for (uint32_t i = 0; i < 2; i++) {
+        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
+        mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputs[i]);
+        const auto op = sModelInfo->getOperand(outputIndex);
+        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+            addResultNode(outputIndex, outputs[i]);
+        }
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
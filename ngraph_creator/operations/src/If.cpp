@@ -0,0 +1,91 @@
+#include <If.hpp>
+#include <NgraphNetworkCreator.hpp>
+#undef LOG_TAG
+#define LOG_TAG "If"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+If::If(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool If::validate() {
+    if (!checkInputOperandType(0, (int32_t)OperandType::TENSOR_BOOL8)) return false;
+
+    // Both branches are evaluated and the results selected, which needs static shapes
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    for (size_t i = 3; i < inputsSize; i++) {
+        const auto& operand = getInputOperand(i);
+        if (android::nn::nonExtensionOperandTypeIsScalar(static_cast<int>(operand.type)) ||
+            android::nn::tensorHasUnspecifiedDimensions(operand)) {
+            ALOGE("%s Only fully specified tensor inputs supported", __func__);
+            return false;
+        }
+    }
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+    for (size_t i = 0; i < outputsSize; i++) {
+        if (android::nn::tensorHasUnspecifiedDimensions(getOutputOperand(i))) {
+            ALOGE("%s Only fully specified outputs supported", __func__);
+            return false;
+        }
+    }
+
+    if (!NgraphNetworkCreator::validateSubgraph(
+            sModelInfo->getOperationInput(mNnapiOperationIndex, 1)) ||
+        !NgraphNetworkCreator::validateSubgraph(
+            sModelInfo->getOperationInput(mNnapiOperationIndex, 2))) {
+        ALOGE("%s Branch contains unsupported operations", __func__);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+void If::connectOperationToGraph() { createNode(); }
+
+std::shared_ptr<ngraph::Node> If::createNode() {
+    // The CPU plugin of OpenVINO 2021.4 has no If operation, so both branches are translated
+    // inline and the outputs of the taken branch selected
+    auto condition = getInputNode(0);
+
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    std::vector<ngraph::Output<ngraph::Node>> branchInputs;
+    for (size_t i = 3; i < inputsSize; i++) branchInputs.push_back(getInputNode(i, false));
+
+    std::vector<ngraph::Output<ngraph::Node>> thenOutputs, elseOutputs;
+    if (!NgraphNetworkCreator::translateSubgraph(
+            sModelInfo->getOperationInput(mNnapiOperationIndex, 1), branchInputs, thenOutputs) ||
+        !NgraphNetworkCreator::translateSubgraph(
+            sModelInfo->getOperationInput(mNnapiOperationIndex, 2), branchInputs, elseOutputs)) {
+        ALOGE("%s Failed to translate branches", __func__);
+        throw std::runtime_error("IF branch translation failed");
+    }
+
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+    std::shared_ptr<ngraph::Node> outputNode;
+    for (size_t i = 0; i < outputsSize; i++) {
+        // Branch outputs are already quantized, both branches share the IF output quantization
+        outputNode =
+            std::make_shared<ngraph::opset3::Select>(condition, thenOutputs[i], elseOutputs[i]);
+
+        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
+        mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputNode);
+        ALOGD("%s Set Output index %d", __func__, outputIndex);
+        const auto op = sModelInfo->getOperand(outputIndex);
+        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+            addResultNode(outputIndex, outputNode);
+            ALOGD("%s Add result %d", __func__, outputIndex);
+        }
+    }
+
+    return outputNode;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
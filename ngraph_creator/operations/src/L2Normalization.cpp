@@ -1,4 +1,5 @@
 #include <L2Normalization.hpp>
+#include <limits>
 #undef LOG_TAG
 #define LOG_TAG "L2Normalization"
 
@@ -7,6 +8,8 @@ namespace hardware {
 namespace neuralnetworks {
 namespace nnhal {
 
+static const double kFloat16MinNormal = 6.103515625e-05;
+
 L2Normalization::L2Normalization(int operationIndex) : OperationsBase(operationIndex) {
     mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
 }
@@ -22,18 +25,37 @@ bool L2Normalization::validate() {
     return true;
 }
 
-std::shared_ptr<ngraph::Node> L2Normalization::createNode() {
-    std::shared_ptr<ngraph::Node> inputNode;
-
-    int32_t inputAxes = -1;
+int64_t L2Normalization::getAxis() {
+    int64_t axis = -1;
     const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
     ALOGD("%s inputsSize %lu", __func__, inputsSize);
-    inputNode = getInputNode(0);
     // NN-HAL 1.2 specific optional input
-    if (inputsSize == 2) {
-        inputAxes = sModelInfo->ParseOperationInput<int32_t>(mNnapiOperationIndex, 1);
-    }
-    auto inputAxesNode = createConstNode(ngraph::element::i32, {1}, convertToVector(inputAxes));
+    if (inputsSize == 2) axis = sModelInfo->ParseOperationInput<int32_t>(mNnapiOperationIndex, 1);
+    if (axis < 0) axis += static_cast<int64_t>(getInputOperandDimensions(0).size());
+    return axis;
+}
+
+std::shared_ptr<ngraph::Node> L2Normalization::createNode() {
+    auto inputNode = getInputNode(0);
+    auto axesNode = createConstNode(ngraph::element::i64, {1}, convertToVector(getAxis()));
+    // The smallest normal value of the element type as lower bound of the sum of squares makes the
+    // output zero where the elements along the axis are all zero, as NNAPI feature level 4 defines
+    // it. The float one flushes to zero in FP16, which has its smallest normal at 2^-14.
+    const double epsilon = inputNode->get_element_type() == ngraph::element::f16
+                               ? kFloat16MinNormal
+                               : std::numeric_limits<float>::min();
+    return std::make_shared<ngraph::opset3::NormalizeL2>(inputNode, axesNode, epsilon,
+                                                         ngraph::op::EpsMode::MAX);
+}
+
+std::shared_ptr<ngraph::Node> L2Normalization::createNodeForPlugin() {
+    if (sPluginType == IntelDeviceType::GNA) return createDecomposedNode();
+    return createNode();
+}
+
+std::shared_ptr<ngraph::Node> L2Normalization::createDecomposedNode() {
+    auto inputNode = getInputNode(0);
+    auto inputAxesNode = createConstNode(ngraph::element::i64, {1}, convertToVector(getAxis()));
     // TODO: Add support for NNAPI feature level 4, if the elements along an axis are all zeros, the
     // result is undefined. Since NNAPI feature level 4, if the elements along an axis are all
     // zeros, the result is logical zero.
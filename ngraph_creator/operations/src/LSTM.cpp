@@ -35,306 +35,353 @@ void LSTM::connectOperationToGraph() { createNode(); }
 
 std::shared_ptr<ngraph::Node> LSTM::createNode() {
     const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    const auto& initial_hidden_state_dims = getInputOperandDimensions(18);
+    const auto& initial_cell_state_dims = getInputOperandDimensions(19);
+
+    auto num_units = initial_cell_state_dims[1];
+    auto output_size = initial_hidden_state_dims[1];
+
+    // Creating input nodes
+    auto inputNode = getInputNode(0);
+    const auto& elementType = inputNode->get_element_type();
+
+    LstmWeights weights;
+    LstmParams params;
+    getLstmWeights(1, inputsSize == 27 ? 23 : -1, elementType, num_units, output_size, weights,
+                   params);
+
+    auto initial_hidden_state = getInputNode(18);  // h_{t-1}
+    auto initial_cell_state = getInputNode(19);    // C_{t-1}
+
+    params.activationFn = sModelInfo->ParseOperationInput<uint32_t>(mNnapiOperationIndex, 20);
+    params.cellClip = getClipValue(21);
+    if (params.isProjectionUsed) params.projClip = getClipValue(22);
 
-    bool isCIFGenabled = false, isPeepholeUsed = false, isProjectionUsed = false,
-         isLayerNormUsed = false, isCifgDimsEmpty = true;
+    std::shared_ptr<ngraph::Node> i_t, H, C;
+    createLstmCell(inputNode, initial_hidden_state, initial_cell_state, weights, params, i_t, H,
+                   C);
+
+    // TODO: Implement proper scratchBuffer
+    // Creating a dummy scratchBuffer with same size as i_t, initialized to 0.0f
+    // and then multiplying with i_t so that it gets connected to the graph
+    // Then it's concat'ed on axis 1 to make that dim 3x with CIFG, 4x otherwise
+    auto scratchBuffer = createConstNode(elementType, i_t->get_shape(), convertToVector(0.f));
+    scratchBuffer = std::make_shared<ngraph::opset3::Multiply>(scratchBuffer, i_t);
+    std::vector<ngraph::Output<ngraph::Node>> inputs;
+    for (int i = 0; i < (params.isCIFGenabled ? 3 : 4); i++) inputs.push_back(scratchBuffer);
+    scratchBuffer = std::make_shared<ngraph::opset3::Concat>(inputs, 1);
+
+    std::vector<std::shared_ptr<ngraph::Node>> LstmOutputs(4, nullptr);
+    LstmOutputs[0] = scratchBuffer;
+    LstmOutputs[1] = H;
+    LstmOutputs[2] = C;
+    LstmOutputs[3] = H;
+
+    for (int i = 0; i < 4; i++) connectOutput(i, LstmOutputs[i]);
+    return nullptr;
+}
+
+void LSTM::getLstmWeights(uint32_t weightsIndex, int32_t layerNormIndex,
+                          const ngraph::element::Type& elementType, size_t numUnits,
+                          size_t outputSize, LstmWeights& weights, LstmParams& params) {
+    // Offsets of the operands within the 17 weights of a direction
+    const uint32_t input2input = weightsIndex, recurrent2input = weightsIndex + 4,
+                   cell2input = weightsIndex + 8, cell2forget = weightsIndex + 9,
+                   cell2output = weightsIndex + 10, inputGateBias = weightsIndex + 11,
+                   projectionWeights = weightsIndex + 15, projectionBias = weightsIndex + 16;
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    bool isCifgDimsEmpty = true;
 
     // checking if CIFG enabled
-    if (sModelInfo->isOmittedInput(mNnapiOperationIndex, 1) &&
-        sModelInfo->isOmittedInput(mNnapiOperationIndex, 5) &&
-        sModelInfo->isOmittedInput(mNnapiOperationIndex, 12)) {
-        isCIFGenabled = true;
+    if (sModelInfo->isOmittedInput(mNnapiOperationIndex, input2input) &&
+        sModelInfo->isOmittedInput(mNnapiOperationIndex, recurrent2input) &&
+        sModelInfo->isOmittedInput(mNnapiOperationIndex, inputGateBias)) {
+        params.isCIFGenabled = true;
     } else {
-        if (isValidInputTensor(1) && isValidInputTensor(5) && isValidInputTensor(12))
-            isCIFGenabled = false;
+        if (isValidInputTensor(input2input) && isValidInputTensor(recurrent2input) &&
+            isValidInputTensor(inputGateBias))
+            params.isCIFGenabled = false;
         else
-            isCIFGenabled = true;
+            params.isCIFGenabled = true;
     }
 
     // checking if peephole enabled
-    if (sModelInfo->isOmittedInput(mNnapiOperationIndex, 9) &&
-        sModelInfo->isOmittedInput(mNnapiOperationIndex, 10) &&
-        sModelInfo->isOmittedInput(mNnapiOperationIndex, 11)) {
-        isPeepholeUsed = false;
+    if (sModelInfo->isOmittedInput(mNnapiOperationIndex, cell2input) &&
+        sModelInfo->isOmittedInput(mNnapiOperationIndex, cell2forget) &&
+        sModelInfo->isOmittedInput(mNnapiOperationIndex, cell2output)) {
+        params.isPeepholeUsed = false;
     } else {
-        if (!isCIFGenabled && !isValidInputTensor(9) && isValidInputTensor(10) &&
-            isValidInputTensor(11)) {
-            isCIFGenabled = true;
+        if (!params.isCIFGenabled && !isValidInputTensor(cell2input) &&
+            isValidInputTensor(cell2forget) && isValidInputTensor(cell2output)) {
+            params.isCIFGenabled = true;
             isCifgDimsEmpty = false;
         }
-        if (isCIFGenabled) {
-            if (isValidInputTensor(10) && isValidInputTensor(11))
-                isPeepholeUsed = true;
+        if (params.isCIFGenabled) {
+            if (isValidInputTensor(cell2forget) && isValidInputTensor(cell2output))
+                params.isPeepholeUsed = true;
             else
-                isPeepholeUsed = false;
+                params.isPeepholeUsed = false;
         } else {
-            if (isValidInputTensor(9) && isValidInputTensor(10) && isValidInputTensor(11))
-                isPeepholeUsed = true;
+            if (isValidInputTensor(cell2input) && isValidInputTensor(cell2forget) &&
+                isValidInputTensor(cell2output))
+                params.isPeepholeUsed = true;
             else
-                isPeepholeUsed = false;
+                params.isPeepholeUsed = false;
         }
     }
 
     // checking if projection enabled
-    if (sModelInfo->isOmittedInput(mNnapiOperationIndex, 16)) {
-        isProjectionUsed = false;
+    if (sModelInfo->isOmittedInput(mNnapiOperationIndex, projectionWeights)) {
+        params.isProjectionUsed = false;
     } else {
-        if (isValidInputTensor(16))
-            isProjectionUsed = true;
+        if (isValidInputTensor(projectionWeights))
+            params.isProjectionUsed = true;
         else
-            isProjectionUsed = false;
+            params.isProjectionUsed = false;
     }
 
-    if (inputsSize == 27) {
+    if (layerNormIndex >= 0 && inputsSize > (size_t)layerNormIndex + 3) {
         // checking if layer normalization enabled
-        if (sModelInfo->isOmittedInput(mNnapiOperationIndex, 23) &&
-            sModelInfo->isOmittedInput(mNnapiOperationIndex, 24) &&
-            sModelInfo->isOmittedInput(mNnapiOperationIndex, 25) &&
-            sModelInfo->isOmittedInput(mNnapiOperationIndex, 26)) {
-            isLayerNormUsed = false;
+        if (sModelInfo->isOmittedInput(mNnapiOperationIndex, layerNormIndex) &&
+            sModelInfo->isOmittedInput(mNnapiOperationIndex, layerNormIndex + 1) &&
+            sModelInfo->isOmittedInput(mNnapiOperationIndex, layerNormIndex + 2) &&
+            sModelInfo->isOmittedInput(mNnapiOperationIndex, layerNormIndex + 3)) {
+            params.isLayerNormUsed = false;
         } else {
-            if (isCIFGenabled) {
-                if (isValidInputTensor(24) && isValidInputTensor(25) && isValidInputTensor(26))
-                    isLayerNormUsed = true;
+            if (params.isCIFGenabled) {
+                if (isValidInputTensor(layerNormIndex + 1) &&
+                    isValidInputTensor(layerNormIndex + 2) &&
+                    isValidInputTensor(layerNormIndex + 3))
+                    params.isLayerNormUsed = true;
                 else
-                    isLayerNormUsed = false;
+                    params.isLayerNormUsed = false;
 
             } else {
-                if (isValidInputTensor(23) && isValidInputTensor(24) && isValidInputTensor(25) &&
-                    isValidInputTensor(26))
-                    isLayerNormUsed = true;
+                if (isValidInputTensor(layerNormIndex) && isValidInputTensor(layerNormIndex + 1) &&
+                    isValidInputTensor(layerNormIndex + 2) &&
+                    isValidInputTensor(layerNormIndex + 3))
+                    params.isLayerNormUsed = true;
                 else
-                    isLayerNormUsed = false;
+                    params.isLayerNormUsed = false;
             }
         }
     }
 
-    std::shared_ptr<ngraph::Node> inputNode, input2input_weights, input2forget_weights,
-        input2cell_weights, input2output_weights, recurrent2input_weights, recurrent2forget_weights,
-        recurrent2cell_weights, recurrent2output_weights, cell2input_weights, cell2forget_weights,
-        cell2output_weights, input_gate_bias, forget_gate_bias, cell_bias, output_gate_bias,
-        projection_weights, projection_bias, initial_hidden_state, initial_cell_state;
-    uint32_t activationFn;
-    float cell_state_clipping, proj_clipping;
-    const auto& initial_hidden_state_dims = getInputOperandDimensions(18);
-    const auto& initial_cell_state_dims = getInputOperandDimensions(19);
-
-    auto num_units = initial_cell_state_dims[1];
-    auto output_size = initial_hidden_state_dims[1];
-
-    // Creating input nodes
-    inputNode = getInputNode(0);
-    const auto& elementType = inputNode->get_element_type();
-
     // W_{xi}, W_{xf}, W_{xc}, W_{xo}
-    if (isCIFGenabled) {
-        if (!isCifgDimsEmpty) removeInputNode(1);
+    if (params.isCIFGenabled) {
+        if (!isCifgDimsEmpty) removeInputNode(input2input);
     } else {
-        input2input_weights = getInputNode(1);
+        weights.input2input = getInputNode(input2input);
     }
-    input2forget_weights = getInputNode(2);
-    input2cell_weights = getInputNode(3);
-    input2output_weights = getInputNode(4);
+    weights.input2forget = getInputNode(weightsIndex + 1);
+    weights.input2cell = getInputNode(weightsIndex + 2);
+    weights.input2output = getInputNode(weightsIndex + 3);
 
     // W_{hi}, W_{hf}, W_{hc}, W_{ho}
-    if (isCIFGenabled) {
-        if (!isCifgDimsEmpty) removeInputNode(5);
+    if (params.isCIFGenabled) {
+        if (!isCifgDimsEmpty) removeInputNode(recurrent2input);
     } else {
-        recurrent2input_weights = getInputNode(5);
+        weights.recurrent2input = getInputNode(recurrent2input);
     }
-    recurrent2forget_weights = getInputNode(6);
-    recurrent2cell_weights = getInputNode(7);
-    recurrent2output_weights = getInputNode(8);
+    weights.recurrent2forget = getInputNode(weightsIndex + 5);
+    weights.recurrent2cell = getInputNode(weightsIndex + 6);
+    weights.recurrent2output = getInputNode(weightsIndex + 7);
 
     // W_{ci}, W_{cf}, W_{co}
-    if (isPeepholeUsed) {
-        if (isCIFGenabled)
-            cell2input_weights =
-                createConstNode(elementType, ngraph::Shape{num_units}, convertToVector(0));
+    if (params.isPeepholeUsed) {
+        if (params.isCIFGenabled)
+            weights.cell2input =
+                createConstNode(elementType, ngraph::Shape{numUnits}, convertToVector(0));
         else
-            cell2input_weights = getInputNode(9);
-        cell2forget_weights = getInputNode(10);
-        cell2output_weights = getInputNode(11);
+            weights.cell2input = getInputNode(cell2input);
+        weights.cell2forget = getInputNode(cell2forget);
+        weights.cell2output = getInputNode(cell2output);
     } else {
-        cell2input_weights =
-            createConstNode(elementType, ngraph::Shape{num_units}, convertToVector(0));
-        cell2forget_weights =
-            createConstNode(elementType, ngraph::Shape{num_units}, convertToVector(0));
-        cell2output_weights =
-            createConstNode(elementType, ngraph::Shape{num_units}, convertToVector(0));
+        weights.cell2input =
+            createConstNode(elementType, ngraph::Shape{numUnits}, convertToVector(0));
+        weights.cell2forget =
+            createConstNode(elementType, ngraph::Shape{numUnits}, convertToVector(0));
+        weights.cell2output =
+            createConstNode(elementType, ngraph::Shape{numUnits}, convertToVector(0));
     }
 
     // b_i, b_f, b_c, b_o
-    if (isCIFGenabled) {
-        if (!isCifgDimsEmpty) removeInputNode(12);
+    if (params.isCIFGenabled) {
+        if (!isCifgDimsEmpty) removeInputNode(inputGateBias);
     } else {
-        input_gate_bias = getInputNode(12);
+        weights.inputGateBias = getBiasNode(inputGateBias);
     }
-    forget_gate_bias = getInputNode(13);
-    cell_bias = getInputNode(14);
-    output_gate_bias = getInputNode(15);
+    weights.forgetGateBias = getBiasNode(weightsIndex + 12);
+    weights.cellBias = getBiasNode(weightsIndex + 13);
+    weights.outputGateBias = getBiasNode(weightsIndex + 14);
 
     // W_{proj}, b_{proj}
-    if (isProjectionUsed) {
-        projection_weights = getInputNode(16);
-        if (isValidInputTensor(17))
-            projection_bias = getInputNode(17);
+    if (params.isProjectionUsed) {
+        weights.projectionWeights = getInputNode(projectionWeights);
+        if (isValidInputTensor(projectionBias))
+            weights.projectionBias = getBiasNode(projectionBias);
         else
-            projection_bias =
-                createConstNode(elementType, ngraph::Shape{output_size}, convertToVector(0));
+            weights.projectionBias =
+                createConstNode(elementType, ngraph::Shape{outputSize}, convertToVector(0));
     }
 
-    initial_hidden_state = getInputNode(18);  // h_{t-1}
-    initial_cell_state = getInputNode(19);    // C_{t-1}
-
-    activationFn = sModelInfo->ParseOperationInput<uint32_t>(mNnapiOperationIndex, 20);
-
-    if (checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT16)) {
-        cell_state_clipping = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 21);
-        if (isProjectionUsed)
-            proj_clipping = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 22);
-    } else {
-        cell_state_clipping = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 21);
-        if (isProjectionUsed)
-            proj_clipping = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 22);
+    if (params.isLayerNormUsed) {
+        if (!params.isCIFGenabled) weights.inputLayerNorm = getInputNode(layerNormIndex);
+        weights.forgetLayerNorm = getInputNode(layerNormIndex + 1);
+        weights.cellLayerNorm = getInputNode(layerNormIndex + 2);
+        weights.outputLayerNorm = getInputNode(layerNormIndex + 3);
     }
+}
 
-    std::shared_ptr<ngraph::Node> i_t, f_t, c_t, o_t;
-    std::shared_ptr<ngraph::Node> scratchBuffer;
+std::shared_ptr<ngraph::Node> LSTM::getBiasNode(uint32_t inputIndex) {
+    auto bias = getInputNode(inputIndex);
+    const auto& operand = getInputOperand(inputIndex);
+    if (operand.type != OperandType::TENSOR_INT32) return bias;
 
-    std::shared_ptr<ngraph::Node> input_layer_norm_weights, forget_layer_norm_weights,
-        cell_layer_norm_weights, output_layer_norm_weights;
+    auto scale = createConstNode(ngraph::element::f32, {}, convertToVector(operand.scale));
+    return mul(std::make_shared<ngraph::opset3::Convert>(bias, ngraph::element::f32), scale);
+}
 
-    if (isLayerNormUsed) {
-        if (!isCIFGenabled) input_layer_norm_weights = getInputNode(23);
-        forget_layer_norm_weights = getInputNode(24);
-        cell_layer_norm_weights = getInputNode(25);
-        output_layer_norm_weights = getInputNode(26);
-    }
+float LSTM::getClipValue(uint32_t inputIndex) {
+    if (getInputOperand(inputIndex).type == OperandType::FLOAT16)
+        return sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, inputIndex);
+    return sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, inputIndex);
+}
+
+void LSTM::createLstmCell(const std::shared_ptr<ngraph::Node>& inputNode,
+                          const std::shared_ptr<ngraph::Node>& initial_hidden_state,
+                          const std::shared_ptr<ngraph::Node>& initial_cell_state,
+                          const LstmWeights& weights, const LstmParams& params,
+                          std::shared_ptr<ngraph::Node>& i_t, std::shared_ptr<ngraph::Node>& H,
+                          std::shared_ptr<ngraph::Node>& C) {
+    const auto& elementType = inputNode->get_element_type();
+    std::shared_ptr<ngraph::Node> f_t, c_t, o_t;
 
     // i_t = W_{xi}x_t+W_{hi}h_{t-1}+W_{ci}C_{t-1}
-    if (!isCIFGenabled)
-        i_t = add(add(matMul(inputNode, input2input_weights, false, true),
-                      matMul(initial_hidden_state, recurrent2input_weights, false, true)),
-                  mul(cell2input_weights, initial_cell_state));
+    if (!params.isCIFGenabled)
+        i_t = add(add(matMul(inputNode, weights.input2input, false, true),
+                      matMul(initial_hidden_state, weights.recurrent2input, false, true)),
+                  mul(weights.cell2input, initial_cell_state));
     // f_t = W_{xf}x_t+W_{hf}h_{t-1}+W_{cf}C_{t-1}
-    f_t = add(add(matMul(inputNode, input2forget_weights, false, true),
-                  matMul(initial_hidden_state, recurrent2forget_weights, false, true)),
-              mul(cell2forget_weights, initial_cell_state));
+    f_t = add(add(matMul(inputNode, weights.input2forget, false, true),
+                  matMul(initial_hidden_state, weights.recurrent2forget, false, true)),
+              mul(weights.cell2forget, initial_cell_state));
     // c_t = W_{xc}x_t+W_{hc}h_{t-1}
-    c_t = add(matMul(inputNode, input2cell_weights, false, true),
-              matMul(initial_hidden_state, recurrent2cell_weights, false, true));
+    c_t = add(matMul(inputNode, weights.input2cell, false, true),
+              matMul(initial_hidden_state, weights.recurrent2cell, false, true));
     // o_t = W_{xo}x_t+W_{ho}h_{t-1}
-    o_t = add(matMul(inputNode, input2output_weights, false, true),
-              matMul(initial_hidden_state, recurrent2output_weights, false, true));
+    o_t = add(matMul(inputNode, weights.input2output, false, true),
+              matMul(initial_hidden_state, weights.recurrent2output, false, true));
 
     /* ################# Update Forget Gate ################# */
-    if (isLayerNormUsed) {
-        f_t = LayerNorm(f_t, forget_layer_norm_weights, forget_gate_bias);
+    if (params.isLayerNormUsed) {
+        f_t = LayerNorm(f_t, weights.forgetLayerNorm, weights.forgetGateBias);
     } else {
         // W_{xf}x_t + W_{hf}h_{t-1} + W_{cf}C_{t-1} + b_f
-        f_t = add(f_t, forget_gate_bias);
+        f_t = add(f_t, weights.forgetGateBias);
     }
     // sigma(W_{xf}x_t + W_{hf}h_{t-1} + W_{cf}C_{t-1} + b_f)
     f_t = applyActivation(f_t, ACTIVATION_FUNCTION_SIGMOID);
 
     /* ################# Update Input Gate ################# */
-    if (isCIFGenabled) {
+    if (params.isCIFGenabled) {
         auto constNode = createConstNode(elementType, f_t->get_shape(), convertToVector(1.f));
         // Couple input with forget gate: 1 - i_f
         i_t = sub(constNode, f_t);
-
-        // TODO: Implement proper scratchBuffer
-        // Creating a dummy scratchBuffer with same size as i_t, initialized to 0.0f
-        // and then multiplying with i_t so that it gets connected to the graph
-        // Then it's concat'ed on axis 1 to make that dim 3x
-        scratchBuffer = createConstNode(elementType, i_t->get_shape(), convertToVector(0.f));
-        scratchBuffer = std::make_shared<ngraph::opset3::Multiply>(scratchBuffer, i_t);
-        std::vector<ngraph::Output<ngraph::Node>> inputs;
-        for (int i = 0; i < 3; i++) inputs.push_back(scratchBuffer);
-        scratchBuffer = std::make_shared<ngraph::opset3::Concat>(inputs, 1);
     } else {
-        if (isLayerNormUsed) {
-            i_t = LayerNorm(i_t, input_layer_norm_weights, input_gate_bias);
+        if (params.isLayerNormUsed) {
+            i_t = LayerNorm(i_t, weights.inputLayerNorm, weights.inputGateBias);
         } else {
             // W_{xi}x_t + W_{hi}h_{t-1} + W_{ci}C_{t-1} + b_i
-            i_t = add(i_t, input_gate_bias);
+            i_t = add(i_t, weights.inputGateBias);
         }
         // sigma(W_{xi}x_t + W_{hi}h_{t-1} + W_{ci}C_{t-1} + b_i)
         i_t = applyActivation(i_t, ACTIVATION_FUNCTION_SIGMOID);
-
-        // TODO: Implement proper scratchBuffer
-        // Creating a dummy scratchBuffer with same size as i_t, initialized to 0.0f
-        // and then multiplying with i_t so that it gets connected to the graph
-        // Then it's concat'ed on axis 1 to make that dim 4x
-        scratchBuffer = createConstNode(elementType, i_t->get_shape(), convertToVector(0.f));
-        scratchBuffer = std::make_shared<ngraph::opset3::Multiply>(scratchBuffer, i_t);
-        std::vector<ngraph::Output<ngraph::Node>> inputs;
-        for (int i = 0; i < 4; i++) inputs.push_back(scratchBuffer);
-        scratchBuffer = std::make_shared<ngraph::opset3::Concat>(inputs, 1);
     }
 
     /* ################# Update Cell Gate ################# */
 
-    if (isLayerNormUsed) {
-        c_t = LayerNorm(c_t, cell_layer_norm_weights, cell_bias);
+    if (params.isLayerNormUsed) {
+        c_t = LayerNorm(c_t, weights.cellLayerNorm, weights.cellBias);
     } else {
         // W_{xc}x_t+W_{hc}h_{t-1}+b_c
-        c_t = add(c_t, cell_bias);
+        c_t = add(c_t, weights.cellBias);
     }
     // g(W_{xc}x_t+W_{hc}h_{t-1}+b_c)
-    c_t = applyActivation(c_t, activationFn);
+    c_t = applyActivation(c_t, params.activationFn);
 
     // ft (.) Ct-1 + it (.) ct
-    auto C = add(mul(f_t, initial_cell_state), mul(i_t, c_t));
+    C = add(mul(f_t, initial_cell_state), mul(i_t, c_t));
     // clip(ft (.) Ct-1 + it (.) ct, t_{cell})
-    C = clip(C, cell_state_clipping);
+    C = clip(C, params.cellClip);
 
     /* ################# Update Output Gate ################# */
 
     // W_{xo}x_t+W_{ho}h_{t-1}+W_{co}C_t
-    o_t = add(o_t, mul(cell2output_weights, C));
+    o_t = add(o_t, mul(weights.cell2output, C));
 
-    if (isLayerNormUsed) {
-        o_t = LayerNorm(o_t, output_layer_norm_weights, output_gate_bias);
+    if (params.isLayerNormUsed) {
+        o_t = LayerNorm(o_t, weights.outputLayerNorm, weights.outputGateBias);
     } else {
         // W_{xo}x_t+W_{ho}h_{t-1}+W_{co}C_t+b_o
-        o_t = add(o_t, output_gate_bias);
+        o_t = add(o_t, weights.outputGateBias);
     }
 
     // sigma(W_{xo}x_t+W_{ho}h_{t-1}+W_{co}C_t+b_o)
     o_t = applyActivation(o_t, ACTIVATION_FUNCTION_SIGMOID);
 
-    std::shared_ptr<ngraph::Node> H;
-    if (isProjectionUsed) {
+    if (params.isProjectionUsed) {
         // o_t odot g(C_t)
-        auto dotProd = mul(o_t, applyActivation(C, activationFn));
+        auto dotProd = mul(o_t, applyActivation(C, params.activationFn));
         // W_{proj}(o_t odot g(C_t))
-        auto projWeightsProduct = matMul(projection_weights, dotProd, false, true);
+        auto projWeightsProduct = matMul(weights.projectionWeights, dotProd, false, true);
         // W_{proj}(o_t odot g(C_t))+b_{proj}
-        auto projBiasAdd = add(transpose(NC_CN, projWeightsProduct), projection_bias);
+        auto projBiasAdd = add(transpose(NC_CN, projWeightsProduct), weights.projectionBias);
         // clip(W_{proj}(o_t odot g(C_t))+b_{proj}, t_{proj})
-        H = clip(projBiasAdd, proj_clipping);
+        H = clip(projBiasAdd, params.projClip);
     } else {
         // o_t odot g(C_t)
-        H = mul(o_t, applyActivation(C, activationFn));
+        H = mul(o_t, applyActivation(C, params.activationFn));
     }
+}
 
-    std::vector<std::shared_ptr<ngraph::Node>> LstmOutputs(4, nullptr);
-    LstmOutputs[0] = scratchBuffer;
-    LstmOutputs[1] = H;
-    LstmOutputs[2] = C;
-    LstmOutputs[3] = H;
+std::shared_ptr<ngraph::Node> LSTM::createLstmSequence(const std::shared_ptr<ngraph::Node>& input,
+                                                       uint32_t maxTime,
+                                                       std::shared_ptr<ngraph::Node>& hiddenState,
+                                                       std::shared_ptr<ngraph::Node>& cellState,
+                                                       const LstmWeights& weights,
+                                                       const LstmParams& params, bool reverse) {
+    auto axisNode = createConstNode(ngraph::element::i32, {}, convertToVector(0));
+    auto timeAxis = createConstNode(ngraph::element::i64, {1}, convertToVector<int64_t>(0));
+    auto inputSplit = std::make_shared<ngraph::opset3::Split>(input, axisNode, maxTime)->outputs();
+
+    std::vector<ngraph::Output<ngraph::Node>> outputs(maxTime);
+    for (uint32_t step = 0; step < maxTime; step++) {
+        const uint32_t t = reverse ? maxTime - 1 - step : step;
+        auto x_t = std::make_shared<ngraph::opset3::Squeeze>(inputSplit[t], timeAxis);
+        std::shared_ptr<ngraph::Node> i_t, H, C;
+        createLstmCell(x_t, hiddenState, cellState, weights, params, i_t, H, C);
+        hiddenState = H;
+        cellState = C;
+        outputs[t] = std::make_shared<ngraph::opset3::Unsqueeze>(H, timeAxis);
+    }
+    return std::make_shared<ngraph::opset3::Concat>(outputs, 0);
+}
 
-    for (int i = 0; i < 4; i++) {
-        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
-        mNgraphNodes->setOutputAtOperandIndex(outputIndex, LstmOutputs[i]);
-        const auto op = sModelInfo->getOperand(outputIndex);
-        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
-            addResultNode(outputIndex, LstmOutputs[i]);
-        }
+void LSTM::connectOutput(uint32_t index, std::shared_ptr<ngraph::Node> outputNode) {
+    auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, index);
+    const auto op = sModelInfo->getOperand(outputIndex);
+    if (op.type == OperandType::TENSOR_QUANT8_ASYMM) {
+        outputNode = QuantizeNode(outputNode, outputIndex, ngraph::element::u8);
+    } else if (op.type == OperandType::TENSOR_QUANT8_ASYMM_SIGNED) {
+        outputNode = QuantizeNode(outputNode, outputIndex, ngraph::element::i8);
+    } else if (op.type == OperandType::TENSOR_QUANT16_SYMM) {
+        outputNode = QuantizeNode(outputNode, outputIndex, ngraph::element::i16);
+    }
+    mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputNode);
+    if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+        addResultNode(outputIndex, outputNode);
     }
-    return nullptr;
 }
 
 std::shared_ptr<ngraph::Node> LSTM::add(const ngraph::Output<ngraph::Node>& lhs,
@@ -0,0 +1,80 @@
+#include <LocalResponseNormalization.hpp>
+#undef LOG_TAG
+#define LOG_TAG "LocalResponseNormalization"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+LocalResponseNormalization::LocalResponseNormalization(int operationIndex)
+    : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool LocalResponseNormalization::validate() {
+    // Check input rank
+    const auto inputRank = getInputOperandDimensions(0).size();
+    if (inputRank == 0 || inputRank > 4) {
+        ALOGE("%s Invalid input dimensions size!", __func__);
+        return false;
+    }
+
+    if (!checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT32) &&
+        !checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT16)) {
+        ALOGE("%s Only FP32 and FP16 inputs are supported", __func__);
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<ngraph::Node> LocalResponseNormalization::createNode() {
+    // Creating input nodes
+    auto input = getInputNode(0);
+
+    auto radius = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 1);
+    double bias, alpha, beta;
+    if (checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT16)) {
+        bias = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 2);
+        alpha = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 3);
+        beta = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 4);
+    } else {
+        bias = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 2);
+        alpha = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 3);
+        beta = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 4);
+    }
+
+    const auto& inputDims = getInputOperandDimensions(0);
+    const int inputRank = inputDims.size();
+    int axis = -1;
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    if (inputsSize == 6) axis = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 5);
+    if (axis < 0) axis += inputRank;
+
+    // Normalizing across channels of an [outer, depth, inner, 1] view covers any axis without
+    // transposing the input
+    int32_t outer = 1, inner = 1;
+    for (int i = 0; i < axis; i++) outer *= inputDims[i];
+    for (int i = axis + 1; i < inputRank; i++) inner *= inputDims[i];
+    auto view = createConstNode(ngraph::element::i32, {4},
+                                std::vector<int32_t>{outer, (int32_t)inputDims[axis], inner, 1});
+    input = std::make_shared<ngraph::opset3::Reshape>(input, view, false);
+
+    // nGraph divides alpha by the size of the window
+    const size_t size = 2 * radius + 1;
+    auto axes = createConstNode(ngraph::element::i32, {1}, convertToVector(1));
+    std::shared_ptr<ngraph::Node> outputNode =
+        std::make_shared<ngraph::opset3::LRN>(input, axes, alpha * size, beta, bias, size);
+
+    auto outputShape = createConstNode(ngraph::element::i32, {inputDims.size()},
+                                       std::vector<int32_t>(inputDims.begin(), inputDims.end()));
+    outputNode = std::make_shared<ngraph::opset3::Reshape>(outputNode, outputShape, false);
+
+    return outputNode;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
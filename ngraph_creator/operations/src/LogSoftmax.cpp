@@ -1,4 +1,5 @@
 #include <LogSoftmax.hpp>
+#include <ngraph/opsets/opset5.hpp>
 #undef LOG_TAG
 #define LOG_TAG "LogSoftmax"
 
@@ -11,29 +12,49 @@ LogSoftmax::LogSoftmax(int operationIndex) : OperationsBase(operationIndex) {
     mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
 }
 
-std::shared_ptr<ngraph::Node> LogSoftmax::createNode() {
-    // Creating input nodes
-    std::shared_ptr<ngraph::Node> input, outputNode;
-
-    input = getInputNode(0);
-
-    std::shared_ptr<ngraph::Node> betaNode;
-
+std::shared_ptr<ngraph::Node> LogSoftmax::createBetaNode(const ngraph::Shape& shape) {
     if (checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT16)) {
         auto beta = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 1);
-        betaNode = createConstNode(ngraph::element::f16, {}, convertToVector(beta));
-    } else {
-        auto beta = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 1);
-        betaNode = createConstNode(ngraph::element::f32, {}, convertToVector(beta));
+        if (beta == 1) return nullptr;
+        return createConstNode(ngraph::element::f16, shape, convertToVector(beta));
     }
-    int axis = -1;
+    auto beta = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 1);
+    if (beta == 1.f) return nullptr;
+    return createConstNode(ngraph::element::f32, shape, convertToVector(beta));
+}
+
+int64_t LogSoftmax::getAxis() {
+    int64_t axis = -1;
     const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
     if (inputsSize == 3) axis = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 2);
+    return axis;
+}
+
+std::shared_ptr<ngraph::Node> LogSoftmax::createNode() {
+    std::shared_ptr<ngraph::Node> input = getInputNode(0);
+    // log_softmax(logits * beta), the scaling fuses into the producer of the logits
+    auto betaNode = createBetaNode({});
+    if (betaNode) input = std::make_shared<ngraph::opset3::Multiply>(input, betaNode);
+    return std::make_shared<ngraph::opset5::LogSoftmax>(input, getAxis());
+}
+
+std::shared_ptr<ngraph::Node> LogSoftmax::createNodeForPlugin() {
+    if (sPluginType == IntelDeviceType::GNA) return createDecomposedNode();
+    return createNode();
+}
+
+std::shared_ptr<ngraph::Node> LogSoftmax::createDecomposedNode() {
+    // Creating input nodes
+    std::shared_ptr<ngraph::Node> input, outputNode;
+
+    input = getInputNode(0);
 
-    const auto axisNode = createConstNode(ngraph::element::i32, {1}, convertToVector(axis));
+    const auto axisNode = createConstNode(ngraph::element::i64, {1}, convertToVector(getAxis()));
 
     // logits * beta
-    auto mul = std::make_shared<ngraph::opset3::Multiply>(input, betaNode);
+    std::shared_ptr<ngraph::Node> mul = input;
+    auto betaNode = createBetaNode({});
+    if (betaNode) mul = std::make_shared<ngraph::opset3::Multiply>(input, betaNode);
     // exp(logits * beta)
     auto exp = std::make_shared<ngraph::opset3::Exp>(mul);
     // reduce_sum(exp(logits * beta), axis)
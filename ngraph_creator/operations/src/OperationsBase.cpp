@@ -9,6 +9,7 @@ namespace nnhal {
 
 IntelDeviceType OperationsBase::sPluginType;
 std::shared_ptr<NnapiModelInfo> OperationsBase::sModelInfo;
+std::recursive_mutex OperationsBase::sTranslationMutex;
 
 std::shared_ptr<ngraph::Node> OperationsBase::transpose(ConversionType type,
                                                         ngraph::Output<ngraph::Node> input) {
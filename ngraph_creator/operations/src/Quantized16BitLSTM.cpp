@@ -0,0 +1,67 @@
+#include <Quantized16BitLSTM.hpp>
+#undef LOG_TAG
+#define LOG_TAG "Quantized16BitLSTM"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+Quantized16BitLSTM::Quantized16BitLSTM(int operationIndex) : LSTM(operationIndex) {}
+
+bool Quantized16BitLSTM::validate() {
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+
+    if (inputsSize != 15 || outputsSize != 2) return false;
+
+    if (!checkInputOperandType(0, (int32_t)OperandType::TENSOR_QUANT8_ASYMM) ||
+        !checkInputOperandType(13, (int32_t)OperandType::TENSOR_QUANT16_SYMM) ||
+        !checkInputOperandType(14, (int32_t)OperandType::TENSOR_QUANT8_ASYMM))
+        return false;
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+std::shared_ptr<ngraph::Node> Quantized16BitLSTM::createNode() {
+    // Basic LSTM cell without CIFG, peephole, projection or clipping, evaluated in float on the
+    // dequantized inputs and requantized to the output operands
+    LstmWeights weights;
+    LstmParams params;
+    weights.input2input = getInputNode(1);
+    weights.input2forget = getInputNode(2);
+    weights.input2cell = getInputNode(3);
+    weights.input2output = getInputNode(4);
+    weights.recurrent2input = getInputNode(5);
+    weights.recurrent2forget = getInputNode(6);
+    weights.recurrent2cell = getInputNode(7);
+    weights.recurrent2output = getInputNode(8);
+    weights.inputGateBias = getBiasNode(9);
+    weights.forgetGateBias = getBiasNode(10);
+    weights.cellBias = getBiasNode(11);
+    weights.outputGateBias = getBiasNode(12);
+
+    auto num_units = getInputOperandDimensions(13)[1];
+    auto zeros =
+        createConstNode(ngraph::element::f32, ngraph::Shape{num_units}, convertToVector(0));
+    weights.cell2input = zeros;
+    weights.cell2forget = zeros;
+    weights.cell2output = zeros;
+
+    auto inputNode = getInputNode(0);
+    auto cellState = getInputNode(13);
+    auto hiddenState = getInputNode(14);
+
+    std::shared_ptr<ngraph::Node> i_t, H, C;
+    createLstmCell(inputNode, hiddenState, cellState, weights, params, i_t, H, C);
+
+    connectOutput(0, C);
+    connectOutput(1, H);
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
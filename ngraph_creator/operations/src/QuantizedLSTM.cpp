@@ -0,0 +1,58 @@
+#include <QuantizedLSTM.hpp>
+#undef LOG_TAG
+#define LOG_TAG "QuantizedLSTM"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+QuantizedLSTM::QuantizedLSTM(int operationIndex) : LSTM(operationIndex) {}
+
+bool QuantizedLSTM::validate() {
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+
+    if (inputsSize != 32 || outputsSize != 3) return false;
+
+    if (!checkInputOperandType(0, (int32_t)OperandType::TENSOR_QUANT8_ASYMM_SIGNED)) return false;
+    if (getInputOperandDimensions(18).size() != 2 || getInputOperandDimensions(19).size() != 2)
+        return false;
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+std::shared_ptr<ngraph::Node> QuantizedLSTM::createNode() {
+    auto num_units = getInputOperandDimensions(19)[1];
+    auto output_size = getInputOperandDimensions(18)[1];
+
+    // Inputs, weights and states are dequantized and the cell evaluated in float. The gate
+    // intermediate scales (inputs 26-29) only describe the integer kernel and are not needed.
+    auto inputNode = getInputNode(0);
+    const auto& elementType = inputNode->get_element_type();
+
+    LstmWeights weights;
+    LstmParams params;
+    getLstmWeights(1, 20, elementType, num_units, output_size, weights, params);
+
+    auto hiddenState = getInputNode(18);
+    auto cellState = getInputNode(19);
+
+    params.cellClip = getClipValue(24);
+    params.projClip = getClipValue(25);
+
+    std::shared_ptr<ngraph::Node> i_t, H, C;
+    createLstmCell(inputNode, hiddenState, cellState, weights, params, i_t, H, C);
+
+    // Outputs are requantized with the scale and zero point of their operands
+    connectOutput(0, H);
+    connectOutput(1, C);
+    connectOutput(2, H);
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,27 @@
+#include <Rank.hpp>
+#undef LOG_TAG
+#define LOG_TAG "Rank"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+Rank::Rank(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+std::shared_ptr<ngraph::Node> Rank::createNode() {
+    // Ranks are static, the output is a constant scalar
+    const int32_t rank = getInputOperandDimensions(0).size();
+
+    std::shared_ptr<ngraph::Node> outputNode =
+        createConstNode(ngraph::element::i32, {}, convertToVector(rank));
+
+    return outputNode;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,118 @@
+#include <SVDF.hpp>
+#undef LOG_TAG
+#define LOG_TAG "SVDF"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+SVDF::SVDF(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 1);
+}
+
+bool SVDF::validate() {
+    for (uint32_t i = 0; i < 5; i++) {
+        if (i == 3 && !isValidInputTensor(i)) continue;
+        if (!checkInputOperandType(i, (int32_t)OperandType::TENSOR_FLOAT32)) {
+            ALOGE("%s Input operand %d is not of type FP32. Unsupported operation", __func__, i);
+            return false;
+        }
+    }
+
+    const auto& inputDims = getInputOperandDimensions(0);
+    const auto& featureDims = getInputOperandDimensions(1);
+    const auto& timeDims = getInputOperandDimensions(2);
+    if (inputDims.size() != 2 || featureDims.size() != 2 || timeDims.size() != 2) {
+        ALOGE("%s Invalid input dimensions size!", __func__);
+        return false;
+    }
+
+    auto rank = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 5);
+    if (rank <= 0 || featureDims[0] % rank != 0) {
+        ALOGE("%s Rank %d does not divide %d filters", __func__, rank, featureDims[0]);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+void SVDF::connectOperationToGraph() { createNode(); }
+
+std::shared_ptr<ngraph::Node> SVDF::createNode() {
+    // Creating input nodes
+    auto input = getInputNode(0);           // [batch, inputSize]
+    auto weightsFeature = getInputNode(1);  // [numFilters, inputSize]
+    auto weightsTime = getInputNode(2);     // [numFilters, memorySize]
+    auto stateIn = getInputNode(4);         // [batch, numFilters * memorySize]
+    auto rank = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 5);
+    auto activationFn = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 6);
+
+    const int32_t batchSize = getInputOperandDimensions(0)[0];
+    const int32_t numFilters = getInputOperandDimensions(1)[0];
+    const int32_t memorySize = getInputOperandDimensions(2)[1];
+    const int32_t numUnits = numFilters / rank;
+
+    auto shape = [&](std::vector<int32_t> dims) {
+        return createConstNode(ngraph::element::i32, {dims.size()}, dims);
+    };
+    auto range = [&](int32_t begin, int32_t end) {
+        std::vector<int32_t> indices;
+        for (int32_t i = begin; i < end; i++) indices.push_back(i);
+        return createConstNode(ngraph::element::i32, {indices.size()}, indices);
+    };
+    auto axis2 = createConstNode(ngraph::element::i32, {}, convertToVector(2));
+
+    // The first memorySize - 1 columns of the state hold the past feature activations of every
+    // filter, the newest activation takes the last column
+    auto state = std::make_shared<ngraph::opset3::Reshape>(
+        stateIn, shape({batchSize, numFilters, memorySize}), false);
+    auto activation = std::make_shared<ngraph::opset3::MatMul>(input, weightsFeature, false, true);
+    auto memory = std::make_shared<ngraph::opset3::Concat>(
+        ngraph::OutputVector{
+            std::make_shared<ngraph::opset3::Gather>(state, range(0, memorySize - 1), axis2),
+            std::make_shared<ngraph::opset3::Reshape>(activation,
+                                                      shape({batchSize, numFilters, 1}), false)},
+        2);
+
+    // Time filtering of every filter, then summing the rank filters of every unit
+    auto filtered = std::make_shared<ngraph::opset3::ReduceSum>(
+        std::make_shared<ngraph::opset3::Multiply>(memory, weightsTime), axis2, false);
+    std::shared_ptr<ngraph::Node> outputNode = std::make_shared<ngraph::opset3::ReduceSum>(
+        std::make_shared<ngraph::opset3::Reshape>(filtered, shape({batchSize, numUnits, rank}),
+                                                  false),
+        axis2, false);
+    if (isValidInputTensor(3)) {
+        outputNode = std::make_shared<ngraph::opset3::Add>(outputNode, getInputNode(3));
+    }
+    outputNode = applyActivation(outputNode, activationFn);
+
+    // The next state is the memory shifted left by one column
+    std::shared_ptr<ngraph::Node> stateOut = std::make_shared<ngraph::opset3::Concat>(
+        ngraph::OutputVector{
+            std::make_shared<ngraph::opset3::Gather>(memory, range(1, memorySize), axis2),
+            createConstNode(ngraph::element::f32,
+                            {(size_t)batchSize, (size_t)numFilters, 1},
+                            std::vector<float>(batchSize * numFilters, 0.f))},
+        2);
+    stateOut = std::make_shared<ngraph::opset3::Reshape>(
+        stateOut, shape({batchSize, numFilters * memorySize}), false);
+
+    std::shared_ptr<ngraph::Node> outputs[] = {stateOut, outputNode};
+    for (uint32_t i = 0; i < 2; i++) {
+        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
+        mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputs[i]);
+        const auto op = sModelInfo->getOperand(outputIndex);
+        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+            addResultNode(outputIndex, outputs[i]);
+        }
+    }
+
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
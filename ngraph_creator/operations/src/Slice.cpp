@@ -0,0 +1,52 @@
+#include <Slice.hpp>
+#undef LOG_TAG
+#define LOG_TAG "Slice"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+Slice::Slice(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool Slice::validate() {
+    // Check input rank
+    const auto inputRank = getInputOperandDimensions(0).size();
+    if (inputRank > 4) {
+        ALOGE("%s Invalid input dimensions size!", __func__);
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<ngraph::Node> Slice::createNode() {
+    // Creating input nodes
+    auto data = getInputNode(0);
+    auto begin = getInputNode(1);
+    auto size = getInputNode(2);
+
+    const auto inputRank = getInputOperandDimensions(0).size();
+
+    // A size of -1 takes all remaining elements of the dimension
+    auto shape = std::make_shared<ngraph::opset3::ShapeOf>(data, ngraph::element::i32);
+    auto allRemaining = std::make_shared<ngraph::opset3::Equal>(
+        size, createConstNode(ngraph::element::i32, {}, convertToVector(-1)));
+    auto end = std::make_shared<ngraph::opset3::Select>(
+        allRemaining, shape, std::make_shared<ngraph::opset3::Add>(begin, size));
+    auto strides = createConstNode(ngraph::element::i32, {inputRank},
+                                   std::vector<int32_t>(inputRank, 1));
+
+    const std::vector<int64_t> mask(inputRank, 0);
+    std::shared_ptr<ngraph::Node> outputNode =
+        std::make_shared<ngraph::opset3::StridedSlice>(data, begin, end, strides, mask, mask);
+
+    return outputNode;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
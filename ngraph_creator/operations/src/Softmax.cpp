@@ -11,35 +11,56 @@ Softmax::Softmax(int operationIndex) : OperationsBase(operationIndex) {
     mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
 }
 
-std::shared_ptr<ngraph::Node> Softmax::createNode() {
-    // Creating input nodes
-    std::shared_ptr<ngraph::Node> input, outputNode;
-
-    input = getInputNode(0);
-
-    std::shared_ptr<ngraph::Node> betaNode;
-
+std::shared_ptr<ngraph::Node> Softmax::createBetaNode(const ngraph::Shape& shape) {
     if (checkInputOperandType(0, (int32_t)OperandType::TENSOR_FLOAT16)) {
         auto beta = sModelInfo->ParseOperationInput<_Float16>(mNnapiOperationIndex, 1);
-        betaNode = createConstNode(ngraph::element::f16, {1}, convertToVector(beta));
-    } else {
-        auto beta = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 1);
-        betaNode = createConstNode(ngraph::element::f32, {1}, convertToVector(beta));
+        if (beta == 1) return nullptr;
+        return createConstNode(ngraph::element::f16, shape, convertToVector(beta));
     }
-    int axis = -1;
+    auto beta = sModelInfo->ParseOperationInput<float>(mNnapiOperationIndex, 1);
+    if (beta == 1.f) return nullptr;
+    return createConstNode(ngraph::element::f32, shape, convertToVector(beta));
+}
+
+int64_t Softmax::getAxis() {
+    int64_t axis = -1;
     const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
     if (inputsSize == 3) axis = sModelInfo->ParseOperationInput<int>(mNnapiOperationIndex, 2);
+    // opset1 Softmax takes a positive axis only
+    if (axis < 0) axis += static_cast<int64_t>(getInputOperandDimensions(0).size());
+    return axis;
+}
+
+std::shared_ptr<ngraph::Node> Softmax::createNode() {
+    std::shared_ptr<ngraph::Node> input = getInputNode(0);
+    // softmax(input * beta), the scaling fuses into the producer of the input
+    auto betaNode = createBetaNode({1});
+    if (betaNode) input = std::make_shared<ngraph::opset3::Multiply>(input, betaNode);
+    return std::make_shared<ngraph::opset3::Softmax>(input, getAxis());
+}
+
+std::shared_ptr<ngraph::Node> Softmax::createNodeForPlugin() {
+    if (sPluginType == IntelDeviceType::GNA) return createDecomposedNode();
+    return createNode();
+}
+
+std::shared_ptr<ngraph::Node> Softmax::createDecomposedNode() {
+    // Creating input nodes
+    std::shared_ptr<ngraph::Node> input, outputNode;
+
+    input = getInputNode(0);
 
-    const auto axisNode = createConstNode(ngraph::element::i32, {1}, convertToVector(axis));
+    const auto axisNode = createConstNode(ngraph::element::i64, {1}, convertToVector(getAxis()));
 
     // max(input[batch, :]
     auto max = std::make_shared<ngraph::opset3::ReduceMax>(input, axisNode, true);
     // input[batch, i] - max(input[batch, :])
-    auto sub = std::make_shared<ngraph::opset3::Subtract>(input, max);
+    std::shared_ptr<ngraph::Node> sub = std::make_shared<ngraph::opset3::Subtract>(input, max);
     // (input[batch, i] - max(input[batch, :])) * beta
-    auto mul = std::make_shared<ngraph::opset3::Multiply>(sub, betaNode);
+    auto betaNode = createBetaNode({1});
+    if (betaNode) sub = std::make_shared<ngraph::opset3::Multiply>(sub, betaNode);
     // exp((input[batch, i] - max(input[batch, :])) * beta)
-    auto exp = std::make_shared<ngraph::opset3::Exp>(mul);
+    auto exp = std::make_shared<ngraph::opset3::Exp>(sub);
     // sum_{k}{exp((input[batch, k] - max(input[batch, :])) * beta)}
     auto sum = std::make_shared<ngraph::opset3::ReduceSum>(exp, axisNode, true);
     // exp((input[batch, i] - max(input[batch, :])) * beta) / sum_{k}{exp((input[batch, k] -
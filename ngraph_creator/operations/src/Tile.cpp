@@ -0,0 +1,28 @@
+#include <Tile.hpp>
+#undef LOG_TAG
+#define LOG_TAG "Tile"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+Tile::Tile(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+std::shared_ptr<ngraph::Node> Tile::createNode() {
+    // Creating input nodes
+    auto input = getInputNode(0);
+    auto multiples = getInputNode(1);
+
+    std::shared_ptr<ngraph::Node> outputNode =
+        std::make_shared<ngraph::opset3::Tile>(input, multiples);
+
+    return outputNode;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,68 @@
+#include <UnidirectionalSequenceLSTM.hpp>
+#undef LOG_TAG
+#define LOG_TAG "UnidirectionalSequenceLSTM"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+UnidirectionalSequenceLSTM::UnidirectionalSequenceLSTM(int operationIndex) : LSTM(operationIndex) {}
+
+bool UnidirectionalSequenceLSTM::validate() {
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+
+    if (inputsSize != 24 && inputsSize != 28) return false;
+    if (outputsSize != 1 && outputsSize != 3) return false;
+
+    if (getInputOperandDimensions(0).size() != 3 || getInputOperandDimensions(18).size() != 2 ||
+        getInputOperandDimensions(19).size() != 2)
+        return false;
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+std::shared_ptr<ngraph::Node> UnidirectionalSequenceLSTM::createNode() {
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+    const auto& inDims = getInputOperandDimensions(0);
+    auto num_units = getInputOperandDimensions(19)[1];
+    auto output_size = getInputOperandDimensions(18)[1];
+
+    auto inputNode = getInputNode(0);
+    const auto& elementType = inputNode->get_element_type();
+
+    LstmWeights weights;
+    LstmParams params;
+    getLstmWeights(1, inputsSize == 28 ? 24 : -1, elementType, num_units, output_size, weights,
+                   params);
+
+    auto hiddenState = getInputNode(18);
+    auto cellState = getInputNode(19);
+
+    params.activationFn = sModelInfo->ParseOperationInput<uint32_t>(mNnapiOperationIndex, 20);
+    params.cellClip = getClipValue(21);
+    if (params.isProjectionUsed) params.projClip = getClipValue(22);
+    auto isTimeMajor = sModelInfo->ParseOperationInput<uint8_t>(mNnapiOperationIndex, 23);
+
+    if (!isTimeMajor) inputNode = transpose(BTS_TBS, inputNode);
+    uint32_t maxTime = isTimeMajor ? inDims[0] : inDims[1];
+
+    auto outputNode = createLstmSequence(inputNode, maxTime, hiddenState, cellState, weights,
+                                         params, false);
+    if (!isTimeMajor) outputNode = transpose(BTS_TBS, outputNode);
+
+    connectOutput(0, outputNode);
+    if (outputsSize == 3) {
+        connectOutput(1, hiddenState);
+        connectOutput(2, cellState);
+    }
+    return nullptr;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
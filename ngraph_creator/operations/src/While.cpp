@@ -0,0 +1,131 @@
+#include <While.hpp>
+#include <NgraphNetworkCreator.hpp>
+#undef LOG_TAG
+#define LOG_TAG "While"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+While::While(int operationIndex) : OperationsBase(operationIndex) {
+    mDefaultOutputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, 0);
+}
+
+bool While::validate() {
+    // Loop body parameters are created from the shapes of the initial values
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    for (size_t i = 2; i < inputsSize; i++) {
+        const auto& operand = getInputOperand(i);
+        if (android::nn::nonExtensionOperandTypeIsScalar(static_cast<int>(operand.type)) ||
+            android::nn::tensorHasUnspecifiedDimensions(operand)) {
+            ALOGE("%s Only fully specified tensor inputs supported", __func__);
+            return false;
+        }
+    }
+
+    auto bodyInfo = sModelInfo->createSubgraphInfo(
+        sModelInfo->getOperationInput(mNnapiOperationIndex, 1));
+    if (!bodyInfo ||
+        bodyInfo->getModelOutputsSize() < sModelInfo->getOperationOutputsSize(mNnapiOperationIndex))
+        return false;
+
+    if (!NgraphNetworkCreator::validateSubgraph(
+            sModelInfo->getOperationInput(mNnapiOperationIndex, 0)) ||
+        !NgraphNetworkCreator::validateSubgraph(
+            sModelInfo->getOperationInput(mNnapiOperationIndex, 1))) {
+        ALOGE("%s Condition or body contains unsupported operations", __func__);
+        return false;
+    }
+
+    ALOGV("%s PASSED", __func__);
+    return true;
+}
+
+void While::connectOperationToGraph() { createNode(); }
+
+std::shared_ptr<ngraph::Node> While::createNode() {
+    const auto condOperand = sModelInfo->getOperationInput(mNnapiOperationIndex, 0);
+    const auto bodyOperand = sModelInfo->getOperationInput(mNnapiOperationIndex, 1);
+
+    // Inputs are the input-output values, then state-only values, then input-only values
+    const auto& inputsSize = sModelInfo->getOperationInputsSize(mNnapiOperationIndex);
+    std::vector<ngraph::Output<ngraph::Node>> loopInputs;
+    for (size_t i = 2; i < inputsSize; i++) loopInputs.push_back(getInputNode(i, false));
+
+    // The condition is first evaluated on the initial values, outside of the loop
+    std::vector<ngraph::Output<ngraph::Node>> initialCondition;
+    if (!NgraphNetworkCreator::translateSubgraph(condOperand, loopInputs, initialCondition)) {
+        ALOGE("%s Failed to translate condition", __func__);
+        throw std::runtime_error("WHILE condition translation failed");
+    }
+
+    ngraph::ParameterVector bodyParams;
+    std::vector<ngraph::Output<ngraph::Node>> bodyInputs, bodyOutputs;
+    for (const auto& input : loopInputs) {
+        auto param = std::make_shared<ngraph::opset3::Parameter>(input.get_element_type(),
+                                                                 input.get_shape());
+        bodyParams.push_back(param);
+        bodyInputs.push_back(param);
+    }
+    if (!NgraphNetworkCreator::translateSubgraph(bodyOperand, bodyInputs, bodyOutputs)) {
+        ALOGE("%s Failed to translate body", __func__);
+        throw std::runtime_error("WHILE body translation failed");
+    }
+    // Body outputs update the input-output and state-only values
+    const size_t carriedSize = bodyOutputs.size();
+
+    // The condition for the next iteration is evaluated inside the body on the updated values
+    std::vector<ngraph::Output<ngraph::Node>> nextInputs(bodyOutputs);
+    nextInputs.insert(nextInputs.end(), bodyInputs.begin() + carriedSize, bodyInputs.end());
+    std::vector<ngraph::Output<ngraph::Node>> nextCondition;
+    if (!NgraphNetworkCreator::translateSubgraph(condOperand, nextInputs, nextCondition)) {
+        ALOGE("%s Failed to translate condition", __func__);
+        throw std::runtime_error("WHILE condition translation failed");
+    }
+
+    ngraph::ResultVector bodyResults;
+    for (const auto& output : bodyOutputs)
+        bodyResults.push_back(std::make_shared<ngraph::opset3::Result>(output));
+    bodyResults.push_back(std::make_shared<ngraph::opset3::Result>(nextCondition[0]));
+
+    // Iterations are unbounded here, the loop timeout is enforced when executing
+    auto tripCount = createConstNode(ngraph::element::i64, {}, convertToVector<int64_t>(-1));
+    auto loop = std::make_shared<ngraph::op::v5::Loop>(tripCount, initialCondition[0]);
+    loop->set_function(std::make_shared<ngraph::Function>(bodyResults, bodyParams));
+    loop->set_special_body_ports({-1, static_cast<int64_t>(carriedSize)});
+    for (size_t i = 0; i < bodyParams.size(); i++) {
+        if (i < carriedSize)
+            loop->set_merged_input(bodyParams[i], loopInputs[i], bodyResults[i]);
+        else
+            loop->set_invariant_input(bodyParams[i], loopInputs[i]);
+    }
+
+    const auto& outputsSize = sModelInfo->getOperationOutputsSize(mNnapiOperationIndex);
+    std::vector<ngraph::Output<ngraph::Node>> loopOutputs;
+    for (size_t i = 0; i < outputsSize; i++)
+        loopOutputs.push_back(loop->get_iter_value(bodyResults[i], -1));
+    loop->validate_and_infer_types();
+
+    for (size_t i = 0; i < outputsSize; i++) {
+        // Outputs of the loop share one node, give each its own node so that results and
+        // blob names are resolved per output
+        std::shared_ptr<ngraph::Node> outputNode = std::make_shared<ngraph::opset3::Convert>(
+            loopOutputs[i], loopOutputs[i].get_element_type());
+        auto outputIndex = sModelInfo->getOperationOutput(mNnapiOperationIndex, i);
+        mNgraphNodes->setOutputAtOperandIndex(outputIndex, outputNode);
+        ALOGD("%s Set Output index %d", __func__, outputIndex);
+        const auto op = sModelInfo->getOperand(outputIndex);
+        if (op.lifetime == OperandLifeTime::SUBGRAPH_OUTPUT) {
+            addResultNode(outputIndex, outputNode);
+            ALOGD("%s Add result %d", __func__, outputIndex);
+        }
+    }
+
+    return loop;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -29,9 +29,85 @@ NgraphNetworkCreator::NgraphNetworkCreator(std::shared_ptr<NnapiModelInfo> model
 
 NgraphNetworkCreator::~NgraphNetworkCreator() { ALOGV("%s Destructed", __func__); }
 
+void NgraphNetworkCreator::enableStatefulMode() {
+    findStateOperands();
+    ALOGD("%s %zu recurrent state operands kept in the plugin", __func__, mStateOperands.size());
+}
+
+void NgraphNetworkCreator::findStateOperands() {
+    // {operation type, state input, state output} for recurrent operations whose next state is
+    // exposed as an output of the same operation
+    static const std::vector<std::tuple<OperationType, uint32_t, uint32_t>> kStateLinks = {
+        {OperationType::LSTM, 18, 1},
+        {OperationType::LSTM, 19, 2},
+        {OperationType::RNN, 4, 0},
+        {OperationType::SVDF, 4, 0},
+        {OperationType::UNIDIRECTIONAL_SEQUENCE_RNN, 4, 1},
+        {OperationType::UNIDIRECTIONAL_SEQUENCE_LSTM, 18, 1},
+        {OperationType::UNIDIRECTIONAL_SEQUENCE_LSTM, 19, 2},
+    };
+
+    mStateOperands.clear();
+    for (size_t index = 0; index < mModelInfo->getOperationsSize(); index++) {
+        for (const auto& [type, stateIn, stateOut] : kStateLinks) {
+            if (mModelInfo->getOperationType(index) != type) continue;
+            if (mModelInfo->getOperationInputsSize(index) <= stateIn ||
+                mModelInfo->getOperationOutputsSize(index) <= stateOut)
+                continue;
+
+            auto inIndex = mModelInfo->getOperationInput(index, stateIn);
+            auto outIndex = mModelInfo->getOperationOutput(index, stateOut);
+            const auto& inOperand = mModelInfo->getOperand(inIndex);
+            const auto& outOperand = mModelInfo->getOperand(outIndex);
+            if (inOperand.lifetime != OperandLifeTime::SUBGRAPH_INPUT ||
+                outOperand.lifetime != OperandLifeTime::SUBGRAPH_OUTPUT)
+                continue;
+            if (inOperand.type != outOperand.type || inOperand.dimensions != outOperand.dimensions)
+                continue;
+            if (inOperand.type != OperandType::TENSOR_FLOAT32 &&
+                inOperand.type != OperandType::TENSOR_FLOAT16)
+                continue;
+            const auto& dims = inOperand.dimensions;
+            if (dims.size() == 0 || std::find(dims.begin(), dims.end(), 0) != dims.end()) continue;
+
+            ALOGD("%s operation %zu state operand %d -> %d", __func__, index, inIndex, outIndex);
+            mStateOperands[inIndex] = outIndex;
+        }
+    }
+}
+
+bool NgraphNetworkCreator::createStateNode(uint32_t inputIndex) {
+    const auto& nnapiOperand = mModelInfo->getOperand(inputIndex);
+    auto elementType = (nnapiOperand.type == OperandType::TENSOR_FLOAT16) ? ngraph::element::f16
+                                                                          : ngraph::element::f32;
+    ngraph::Shape shape(nnapiOperand.dimensions.begin(), nnapiOperand.dimensions.end());
+    // The state starts from zeros and on every resetState() of the plugin
+    auto initValue = ngraph::opset3::Constant::create(elementType, shape, {0});
+    auto readValue = std::make_shared<ngraph::opset3::ReadValue>(
+        initValue, "nnapi_state_" + std::to_string(inputIndex));
+
+    mNgraphNodes->setOutputAtOperandIndex(inputIndex, readValue);
+    // State is not read back from the request, so the input is skipped at execution time
+    mNgraphNodes->setInvalidNode(inputIndex);
+    ALOGV("createStateNode created state for inputIndex %d", inputIndex);
+    return true;
+}
+
+void NgraphNetworkCreator::connectStateNodes() {
+    for (const auto& [inIndex, outIndex] : mStateOperands) {
+        auto assign = std::make_shared<ngraph::opset3::Assign>(
+            mNgraphNodes->getOperationOutput(outIndex), "nnapi_state_" + std::to_string(inIndex));
+        mNgraphNodes->addSinkNode(assign);
+    }
+}
+
 bool NgraphNetworkCreator::createInputParams() {
     for (auto i : mModelInfo->getModelInputIndexes()) {
         std::shared_ptr<ngraph::opset3::Parameter> inputParam;
+        if (isStateInput(i)) {
+            if (!createStateNode(i)) return false;
+            continue;
+        }
         auto& nnapiOperand = mModelInfo->getOperand(i);
         auto& dims = nnapiOperand.dimensions;
         ALOGV("createInputParams operand %d dims.size(%zu)", i, dims.size());
@@ -113,17 +189,6 @@ bool NgraphNetworkCreator::createInputParams() {
     return true;
 }
 
-void NgraphNetworkCreator::getSupportedOperations(std::vector<bool>& supportedOperations) {
-    for (size_t i = 0; i < mModelInfo->getOperationsSize(); i++) {
-        if (!mOperationNodes[i] || !mOperationNodes[i]->validateForPlugin())
-            supportedOperations[i] = false;
-        else
-            supportedOperations[i] = true;
-        ALOGD("%s index %zu type %d, supported : %d", __func__, i, mModelInfo->getOperationType(i),
-              static_cast<int>(supportedOperations[i]));
-    }
-}
-
 bool NgraphNetworkCreator::validateOperations() {
     for (size_t i = 0; i < mModelInfo->getOperationsSize(); i++) {
         if (!mOperationNodes[i] || !mOperationNodes[i]->validateForPlugin()) {
@@ -135,9 +200,7 @@ bool NgraphNetworkCreator::validateOperations() {
     return true;
 }
 
-bool NgraphNetworkCreator::initializeModel() {
-    ALOGV("%s Called", __func__);
-    if (!createInputParams()) return false;
+bool NgraphNetworkCreator::connectOperations() {
     for (size_t i = 0; i < mModelInfo->getOperationsSize(); i++) {
         if (mOperationNodes[i] == nullptr) {
             ALOGE("initializeModel Failure at type %d", mModelInfo->getOperationType(i));
@@ -149,11 +212,84 @@ bool NgraphNetworkCreator::initializeModel() {
             ALOGE("%s Exception !!! %s", __func__, ex.what());
             return false;
         }
+        mapOperationNodes(i);
+    }
+    return true;
+}
+
+void NgraphNetworkCreator::mapOperationNodes(uint32_t operationIndex) {
+    // Nodes reachable from the outputs of an operation which no earlier operation claimed were
+    // created by it
+    std::vector<std::shared_ptr<ngraph::Node>> pending;
+    for (size_t i = 0; i < mModelInfo->getOperationOutputsSize(operationIndex); i++) {
+        auto output =
+            mNgraphNodes->getOperationOutput(mModelInfo->getOperationOutput(operationIndex, i));
+        if (output.get_node()) pending.push_back(output.get_node_shared_ptr());
+    }
+    while (!pending.empty()) {
+        auto node = pending.back();
+        pending.pop_back();
+        if (ngraph::op::is_parameter(node)) continue;
+        if (!mNodeOperations.emplace(node->get_friendly_name(), operationIndex).second) continue;
+        for (const auto& input : node->input_values())
+            pending.push_back(input.get_node_shared_ptr());
     }
+}
+
+bool NgraphNetworkCreator::initializeModel() {
+    ALOGV("%s Called", __func__);
+    if (!createInputParams() || !connectOperations()) return false;
+    connectStateNodes();
     ALOGD("initializeModel Success");
     return true;
 }
 
+bool NgraphNetworkCreator::createSubgraph(const std::vector<ngraph::Output<ngraph::Node>>& inputs,
+                                          std::vector<ngraph::Output<ngraph::Node>>& outputs) {
+    const auto& inputIndexes = mModelInfo->getModelInputIndexes();
+    if (inputs.size() != inputIndexes.size()) {
+        ALOGE("%s Expected %zu inputs, got %zu", __func__, inputIndexes.size(), inputs.size());
+        return false;
+    }
+    for (size_t i = 0; i < inputs.size(); i++)
+        mNgraphNodes->setOutputAtOperandIndex(inputIndexes[i], inputs[i]);
+    if (!connectOperations()) return false;
+
+    outputs.clear();
+    for (size_t i = 0; i < mModelInfo->getModelOutputsSize(); i++)
+        outputs.push_back(mNgraphNodes->getOperationOutput(mModelInfo->getModelOutputIndex(i)));
+    return true;
+}
+
+bool NgraphNetworkCreator::translateSubgraph(
+    uint32_t operandIndex, const std::vector<ngraph::Output<ngraph::Node>>& inputs,
+    std::vector<ngraph::Output<ngraph::Node>>& outputs) {
+    auto outerModelInfo = OperationsBase::sModelInfo;
+    auto subgraphInfo = outerModelInfo->createSubgraphInfo(operandIndex);
+    bool success = false;
+    if (subgraphInfo) {
+        // Constructing the creator points the operations at the subgraph
+        NgraphNetworkCreator subgraphCreator(subgraphInfo, OperationsBase::sPluginType);
+        success = subgraphCreator.validateOperations() &&
+                  subgraphCreator.createSubgraph(inputs, outputs);
+    }
+    // Operations of the enclosing model resolve their operands through the static model info
+    OperationsBase::sModelInfo = outerModelInfo;
+    return success;
+}
+
+bool NgraphNetworkCreator::validateSubgraph(uint32_t operandIndex) {
+    auto outerModelInfo = OperationsBase::sModelInfo;
+    auto subgraphInfo = outerModelInfo->createSubgraphInfo(operandIndex);
+    bool success = false;
+    if (subgraphInfo) {
+        NgraphNetworkCreator subgraphCreator(subgraphInfo, OperationsBase::sPluginType);
+        success = subgraphCreator.validateOperations();
+    }
+    OperationsBase::sModelInfo = outerModelInfo;
+    return success;
+}
+
 const std::string& NgraphNetworkCreator::getNodeName(uint32_t index) {
     ALOGV("getNodeName %d", index);
     return mNgraphNodes->getNodeName(index);
@@ -31,6 +31,11 @@ void NgraphNodes::setResultNode(size_t outputIndex, std::shared_ptr<ngraph::Node
     mResultNodes.push_back(resultNode);
 }
 
+void NgraphNodes::addSinkNode(std::shared_ptr<ngraph::op::Sink> sinkNode) {
+    ALOGD("addSinkNode %s", sinkNode->get_name().c_str());
+    mSinkNodes.push_back(sinkNode);
+}
+
 const std::string& NgraphNodes::getNodeName(size_t index) {
     if (mNodeNames.find(index) == mNodeNames.end()) {
         mNodeNames[index] = mOutputAtOperandIndex[index].get_node_shared_ptr()->get_name();
@@ -50,7 +55,10 @@ void NgraphNodes::removeInputParameter(std::string name, size_t index) {
 }
 
 std::shared_ptr<ngraph::Function> NgraphNodes::generateGraph() {
-    return std::make_shared<ngraph::Function>(mResultNodes, mInputParams);
+    if (mSinkNodes.empty()) return std::make_shared<ngraph::Function>(mResultNodes, mInputParams);
+
+    ngraph::OutputVector results(mResultNodes.begin(), mResultNodes.end());
+    return std::make_shared<ngraph::Function>(results, mSinkNodes, mInputParams);
 }
 
 void NgraphNodes::setInvalidNode(size_t index) { mNodeNames[index] = ""; }
@@ -9,7 +9,8 @@ namespace nnhal {
 
 OperationsFactory::OperationsFactory(IntelDeviceType deviceType,
                                      std::shared_ptr<NnapiModelInfo> modelInfo,
-                                     std::shared_ptr<NgraphNodes> nodes) {
+                                     std::shared_ptr<NgraphNodes> nodes)
+    : mTranslationLock(OperationsBase::sTranslationMutex) {
     OperationsBase::sPluginType = deviceType;
     OperationsBase::sModelInfo = modelInfo;
     ALOGV("%s Constructed", __func__);
@@ -28,10 +29,16 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<Argmin>(operationIndex);
         case OperationType::AVERAGE_POOL_2D:
             return std::make_shared<AveragePool2D>(operationIndex);
+        case OperationType::AXIS_ALIGNED_BBOX_TRANSFORM:
+            return std::make_shared<AxisAlignedBboxTransform>(operationIndex);
         case OperationType::BATCH_TO_SPACE_ND:
             return std::make_shared<BatchToSpace>(operationIndex);
+        case OperationType::BIDIRECTIONAL_SEQUENCE_LSTM:
+            return std::make_shared<BidirectionalSequenceLSTM>(operationIndex);
         case OperationType::BIDIRECTIONAL_SEQUENCE_RNN:
             return std::make_shared<BidirectionalSequenceRNN>(operationIndex);
+        case OperationType::BOX_WITH_NMS_LIMIT:
+            return std::make_shared<BoxWithNmsLimit>(operationIndex);
         case OperationType::CAST:
             return std::make_shared<Cast>(operationIndex);
         case OperationType::CHANNEL_SHUFFLE:
@@ -46,8 +53,12 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<DepthwiseConv2d>(operationIndex);
         case OperationType::DEQUANTIZE:
             return std::make_shared<Dequantize>(operationIndex);
+        case OperationType::DETECTION_POSTPROCESSING:
+            return std::make_shared<DetectionPostprocessing>(operationIndex);
         case OperationType::DIV:
             return std::make_shared<Div>(operationIndex);
+        case OperationType::ELU:
+            return std::make_shared<Elu>(operationIndex);
         case OperationType::EMBEDDING_LOOKUP:
             return std::make_shared<EmbeddingLookup>(operationIndex);
         case OperationType::EQUAL:
@@ -56,12 +67,16 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<Exp>(operationIndex);
         case OperationType::EXPAND_DIMS:
             return std::make_shared<ExpandDims>(operationIndex);
+        case OperationType::FILL:
+            return std::make_shared<Fill>(operationIndex);
         case OperationType::FULLY_CONNECTED:
             return std::make_shared<FullyConnected>(operationIndex);
         case OperationType::FLOOR:
             return std::make_shared<Floor>(operationIndex);
         case OperationType::GATHER:
             return std::make_shared<Gather>(operationIndex);
+        case OperationType::GENERATE_PROPOSALS:
+            return std::make_shared<GenerateProposals>(operationIndex);
         case OperationType::GREATER:
             return std::make_shared<Greater>(operationIndex);
         case OperationType::GREATER_EQUAL:
@@ -70,6 +85,12 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<GroupedConv2d>(operationIndex);
         case OperationType::HARD_SWISH:
             return std::make_shared<HardSwish>(operationIndex);
+        case OperationType::HASHTABLE_LOOKUP:
+            return std::make_shared<HashtableLookup>(operationIndex);
+        case OperationType::HEATMAP_MAX_KEYPOINT:
+            return std::make_shared<HeatmapMaxKeypoint>(operationIndex);
+        case OperationType::IF:
+            return std::make_shared<If>(operationIndex);
         case OperationType::INSTANCE_NORMALIZATION:
             return std::make_shared<InstanceNormalization>(operationIndex);
         case OperationType::L2_POOL_2D:
@@ -82,6 +103,8 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<Less>(operationIndex);
         case OperationType::LESS_EQUAL:
             return std::make_shared<LessEqual>(operationIndex);
+        case OperationType::LOCAL_RESPONSE_NORMALIZATION:
+            return std::make_shared<LocalResponseNormalization>(operationIndex);
         case OperationType::LOG_SOFTMAX:
             return std::make_shared<LogSoftmax>(operationIndex);
         case OperationType::LOG:
@@ -118,6 +141,10 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<PRelu>(operationIndex);
         case OperationType::QUANTIZE:
             return std::make_shared<Quantize>(operationIndex);
+        case OperationType::QUANTIZED_16BIT_LSTM:
+            return std::make_shared<Quantized16BitLSTM>(operationIndex);
+        case OperationType::QUANTIZED_LSTM:
+            return std::make_shared<QuantizedLSTM>(operationIndex);
         case OperationType::REDUCE_ALL:
             return std::make_shared<ReduceAll>(operationIndex);
         case OperationType::REDUCE_ANY:
@@ -146,6 +173,8 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<ROIPooling>(operationIndex);
         case OperationType::RSQRT:
             return std::make_shared<RSQRT>(operationIndex);
+        case OperationType::RANK:
+            return std::make_shared<Rank>(operationIndex);
         case OperationType::RESIZE_BILINEAR:
             return std::make_shared<ResizeBilinear>(operationIndex);
         case OperationType::RESIZE_NEAREST_NEIGHBOR:
@@ -160,8 +189,12 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<SpaceToDepth>(operationIndex);
         case OperationType::SQRT:
             return std::make_shared<SQRT>(operationIndex);
+        case OperationType::SVDF:
+            return std::make_shared<SVDF>(operationIndex);
         case OperationType::SIN:
             return std::make_shared<Sin>(operationIndex);
+        case OperationType::SLICE:
+            return std::make_shared<Slice>(operationIndex);
         case OperationType::SPLIT:
             return std::make_shared<Split>(operationIndex);
         case OperationType::STRIDED_SLICE:
@@ -172,14 +205,20 @@ std::shared_ptr<OperationsBase> OperationsFactory::getOperation(
             return std::make_shared<Sub>(operationIndex);
         case OperationType::TANH:
             return std::make_shared<Tanh>(operationIndex);
+        case OperationType::TILE:
+            return std::make_shared<Tile>(operationIndex);
         case OperationType::TOPK_V2:
             return std::make_shared<TopkV2>(operationIndex);
         case OperationType::TRANSPOSE_CONV_2D:
             return std::make_shared<TransposeConv2D>(operationIndex);
         case OperationType::TRANSPOSE:
             return std::make_shared<Transpose>(operationIndex);
+        case OperationType::UNIDIRECTIONAL_SEQUENCE_LSTM:
+            return std::make_shared<UnidirectionalSequenceLSTM>(operationIndex);
         case OperationType::UNIDIRECTIONAL_SEQUENCE_RNN:
             return std::make_shared<UnidirectionalSequenceRNN>(operationIndex);
+        case OperationType::WHILE:
+            return std::make_shared<While>(operationIndex);
         default:
             ALOGE("%s Cannot identify OperationType %d", __func__, operationType);
             break;
@@ -0,0 +1,91 @@
+#include <SupportChecker.hpp>
+
+#include <OperationsFactory.hpp>
+#include <android/log.h>
+#include <cutils/properties.h>
+#include <log/log.h>
+#include <algorithm>
+#include <sstream>
+
+#include "ContentHash.h"
+
+#undef LOG_TAG
+#define LOG_TAG "SupportChecker"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Number of models whose support is remembered
+static const char* kSupportCacheSizeProperty = "vendor.nn.hal.support_cache_size";
+static const int32_t kDefaultSupportCacheSize = 64;
+
+SupportChecker& SupportChecker::get() {
+    static SupportChecker sChecker;
+    return sChecker;
+}
+
+SupportChecker::SupportChecker()
+    : mCache(std::max(property_get_int32(kSupportCacheSizeProperty, kDefaultSupportCacheSize),
+                      1)) {}
+
+std::vector<bool> SupportChecker::getSupportedOperations(const Model& model,
+                                                         IntelDeviceType deviceType) {
+    // Operations are validated against their operand metadata and inline constants, the
+    // contents of the memory pools are never read
+    ContentHash hash;
+    hashModel(hash, model);
+    hash.update<uint64_t>(model.pools.size());
+    for (const auto& pool : model.pools) hash.update<uint64_t>(pool.size());
+    Key key;
+    hash.finish(key.hashLow, key.hashHigh);
+    key.deviceType = deviceType;
+
+    std::vector<bool> supported;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mCache.get(key, supported)) {
+            mHits++;
+            return supported;
+        }
+        mMisses++;
+    }
+
+    supported = checkOperations(model, deviceType);
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCache.put(key, supported);
+    return supported;
+}
+
+std::vector<bool> SupportChecker::checkOperations(const Model& model, IntelDeviceType deviceType) {
+    auto modelInfo = std::make_shared<NnapiModelInfo>(model);
+    // Operations only resolve their operands through the model info, no graph nodes are needed
+    OperationsFactory factory(deviceType, modelInfo, nullptr);
+    std::vector<bool> supported(modelInfo->getOperationsSize(), false);
+    for (size_t i = 0; i < supported.size(); i++) {
+        auto operation = factory.getOperation(i, modelInfo->getOperationType(i));
+        supported[i] = operation != nullptr && operation->validateForPlugin();
+        ALOGD("%s index %zu type %d, supported : %d", __func__, i, modelInfo->getOperationType(i),
+              static_cast<int>(supported[i]));
+    }
+    return supported;
+}
+
+std::string SupportChecker::dump(bool json) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::ostringstream out;
+    if (json) {
+        out << "{\"hits\": " << mHits << ", \"misses\": " << mMisses
+            << ", \"entries\": " << mCache.size() << "}";
+    } else {
+        out << "support cache hits " << mHits << " misses " << mMisses << " entries "
+            << mCache.size() << "\n";
+    }
+    return out.str();
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,124 @@
+#include <WeightStore.hpp>
+
+#include <android/log.h>
+#include <log/log.h>
+#include <cstring>
+#include <ngraph/runtime/shared_buffer.hpp>
+#include <sstream>
+
+#include "ContentHash.h"
+
+#undef LOG_TAG
+#define LOG_TAG "WeightStore"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Smaller constants, mostly scalars and shapes, cost less to copy than a store entry
+static const size_t kMinSharedBytes = 256;
+static const size_t kAlignment = 64;
+
+WeightStore& WeightStore::get() {
+    // Never destroyed, so that constants outliving static destruction still release into it
+    static WeightStore* sStore = new WeightStore();
+    return *sStore;
+}
+
+std::shared_ptr<ngraph::Node> WeightStore::createConstant(const ngraph::element::Type& elementType,
+                                                          const ngraph::Shape& shape,
+                                                          const uint8_t* data, size_t length) {
+    if (length < kMinSharedBytes) {
+        return std::make_shared<ngraph::op::Constant>(elementType, shape, data);
+    }
+
+    ContentHash hash;
+    hash.update(data, length);
+    Key key;
+    hash.finish(key.hashLow, key.hashHigh);
+    key.elementType = elementType;
+    key.shape = shape;
+
+    typedef std::shared_ptr<ngraph::runtime::AlignedBuffer> BufferPtr;
+    BufferPtr buffer = acquire(key, data, length);
+    auto sharedBuffer = std::make_shared<ngraph::runtime::SharedBuffer<BufferPtr>>(
+        buffer->get_ptr<char>(), buffer->size(), buffer);
+    return std::make_shared<ngraph::op::Constant>(elementType, shape, sharedBuffer);
+}
+
+std::shared_ptr<ngraph::runtime::AlignedBuffer> WeightStore::acquire(const Key& key,
+                                                                     const uint8_t* data,
+                                                                     size_t length) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mBuffers.find(key);
+    if (it != mBuffers.end()) {
+        auto buffer = it->second.lock();
+        if (buffer && buffer->size() == length &&
+            std::memcmp(buffer->get_ptr(), data, length) == 0) {
+            mHits++;
+            mBytesShared += length;
+            return buffer;
+        }
+        mMisses++;
+        // Different content with the same hash is not shared
+        if (buffer) {
+            ALOGD("%s Hash collision, %zu bytes not shared", __func__, length);
+            auto copy = std::make_shared<ngraph::runtime::AlignedBuffer>(length, kAlignment);
+            std::memcpy(copy->get_ptr(), data, length);
+            return copy;
+        }
+    } else {
+        mMisses++;
+    }
+
+    auto* buffer = new ngraph::runtime::AlignedBuffer(length, kAlignment);
+    std::memcpy(buffer->get_ptr(), data, length);
+    std::shared_ptr<ngraph::runtime::AlignedBuffer> shared(
+        buffer, [this, key](ngraph::runtime::AlignedBuffer* released) { release(key, released); });
+    mBuffers[key] = shared;
+    mBytes += length;
+    return shared;
+}
+
+void WeightStore::release(const Key& key, ngraph::runtime::AlignedBuffer* buffer) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBytes -= buffer->size();
+        // A new buffer of the same content may have replaced the entry before the lock was taken
+        auto it = mBuffers.find(key);
+        if (it != mBuffers.end() && it->second.expired()) mBuffers.erase(it);
+    }
+    delete buffer;
+}
+
+WeightStore::Stats WeightStore::getStats() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Stats stats;
+    stats.tensors = mBuffers.size();
+    stats.bytes = mBytes;
+    stats.hits = mHits;
+    stats.misses = mMisses;
+    stats.bytesShared = mBytesShared;
+    return stats;
+}
+
+std::string WeightStore::dump(bool json) {
+    const auto stats = getStats();
+    std::ostringstream out;
+    if (json) {
+        out << "{\"tensors\": " << stats.tensors << ", \"bytes\": " << stats.bytes
+            << ", \"hits\": " << stats.hits << ", \"misses\": " << stats.misses
+            << ", \"bytesShared\": " << stats.bytesShared << "}";
+    } else {
+        out << "weight store tensors " << stats.tensors << " bytes " << stats.bytes << " hits "
+            << stats.hits << " misses " << stats.misses << " bytes shared "
+            << stats.bytesShared << "\n";
+    }
+    return out.str();
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
@@ -15,6 +15,8 @@
  */
 
 #include <log/log.h>
+#include <cstdlib>
+#include "CpuTopology.h"
 #include "Driver.h"
 #define MAX_LENGTH (255)
 
@@ -27,12 +29,36 @@
 
 using android::hardware::configureRpcThreadpool;
 using android::hardware::joinRpcThreadpool;
+using android::hardware::neuralnetworks::nnhal::CpuTopology;
 using android::hardware::neuralnetworks::nnhal::Driver;
 
+// -D <device> [--cpu-threads N] [--cpu-streams N] [--cpu-bind YES|NUMA|NO], the CPU options
+// replace what the service of this device derives from the CPU topology
+static void setCpuOverrides(int argc, char* argv[]) {
+    int32_t threads = 0, streams = 0;
+    std::string bind;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--cpu-threads") == 0) {
+            threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--cpu-streams") == 0) {
+            streams = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--cpu-bind") == 0) {
+            bind = argv[i + 1];
+        } else {
+            ALOGE("Ignoring unknown option %s", argv[i]);
+        }
+    }
+    if (threads > 0 || streams > 0 || !bind.empty()) {
+        ALOGD("CPU overrides threads %d streams %d bind %s", threads, streams, bind.c_str());
+        CpuTopology::get().setOverrides(threads, streams, bind);
+    }
+}
+
 int main(int argc, char* argv[]) {
     if (argc > 2 && argv[2] != NULL && strnlen(argv[2], MAX_LENGTH) > 0) {
         if (strcmp(argv[1], "-D") != 0) return 0;
         const char* deviceType = argv[2];
+        setCpuOverrides(argc, argv);
         android::sp<Driver> device;
 
         if (strncmp(deviceType, "GNA", 3) == 0)
@@ -44,6 +70,8 @@ int main(int argc, char* argv[]) {
         else
             device = new Driver(android::hardware::neuralnetworks::nnhal::IntelDeviceType::CPU);
 
+        // Clients querying the capabilities before the calibration completes get the defaults
+        device->startCalibration();
         ALOGD("NN-HAL-1.3(%s) is ready.", deviceType);
         configureRpcThreadpool(4, true);
         android::status_t status = device->registerAsService(deviceType);
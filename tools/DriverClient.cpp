@@ -0,0 +1,230 @@
+#include "DriverClient.h"
+
+#include <ExecutionBurstController.h>
+#include <NeuralNetworks.h>
+#include <Utils.h>
+#include <log/log.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "SyntheticModels.h"
+
+#undef LOG_TAG
+#define LOG_TAG "DriverClient"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+SharedMemory::~SharedMemory() {
+    if (mData != nullptr) munmap(mData, mSize);
+    if (mHandle != nullptr) native_handle_delete(mHandle);
+    if (mFd >= 0) close(mFd);
+}
+
+bool SharedMemory::create(size_t size) {
+    mFd = memfd_create("nnhal-request-pool", MFD_CLOEXEC);
+    if (mFd < 0 || ftruncate(mFd, size) != 0) {
+        ALOGE("%s Failed to create a memfd of %zu bytes", __func__, size);
+        return false;
+    }
+    mData = static_cast<uint8_t*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0));
+    if (mData == MAP_FAILED) {
+        mData = nullptr;
+        ALOGE("%s Failed to map the memfd", __func__);
+        return false;
+    }
+    mSize = size;
+    // data[1] holds the protection, data[2] and data[3] the 64 bit offset
+    mHandle = native_handle_create(1, 3);
+    mHandle->data[0] = mFd;
+    mHandle->data[1] = PROT_READ | PROT_WRITE;
+    mHandle->data[2] = 0;
+    mHandle->data[3] = 0;
+    mMemory = hidl_memory("mmap_fd", mHandle, size);
+    return true;
+}
+
+Return<void> PreparedModelCallback::notify(V1_0::ErrorStatus status,
+                                           const sp<V1_0::IPreparedModel>& preparedModel) {
+    return notify_1_3(convertToV1_3(status), V1_3::IPreparedModel::castFrom(preparedModel));
+}
+
+Return<void> PreparedModelCallback::notify_1_2(V1_0::ErrorStatus status,
+                                               const sp<V1_2::IPreparedModel>& preparedModel) {
+    return notify_1_3(convertToV1_3(status), V1_3::IPreparedModel::castFrom(preparedModel));
+}
+
+Return<void> PreparedModelCallback::notify_1_3(V1_3::ErrorStatus status,
+                                               const sp<V1_3::IPreparedModel>& preparedModel) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mNotified = true;
+    if (status == V1_3::ErrorStatus::NONE) mPreparedModel = preparedModel;
+    mCondition.notify_all();
+    return Void();
+}
+
+sp<V1_3::IPreparedModel> PreparedModelCallback::wait() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this] { return mNotified; });
+    return mPreparedModel;
+}
+
+Return<void> ExecutionCallback::notify(V1_0::ErrorStatus status) {
+    return notify_1_3(convertToV1_3(status), {}, {});
+}
+
+Return<void> ExecutionCallback::notify_1_2(V1_0::ErrorStatus status,
+                                           const hidl_vec<V1_2::OutputShape>& shapes,
+                                           const V1_2::Timing& timing) {
+    return notify_1_3(convertToV1_3(status), shapes, timing);
+}
+
+Return<void> ExecutionCallback::notify_1_3(V1_3::ErrorStatus status,
+                                           const hidl_vec<V1_2::OutputShape>&,
+                                           const V1_2::Timing&) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mNotified = true;
+    mStatus = status;
+    mCondition.notify_all();
+    return Void();
+}
+
+V1_3::ErrorStatus ExecutionCallback::wait() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this] { return mNotified; });
+    return mStatus;
+}
+
+static const std::pair<ExecutionMode, const char*> kExecutionModes[] = {
+    {ExecutionMode::SYNC, "sync"},
+    {ExecutionMode::ASYNC, "async"},
+    {ExecutionMode::FENCED, "fenced"},
+    {ExecutionMode::BURST, "burst"},
+};
+
+bool parseExecutionMode(const std::string& name, ExecutionMode& mode) {
+    for (const auto& [value, modeName] : kExecutionModes) {
+        if (name == modeName) {
+            mode = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* executionModeName(ExecutionMode mode) {
+    for (const auto& [value, modeName] : kExecutionModes) {
+        if (mode == value) return modeName;
+    }
+    return "unknown";
+}
+
+sp<V1_3::IPreparedModel> prepareModel(const sp<Driver>& driver, const Model& model,
+                                      V1_1::ExecutionPreference preference) {
+    sp<PreparedModelCallback> callback = new PreparedModelCallback();
+    auto status = driver->prepareModel_1_3(model, preference, V1_3::Priority::MEDIUM, {}, {}, {},
+                                           {}, callback);
+    if (!status.isOk() || status != V1_3::ErrorStatus::NONE) {
+        ALOGE("%s prepareModel_1_3 failed", __func__);
+        return nullptr;
+    }
+    return callback->wait();
+}
+
+bool PooledRequest::create(const Model& model) {
+    const auto& operands = model.main.operands;
+    std::vector<size_t> inputLengths, outputLengths;
+    for (auto index : model.main.inputIndexes) {
+        inputLengths.push_back(operandByteSize(operands[index]));
+    }
+    for (auto index : model.main.outputIndexes) {
+        outputLengths.push_back(operandByteSize(operands[index]));
+    }
+    return create(inputLengths, outputLengths);
+}
+
+bool PooledRequest::create(const std::vector<size_t>& inputLengths,
+                           const std::vector<size_t>& outputLengths) {
+    size_t size = 0;
+    auto place = [&size](const std::vector<size_t>& lengths, std::vector<size_t>& offsets,
+                         hidl_vec<V1_0::RequestArgument>& arguments) {
+        arguments.resize(lengths.size());
+        for (size_t i = 0; i < lengths.size(); i++) {
+            offsets.push_back(size);
+            arguments[i] = {.hasNoValue = false,
+                            .location = {.poolIndex = 0,
+                                         .offset = static_cast<uint32_t>(size),
+                                         .length = static_cast<uint32_t>(lengths[i])}};
+            // Keep every argument aligned for the widest element type
+            size = (size + lengths[i] + 63) & ~size_t(63);
+        }
+    };
+    place(inputLengths, inputOffsets, request.inputs);
+    place(outputLengths, outputOffsets, request.outputs);
+
+    pool = std::make_unique<SharedMemory>();
+    if (!pool->create(std::max<size_t>(size, 1))) return false;
+    request.pools = {pool->memory()};
+    return true;
+}
+
+Executor::Executor(sp<V1_3::IPreparedModel> preparedModel, ExecutionMode mode)
+    : mPreparedModel(std::move(preparedModel)), mMode(mode) {
+    if (mMode == ExecutionMode::BURST) {
+        mBurst = nn::ExecutionBurstController::create(mPreparedModel,
+                                                      std::chrono::microseconds(0));
+    }
+}
+
+Executor::~Executor() = default;
+
+bool Executor::execute(const V1_0::Request& request) {
+    switch (mMode) {
+        case ExecutionMode::SYNC: {
+            bool succeeded = false;
+            auto returned = mPreparedModel->executeSynchronously_1_3(
+                convertToV1_3(request), V1_2::MeasureTiming::NO, {}, {},
+                [&succeeded](V1_3::ErrorStatus status, const hidl_vec<V1_2::OutputShape>&,
+                             const V1_2::Timing&) {
+                    succeeded = status == V1_3::ErrorStatus::NONE;
+                });
+            return returned.isOk() && succeeded;
+        }
+        case ExecutionMode::ASYNC: {
+            sp<ExecutionCallback> callback = new ExecutionCallback();
+            auto status = mPreparedModel->execute_1_3(convertToV1_3(request),
+                                                      V1_2::MeasureTiming::NO, {}, {}, callback);
+            if (!status.isOk() || status != V1_3::ErrorStatus::NONE) return false;
+            return callback->wait() == V1_3::ErrorStatus::NONE;
+        }
+        case ExecutionMode::FENCED: {
+            bool succeeded = false;
+            auto returned = mPreparedModel->executeFenced(
+                convertToV1_3(request), {}, V1_2::MeasureTiming::NO, {}, {}, {},
+                [&succeeded](V1_3::ErrorStatus status, const hidl_handle&,
+                             const sp<V1_3::IFencedExecutionCallback>&) {
+                    succeeded = status == V1_3::ErrorStatus::NONE;
+                });
+            return returned.isOk() && succeeded;
+        }
+        case ExecutionMode::BURST: {
+            if (mBurst == nullptr) return false;
+            // The burst caches pools by identifier, the native handle is unique per pool
+            std::vector<intptr_t> memoryIds;
+            for (const auto& pool : request.pools) {
+                memoryIds.push_back(reinterpret_cast<intptr_t>(pool.handle()));
+            }
+            auto result = mBurst->compute(request, V1_2::MeasureTiming::NO, memoryIds);
+            return std::get<0>(result) == ANEURALNETWORKS_NO_ERROR;
+        }
+    }
+    return false;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
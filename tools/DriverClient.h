@@ -0,0 +1,127 @@
+#ifndef ANDROID_ML_NN_TOOLS_DRIVER_CLIENT_H
+#define ANDROID_ML_NN_TOOLS_DRIVER_CLIENT_H
+
+#include <cutils/native_handle.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Driver.h"
+
+namespace android {
+namespace nn {
+class ExecutionBurstController;
+}  // namespace nn
+
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Talks to a Driver in process the way the NNAPI runtime does over HIDL, for tools driving the
+// driver without the runtime.
+
+// Request pool backed by an mmap_fd hidl_memory over a memfd, which hosts without ashmem can map
+class SharedMemory {
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    bool create(size_t size);
+    uint8_t* data() { return mData; }
+    size_t size() const { return mSize; }
+    const hidl_memory& memory() const { return mMemory; }
+
+private:
+    int mFd = -1;
+    native_handle_t* mHandle = nullptr;
+    uint8_t* mData = nullptr;
+    size_t mSize = 0;
+    hidl_memory mMemory;
+};
+
+class PreparedModelCallback : public V1_3::IPreparedModelCallback {
+public:
+    Return<void> notify(V1_0::ErrorStatus status,
+                        const sp<V1_0::IPreparedModel>& preparedModel) override;
+    Return<void> notify_1_2(V1_0::ErrorStatus status,
+                            const sp<V1_2::IPreparedModel>& preparedModel) override;
+    Return<void> notify_1_3(V1_3::ErrorStatus status,
+                            const sp<V1_3::IPreparedModel>& preparedModel) override;
+
+    sp<V1_3::IPreparedModel> wait();
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mNotified = false;
+    sp<V1_3::IPreparedModel> mPreparedModel;
+};
+
+class ExecutionCallback : public V1_3::IExecutionCallback {
+public:
+    Return<void> notify(V1_0::ErrorStatus status) override;
+    Return<void> notify_1_2(V1_0::ErrorStatus status, const hidl_vec<V1_2::OutputShape>& shapes,
+                            const V1_2::Timing& timing) override;
+    Return<void> notify_1_3(V1_3::ErrorStatus status, const hidl_vec<V1_2::OutputShape>& shapes,
+                            const V1_2::Timing& timing) override;
+
+    V1_3::ErrorStatus wait();
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mNotified = false;
+    V1_3::ErrorStatus mStatus = V1_3::ErrorStatus::GENERAL_FAILURE;
+};
+
+enum class ExecutionMode { SYNC, ASYNC, FENCED, BURST };
+
+bool parseExecutionMode(const std::string& name, ExecutionMode& mode);
+const char* executionModeName(ExecutionMode mode);
+
+// Prepares a model, returning null on failure
+sp<V1_3::IPreparedModel> prepareModel(const sp<Driver>& driver, const Model& model,
+                                      V1_1::ExecutionPreference preference =
+                                          V1_1::ExecutionPreference::FAST_SINGLE_ANSWER);
+
+// Request with every model input followed by every model output laid out in one pool
+struct PooledRequest {
+    std::unique_ptr<SharedMemory> pool;
+    V1_0::Request request;
+    std::vector<size_t> inputOffsets;
+    std::vector<size_t> outputOffsets;
+
+    // Sized for the operands of the model, which need to have all dimensions specified
+    bool create(const Model& model);
+    bool create(const std::vector<size_t>& inputLengths, const std::vector<size_t>& outputLengths);
+    uint8_t* input(size_t i) { return pool->data() + inputOffsets[i]; }
+    uint8_t* output(size_t i) { return pool->data() + outputOffsets[i]; }
+    size_t inputLength(size_t i) const { return request.inputs[i].location.length; }
+    size_t outputLength(size_t i) const { return request.outputs[i].location.length; }
+};
+
+// Runs executions of one prepared model in one of the execution modes
+class Executor {
+public:
+    Executor(sp<V1_3::IPreparedModel> preparedModel, ExecutionMode mode);
+    ~Executor();
+
+    bool execute(const V1_0::Request& request);
+
+private:
+    sp<V1_3::IPreparedModel> mPreparedModel;
+    ExecutionMode mMode;
+    std::unique_ptr<nn::ExecutionBurstController> mBurst;
+};
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_TOOLS_DRIVER_CLIENT_H
@@ -0,0 +1,361 @@
+#include "SyntheticModels.h"
+
+#include <cstring>
+#include <functional>
+#include <map>
+#include <numeric>
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+namespace {
+
+constexpr int32_t kPaddingSame = 1;
+constexpr int32_t kPaddingValid = 2;
+constexpr int32_t kActivationNone = 0;
+constexpr int32_t kActivationRelu = 1;
+constexpr int32_t kActivationRelu6 = 3;
+constexpr int32_t kActivationTanh = 4;
+
+// Quantization of the weights and outputs of quantized layers
+constexpr float kWeightScale = 0.01f;
+constexpr int32_t kWeightZeroPoint = 128;
+constexpr float kActivationScale = 0.05f;
+
+bool isQuantized(OperandType type) { return type == OperandType::TENSOR_QUANT8_ASYMM; }
+
+uint32_t elementSize(OperandType type) {
+    switch (type) {
+        case OperandType::TENSOR_QUANT8_ASYMM:
+        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
+        case OperandType::TENSOR_QUANT8_SYMM:
+        case OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL:
+        case OperandType::TENSOR_BOOL8:
+        case OperandType::BOOL:
+            return 1;
+        case OperandType::TENSOR_FLOAT16:
+        case OperandType::TENSOR_QUANT16_ASYMM:
+        case OperandType::TENSOR_QUANT16_SYMM:
+        case OperandType::FLOAT16:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+}  // namespace
+
+size_t operandByteSize(const Operand& operand) {
+    return std::accumulate(operand.dimensions.begin(), operand.dimensions.end(),
+                           size_t(elementSize(operand.type)), std::multiplies<size_t>());
+}
+
+uint32_t ModelBuilder::addOperand(Operand operand) {
+    mOperands.push_back(std::move(operand));
+    return mOperands.size() - 1;
+}
+
+Tensor ModelBuilder::addInput(OperandType type, std::vector<uint32_t> dims, float scale,
+                              int32_t zeroPoint) {
+    auto tensor = addTemporary(type, dims, scale, zeroPoint);
+    mOperands[tensor.index].lifetime = OperandLifeTime::SUBGRAPH_INPUT;
+    mInputs.push_back(tensor.index);
+    return tensor;
+}
+
+Tensor ModelBuilder::addTemporary(OperandType type, std::vector<uint32_t> dims, float scale,
+                                  int32_t zeroPoint) {
+    Operand operand = {.type = type,
+                       .dimensions = dims,
+                       .scale = scale,
+                       .zeroPoint = zeroPoint,
+                       .lifetime = OperandLifeTime::TEMPORARY_VARIABLE};
+    return {addOperand(std::move(operand)), type, dims, scale, zeroPoint};
+}
+
+uint32_t ModelBuilder::addConstant(OperandType type, std::vector<uint32_t> dims, const void* data,
+                                   size_t length, float scale, int32_t zeroPoint) {
+    // Keep every value aligned for the widest element type
+    mOperandValues.resize((mOperandValues.size() + 7) & ~size_t(7));
+    const uint32_t offset = mOperandValues.size();
+    mOperandValues.resize(offset + length);
+    std::memcpy(mOperandValues.data() + offset, data, length);
+
+    Operand operand = {.type = type,
+                       .dimensions = std::move(dims),
+                       .scale = scale,
+                       .zeroPoint = zeroPoint,
+                       .lifetime = OperandLifeTime::CONSTANT_COPY,
+                       .location = {.poolIndex = 0,
+                                    .offset = offset,
+                                    .length = static_cast<uint32_t>(length)}};
+    return addOperand(std::move(operand));
+}
+
+Tensor ModelBuilder::addRandomConstant(OperandType type, std::vector<uint32_t> dims, float scale,
+                                       int32_t zeroPoint) {
+    const size_t count =
+        std::accumulate(dims.begin(), dims.end(), size_t(1), std::multiplies<size_t>());
+    std::vector<uint8_t> data(count * elementSize(type));
+    if (type == OperandType::TENSOR_FLOAT32) {
+        std::uniform_real_distribution<float> distribution(-0.1f, 0.1f);
+        auto* values = reinterpret_cast<float*>(data.data());
+        for (size_t i = 0; i < count; i++) values[i] = distribution(mRandom);
+    } else if (type == OperandType::TENSOR_INT32) {
+        std::uniform_int_distribution<int32_t> distribution(-1000, 1000);
+        auto* values = reinterpret_cast<int32_t*>(data.data());
+        for (size_t i = 0; i < count; i++) values[i] = distribution(mRandom);
+    } else {
+        std::uniform_int_distribution<int> distribution(0, 255);
+        for (auto& value : data) value = distribution(mRandom);
+    }
+    return {addConstant(type, dims, data.data(), data.size(), scale, zeroPoint), type, dims, scale,
+            zeroPoint};
+}
+
+uint32_t ModelBuilder::addInt32(int32_t value) {
+    return addConstant(OperandType::INT32, {}, &value, sizeof(value));
+}
+
+uint32_t ModelBuilder::addFloat32(float value) {
+    return addConstant(OperandType::FLOAT32, {}, &value, sizeof(value));
+}
+
+uint32_t ModelBuilder::addNoValue(OperandType type) {
+    Operand operand = {.type = type, .lifetime = OperandLifeTime::NO_VALUE};
+    return addOperand(std::move(operand));
+}
+
+uint32_t ModelBuilder::addSubgraph(const Model& subgraph) {
+    // Constants of all subgraphs live in the operand values of the model
+    mOperandValues.resize((mOperandValues.size() + 7) & ~size_t(7));
+    const uint32_t base = mOperandValues.size();
+    mOperandValues.insert(mOperandValues.end(), subgraph.operandValues.begin(),
+                          subgraph.operandValues.end());
+    Subgraph referenced = subgraph.main;
+    for (auto& operand : referenced.operands) {
+        if (operand.lifetime == OperandLifeTime::CONSTANT_COPY) operand.location.offset += base;
+    }
+    mReferenced.push_back(std::move(referenced));
+
+    Operand operand = {.type = OperandType::SUBGRAPH,
+                       .lifetime = OperandLifeTime::SUBGRAPH,
+                       .location = {.poolIndex = 0,
+                                    .offset = static_cast<uint32_t>(mReferenced.size() - 1),
+                                    .length = 0}};
+    return addOperand(std::move(operand));
+}
+
+void ModelBuilder::addOperation(OperationType type, std::vector<uint32_t> inputs,
+                                std::vector<uint32_t> outputs) {
+    for (auto input : inputs) mOperands[input].numberOfConsumers++;
+    mOperations.push_back({.type = type, .inputs = inputs, .outputs = outputs});
+}
+
+void ModelBuilder::markOutput(const Tensor& tensor) {
+    mOperands[tensor.index].lifetime = OperandLifeTime::SUBGRAPH_OUTPUT;
+    mOutputs.push_back(tensor.index);
+}
+
+Model ModelBuilder::build() const {
+    Model model;
+    model.main.operands = mOperands;
+    model.main.operations = mOperations;
+    model.main.inputIndexes = mInputs;
+    model.main.outputIndexes = mOutputs;
+    model.referenced = mReferenced;
+    model.operandValues = mOperandValues;
+    return model;
+}
+
+// Quantized layers take INT32 biases scaled by the input and weight scales
+static Tensor addBias(ModelBuilder& builder, const Tensor& input, uint32_t size) {
+    if (!isQuantized(input.type)) {
+        return builder.addRandomConstant(OperandType::TENSOR_FLOAT32, {size});
+    }
+    return builder.addRandomConstant(OperandType::TENSOR_INT32, {size},
+                                     input.scale * kWeightScale);
+}
+
+static Tensor addActivationOutput(ModelBuilder& builder, const Tensor& input,
+                                  std::vector<uint32_t> dims) {
+    if (!isQuantized(input.type)) return builder.addTemporary(input.type, dims);
+    return builder.addTemporary(input.type, dims, kActivationScale, 0);
+}
+
+static Tensor addWeights(ModelBuilder& builder, const Tensor& input, std::vector<uint32_t> dims) {
+    if (!isQuantized(input.type)) return builder.addRandomConstant(input.type, dims);
+    return builder.addRandomConstant(input.type, dims, kWeightScale, kWeightZeroPoint);
+}
+
+Tensor addConv2d(ModelBuilder& builder, const Tensor& input, uint32_t outChannels,
+                 uint32_t kernel, uint32_t stride, int32_t activation) {
+    const auto& dims = input.dims;
+    auto filter = addWeights(builder, input, {outChannels, kernel, kernel, dims[3]});
+    auto bias = addBias(builder, input, outChannels);
+    auto output = addActivationOutput(
+        builder, input,
+        {dims[0], (dims[1] + stride - 1) / stride, (dims[2] + stride - 1) / stride, outChannels});
+    builder.addOperation(OperationType::CONV_2D,
+                         {input.index, filter.index, bias.index, builder.addInt32(kPaddingSame),
+                          builder.addInt32(stride), builder.addInt32(stride),
+                          builder.addInt32(activation)},
+                         {output.index});
+    return output;
+}
+
+Tensor addDepthwiseConv2d(ModelBuilder& builder, const Tensor& input, uint32_t kernel,
+                          uint32_t stride, int32_t activation) {
+    const auto& dims = input.dims;
+    auto filter = addWeights(builder, input, {1, kernel, kernel, dims[3]});
+    auto bias = addBias(builder, input, dims[3]);
+    auto output = addActivationOutput(
+        builder, input,
+        {dims[0], (dims[1] + stride - 1) / stride, (dims[2] + stride - 1) / stride, dims[3]});
+    builder.addOperation(OperationType::DEPTHWISE_CONV_2D,
+                         {input.index, filter.index, bias.index, builder.addInt32(kPaddingSame),
+                          builder.addInt32(stride), builder.addInt32(stride), builder.addInt32(1),
+                          builder.addInt32(activation)},
+                         {output.index});
+    return output;
+}
+
+Tensor addFullyConnected(ModelBuilder& builder, const Tensor& input, uint32_t outputs,
+                         int32_t activation) {
+    const uint32_t batch = input.dims[0];
+    const uint32_t inputSize = std::accumulate(input.dims.begin() + 1, input.dims.end(), 1u,
+                                               std::multiplies<uint32_t>());
+    auto weights = addWeights(builder, input, {outputs, inputSize});
+    auto bias = addBias(builder, input, outputs);
+    auto output = addActivationOutput(builder, input, {batch, outputs});
+    builder.addOperation(OperationType::FULLY_CONNECTED,
+                         {input.index, weights.index, bias.index, builder.addInt32(activation)},
+                         {output.index});
+    return output;
+}
+
+Tensor addGlobalAveragePool(ModelBuilder& builder, const Tensor& input) {
+    const auto& dims = input.dims;
+    auto output = builder.addTemporary(input.type, {dims[0], 1, 1, dims[3]}, input.scale,
+                                       input.zeroPoint);
+    builder.addOperation(OperationType::AVERAGE_POOL_2D,
+                         {input.index, builder.addInt32(kPaddingValid), builder.addInt32(1),
+                          builder.addInt32(1), builder.addInt32(dims[2]),
+                          builder.addInt32(dims[1]), builder.addInt32(kActivationNone)},
+                         {output.index});
+    return output;
+}
+
+Tensor addSoftmax(ModelBuilder& builder, const Tensor& input) {
+    // Quantized softmax outputs are fixed to a scale of 1/256 and zero point 0
+    auto output = isQuantized(input.type)
+                      ? builder.addTemporary(input.type, input.dims, 1.f / 256, 0)
+                      : builder.addTemporary(input.type, input.dims);
+    builder.addOperation(OperationType::SOFTMAX, {input.index, builder.addFloat32(1.f)},
+                         {output.index});
+    return output;
+}
+
+// Strided convolutions down to a pooled classifier
+static void buildConvNet(ModelBuilder& builder, OperandType type) {
+    auto tensor = isQuantized(type) ? builder.addInput(type, {1, 224, 224, 3}, 1.f / 128, 128)
+                                    : builder.addInput(type, {1, 224, 224, 3});
+    tensor = addConv2d(builder, tensor, 32, 3, 2, kActivationRelu6);
+    tensor = addConv2d(builder, tensor, 64, 3, 2, kActivationRelu6);
+    tensor = addConv2d(builder, tensor, 128, 3, 2, kActivationRelu6);
+    tensor = addConv2d(builder, tensor, 256, 3, 2, kActivationRelu6);
+    tensor = addGlobalAveragePool(builder, tensor);
+    tensor = addFullyConnected(builder, tensor, 1000, kActivationNone);
+    builder.markOutput(addSoftmax(builder, tensor));
+}
+
+// Depthwise separable blocks as in MobileNet
+static void buildDepthwiseStack(ModelBuilder& builder, OperandType type) {
+    auto tensor = isQuantized(type) ? builder.addInput(type, {1, 56, 56, 64}, 1.f / 128, 128)
+                                    : builder.addInput(type, {1, 56, 56, 64});
+    for (int block = 0; block < 6; block++) {
+        tensor = addDepthwiseConv2d(builder, tensor, 3, 1, kActivationRelu6);
+        tensor = addConv2d(builder, tensor, 64, 1, 1, kActivationRelu6);
+    }
+    builder.markOutput(tensor);
+}
+
+static void buildFullyConnectedStack(ModelBuilder& builder, OperandType type) {
+    auto tensor = isQuantized(type) ? builder.addInput(type, {8, 1024}, 1.f / 128, 128)
+                                    : builder.addInput(type, {8, 1024});
+    for (int layer = 0; layer < 4; layer++) {
+        tensor = addFullyConnected(builder, tensor, 1024, kActivationRelu);
+    }
+    builder.markOutput(tensor);
+}
+
+// One LSTM step without peepholes or projection, states passed in and out by the caller
+static void buildLstm(ModelBuilder& builder) {
+    constexpr uint32_t kBatch = 4, kInputSize = 128, kNumUnits = 256;
+    constexpr auto kFloat = OperandType::TENSOR_FLOAT32;
+    auto input = builder.addInput(kFloat, {kBatch, kInputSize});
+    std::vector<uint32_t> inputs = {input.index};
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(builder.addRandomConstant(kFloat, {kNumUnits, kInputSize}).index);
+    }
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(builder.addRandomConstant(kFloat, {kNumUnits, kNumUnits}).index);
+    }
+    for (int gate = 0; gate < 3; gate++) inputs.push_back(builder.addNoValue(kFloat));
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(builder.addRandomConstant(kFloat, {kNumUnits}).index);
+    }
+    inputs.push_back(builder.addNoValue(kFloat));
+    inputs.push_back(builder.addNoValue(kFloat));
+    inputs.push_back(builder.addInput(kFloat, {kBatch, kNumUnits}).index);
+    inputs.push_back(builder.addInput(kFloat, {kBatch, kNumUnits}).index);
+    inputs.push_back(builder.addInt32(kActivationTanh));
+    inputs.push_back(builder.addFloat32(0.f));
+    inputs.push_back(builder.addFloat32(0.f));
+
+    std::vector<Tensor> outputs = {builder.addTemporary(kFloat, {kBatch, kNumUnits * 4}),
+                                   builder.addTemporary(kFloat, {kBatch, kNumUnits}),
+                                   builder.addTemporary(kFloat, {kBatch, kNumUnits}),
+                                   builder.addTemporary(kFloat, {kBatch, kNumUnits})};
+    builder.addOperation(OperationType::LSTM, inputs,
+                         {outputs[0].index, outputs[1].index, outputs[2].index, outputs[3].index});
+    for (const auto& output : outputs) builder.markOutput(output);
+}
+
+static const std::map<std::string, std::function<void(ModelBuilder&)>>& syntheticModels() {
+    static const std::map<std::string, std::function<void(ModelBuilder&)>> models = {
+        {"conv", [](ModelBuilder& b) { buildConvNet(b, OperandType::TENSOR_FLOAT32); }},
+        {"conv_quant", [](ModelBuilder& b) { buildConvNet(b, OperandType::TENSOR_QUANT8_ASYMM); }},
+        {"depthwise",
+         [](ModelBuilder& b) { buildDepthwiseStack(b, OperandType::TENSOR_FLOAT32); }},
+        {"depthwise_quant",
+         [](ModelBuilder& b) { buildDepthwiseStack(b, OperandType::TENSOR_QUANT8_ASYMM); }},
+        {"fc", [](ModelBuilder& b) { buildFullyConnectedStack(b, OperandType::TENSOR_FLOAT32); }},
+        {"fc_quant",
+         [](ModelBuilder& b) { buildFullyConnectedStack(b, OperandType::TENSOR_QUANT8_ASYMM); }},
+        {"lstm", [](ModelBuilder& b) { buildLstm(b); }},
+    };
+    return models;
+}
+
+std::vector<std::string> syntheticModelNames() {
+    std::vector<std::string> names;
+    for (const auto& entry : syntheticModels()) names.push_back(entry.first);
+    return names;
+}
+
+bool buildSyntheticModel(const std::string& name, Model& model) {
+    auto it = syntheticModels().find(name);
+    if (it == syntheticModels().end()) return false;
+    ModelBuilder builder;
+    it->second(builder);
+    model = builder.build();
+    return true;
+}
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
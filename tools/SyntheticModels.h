@@ -0,0 +1,87 @@
+#ifndef ANDROID_ML_NN_TOOLS_SYNTHETIC_MODELS_H
+#define ANDROID_ML_NN_TOOLS_SYNTHETIC_MODELS_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Driver.h"
+
+namespace android {
+namespace hardware {
+namespace neuralnetworks {
+namespace nnhal {
+
+// Operand of a model under construction, with the type information the layer helpers need to
+// derive the operands they add
+struct Tensor {
+    uint32_t index;
+    OperandType type;
+    std::vector<uint32_t> dims;
+    float scale = 0.f;
+    int32_t zeroPoint = 0;
+};
+
+// Builds a V1_3::Model in code. Constant tensors are filled with reproducible pseudo random values,
+// which is all benchmarks need.
+class ModelBuilder {
+public:
+    ModelBuilder() : mRandom(42) {}
+
+    Tensor addInput(OperandType type, std::vector<uint32_t> dims, float scale = 0.f,
+                    int32_t zeroPoint = 0);
+    Tensor addTemporary(OperandType type, std::vector<uint32_t> dims, float scale = 0.f,
+                        int32_t zeroPoint = 0);
+    Tensor addRandomConstant(OperandType type, std::vector<uint32_t> dims, float scale = 0.f,
+                             int32_t zeroPoint = 0);
+    uint32_t addConstant(OperandType type, std::vector<uint32_t> dims, const void* data,
+                         size_t length, float scale = 0.f, int32_t zeroPoint = 0);
+    uint32_t addInt32(int32_t value);
+    uint32_t addFloat32(float value);
+    uint32_t addNoValue(OperandType type);
+    // Adds the main subgraph of a model of another builder as a referenced subgraph, for IF and
+    // WHILE operations. The model can't reference subgraphs itself.
+    uint32_t addSubgraph(const Model& subgraph);
+
+    void addOperation(OperationType type, std::vector<uint32_t> inputs,
+                      std::vector<uint32_t> outputs);
+    // Turns a temporary into a model output
+    void markOutput(const Tensor& tensor);
+
+    Model build() const;
+
+private:
+    uint32_t addOperand(Operand operand);
+
+    std::vector<Operand> mOperands;
+    std::vector<Operation> mOperations;
+    std::vector<uint32_t> mInputs;
+    std::vector<uint32_t> mOutputs;
+    std::vector<uint8_t> mOperandValues;
+    std::vector<Subgraph> mReferenced;
+    std::mt19937 mRandom;
+};
+
+// Layers built from NNAPI operations, SAME padded. Quantized layers derive their operand
+// quantization from the input tensor.
+Tensor addConv2d(ModelBuilder& builder, const Tensor& input, uint32_t outChannels,
+                 uint32_t kernel, uint32_t stride, int32_t activation);
+Tensor addDepthwiseConv2d(ModelBuilder& builder, const Tensor& input, uint32_t kernel,
+                          uint32_t stride, int32_t activation);
+Tensor addFullyConnected(ModelBuilder& builder, const Tensor& input, uint32_t outputs,
+                         int32_t activation);
+Tensor addGlobalAveragePool(ModelBuilder& builder, const Tensor& input);
+Tensor addSoftmax(ModelBuilder& builder, const Tensor& input);
+
+// Representative models by name, see syntheticModelNames()
+std::vector<std::string> syntheticModelNames();
+bool buildSyntheticModel(const std::string& name, Model& model);
+
+size_t operandByteSize(const Operand& operand);
+
+}  // namespace nnhal
+}  // namespace neuralnetworks
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_ML_NN_TOOLS_SYNTHETIC_MODELS_H
@@ -0,0 +1,295 @@
+// Benchmarks the driver in process on synthetic models and reports the results as JSON:
+//
+//   nnhal_benchmark [--device CPU|GNA|GPU|VPU] [--models conv,lstm,...]
+//                   [--modes sync,async,fenced,burst] [--iterations N] [--warmup N]
+//                   [--concurrency 1,2,4] [--output file]
+//
+// For every model and execution mode it reports the prepare latency, the growth of the resident
+// set kept by the prepared model, the latency and page faults of the first execution, the
+// execution latency percentiles and page faults of back to back executions, and the throughput
+// with concurrent clients. Every client thread has its own request pool and, for bursts, its own
+// burst. Running it with vendor.nn.hal.arena set to false compares against plugin allocated blobs.
+
+#include <log/log.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "DriverClient.h"
+#include "SyntheticModels.h"
+
+#undef LOG_TAG
+#define LOG_TAG "nnhal_benchmark"
+
+using namespace android::hardware::neuralnetworks::nnhal;
+using android::sp;
+using PreparedModel = android::hardware::neuralnetworks::V1_3::IPreparedModel;
+
+namespace {
+
+struct Options {
+    IntelDeviceType device = IntelDeviceType::CPU;
+    std::string deviceName = "CPU";
+    std::vector<std::string> models = syntheticModelNames();
+    std::vector<ExecutionMode> modes = {ExecutionMode::SYNC};
+    size_t iterations = 200;
+    size_t warmup = 10;
+    std::vector<size_t> concurrency = {1, 2, 4};
+    std::string output;
+};
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    for (std::string item; std::getline(stream, item, ',');) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << option << "\n";
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (option == "--device") {
+            options.deviceName = value;
+            if (value == "CPU") {
+                options.device = IntelDeviceType::CPU;
+            } else if (value == "GNA") {
+                options.device = IntelDeviceType::GNA;
+            } else if (value == "GPU") {
+                options.device = IntelDeviceType::GPU;
+            } else if (value == "VPU") {
+                options.device = IntelDeviceType::VPU;
+            } else {
+                std::cerr << "unknown device " << value << "\n";
+                return false;
+            }
+        } else if (option == "--models") {
+            options.models = split(value);
+        } else if (option == "--modes") {
+            options.modes.clear();
+            for (const auto& name : split(value)) {
+                ExecutionMode mode;
+                if (!parseExecutionMode(name, mode)) {
+                    std::cerr << "unknown execution mode " << name << "\n";
+                    return false;
+                }
+                options.modes.push_back(mode);
+            }
+        } else if (option == "--iterations") {
+            options.iterations = std::max(1, std::stoi(value));
+        } else if (option == "--warmup") {
+            options.warmup = std::max(0, std::stoi(value));
+        } else if (option == "--concurrency") {
+            options.concurrency.clear();
+            for (const auto& item : split(value)) {
+                options.concurrency.push_back(std::max(1, std::stoi(item)));
+            }
+        } else if (option == "--output") {
+            options.output = value;
+        } else {
+            std::cerr << "unknown option " << option << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+void fillInputs(const Model& model, PooledRequest& request) {
+    std::mt19937 random(7);
+    for (size_t i = 0; i < model.main.inputIndexes.size(); i++) {
+        const auto& operand = model.main.operands[model.main.inputIndexes[i]];
+        uint8_t* data = request.input(i);
+        const size_t length = request.inputLength(i);
+        if (operand.type == OperandType::TENSOR_FLOAT32) {
+            std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+            auto* values = reinterpret_cast<float*>(data);
+            for (size_t k = 0; k < length / sizeof(float); k++) values[k] = distribution(random);
+        } else {
+            std::uniform_int_distribution<int> distribution(0, 255);
+            for (size_t k = 0; k < length; k++) data[k] = distribution(random);
+        }
+    }
+}
+
+struct LatencyStats {
+    size_t failures = 0;
+    uint64_t p50 = 0, p99 = 0, mean = 0, max = 0;
+    uint64_t firstUs = 0;
+    long firstFaults = 0;
+    double faultsPerExecution = 0;
+};
+
+// Minor and major page faults of the process so far
+long pageFaults() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_minflt + usage.ru_majflt;
+}
+
+LatencyStats measureLatency(const sp<PreparedModel>& preparedModel, const Model& model,
+                            ExecutionMode mode, const Options& options) {
+    LatencyStats stats;
+    PooledRequest request;
+    if (!request.create(model)) {
+        stats.failures = options.iterations;
+        return stats;
+    }
+    fillInputs(model, request);
+    Executor executor(preparedModel, mode);
+    // The first execution faults in the memory the network and its blobs were not touched in yet
+    const long firstFaultsBefore = pageFaults();
+    const auto firstStart = std::chrono::steady_clock::now();
+    executor.execute(request.request);
+    stats.firstUs = elapsedUs(firstStart);
+    stats.firstFaults = pageFaults() - firstFaultsBefore;
+    for (size_t i = 1; i < options.warmup; i++) executor.execute(request.request);
+
+    std::vector<uint64_t> latencies;
+    const long faultsBefore = pageFaults();
+    for (size_t i = 0; i < options.iterations; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!executor.execute(request.request)) {
+            stats.failures++;
+            continue;
+        }
+        latencies.push_back(elapsedUs(start));
+    }
+    if (options.iterations > 0) {
+        stats.faultsPerExecution = double(pageFaults() - faultsBefore) / options.iterations;
+    }
+    if (latencies.empty()) return stats;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double fraction) {
+        return latencies[std::min(latencies.size() - 1, size_t(fraction * latencies.size()))];
+    };
+    stats.p50 = percentile(0.5);
+    stats.p99 = percentile(0.99);
+    stats.max = latencies.back();
+    uint64_t total = 0;
+    for (auto latency : latencies) total += latency;
+    stats.mean = total / latencies.size();
+    return stats;
+}
+
+// Executions per second with clients each running iterations executions back to back
+double measureThroughput(const sp<PreparedModel>& preparedModel, const Model& model,
+                         ExecutionMode mode, size_t clients, const Options& options) {
+    std::vector<PooledRequest> requests(clients);
+    for (auto& request : requests) {
+        if (!request.create(model)) return 0;
+        fillInputs(model, request);
+    }
+    std::atomic<size_t> completed{0};
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t client = 0; client < clients; client++) {
+        threads.emplace_back([&, client] {
+            Executor executor(preparedModel, mode);
+            for (size_t i = 0; i < options.iterations; i++) {
+                if (executor.execute(requests[client].request)) completed++;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    const uint64_t us = elapsedUs(start);
+    return us ? completed * 1e6 / us : 0;
+}
+
+long residentKb() {
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    if (!(statm >> size >> resident)) return 0;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+long peakRssKb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    sp<Driver> driver = new Driver(options.device);
+    std::ostringstream out;
+    out << "{\"device\": \"" << options.deviceName << "\", \"results\": [";
+    bool first = true;
+    for (const auto& name : options.models) {
+        Model model;
+        if (!buildSyntheticModel(name, model)) {
+            std::cerr << "unknown model " << name << "\n";
+            return 1;
+        }
+        const long residentBefore = residentKb();
+        const auto prepareStart = std::chrono::steady_clock::now();
+        auto preparedModel = prepareModel(driver, model);
+        const uint64_t prepareUs = elapsedUs(prepareStart);
+        const long preparedRssKb = residentKb() - residentBefore;
+        if (preparedModel == nullptr) {
+            out << (first ? "" : ",") << "\n{\"model\": \"" << name
+                << "\", \"error\": \"prepare failed\"}";
+            first = false;
+            continue;
+        }
+
+        for (auto mode : options.modes) {
+            const auto latency = measureLatency(preparedModel, model, mode, options);
+            out << (first ? "" : ",") << "\n{\"model\": \"" << name << "\", \"mode\": \""
+                << executionModeName(mode) << "\", \"prepareUs\": " << prepareUs
+                << ", \"preparedRssKb\": " << preparedRssKb
+                << ", \"iterations\": " << options.iterations
+                << ", \"failures\": " << latency.failures
+                << ", \"firstExecution\": {\"latencyUs\": " << latency.firstUs
+                << ", \"pageFaults\": " << latency.firstFaults << "}, \"latencyUs\": {\"p50\": "
+                << latency.p50 << ", \"p99\": " << latency.p99 << ", \"mean\": " << latency.mean
+                << ", \"max\": " << latency.max
+                << "}, \"pageFaultsPerExecution\": " << latency.faultsPerExecution
+                << ", \"throughput\": [";
+            for (size_t i = 0; i < options.concurrency.size(); i++) {
+                const size_t clients = options.concurrency[i];
+                out << (i ? ", " : "") << "{\"concurrency\": " << clients
+                    << ", \"executionsPerSecond\": "
+                    << measureThroughput(preparedModel, model, mode, clients, options) << "}";
+            }
+            out << "]}";
+            first = false;
+        }
+    }
+    out << "\n], \"peakRssKb\": " << peakRssKb() << "}\n";
+
+    if (options.output.empty()) {
+        std::cout << out.str();
+    } else {
+        std::ofstream file(options.output);
+        file << out.str();
+        if (!file) {
+            std::cerr << "failed to write " << options.output << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,1735 @@
+// Checks the results of the driver in process and reports one verdict per check as JSON:
+//
+//   nnhal_check [--device CPU|GNA|GPU|VPU] [--mode sync|async|fenced|burst]
+//               [--checks recurrent_state,lstm,...] [--tolerance T] [--output file]
+//
+// Operation checks run single operation models on random inputs and compare the outputs with
+// the ones of the NNAPI reference implementation. Float outputs match when within the tolerance
+// of the expected values, other outputs when within one unit. Checks of operations the device
+// doesn't support are skipped. Exits with 2 when a check fails.
+
+#include <cutils/properties.h>
+#include <log/log.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+#include "BasePreparedModel.h"
+#include "CpuExecutor.h"
+#include "DriverClient.h"
+#include "SyntheticModels.h"
+#include "WeightStore.hpp"
+
+#undef LOG_TAG
+#define LOG_TAG "nnhal_check"
+
+using namespace android::hardware::neuralnetworks::nnhal;
+using android::sp;
+using PreparedModel = android::hardware::neuralnetworks::V1_3::IPreparedModel;
+
+namespace {
+
+namespace nn = ::android::nn;
+
+static const char* kStatefulModeProperty = "vendor.nn.hal.stateful";
+static const char* kBf16Property = "vendor.nn.hal.bf16";
+static const char* kBatchSizeProperty = "vendor.nn.hal.batch.max_size";
+static const char* kMinIdleProperty = "vendor.nn.hal.memory_budget.min_idle_ms";
+static const int32_t kDefaultMinIdleMs = 1000;
+
+// BF16 keeps 8 significant bits, relaxed outputs around 1 are a few units of 2^-7 off
+constexpr double kRelaxedTolerance = 5e-2;
+// FP16 keeps 11 significant bits, results around 1 are a few units of 2^-11 off
+constexpr double kFloat16Tolerance = 5e-3;
+
+struct Options {
+    IntelDeviceType device = IntelDeviceType::CPU;
+    std::string deviceName = "CPU";
+    ExecutionMode mode = ExecutionMode::SYNC;
+    double tolerance = 1e-3;
+    std::vector<std::string> checks;
+    std::string output;
+};
+
+enum class Verdict { PASS, FAIL, SKIP };
+
+const char* verdictName(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::PASS:
+            return "pass";
+        case Verdict::FAIL:
+            return "fail";
+        case Verdict::SKIP:
+            return "skip";
+    }
+    return "unknown";
+}
+
+struct CheckResult {
+    Verdict verdict = Verdict::PASS;
+    double maxError = 0;
+    std::string detail;
+};
+
+CheckResult failed(const std::string& detail) { return {Verdict::FAIL, 0, detail}; }
+CheckResult skipped(const std::string& detail) { return {Verdict::SKIP, 0, detail}; }
+
+struct Check {
+    std::string name;
+    std::function<CheckResult(const sp<Driver>&, const Options&)> run;
+};
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    for (std::string item; std::getline(stream, item, ',');) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << option << "\n";
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (option == "--device") {
+            options.deviceName = value;
+            if (value == "CPU") {
+                options.device = IntelDeviceType::CPU;
+            } else if (value == "GNA") {
+                options.device = IntelDeviceType::GNA;
+            } else if (value == "GPU") {
+                options.device = IntelDeviceType::GPU;
+            } else if (value == "VPU") {
+                options.device = IntelDeviceType::VPU;
+            } else {
+                std::cerr << "unknown device " << value << "\n";
+                return false;
+            }
+        } else if (option == "--mode") {
+            if (!parseExecutionMode(value, options.mode)) {
+                std::cerr << "unknown execution mode " << value << "\n";
+                return false;
+            }
+        } else if (option == "--checks") {
+            options.checks = split(value);
+        } else if (option == "--tolerance") {
+            options.tolerance = std::stod(value);
+        } else if (option == "--output") {
+            options.output = value;
+        } else {
+            std::cerr << "unknown option " << option << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isFloat(OperandType type) {
+    return type == OperandType::TENSOR_FLOAT32 || type == OperandType::TENSOR_FLOAT16;
+}
+
+// Fills an operand with reproducible values in the range the checked operations are exercised
+// with: floats in [-1, 1], integers in [0, 3] and any value for quantized types
+void fillOperand(OperandType type, uint8_t* data, size_t length, std::mt19937& random) {
+    if (type == OperandType::TENSOR_FLOAT32) {
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        auto* values = reinterpret_cast<float*>(data);
+        for (size_t k = 0; k < length / sizeof(float); k++) values[k] = distribution(random);
+    } else if (type == OperandType::TENSOR_FLOAT16) {
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        auto* values = reinterpret_cast<_Float16*>(data);
+        for (size_t k = 0; k < length / sizeof(_Float16); k++) {
+            values[k] = _Float16(distribution(random));
+        }
+    } else if (type == OperandType::TENSOR_INT32) {
+        std::uniform_int_distribution<int32_t> distribution(0, 3);
+        auto* values = reinterpret_cast<int32_t*>(data);
+        for (size_t k = 0; k < length / sizeof(int32_t); k++) values[k] = distribution(random);
+    } else if (type == OperandType::TENSOR_BOOL8) {
+        std::uniform_int_distribution<int> distribution(0, 1);
+        for (size_t k = 0; k < length; k++) data[k] = distribution(random);
+    } else {
+        std::uniform_int_distribution<int> distribution(0, 255);
+        for (size_t k = 0; k < length; k++) data[k] = distribution(random);
+    }
+}
+
+template <typename T>
+double maxDifference(const uint8_t* actual, const uint8_t* expected, size_t length) {
+    double error = 0;
+    for (size_t i = 0; i + sizeof(T) <= length; i += sizeof(T)) {
+        T lhs, rhs;
+        std::memcpy(&lhs, actual + i, sizeof(T));
+        std::memcpy(&rhs, expected + i, sizeof(T));
+        error = std::max(error, std::fabs(double(lhs) - double(rhs)));
+    }
+    return error;
+}
+
+double maxError(OperandType type, const uint8_t* actual, const uint8_t* expected, size_t length) {
+    switch (type) {
+        case OperandType::TENSOR_FLOAT32:
+            return maxDifference<float>(actual, expected, length);
+        case OperandType::TENSOR_FLOAT16:
+            return maxDifference<_Float16>(actual, expected, length);
+        case OperandType::TENSOR_INT32:
+            return maxDifference<int32_t>(actual, expected, length);
+        case OperandType::TENSOR_QUANT16_SYMM:
+            return maxDifference<int16_t>(actual, expected, length);
+        case OperandType::TENSOR_QUANT16_ASYMM:
+            return maxDifference<uint16_t>(actual, expected, length);
+        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
+        case OperandType::TENSOR_QUANT8_SYMM:
+            return maxDifference<int8_t>(actual, expected, length);
+        default:
+            return maxDifference<uint8_t>(actual, expected, length);
+    }
+}
+
+bool withinTolerance(OperandType type, double error, const Options& options) {
+    return error <= (isFloat(type) ? options.tolerance : 1.0);
+}
+
+// Answer of the driver to a support query, false when the query failed
+bool getSupportedOperations(const sp<Driver>& driver, const Model& model,
+                            std::vector<bool>& supported) {
+    bool answered = false;
+    driver->getSupportedOperations_1_3(
+        model, [&](android::hardware::neuralnetworks::V1_3::ErrorStatus status,
+                   const android::hardware::hidl_vec<bool>& operations) {
+            answered = status == android::hardware::neuralnetworks::V1_3::ErrorStatus::NONE;
+            supported = operations;
+        });
+    return answered;
+}
+
+bool isSupported(const sp<Driver>& driver, const Model& model) {
+    std::vector<bool> supported;
+    return getSupportedOperations(driver, model, supported) &&
+           std::all_of(supported.begin(), supported.end(),
+                       [](bool operation) { return operation; });
+}
+
+// Single operation model compared with the reference implementation, leaving out the outputs
+// whose content is implementation defined, like the LSTM scratch buffer. Inputs without given
+// values are random.
+struct ReferenceModel {
+    Model model;
+    std::vector<size_t> ignoredOutputs;
+    std::map<size_t, std::vector<uint8_t>> inputValues;
+};
+
+template <typename T>
+std::vector<uint8_t> toBytes(const std::vector<T>& values) {
+    const auto* data = reinterpret_cast<const uint8_t*>(values.data());
+    return std::vector<uint8_t>(data, data + values.size() * sizeof(T));
+}
+
+// Runs request, whose inputs are set, on the prepared model and the reference implementation and
+// compares the outputs, leaving out the ignored ones
+CheckResult compareExecution(const sp<PreparedModel>& preparedModel, const Options& options,
+                             const Model& model, PooledRequest& request,
+                             const std::vector<size_t>& ignoredOutputs = {}) {
+    std::vector<uint8_t> expected(request.pool->data(),
+                                  request.pool->data() + request.pool->size());
+
+    Executor executor(preparedModel, options.mode);
+    if (!executor.execute(request.request)) return failed("execution failed");
+
+    const auto referenceRequest = nn::convertToV1_3(request.request);
+    const std::vector<nn::RunTimePoolInfo> modelPools;
+    const std::vector<nn::RunTimePoolInfo> requestPools = {
+        nn::RunTimePoolInfo::createFromExistingBuffer(expected.data(), expected.size())};
+    nn::CpuExecutor cpuExecutor;
+    if (cpuExecutor.run(model, referenceRequest, modelPools, requestPools) !=
+        ANEURALNETWORKS_NO_ERROR) {
+        return failed("reference execution failed");
+    }
+
+    CheckResult result;
+    for (size_t i = 0; i < model.main.outputIndexes.size(); i++) {
+        if (std::find(ignoredOutputs.begin(), ignoredOutputs.end(), i) != ignoredOutputs.end()) {
+            continue;
+        }
+        const auto type = model.main.operands[model.main.outputIndexes[i]].type;
+        const double error = maxError(type, request.output(i),
+                                      expected.data() + request.outputOffsets[i],
+                                      request.outputLength(i));
+        result.maxError = std::max(result.maxError, error);
+        if (!withinTolerance(type, error, options) && result.verdict == Verdict::PASS) {
+            result.verdict = Verdict::FAIL;
+            result.detail = "output " + std::to_string(i) + " differs from the reference";
+        }
+    }
+    return result;
+}
+
+CheckResult compareWithReference(const sp<Driver>& driver, const Options& options,
+                                 const ReferenceModel& reference) {
+    const Model& model = reference.model;
+    if (!isSupported(driver, model)) return skipped("unsupported model");
+
+    auto preparedModel = prepareModel(driver, model);
+    if (preparedModel == nullptr) return failed("prepare failed");
+
+    PooledRequest request;
+    if (!request.create(model)) return failed("request allocation failed");
+    std::memset(request.pool->data(), 0, request.pool->size());
+    std::mt19937 random(7);
+    for (size_t i = 0; i < model.main.inputIndexes.size(); i++) {
+        const auto type = model.main.operands[model.main.inputIndexes[i]].type;
+        auto values = reference.inputValues.find(i);
+        if (values != reference.inputValues.end()) {
+            std::memcpy(request.input(i), values->second.data(),
+                        std::min(values->second.size(), request.inputLength(i)));
+        } else {
+            fillOperand(type, request.input(i), request.inputLength(i), random);
+        }
+    }
+    return compareExecution(preparedModel, options, model, request, reference.ignoredOutputs);
+}
+
+Check referenceCheck(const std::string& name, std::function<ReferenceModel()> build) {
+    return {name, [build](const sp<Driver>& driver, const Options& options) {
+                return compareWithReference(driver, options, build());
+            }};
+}
+
+uint32_t addBool(ModelBuilder& builder, bool value) {
+    const uint8_t data = value;
+    return builder.addConstant(OperandType::BOOL, {}, &data, sizeof(data));
+}
+
+// Recurrent operations run over a short time major sequence of a small batch
+constexpr uint32_t kMaxTime = 4, kBatch = 2, kInputSize = 8, kNumUnits = 16;
+constexpr int32_t kActivationTanh = 4;
+
+// Appends the weights and biases of one LSTM direction without peepholes or projection, in the
+// operand order of the LSTM operations
+void addLstmWeights(ModelBuilder& builder, std::vector<uint32_t>& inputs) {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(builder.addRandomConstant(F32, {kNumUnits, kInputSize}).index);
+    }
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(builder.addRandomConstant(F32, {kNumUnits, kNumUnits}).index);
+    }
+    for (int gate = 0; gate < 3; gate++) inputs.push_back(builder.addNoValue(F32));
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(builder.addRandomConstant(F32, {kNumUnits}).index);
+    }
+    inputs.push_back(builder.addNoValue(F32));
+    inputs.push_back(builder.addNoValue(F32));
+}
+
+ReferenceModel buildLstmReference() {
+    ReferenceModel reference{{}, {0}};
+    buildSyntheticModel("lstm", reference.model);
+    return reference;
+}
+
+ReferenceModel buildUnidirectionalSequenceLstm() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    std::vector<uint32_t> inputs = {builder.addInput(F32, {kMaxTime, kBatch, kInputSize}).index};
+    addLstmWeights(builder, inputs);
+    inputs.push_back(builder.addInput(F32, {kBatch, kNumUnits}).index);
+    inputs.push_back(builder.addInput(F32, {kBatch, kNumUnits}).index);
+    inputs.push_back(builder.addInt32(kActivationTanh));
+    inputs.push_back(builder.addFloat32(0.f));
+    inputs.push_back(builder.addFloat32(0.f));
+    inputs.push_back(addBool(builder, true));
+    const Tensor output = builder.addTemporary(F32, {kMaxTime, kBatch, kNumUnits});
+    builder.addOperation(OperationType::UNIDIRECTIONAL_SEQUENCE_LSTM, inputs, {output.index});
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+// Separate forward and backward outputs, without auxiliary input or layer normalization
+ReferenceModel buildBidirectionalSequenceLstm() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    std::vector<uint32_t> inputs = {builder.addInput(F32, {kMaxTime, kBatch, kInputSize}).index};
+    addLstmWeights(builder, inputs);
+    addLstmWeights(builder, inputs);
+    for (int state = 0; state < 4; state++) {
+        inputs.push_back(builder.addInput(F32, {kBatch, kNumUnits}).index);
+    }
+    for (int aux = 0; aux < 9; aux++) inputs.push_back(builder.addNoValue(F32));
+    inputs.push_back(builder.addInt32(kActivationTanh));
+    inputs.push_back(builder.addFloat32(0.f));
+    inputs.push_back(builder.addFloat32(0.f));
+    inputs.push_back(addBool(builder, false));
+    inputs.push_back(addBool(builder, true));
+    for (int norm = 0; norm < 8; norm++) inputs.push_back(builder.addNoValue(F32));
+    const Tensor forward = builder.addTemporary(F32, {kMaxTime, kBatch, kNumUnits});
+    const Tensor backward = builder.addTemporary(F32, {kMaxTime, kBatch, kNumUnits});
+    builder.addOperation(OperationType::BIDIRECTIONAL_SEQUENCE_LSTM, inputs,
+                         {forward.index, backward.index});
+    builder.markOutput(forward);
+    builder.markOutput(backward);
+    return {builder.build(), {}};
+}
+
+ReferenceModel buildUnidirectionalSequenceRnn() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, {kMaxTime, kBatch, kInputSize});
+    const Tensor hidden = builder.addInput(F32, {kBatch, kNumUnits});
+    const Tensor weights = builder.addRandomConstant(F32, {kNumUnits, kInputSize});
+    const Tensor recurrentWeights = builder.addRandomConstant(F32, {kNumUnits, kNumUnits});
+    const Tensor bias = builder.addRandomConstant(F32, {kNumUnits});
+    const Tensor output = builder.addTemporary(F32, {kMaxTime, kBatch, kNumUnits});
+    builder.addOperation(OperationType::UNIDIRECTIONAL_SEQUENCE_RNN,
+                         {input.index, weights.index, recurrentWeights.index, bias.index,
+                          hidden.index, builder.addInt32(kActivationTanh), builder.addInt32(1)},
+                         {output.index});
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+// Inputs and outputs scaled by 1/128 around 128 and the cell state by 2^-11, as the operation
+// requires, with the biases scaled by the input and weight scales
+ReferenceModel buildQuantized16BitLstm() {
+    constexpr float kScale = 1.f / 128, kWeightsScale = 0.01f, kCellScale = 1.f / 2048;
+    constexpr int32_t kZeroPoint = 128;
+    const auto Q8 = OperandType::TENSOR_QUANT8_ASYMM;
+    const auto Q16 = OperandType::TENSOR_QUANT16_SYMM;
+    ModelBuilder builder;
+    std::vector<uint32_t> inputs = {
+        builder.addInput(Q8, {kBatch, kInputSize}, kScale, kZeroPoint).index};
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(
+            builder.addRandomConstant(Q8, {kNumUnits, kInputSize}, kWeightsScale, kZeroPoint)
+                .index);
+    }
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(
+            builder.addRandomConstant(Q8, {kNumUnits, kNumUnits}, kWeightsScale, kZeroPoint)
+                .index);
+    }
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(builder
+                             .addRandomConstant(OperandType::TENSOR_INT32, {kNumUnits},
+                                                kScale * kWeightsScale)
+                             .index);
+    }
+    inputs.push_back(builder.addInput(Q16, {kBatch, kNumUnits}, kCellScale).index);
+    inputs.push_back(builder.addInput(Q8, {kBatch, kNumUnits}, kScale, kZeroPoint).index);
+    const Tensor cellState = builder.addTemporary(Q16, {kBatch, kNumUnits}, kCellScale);
+    const Tensor output = builder.addTemporary(Q8, {kBatch, kNumUnits}, kScale, kZeroPoint);
+    builder.addOperation(OperationType::QUANTIZED_16BIT_LSTM, inputs,
+                         {cellState.index, output.index});
+    builder.markOutput(cellState);
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+// Signed 8 bit inputs and states with symmetric weights, without peepholes, projection or layer
+// normalization, so the hidden state shares the output state quantization
+ReferenceModel buildQuantizedLstm() {
+    constexpr float kScale = 1.f / 128, kWeightsScale = 0.01f, kCellScale = 1.f / 2048;
+    constexpr float kIntermediateScale = 1.f / 4096;
+    const auto QS8 = OperandType::TENSOR_QUANT8_ASYMM_SIGNED;
+    const auto W8 = OperandType::TENSOR_QUANT8_SYMM;
+    const auto Q16 = OperandType::TENSOR_QUANT16_SYMM;
+    const auto I32 = OperandType::TENSOR_INT32;
+    ModelBuilder builder;
+    std::vector<uint32_t> inputs = {builder.addInput(QS8, {kBatch, kInputSize}, kScale).index};
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(
+            builder.addRandomConstant(W8, {kNumUnits, kInputSize}, kWeightsScale).index);
+    }
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(
+            builder.addRandomConstant(W8, {kNumUnits, kNumUnits}, kWeightsScale).index);
+    }
+    for (int gate = 0; gate < 3; gate++) inputs.push_back(builder.addNoValue(Q16));
+    for (int gate = 0; gate < 4; gate++) {
+        inputs.push_back(
+            builder.addRandomConstant(I32, {kNumUnits}, kScale * kWeightsScale).index);
+    }
+    inputs.push_back(builder.addNoValue(W8));
+    inputs.push_back(builder.addNoValue(I32));
+    inputs.push_back(builder.addInput(QS8, {kBatch, kNumUnits}, kScale).index);
+    inputs.push_back(builder.addInput(Q16, {kBatch, kNumUnits}, kCellScale).index);
+    for (int norm = 0; norm < 4; norm++) inputs.push_back(builder.addNoValue(Q16));
+    inputs.push_back(builder.addFloat32(0.f));
+    inputs.push_back(builder.addFloat32(0.f));
+    for (int gate = 0; gate < 4; gate++) inputs.push_back(builder.addFloat32(kIntermediateScale));
+    inputs.push_back(builder.addInt32(0));
+    inputs.push_back(builder.addFloat32(kScale));
+    const Tensor outputState = builder.addTemporary(QS8, {kBatch, kNumUnits}, kScale);
+    const Tensor cellState = builder.addTemporary(Q16, {kBatch, kNumUnits}, kCellScale);
+    const Tensor output = builder.addTemporary(QS8, {kBatch, kNumUnits}, kScale);
+    builder.addOperation(OperationType::QUANTIZED_LSTM, inputs,
+                         {outputState.index, cellState.index, output.index});
+    builder.markOutput(outputState);
+    builder.markOutput(cellState);
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+// Detection operations keep or drop boxes depending on their values and the reference only
+// accepts outputs of the size it produces, so boxes are given and laid out not to overlap. Scores
+// are distinct for a deterministic order.
+
+// Four rois of one image with random deltas for two classes
+ReferenceModel buildAxisAlignedBboxTransform() {
+    constexpr uint32_t kRois = 4, kClasses = 2;
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor rois = builder.addInput(F32, {kRois, 4});
+    const Tensor deltas = builder.addInput(F32, {kRois, kClasses * 4});
+    const Tensor batchSplit = builder.addInput(OperandType::TENSOR_INT32, {kRois});
+    const Tensor imageInfo = builder.addInput(F32, {1, 2});
+    const Tensor output = builder.addTemporary(F32, {kRois, kClasses * 4});
+    builder.addOperation(OperationType::AXIS_ALIGNED_BBOX_TRANSFORM,
+                         {rois.index, deltas.index, batchSplit.index, imageInfo.index},
+                         {output.index});
+    builder.markOutput(output);
+
+    std::vector<float> boxes;
+    for (uint32_t roi = 0; roi < kRois; roi++) {
+        const float x = 10.f * roi, y = 5.f * roi;
+        boxes.insert(boxes.end(), {x, y, x + 20.f + roi, y + 30.f});
+    }
+    return {builder.build(),
+            {},
+            {{0, toBytes(boxes)},
+             {2, toBytes(std::vector<int32_t>(kRois, 0))},
+             {3, toBytes(std::vector<float>{64.f, 64.f})}}};
+}
+
+// Hard NMS of twelve boxes of three classes, the background one ignored, keeping the five best
+ReferenceModel buildBoxWithNmsLimit() {
+    constexpr uint32_t kRois = 4, kClasses = 3, kDetections = 5;
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    const auto I32 = OperandType::TENSOR_INT32;
+    ModelBuilder builder;
+    const Tensor scores = builder.addInput(F32, {kRois, kClasses});
+    const Tensor rois = builder.addInput(F32, {kRois, kClasses * 4});
+    const std::vector<int32_t> batchSplit(kRois, 0);
+    const uint32_t batchSplitIndex = builder.addConstant(
+        I32, {kRois}, batchSplit.data(), batchSplit.size() * sizeof(int32_t));
+    const Tensor outScores = builder.addTemporary(F32, {kDetections});
+    const Tensor outRois = builder.addTemporary(F32, {kDetections, 4});
+    const Tensor outClasses = builder.addTemporary(I32, {kDetections});
+    const Tensor outBatchSplit = builder.addTemporary(I32, {kDetections});
+    builder.addOperation(
+        OperationType::BOX_WITH_NMS_LIMIT,
+        {scores.index, rois.index, batchSplitIndex, builder.addFloat32(0.1f),
+         builder.addInt32(kDetections), builder.addInt32(0), builder.addFloat32(0.5f),
+         builder.addFloat32(0.5f), builder.addFloat32(0.1f)},
+        {outScores.index, outRois.index, outClasses.index, outBatchSplit.index});
+    for (const auto& output : {outScores, outRois, outClasses, outBatchSplit}) {
+        builder.markOutput(output);
+    }
+
+    std::vector<float> scoreValues, boxes;
+    for (uint32_t i = 0; i < kRois * kClasses; i++) {
+        scoreValues.push_back(0.2f + 0.7f * ((i * 5) % (kRois * kClasses)) / (kRois * kClasses));
+    }
+    for (uint32_t roi = 0; roi < kRois; roi++) {
+        for (uint32_t c = 0; c < kClasses; c++) {
+            const float x = 20.f * roi, y = 20.f * c;
+            boxes.insert(boxes.end(), {x, y, x + 10.f, y + 10.f});
+        }
+    }
+    return {builder.build(), {}, {{0, toBytes(scoreValues)}, {1, toBytes(boxes)}}};
+}
+
+// Fast NMS over a 4x4 grid of anchors with random scores and small random deltas, keeping four
+// detections
+ReferenceModel buildDetectionPostprocessing() {
+    constexpr uint32_t kAnchors = 16, kClasses = 3, kDetections = 4;
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    const auto I32 = OperandType::TENSOR_INT32;
+    ModelBuilder builder;
+    const Tensor scores = builder.addInput(F32, {1, kAnchors, kClasses});
+    const Tensor deltas = builder.addInput(F32, {1, kAnchors, 4});
+    const Tensor anchors = builder.addInput(F32, {kAnchors, 4});
+    const Tensor outScores = builder.addTemporary(F32, {1, kDetections});
+    const Tensor outBoxes = builder.addTemporary(F32, {1, kDetections, 4});
+    const Tensor outClasses = builder.addTemporary(I32, {1, kDetections});
+    const Tensor outCount = builder.addTemporary(I32, {1});
+    builder.addOperation(
+        OperationType::DETECTION_POSTPROCESSING,
+        {scores.index, deltas.index, anchors.index, builder.addFloat32(10.f),
+         builder.addFloat32(10.f), builder.addFloat32(5.f), builder.addFloat32(5.f),
+         addBool(builder, false), builder.addInt32(kDetections), builder.addInt32(1),
+         builder.addInt32(kDetections), builder.addFloat32(0.f), builder.addFloat32(0.5f),
+         addBool(builder, false)},
+        {outScores.index, outBoxes.index, outClasses.index, outCount.index});
+    for (const auto& output : {outScores, outBoxes, outClasses, outCount}) {
+        builder.markOutput(output);
+    }
+
+    // Center y, center x, height and width
+    std::vector<float> anchorValues;
+    for (uint32_t anchor = 0; anchor < kAnchors; anchor++) {
+        anchorValues.insert(anchorValues.end(), {0.125f + 0.25f * (anchor / 4),
+                                                 0.125f + 0.25f * (anchor % 4), 0.1f, 0.1f});
+    }
+    return {builder.build(), {}, {{2, toBytes(anchorValues)}}};
+}
+
+// Proposals of two anchors per cell of a 4x4 feature map with a stride of 16, keeping six
+ReferenceModel buildGenerateProposals() {
+    constexpr uint32_t kSize = 4, kAnchors = 2, kProposals = 6;
+    constexpr float kStride = 16.f;
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    const auto I32 = OperandType::TENSOR_INT32;
+    ModelBuilder builder;
+    const Tensor scores = builder.addInput(F32, {1, kSize, kSize, kAnchors});
+    const Tensor deltas = builder.addInput(F32, {1, kSize, kSize, kAnchors * 4});
+    const Tensor anchors = builder.addInput(F32, {kAnchors, 4});
+    const Tensor imageInfo = builder.addInput(F32, {1, 2});
+    const Tensor outScores = builder.addTemporary(F32, {kProposals});
+    const Tensor outRois = builder.addTemporary(F32, {kProposals, 4});
+    const Tensor outBatchSplit = builder.addTemporary(I32, {kProposals});
+    builder.addOperation(OperationType::GENERATE_PROPOSALS,
+                         {scores.index, deltas.index, anchors.index, imageInfo.index,
+                          builder.addFloat32(kStride), builder.addFloat32(kStride),
+                          builder.addInt32(kSize * kSize * kAnchors),
+                          builder.addInt32(kProposals), builder.addFloat32(0.5f),
+                          builder.addFloat32(1.f), addBool(builder, false)},
+                         {outScores.index, outRois.index, outBatchSplit.index});
+    for (const auto& output : {outScores, outRois, outBatchSplit}) builder.markOutput(output);
+
+    // Deltas small enough for the boxes to stay apart
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> distribution(-0.1f, 0.1f);
+    std::vector<float> deltaValues(kSize * kSize * kAnchors * 4);
+    for (auto& value : deltaValues) value = distribution(random);
+    return {builder.build(),
+            {},
+            {{1, toBytes(deltaValues)},
+             {2, toBytes(std::vector<float>{0.f, 0.f, 5.f, 5.f, 9.f, 9.f, 14.f, 14.f})},
+             {3, toBytes(std::vector<float>{64.f, 64.f})}}};
+}
+
+// Random NHWC heatmaps of three keypoints for two boxes
+ReferenceModel buildHeatmapMaxKeypoint() {
+    constexpr uint32_t kBoxes = 2, kKeypoints = 3, kSize = 8;
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor heatmaps = builder.addInput(F32, {kBoxes, kSize, kSize, kKeypoints});
+    const Tensor boxes = builder.addInput(F32, {kBoxes, 4});
+    const Tensor scores = builder.addTemporary(F32, {kBoxes, kKeypoints});
+    const Tensor keypoints = builder.addTemporary(F32, {kBoxes, kKeypoints, 2});
+    builder.addOperation(OperationType::HEATMAP_MAX_KEYPOINT,
+                         {heatmaps.index, boxes.index, addBool(builder, false)},
+                         {scores.index, keypoints.index});
+    builder.markOutput(scores);
+    builder.markOutput(keypoints);
+    return {builder.build(),
+            {},
+            {{1, toBytes(std::vector<float>{0.f, 0.f, 16.f, 16.f, 8.f, 4.f, 40.f, 36.f})}}};
+}
+
+uint32_t addInt32Vector(ModelBuilder& builder, const std::vector<int32_t>& values) {
+    return builder.addConstant(OperandType::TENSOR_INT32, {uint32_t(values.size())},
+                               values.data(), values.size() * sizeof(int32_t));
+}
+
+// Slice of every dimension, the third one to its end
+ReferenceModel buildSlice() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, {2, 4, 6, 3});
+    const Tensor output = builder.addTemporary(F32, {2, 2, 4, 3});
+    builder.addOperation(OperationType::SLICE,
+                         {input.index, addInt32Vector(builder, {0, 1, 2, 0}),
+                          addInt32Vector(builder, {2, 2, -1, 3})},
+                         {output.index});
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+ReferenceModel buildTile() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, {2, 3, 4});
+    const Tensor output = builder.addTemporary(F32, {4, 3, 12});
+    builder.addOperation(OperationType::TILE,
+                         {input.index, addInt32Vector(builder, {2, 1, 3})}, {output.index});
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+// The filled tensor is added to an input, the driver needs constant dimensions and value
+ReferenceModel buildFill() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, {2, 3, 4});
+    const Tensor filled = builder.addTemporary(F32, {2, 3, 4});
+    builder.addOperation(OperationType::FILL,
+                         {addInt32Vector(builder, {2, 3, 4}), builder.addFloat32(0.5f)},
+                         {filled.index});
+    const Tensor output = builder.addTemporary(F32, {2, 3, 4});
+    builder.addOperation(OperationType::ADD, {input.index, filled.index, builder.addInt32(0)},
+                         {output.index});
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+ReferenceModel buildRank() {
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(OperandType::TENSOR_FLOAT32, {2, 3, 4});
+    const Tensor output = builder.addTemporary(OperandType::INT32, {});
+    builder.addOperation(OperationType::RANK, {input.index}, {output.index});
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+ReferenceModel buildElu() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, {2, 3, 4, 5});
+    const Tensor output = builder.addTemporary(F32, {2, 3, 4, 5});
+    builder.addOperation(OperationType::ELU, {input.index, builder.addFloat32(0.8f)},
+                         {output.index});
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+// Normalization across the default last axis and across axis 1 of the same input
+ReferenceModel buildLocalResponseNormalization() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, {1, 6, 4, 8});
+    const Tensor lastAxis = builder.addTemporary(F32, {1, 6, 4, 8});
+    const Tensor firstAxis = builder.addTemporary(F32, {1, 6, 4, 8});
+    const uint32_t radius = builder.addInt32(2), bias = builder.addFloat32(1.f),
+                   alpha = builder.addFloat32(0.5f), beta = builder.addFloat32(0.75f);
+    builder.addOperation(OperationType::LOCAL_RESPONSE_NORMALIZATION,
+                         {input.index, radius, bias, alpha, beta}, {lastAxis.index});
+    builder.addOperation(OperationType::LOCAL_RESPONSE_NORMALIZATION,
+                         {input.index, radius, bias, alpha, beta, builder.addInt32(1)},
+                         {firstAxis.index});
+    builder.markOutput(lastAxis);
+    builder.markOutput(firstAxis);
+    return {builder.build(), {}};
+}
+
+uint32_t addFloat32Tensor(ModelBuilder& builder, float value) {
+    return builder.addConstant(OperandType::TENSOR_FLOAT32, {1}, &value, sizeof(value));
+}
+
+// Subgraph of an input of the given dimensions and the result of one elementwise operation,
+// doubling or TANH
+Model buildElementwiseBranch(OperationType type, const std::vector<uint32_t>& dims) {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, dims);
+    const Tensor output = builder.addTemporary(F32, dims);
+    if (type == OperationType::ADD) {
+        builder.addOperation(type, {input.index, input.index, builder.addInt32(0)},
+                             {output.index});
+    } else {
+        builder.addOperation(type, {input.index}, {output.index});
+    }
+    builder.markOutput(output);
+    return builder.build();
+}
+
+// IF doubling its input when the condition is set and taking its TANH otherwise
+ReferenceModel buildIf(bool condition) {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor cond = builder.addInput(OperandType::TENSOR_BOOL8, {1});
+    const Tensor input = builder.addInput(F32, {2, 4});
+    const Tensor output = builder.addTemporary(F32, {2, 4});
+    builder.addOperation(
+        OperationType::IF,
+        {cond.index, builder.addSubgraph(buildElementwiseBranch(OperationType::ADD, {2, 4})),
+         builder.addSubgraph(buildElementwiseBranch(OperationType::TANH, {2, 4})), input.index},
+        {output.index});
+    builder.markOutput(output);
+    return {builder.build(), {}, {{0, std::vector<uint8_t>{condition}}}};
+}
+
+// Runs the IF model with either condition, so that both branches are taken
+CheckResult checkIf(const sp<Driver>& driver, const Options& options) {
+    CheckResult result;
+    for (bool condition : {true, false}) {
+        const CheckResult branch = compareWithReference(driver, options, buildIf(condition));
+        if (branch.verdict == Verdict::SKIP) return branch;
+        result.maxError = std::max(result.maxError, branch.maxError);
+        if (branch.verdict == Verdict::FAIL && result.verdict == Verdict::PASS) {
+            result.verdict = Verdict::FAIL;
+            result.detail = std::string(condition ? "then" : "else") + " branch: " + branch.detail;
+        }
+    }
+    return result;
+}
+
+// WHILE counting from zero to three, doubling its input and taking the TANH of it each iteration
+ReferenceModel buildWhile() {
+    constexpr float kIterations = 3.f;
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+
+    ModelBuilder condition;
+    {
+        const Tensor counter = condition.addInput(F32, {1});
+        condition.addInput(F32, {2, 4});
+        const Tensor more = condition.addTemporary(OperandType::TENSOR_BOOL8, {1});
+        condition.addOperation(OperationType::LESS,
+                               {counter.index, addFloat32Tensor(condition, kIterations)},
+                               {more.index});
+        condition.markOutput(more);
+    }
+
+    ModelBuilder body;
+    {
+        const Tensor counter = body.addInput(F32, {1});
+        const Tensor input = body.addInput(F32, {2, 4});
+        const Tensor nextCounter = body.addTemporary(F32, {1});
+        body.addOperation(OperationType::ADD,
+                          {counter.index, addFloat32Tensor(body, 1.f), body.addInt32(0)},
+                          {nextCounter.index});
+        const Tensor doubled = body.addTemporary(F32, {2, 4});
+        body.addOperation(OperationType::ADD, {input.index, input.index, body.addInt32(0)},
+                          {doubled.index});
+        const Tensor output = body.addTemporary(F32, {2, 4});
+        body.addOperation(OperationType::TANH, {doubled.index}, {output.index});
+        body.markOutput(nextCounter);
+        body.markOutput(output);
+    }
+
+    ModelBuilder builder;
+    const Tensor counter = builder.addInput(F32, {1});
+    const Tensor input = builder.addInput(F32, {2, 4});
+    const Tensor finalCounter = builder.addTemporary(F32, {1});
+    const Tensor output = builder.addTemporary(F32, {2, 4});
+    builder.addOperation(OperationType::WHILE,
+                         {builder.addSubgraph(condition.build()), builder.addSubgraph(body.build()),
+                          counter.index, input.index},
+                         {finalCounter.index, output.index});
+    builder.markOutput(finalCounter);
+    builder.markOutput(output);
+    return {builder.build(), {}, {{0, toBytes(std::vector<float>{0.f})}}};
+}
+
+// Rank 2 SVDF of four units with a memory of five steps over a random state
+ReferenceModel buildSvdf() {
+    constexpr uint32_t kRank = 2, kUnits = 4, kMemory = 5, kFilters = kRank * kUnits;
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, {kBatch, kInputSize});
+    const Tensor weightsFeature = builder.addRandomConstant(F32, {kFilters, kInputSize});
+    const Tensor weightsTime = builder.addRandomConstant(F32, {kFilters, kMemory});
+    const Tensor bias = builder.addRandomConstant(F32, {kUnits});
+    const Tensor stateIn = builder.addInput(F32, {kBatch, kFilters * kMemory});
+    const Tensor stateOut = builder.addTemporary(F32, {kBatch, kFilters * kMemory});
+    const Tensor output = builder.addTemporary(F32, {kBatch, kUnits});
+    builder.addOperation(OperationType::SVDF,
+                         {input.index, weightsFeature.index, weightsTime.index, bias.index,
+                          stateIn.index, builder.addInt32(kRank), builder.addInt32(0)},
+                         {stateOut.index, output.index});
+    builder.markOutput(stateOut);
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+// Lookups of present and missing keys in a table of four rows
+ReferenceModel buildHashtableLookup() {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    const std::vector<int32_t> lookupValues = {3, 4, 7, 1, 0};
+    const uint32_t lookupCount = lookupValues.size();
+    ModelBuilder builder;
+    const Tensor lookups = builder.addInput(OperandType::TENSOR_INT32, {lookupCount});
+    const Tensor values = builder.addInput(F32, {4, 3});
+    const Tensor output = builder.addTemporary(F32, {lookupCount, 3});
+    const Tensor hits =
+        builder.addTemporary(OperandType::TENSOR_QUANT8_ASYMM, {lookupCount}, 1.f, 0);
+    // The reference implementation binary searches the keys, which are sorted
+    builder.addOperation(OperationType::HASHTABLE_LOOKUP,
+                         {lookups.index, addInt32Vector(builder, {1, 3, 5, 7}), values.index},
+                         {output.index, hits.index});
+    builder.markOutput(output);
+    builder.markOutput(hits);
+    return {builder.build(), {}, {{0, toBytes(lookupValues)}}};
+}
+
+// SOFTMAX or LOG_SOFTMAX across the last axis and across axis 1 of the same input, softmax with a
+// beta other than one
+ReferenceModel buildSoftmaxReference(OperationType type) {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(F32, {2, 3, 8});
+    const Tensor lastAxis = builder.addTemporary(F32, {2, 3, 8});
+    const Tensor firstAxis = builder.addTemporary(F32, {2, 3, 8});
+    const uint32_t beta = builder.addFloat32(type == OperationType::SOFTMAX ? 1.5f : 1.f);
+    builder.addOperation(type, {input.index, beta, builder.addInt32(-1)}, {lastAxis.index});
+    builder.addOperation(type, {input.index, beta, builder.addInt32(1)}, {firstAxis.index});
+    builder.markOutput(lastAxis);
+    builder.markOutput(firstAxis);
+    return {builder.build(), {}};
+}
+
+// L2_NORMALIZATION of rows of which the first is all zeros, which normalize to zeros
+ReferenceModel buildL2Normalization(OperandType type) {
+    constexpr uint32_t kRows = 4, kColumns = 8;
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(type, {kRows, kColumns});
+    const Tensor output = builder.addTemporary(type, {kRows, kColumns});
+    builder.addOperation(OperationType::L2_NORMALIZATION, {input.index}, {output.index});
+    builder.markOutput(output);
+
+    const size_t rowLength = kColumns * (type == OperandType::TENSOR_FLOAT16 ? 2 : 4);
+    std::vector<uint8_t> values(kRows * rowLength, 0);
+    std::mt19937 random(13);
+    fillOperand(type, values.data() + rowLength, values.size() - rowLength, random);
+    return {builder.build(), {}, {{0, values}}};
+}
+
+// FP32 and FP16 normalization, FP16 within its own tolerance
+CheckResult checkL2Normalization(const sp<Driver>& driver, const Options& options) {
+    Options float16 = options;
+    float16.tolerance = std::max(options.tolerance, kFloat16Tolerance);
+    const std::vector<std::tuple<std::string, OperandType, const Options*>> variants = {
+        {"fp32", OperandType::TENSOR_FLOAT32, &options},
+        {"fp16", OperandType::TENSOR_FLOAT16, &float16},
+    };
+
+    CheckResult result;
+    for (const auto& [name, type, variantOptions] : variants) {
+        const CheckResult variant =
+            compareWithReference(driver, *variantOptions, buildL2Normalization(type));
+        result.maxError = std::max(result.maxError, variant.maxError);
+        if (variant.verdict == Verdict::FAIL) {
+            result.verdict = Verdict::FAIL;
+            result.detail += (result.detail.empty() ? "" : ", ") + name + ": " + variant.detail;
+        } else if (variant.verdict == Verdict::SKIP && result.verdict == Verdict::PASS) {
+            result.detail += (result.detail.empty() ? "" : ", ") + name + " skipped";
+        }
+    }
+    return result;
+}
+
+// Prepares a model with the state of its recurrent operations kept in the plugin between
+// executions instead of read from and written to the state operands
+sp<PreparedModel> prepareStatefulModel(const sp<Driver>& driver, const Model& model) {
+    property_set(kStatefulModeProperty, "true");
+    auto preparedModel = prepareModel(driver, model);
+    property_set(kStatefulModeProperty, "false");
+    return preparedModel;
+}
+
+// Recurrent model with its state operands, as pairs of a model input and the model output
+// carrying its next value
+struct RecurrentModel {
+    Model model;
+    std::vector<std::pair<size_t, size_t>> stateLinks;
+};
+
+Model buildRnnModel() {
+    ModelBuilder builder;
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    const Tensor input = builder.addInput(F32, {kBatch, kInputSize});
+    const Tensor hiddenIn = builder.addInput(F32, {kBatch, kNumUnits});
+    const Tensor weights = builder.addRandomConstant(F32, {kNumUnits, kInputSize});
+    const Tensor recurrentWeights = builder.addRandomConstant(F32, {kNumUnits, kNumUnits});
+    const Tensor bias = builder.addRandomConstant(F32, {kNumUnits});
+    const Tensor hiddenOut = builder.addTemporary(F32, {kBatch, kNumUnits});
+    const Tensor output = builder.addTemporary(F32, {kBatch, kNumUnits});
+    builder.addOperation(OperationType::RNN,
+                         {input.index, weights.index, recurrentWeights.index, bias.index,
+                          hiddenIn.index, builder.addInt32(kActivationTanh)},
+                         {hiddenOut.index, output.index});
+    builder.markOutput(hiddenOut);
+    builder.markOutput(output);
+    return builder.build();
+}
+
+// Runs a sequence of steps of a recurrent model stateless, with the state outputs fed back as
+// state inputs, and stateful, with the state kept in the plugin from zeros, and compares every
+// output of every step. Both start from a zero state and see the same inputs.
+CheckResult checkRecurrentSequence(const sp<Driver>& driver, const Options& options,
+                                   const RecurrentModel& recurrent) {
+    constexpr size_t kSteps = 8;
+    const Model& model = recurrent.model;
+    if (!isSupported(driver, model)) return skipped("unsupported model");
+
+    auto stateless = prepareModel(driver, model);
+    auto stateful = prepareStatefulModel(driver, model);
+    if (stateless == nullptr || stateful == nullptr) return failed("prepare failed");
+
+    PooledRequest statelessRequest, statefulRequest;
+    if (!statelessRequest.create(model) || !statefulRequest.create(model)) {
+        return failed("request allocation failed");
+    }
+    std::memset(statelessRequest.pool->data(), 0, statelessRequest.pool->size());
+    std::memset(statefulRequest.pool->data(), 0, statefulRequest.pool->size());
+
+    Executor statelessExecutor(stateless, options.mode);
+    Executor statefulExecutor(stateful, options.mode);
+    CheckResult result;
+    std::mt19937 random(7);
+    for (size_t step = 0; step < kSteps; step++) {
+        for (size_t i = 0; i < model.main.inputIndexes.size(); i++) {
+            const bool isState =
+                std::any_of(recurrent.stateLinks.begin(), recurrent.stateLinks.end(),
+                            [i](const std::pair<size_t, size_t>& link) { return link.first == i; });
+            if (isState) continue;
+            const auto type = model.main.operands[model.main.inputIndexes[i]].type;
+            fillOperand(type, statelessRequest.input(i), statelessRequest.inputLength(i), random);
+            std::memcpy(statefulRequest.input(i), statelessRequest.input(i),
+                        statelessRequest.inputLength(i));
+        }
+        if (!statelessExecutor.execute(statelessRequest.request) ||
+            !statefulExecutor.execute(statefulRequest.request)) {
+            return failed("execution of step " + std::to_string(step) + " failed");
+        }
+        for (size_t i = 0; i < model.main.outputIndexes.size(); i++) {
+            const auto type = model.main.operands[model.main.outputIndexes[i]].type;
+            const double error = maxError(type, statefulRequest.output(i),
+                                          statelessRequest.output(i),
+                                          statelessRequest.outputLength(i));
+            result.maxError = std::max(result.maxError, error);
+            if (!withinTolerance(type, error, options) && result.verdict == Verdict::PASS) {
+                result.verdict = Verdict::FAIL;
+                result.detail = "output " + std::to_string(i) + " differs at step " +
+                                std::to_string(step);
+            }
+        }
+        for (const auto& link : recurrent.stateLinks) {
+            std::memcpy(statelessRequest.input(link.first), statelessRequest.output(link.second),
+                        statelessRequest.inputLength(link.first));
+        }
+    }
+    return result;
+}
+
+CheckResult checkRecurrentState(const sp<Driver>& driver, const Options& options) {
+    RecurrentModel lstm;
+    if (!buildSyntheticModel("lstm", lstm.model)) return failed("lstm model build failed");
+    // Output state and cell state
+    lstm.stateLinks = {{1, 1}, {2, 2}};
+    RecurrentModel rnn{buildRnnModel(), {{1, 0}}};
+
+    CheckResult result;
+    for (const auto* model : {&lstm, &rnn}) {
+        const CheckResult sequence = checkRecurrentSequence(driver, options, *model);
+        const std::string name = model == &lstm ? "lstm" : "rnn";
+        result.maxError = std::max(result.maxError, sequence.maxError);
+        if (sequence.verdict == Verdict::FAIL) {
+            result.verdict = Verdict::FAIL;
+            result.detail += (result.detail.empty() ? "" : ", ") + name + ": " + sequence.detail;
+        } else if (sequence.verdict == Verdict::SKIP && result.verdict == Verdict::PASS) {
+            result.detail += (result.detail.empty() ? "" : ", ") + name + " skipped";
+        }
+    }
+    return result;
+}
+
+long residentKb() {
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    if (!(statm >> size >> resident)) return 0;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Prepares model while sampling the resident set, peakKb is the highest sample
+sp<PreparedModel> prepareSampled(const sp<Driver>& driver, const Model& model, long& peakKb) {
+    std::atomic<bool> preparing(true);
+    std::atomic<long> peak(residentKb());
+    std::thread sampler([&]() {
+        while (preparing) {
+            const long kb = residentKb();
+            if (kb > peak) peak = kb;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    auto preparedModel = prepareModel(driver, model);
+    preparing = false;
+    sampler.join();
+    peakKb = peak.load();
+    return preparedModel;
+}
+
+// Prepares the fully connected stack twice, the second time while the first prepared model is
+// alive, sampling the resident set. Once a network is loaded the compile time copies of the
+// weights are released, so the resident set has to end at least half the weight size below its
+// peak during each prepare, the first prepared model keeping no copy the second one prepares
+// next to.
+CheckResult checkPrepareMemory(const sp<Driver>& driver, const Options& options) {
+    Model model;
+    if (!buildSyntheticModel("fc", model)) return failed("fc model build failed");
+    if (!isSupported(driver, model)) return skipped("unsupported model");
+
+    const long weightsKb = model.operandValues.size() / 1024;
+    CheckResult result;
+    result.detail = "weights " + std::to_string(weightsKb) + " kB";
+    std::vector<sp<PreparedModel>> preparedModels;
+    for (int i = 0; i < 2; i++) {
+        long peakKb = 0;
+        auto preparedModel = prepareSampled(driver, model, peakKb);
+        if (preparedModel == nullptr) return failed("prepare failed");
+        preparedModels.push_back(preparedModel);
+
+        const long afterKb = residentKb();
+        result.detail += ", model " + std::to_string(i) + " peak " + std::to_string(peakKb) +
+                         " kB after prepare " + std::to_string(afterKb) + " kB";
+        if (afterKb + weightsKb / 2 > peakKb) result.verdict = Verdict::FAIL;
+    }
+    return result;
+}
+
+// Fully connected layers with or without a softmax head, so that both models have the same
+// weights but are compiled separately
+Model buildSharedWeightsModel(bool softmax) {
+    ModelBuilder builder;
+    Tensor tensor = builder.addInput(OperandType::TENSOR_FLOAT32, {8, 256});
+    for (int layer = 0; layer < 2; layer++) {
+        tensor = addFullyConnected(builder, tensor, 256, /*activation=*/0);
+    }
+    if (softmax) tensor = addSoftmax(builder, tensor);
+    builder.markOutput(tensor);
+    return builder.build();
+}
+
+// Prepares two models with the same weights, the second while the first is alive. The plugin
+// copies the constants, so once each network is loaded the weight store holds none of them.
+CheckResult checkWeightSharing(const sp<Driver>& driver, const Options& options) {
+    const Model first = buildSharedWeightsModel(false);
+    const Model second = buildSharedWeightsModel(true);
+    if (!isSupported(driver, first) || !isSupported(driver, second)) {
+        return skipped("unsupported model");
+    }
+
+    auto& store = WeightStore::get();
+    const auto before = store.getStats();
+    auto firstPrepared = prepareModel(driver, first);
+    const auto afterFirst = store.getStats();
+    auto secondPrepared = prepareModel(driver, second);
+    const auto afterSecond = store.getStats();
+    if (firstPrepared == nullptr || secondPrepared == nullptr) return failed("prepare failed");
+
+    CheckResult result;
+    result.detail = "store held " + std::to_string(afterFirst.bytes) + " bytes after the first " +
+                    "model, " + std::to_string(afterSecond.bytes) + " after the second, " +
+                    std::to_string(before.bytes) + " before";
+    if (afterFirst.bytes > before.bytes || afterSecond.bytes > before.bytes) {
+        result.verdict = Verdict::FAIL;
+    }
+    return result;
+}
+
+// Runs a relaxed fully connected model with BF16 enabled and compares it with the FP32 reference.
+// Devices without BF16 run it in FP16 or FP32.
+CheckResult checkRelaxedPrecision(const sp<Driver>& driver, const Options& options) {
+    constexpr int32_t kActivationRelu = 1;
+    ModelBuilder builder;
+    Tensor tensor = builder.addInput(OperandType::TENSOR_FLOAT32, {4, 64});
+    for (int layer = 0; layer < 2; layer++) {
+        tensor = addFullyConnected(builder, tensor, 64, kActivationRelu);
+    }
+    builder.markOutput(tensor);
+    ReferenceModel reference{builder.build(), {}};
+    reference.model.relaxComputationFloat32toFloat16 = true;
+
+    Options relaxed = options;
+    relaxed.tolerance = std::max(options.tolerance, kRelaxedTolerance);
+    property_set(kBf16Property, "true");
+    const CheckResult result = compareWithReference(driver, relaxed, reference);
+    property_set(kBf16Property, "false");
+    return result;
+}
+
+// Metrics of a prepared model of the driver in process
+ModelMetrics& modelMetrics(const sp<PreparedModel>& preparedModel) {
+    return static_cast<BasePreparedModel*>(preparedModel.get())->getMetrics();
+}
+
+// Fully connected layer with a softmax head over a batch left unspecified
+Model buildDynamicBatchModel() {
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(OperandType::TENSOR_FLOAT32, {0, 32});
+    const Tensor hidden = addFullyConnected(builder, input, 16, /*activation=*/0);
+    builder.markOutput(addSoftmax(builder, hidden));
+    return builder.build();
+}
+
+// Executes a model with an unspecified batch with the batch given by the requests, coming back to
+// a batch seen before. Every execution matches the reference, and only the first execution of
+// each batch compiles the network.
+CheckResult checkDynamicShapes(const sp<Driver>& driver, const Options& options) {
+    constexpr uint32_t kFeatures = 32, kClasses = 16;
+    const Model model = buildDynamicBatchModel();
+    if (!isSupported(driver, model)) return skipped("unsupported model");
+
+    auto preparedModel = prepareModel(driver, model);
+    if (preparedModel == nullptr) return failed("prepare failed");
+
+    CheckResult result;
+    std::mt19937 random(7);
+    for (uint32_t batch : {2u, 4u, 2u}) {
+        PooledRequest request;
+        if (!request.create({batch * kFeatures * sizeof(float)},
+                            {batch * kClasses * sizeof(float)})) {
+            return failed("request allocation failed");
+        }
+        request.request.inputs[0].dimensions = {batch, kFeatures};
+        request.request.outputs[0].dimensions = {batch, kClasses};
+        fillOperand(OperandType::TENSOR_FLOAT32, request.input(0), request.inputLength(0), random);
+
+        const CheckResult execution = compareExecution(preparedModel, options, model, request);
+        result.maxError = std::max(result.maxError, execution.maxError);
+        if (execution.verdict != Verdict::PASS) {
+            return failed("batch " + std::to_string(batch) + ": " + execution.detail);
+        }
+    }
+
+    const uint64_t compilations = modelMetrics(preparedModel).compilations.load();
+    result.detail = std::to_string(compilations) + " compilations";
+    if (compilations != 2) result.verdict = Verdict::FAIL;
+    return result;
+}
+
+// Fully connected layer with a softmax head over a batch of one, which batched executions are
+// stacked along
+Model buildBatchableModel() {
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(OperandType::TENSOR_FLOAT32, {1, 64});
+    const Tensor hidden = addFullyConnected(builder, input, 32, /*activation=*/0);
+    builder.markOutput(addSoftmax(builder, hidden));
+    return builder.build();
+}
+
+// Prepares a model with and without vendor.nn.hal.batch.max_size and runs concurrent executions
+// on the batched one, which the driver stacks into batches of up to four. Each has to produce the
+// outputs of the same inputs executed alone on the unbatched model.
+CheckResult checkBatching(const sp<Driver>& driver, const Options& options) {
+    constexpr size_t kExecutions = 8;
+    const Model model = buildBatchableModel();
+    if (!isSupported(driver, model)) return skipped("unsupported model");
+
+    auto unbatched = prepareModel(driver, model);
+    property_set(kBatchSizeProperty, "4");
+    auto batched = prepareModel(driver, model);
+    property_set(kBatchSizeProperty, "0");
+    if (unbatched == nullptr || batched == nullptr) return failed("prepare failed");
+
+    std::vector<PooledRequest> requests(kExecutions), expected(kExecutions);
+    std::mt19937 random(7);
+    Executor executor(unbatched, options.mode);
+    for (size_t k = 0; k < kExecutions; k++) {
+        if (!requests[k].create(model) || !expected[k].create(model)) {
+            return failed("request allocation failed");
+        }
+        fillOperand(OperandType::TENSOR_FLOAT32, requests[k].input(0), requests[k].inputLength(0),
+                    random);
+        std::memcpy(expected[k].input(0), requests[k].input(0), requests[k].inputLength(0));
+        if (!executor.execute(expected[k].request)) return failed("unbatched execution failed");
+    }
+
+    std::atomic<size_t> failures(0);
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < kExecutions; k++) {
+        threads.emplace_back([&, k]() {
+            Executor batchedExecutor(batched, options.mode);
+            if (!batchedExecutor.execute(requests[k].request)) failures++;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    if (failures > 0) return failed(std::to_string(failures.load()) + " executions failed");
+
+    CheckResult result;
+    const auto type = model.main.operands[model.main.outputIndexes[0]].type;
+    for (size_t k = 0; k < kExecutions; k++) {
+        const double error = maxError(type, requests[k].output(0), expected[k].output(0),
+                                      expected[k].outputLength(0));
+        result.maxError = std::max(result.maxError, error);
+        if (!withinTolerance(type, error, options) && result.verdict == Verdict::PASS) {
+            result.verdict = Verdict::FAIL;
+            result.detail = "execution " + std::to_string(k) + " differs from the unbatched one";
+        }
+    }
+    return result;
+}
+
+// JSON debug dump of the driver, as lshal debug <service> --json prints it
+std::string debugDump(const sp<Driver>& driver) {
+    const int fd = memfd_create("nnhal-check-dump", MFD_CLOEXEC);
+    if (fd < 0) return "";
+    native_handle_t* handle = native_handle_create(1, 0);
+    handle->data[0] = fd;
+    driver->debug(android::hardware::hidl_handle(handle), {"--json"});
+
+    std::string dump;
+    char buffer[4096];
+    lseek(fd, 0, SEEK_SET);
+    for (ssize_t length; (length = read(fd, buffer, sizeof(buffer))) > 0;) {
+        dump.append(buffer, length);
+    }
+    native_handle_close(handle);
+    native_handle_delete(handle);
+    return dump;
+}
+
+// Counter of a driver wide section of a debug dump, 0 when missing
+uint64_t dumpCounter(const std::string& dump, const std::string& section,
+                     const std::string& counter) {
+    const size_t start = dump.find("\"" + section + "\": {");
+    if (start == std::string::npos) return 0;
+    const std::string key = "\"" + counter + "\": ";
+    const size_t at = dump.find(key, start);
+    if (at == std::string::npos) return 0;
+    return std::strtoull(dump.c_str() + at + key.size(), nullptr, 10);
+}
+
+// Compares an execution of a model of one FP32 input on random values with the reference
+CheckResult compareRandomExecution(const sp<PreparedModel>& preparedModel, const Options& options,
+                                   const Model& model, std::mt19937& random) {
+    PooledRequest request;
+    if (!request.create(model)) return failed("request allocation failed");
+    fillOperand(OperandType::TENSOR_FLOAT32, request.input(0), request.inputLength(0), random);
+    return compareExecution(preparedModel, options, model, request);
+}
+
+// Prepares the same model twice. With vendor.nn.hal.network_cache_mb set the second prepare
+// reuses the network the first one loaded, and both prepared models match the reference.
+CheckResult checkNetworkCache(const sp<Driver>& driver, const Options& options) {
+    if (dumpCounter(debugDump(driver), "networkCache", "capacityBytes") == 0) {
+        return skipped("network cache disabled");
+    }
+    ModelBuilder builder;
+    const Tensor input = builder.addInput(OperandType::TENSOR_FLOAT32, {2, 64});
+    builder.markOutput(addFullyConnected(builder, input, 32, /*activation=*/1));
+    const Model model = builder.build();
+    if (!isSupported(driver, model)) return skipped("unsupported model");
+
+    auto first = prepareModel(driver, model);
+    const uint64_t hitsBefore = dumpCounter(debugDump(driver), "networkCache", "hits");
+    auto second = prepareModel(driver, model);
+    const uint64_t hits = dumpCounter(debugDump(driver), "networkCache", "hits") - hitsBefore;
+    if (first == nullptr || second == nullptr) return failed("prepare failed");
+
+    CheckResult result;
+    std::mt19937 random(7);
+    for (const auto& preparedModel : {first, second}) {
+        const CheckResult execution = compareRandomExecution(preparedModel, options, model, random);
+        result.maxError = std::max(result.maxError, execution.maxError);
+        if (execution.verdict != Verdict::PASS) return execution;
+    }
+    result.detail = std::to_string(hits) + " cache hits preparing the model again";
+    if (hits != 1) result.verdict = Verdict::FAIL;
+    return result;
+}
+
+// Stack of 512x512 fully connected layers, one MiB of weights each, with or without a softmax head
+// so that models of the same size don't share a network
+Model buildMegabyteLayersModel(uint32_t layers, bool softmax) {
+    ModelBuilder builder;
+    Tensor tensor = builder.addInput(OperandType::TENSOR_FLOAT32, {1, 512});
+    for (uint32_t layer = 0; layer < layers; layer++) {
+        tensor = addFullyConnected(builder, tensor, 512, /*activation=*/0);
+    }
+    if (softmax) tensor = addSoftmax(builder, tensor);
+    builder.markOutput(tensor);
+    return builder.build();
+}
+
+// With vendor.nn.hal.memory_budget_mb set, prepares two models of more than half the budget each,
+// the second once the first was idle for long enough, which evicts the first. Its next execution
+// reloads the network and has to match the reference as before the eviction.
+CheckResult checkMemoryBudget(const sp<Driver>& driver, const Options& options) {
+    constexpr uint64_t kMaxBudgetMb = 64;
+    const uint64_t budgetMb = dumpCounter(debugDump(driver), "memoryBudget", "budgetBytes") >> 20;
+    if (budgetMb == 0) return skipped("memory budget disabled");
+    if (budgetMb > kMaxBudgetMb) return skipped("memory budget above 64 MB");
+
+    const Model first = buildMegabyteLayersModel(budgetMb / 2 + 1, false);
+    const Model second = buildMegabyteLayersModel(budgetMb / 2 + 1, true);
+    if (!isSupported(driver, first) || !isSupported(driver, second)) {
+        return skipped("unsupported model");
+    }
+
+    auto firstPrepared = prepareModel(driver, first);
+    if (firstPrepared == nullptr) return failed("prepare failed");
+    std::mt19937 random(7);
+    CheckResult result = compareRandomExecution(firstPrepared, options, first, random);
+    if (result.verdict != Verdict::PASS) return result;
+
+    const auto minIdle = std::max(property_get_int32(kMinIdleProperty, kDefaultMinIdleMs), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(minIdle + 100));
+    auto secondPrepared = prepareModel(driver, second);
+    if (secondPrepared == nullptr) return failed("prepare failed");
+    auto& metrics = modelMetrics(firstPrepared);
+    if (metrics.evictions == 0) return failed("idle model not evicted");
+
+    const CheckResult reloaded = compareRandomExecution(firstPrepared, options, first, random);
+    if (reloaded.verdict != Verdict::PASS) return reloaded;
+    result.maxError = std::max(result.maxError, reloaded.maxError);
+    result.detail = std::to_string(metrics.evictions.load()) + " evictions, " +
+                    std::to_string(metrics.reloads.load()) + " reloads";
+    if (metrics.reloads == 0) result.verdict = Verdict::FAIL;
+    return result;
+}
+
+// FILL of an input value or of input dimensions, which the driver only supports constant
+Model buildFillFromInput(bool inputDims) {
+    const auto F32 = OperandType::TENSOR_FLOAT32;
+    ModelBuilder builder;
+    const uint32_t dims = inputDims ? builder.addInput(OperandType::TENSOR_INT32, {3}).index
+                                    : addInt32Vector(builder, {2, 3, 4});
+    const uint32_t value = inputDims ? builder.addFloat32(0.5f)
+                                     : builder.addInput(OperandType::FLOAT32, {}).index;
+    const Tensor output = builder.addTemporary(F32, {2, 3, 4});
+    builder.addOperation(OperationType::FILL, {dims, value}, {output.index});
+    builder.markOutput(output);
+    return builder.build();
+}
+
+// Queries the support of supported and unsupported models twice. The second answer has to come
+// from the support cache and be the first one, and a model has to prepare exactly when all of
+// its operations are reported supported, the cached answer agreeing with the translator.
+CheckResult checkSupportCache(const sp<Driver>& driver, const Options& options) {
+    const std::vector<std::pair<std::string, Model>> models = {
+        {"fully connected", buildBatchableModel()},
+        {"fill", buildFill().model},
+        {"fill of an input value", buildFillFromInput(false)},
+        {"fill of input dims", buildFillFromInput(true)},
+    };
+
+    CheckResult result;
+    size_t supportedModels = 0;
+    for (const auto& [name, model] : models) {
+        std::vector<bool> first, second;
+        if (!getSupportedOperations(driver, model, first)) return failed(name + " query failed");
+        const uint64_t hits = dumpCounter(debugDump(driver), "supportCache", "hits");
+        if (!getSupportedOperations(driver, model, second)) return failed(name + " query failed");
+        if (dumpCounter(debugDump(driver), "supportCache", "hits") == hits) {
+            return failed(name + " query again missed the support cache");
+        }
+        if (second != first) return failed(name + " answered differently from the cache");
+
+        const bool supported =
+            std::all_of(first.begin(), first.end(), [](bool operation) { return operation; });
+        const bool prepared = prepareModel(driver, model) != nullptr;
+        if (supported != prepared) {
+            return failed(name + (supported ? " supported but failed to prepare"
+                                            : " unsupported but prepared"));
+        }
+        if (supported) supportedModels++;
+    }
+    result.detail = std::to_string(supportedModels) + " of " + std::to_string(models.size()) +
+                    " models supported";
+    return result;
+}
+
+// Model taking and returning one operand type through an operation that leaves the values as they
+// are or barely changes them: RELU of FP16, ADD of INT32, RESHAPE of quantized values and
+// LOGICAL_NOT of booleans
+ReferenceModel buildNativePrecisionModel(OperandType type) {
+    const bool quantized = type == OperandType::TENSOR_QUANT8_ASYMM ||
+                           type == OperandType::TENSOR_QUANT8_ASYMM_SIGNED;
+    ModelBuilder builder;
+    const Tensor input =
+        quantized ? builder.addInput(type, {2, 3, 4}, 0.5f,
+                                     type == OperandType::TENSOR_QUANT8_ASYMM ? 128 : 0)
+                  : builder.addInput(type, {2, 3, 4});
+    Tensor output;
+    switch (type) {
+        case OperandType::TENSOR_FLOAT16:
+            output = builder.addTemporary(type, {2, 3, 4});
+            builder.addOperation(OperationType::RELU, {input.index}, {output.index});
+            break;
+        case OperandType::TENSOR_INT32:
+            output = builder.addTemporary(type, {2, 3, 4});
+            builder.addOperation(OperationType::ADD,
+                                 {input.index, input.index, builder.addInt32(0)}, {output.index});
+            break;
+        case OperandType::TENSOR_BOOL8:
+            output = builder.addTemporary(type, {2, 3, 4});
+            builder.addOperation(OperationType::LOGICAL_NOT, {input.index}, {output.index});
+            break;
+        default:
+            output = builder.addTemporary(type, {6, 4}, input.scale, input.zeroPoint);
+            builder.addOperation(OperationType::RESHAPE,
+                                 {input.index, addInt32Vector(builder, {6, 4})}, {output.index});
+            break;
+    }
+    builder.markOutput(output);
+    return {builder.build(), {}};
+}
+
+// Runs models whose input and output are of each type the driver binds natively, so that the
+// values are handed to and taken from the plugin without conversion, against the reference
+CheckResult checkNativePrecision(const sp<Driver>& driver, const Options& options) {
+    const std::vector<std::pair<std::string, OperandType>> types = {
+        {"fp16", OperandType::TENSOR_FLOAT16},
+        {"int32", OperandType::TENSOR_INT32},
+        {"quant8_asymm", OperandType::TENSOR_QUANT8_ASYMM},
+        {"quant8_asymm_signed", OperandType::TENSOR_QUANT8_ASYMM_SIGNED},
+        {"bool8", OperandType::TENSOR_BOOL8},
+    };
+
+    CheckResult result;
+    for (const auto& [name, type] : types) {
+        const CheckResult typeResult =
+            compareWithReference(driver, options, buildNativePrecisionModel(type));
+        result.maxError = std::max(result.maxError, typeResult.maxError);
+        if (typeResult.verdict == Verdict::FAIL) {
+            result.verdict = Verdict::FAIL;
+            result.detail += (result.detail.empty() ? "" : ", ") + name + ": " + typeResult.detail;
+        } else if (typeResult.verdict == Verdict::SKIP && result.verdict == Verdict::PASS) {
+            result.detail += (result.detail.empty() ? "" : ", ") + name + " skipped";
+        }
+    }
+    return result;
+}
+
+// Runs execute on a thread of its own, false when it didn't return within the timeout. A hung
+// execution keeps its thread and what execute captured.
+bool returnsWithin(std::function<void()> execute, std::chrono::seconds timeout) {
+    auto done = std::make_shared<std::promise<void>>();
+    auto future = done->get_future();
+    std::thread([execute, done]() {
+        execute();
+        done->set_value();
+    }).detach();
+    return future.wait_for(timeout) == std::future_status::ready;
+}
+
+// Runs failing executions asynchronously and fenced: an output one element short, which only fails
+// once the inference completed, and an input in a pool the request doesn't have. Each has to
+// report an error instead of hanging or succeeding, and the prepared model has to match the
+// reference afterwards.
+CheckResult checkExecutionFailures(const sp<Driver>& driver, const Options& options) {
+    constexpr auto kTimeout = std::chrono::seconds(10);
+    const Model model = buildBatchableModel();
+    if (!isSupported(driver, model)) return skipped("unsupported model");
+    auto preparedModel = prepareModel(driver, model);
+    if (preparedModel == nullptr) return failed("prepare failed");
+
+    const size_t inputLength = operandByteSize(model.main.operands[model.main.inputIndexes[0]]);
+    const size_t outputLength = operandByteSize(model.main.operands[model.main.outputIndexes[0]]);
+    CheckResult result;
+    std::mt19937 random(7);
+    for (ExecutionMode mode : {ExecutionMode::ASYNC, ExecutionMode::FENCED}) {
+        const std::string modeName = executionModeName(mode);
+        auto shortOutput = std::make_shared<PooledRequest>();
+        auto missingPool = std::make_shared<PooledRequest>();
+        if (!shortOutput->create({inputLength}, {outputLength - sizeof(float)}) ||
+            !missingPool->create(model)) {
+            return failed("request allocation failed");
+        }
+        missingPool->request.inputs[0].location.poolIndex = 1;
+
+        auto executor = std::make_shared<Executor>(preparedModel, mode);
+        for (const auto& [name, request] : {std::make_pair("short output", shortOutput),
+                                            std::make_pair("missing pool", missingPool)}) {
+            auto succeeded = std::make_shared<std::atomic<bool>>(false);
+            auto execute = [executor, request = request, succeeded]() {
+                *succeeded = executor->execute(request->request);
+            };
+            if (!returnsWithin(execute, kTimeout)) {
+                return failed(modeName + " execution with a " + name + " hangs");
+            }
+            if (*succeeded) return failed(modeName + " execution with a " + name + " succeeded");
+        }
+
+        Options modeOptions = options;
+        modeOptions.mode = mode;
+        const CheckResult execution =
+            compareRandomExecution(preparedModel, modeOptions, model, random);
+        result.maxError = std::max(result.maxError, execution.maxError);
+        if (execution.verdict != Verdict::PASS) {
+            return failed(modeName + " execution after the failures: " + execution.detail);
+        }
+    }
+    return result;
+}
+
+// Prepares a model with each execution preference, which configure the streams, threads and
+// thread binding of the CPU plugin differently, and compares it with the reference
+CheckResult checkExecutionPreferences(const sp<Driver>& driver, const Options& options) {
+    using Preference = android::hardware::neuralnetworks::V1_1::ExecutionPreference;
+    const std::vector<std::pair<std::string, Preference>> preferences = {
+        {"low power", Preference::LOW_POWER},
+        {"fast single answer", Preference::FAST_SINGLE_ANSWER},
+        {"sustained speed", Preference::SUSTAINED_SPEED},
+    };
+    Model model;
+    if (!buildSyntheticModel("depthwise", model)) return failed("depthwise model build failed");
+    if (!isSupported(driver, model)) return skipped("unsupported model");
+
+    CheckResult result;
+    for (const auto& [name, preference] : preferences) {
+        auto preparedModel = prepareModel(driver, model, preference);
+        if (preparedModel == nullptr) return failed(name + " prepare failed");
+        std::mt19937 random(7);
+        const CheckResult execution = compareRandomExecution(preparedModel, options, model, random);
+        result.maxError = std::max(result.maxError, execution.maxError);
+        if (execution.verdict != Verdict::PASS) return failed(name + ": " + execution.detail);
+    }
+    return result;
+}
+
+// Runs a model and releases it, then runs a model with the same input and output shapes a few
+// times with fresh inputs. Arena blocks are handed out again without being cleared, each
+// execution has to match the reference all the same.
+CheckResult checkArenaReuse(const sp<Driver>& driver, const Options& options) {
+    constexpr int kExecutions = 4;
+    const Model first = buildSharedWeightsModel(false);
+    const Model second = buildSharedWeightsModel(true);
+    if (!isSupported(driver, first) || !isSupported(driver, second)) {
+        return skipped("unsupported model");
+    }
+
+    CheckResult result;
+    std::mt19937 random(7);
+    {
+        auto preparedModel = prepareModel(driver, first);
+        if (preparedModel == nullptr) return failed("prepare failed");
+        result = compareRandomExecution(preparedModel, options, first, random);
+        if (result.verdict != Verdict::PASS) return result;
+    }
+
+    auto preparedModel = prepareModel(driver, second);
+    if (preparedModel == nullptr) return failed("prepare failed");
+    for (int i = 0; i < kExecutions; i++) {
+        const CheckResult execution =
+            compareRandomExecution(preparedModel, options, second, random);
+        result.maxError = std::max(result.maxError, execution.maxError);
+        if (execution.verdict != Verdict::PASS) {
+            return failed("execution " + std::to_string(i) + ": " + execution.detail);
+        }
+    }
+    return result;
+}
+
+std::vector<Check> allChecks() {
+    return {
+        {"recurrent_state", checkRecurrentState},
+        referenceCheck("lstm", buildLstmReference),
+        referenceCheck("unidirectional_sequence_lstm", buildUnidirectionalSequenceLstm),
+        referenceCheck("bidirectional_sequence_lstm", buildBidirectionalSequenceLstm),
+        referenceCheck("unidirectional_sequence_rnn", buildUnidirectionalSequenceRnn),
+        referenceCheck("quantized_16bit_lstm", buildQuantized16BitLstm),
+        referenceCheck("quantized_lstm", buildQuantizedLstm),
+        referenceCheck("axis_aligned_bbox_transform", buildAxisAlignedBboxTransform),
+        referenceCheck("box_with_nms_limit", buildBoxWithNmsLimit),
+        referenceCheck("detection_postprocessing", buildDetectionPostprocessing),
+        referenceCheck("generate_proposals", buildGenerateProposals),
+        referenceCheck("heatmap_max_keypoint", buildHeatmapMaxKeypoint),
+        referenceCheck("slice", buildSlice),
+        referenceCheck("tile", buildTile),
+        referenceCheck("fill", buildFill),
+        referenceCheck("rank", buildRank),
+        referenceCheck("elu", buildElu),
+        referenceCheck("local_response_normalization", buildLocalResponseNormalization),
+        {"prepare_memory", checkPrepareMemory},
+        {"weight_sharing", checkWeightSharing},
+        {"relaxed_precision", checkRelaxedPrecision},
+        {"dynamic_shapes", checkDynamicShapes},
+        {"batching", checkBatching},
+        {"if", checkIf},
+        referenceCheck("while", buildWhile),
+        referenceCheck("svdf", buildSvdf),
+        referenceCheck("hashtable_lookup", buildHashtableLookup),
+        {"network_cache", checkNetworkCache},
+        {"memory_budget", checkMemoryBudget},
+        {"support_cache", checkSupportCache},
+        {"native_precision", checkNativePrecision},
+        {"execution_failures", checkExecutionFailures},
+        {"execution_preferences", checkExecutionPreferences},
+        {"arena_reuse", checkArenaReuse},
+        referenceCheck("softmax", []() { return buildSoftmaxReference(OperationType::SOFTMAX); }),
+        referenceCheck("log_softmax",
+                       []() { return buildSoftmaxReference(OperationType::LOG_SOFTMAX); }),
+        {"l2_normalization", checkL2Normalization},
+    };
+}
+
+std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    std::vector<Check> checks;
+    for (auto& check : allChecks()) {
+        if (options.checks.empty() ||
+            std::find(options.checks.begin(), options.checks.end(), check.name) !=
+                options.checks.end()) {
+            checks.push_back(std::move(check));
+        }
+    }
+    for (const auto& name : options.checks) {
+        if (std::none_of(checks.begin(), checks.end(),
+                         [&name](const Check& check) { return check.name == name; })) {
+            std::cerr << "unknown check " << name << "\n";
+            return 1;
+        }
+    }
+
+    sp<Driver> driver = new Driver(options.device);
+    size_t failures = 0, skips = 0;
+    std::ostringstream results;
+    for (size_t i = 0; i < checks.size(); i++) {
+        CheckResult result;
+        try {
+            result = checks[i].run(driver, options);
+        } catch (const std::exception& ex) {
+            result = failed(std::string("exception: ") + ex.what());
+        }
+        if (result.verdict == Verdict::FAIL) failures++;
+        if (result.verdict == Verdict::SKIP) skips++;
+        ALOGI("%s: %s %s", checks[i].name.c_str(), verdictName(result.verdict),
+              result.detail.c_str());
+        results << (i ? "," : "") << "\n{\"name\": \"" << checks[i].name << "\", \"result\": \""
+                << verdictName(result.verdict) << "\", \"maxError\": " << result.maxError
+                << ", \"detail\": \"" << escape(result.detail) << "\"}";
+    }
+
+    std::ostringstream out;
+    out << "{\"device\": \"" << options.deviceName << "\", \"mode\": \""
+        << executionModeName(options.mode) << "\", \"tolerance\": " << options.tolerance
+        << ", \"checks\": " << checks.size() << ", \"failures\": " << failures
+        << ", \"skipped\": " << skips << ", \"results\": [" << results.str() << "\n]}\n";
+
+    if (options.output.empty()) {
+        std::cout << out.str();
+    } else {
+        std::ofstream file(options.output);
+        file << out.str();
+        if (!file) {
+            std::cerr << "failed to write " << options.output << "\n";
+            return 1;
+        }
+    }
+    return failures == 0 ? 0 : 2;
+}
@@ -0,0 +1,229 @@
+// Replays a request capture against the driver in process and compares outputs and latencies
+// with the captured ones, reporting the results as JSON:
+//
+//   nnhal_replay [--device CPU|GNA|GPU|VPU] [--mode sync|async|fenced|burst]
+//                [--speed original|max] [--tolerance T] [--output file] capture.nnhc
+//
+// Captures are written by prepared models while vendor.nn.hal.capture is set. At the original
+// speed requests are issued at their captured offsets, otherwise back to back. Float outputs
+// match when within the tolerance of the captured values, other outputs when within one unit.
+
+#include <log/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "DriverClient.h"
+#include "RequestCapture.h"
+
+#undef LOG_TAG
+#define LOG_TAG "nnhal_replay"
+
+using namespace android::hardware::neuralnetworks::nnhal;
+using android::sp;
+
+namespace {
+
+struct Options {
+    IntelDeviceType device = IntelDeviceType::CPU;
+    ExecutionMode mode = ExecutionMode::SYNC;
+    bool originalSpeed = true;
+    double tolerance = 1e-3;
+    std::string output;
+    std::string capture;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string option = argv[i];
+        if (option.rfind("--", 0) != 0) {
+            options.capture = option;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << option << "\n";
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (option == "--device") {
+            if (value == "CPU") {
+                options.device = IntelDeviceType::CPU;
+            } else if (value == "GNA") {
+                options.device = IntelDeviceType::GNA;
+            } else if (value == "GPU") {
+                options.device = IntelDeviceType::GPU;
+            } else if (value == "VPU") {
+                options.device = IntelDeviceType::VPU;
+            } else {
+                std::cerr << "unknown device " << value << "\n";
+                return false;
+            }
+        } else if (option == "--mode") {
+            if (!parseExecutionMode(value, options.mode)) {
+                std::cerr << "unknown execution mode " << value << "\n";
+                return false;
+            }
+        } else if (option == "--speed") {
+            if (value != "original" && value != "max") {
+                std::cerr << "unknown speed " << value << "\n";
+                return false;
+            }
+            options.originalSpeed = value == "original";
+        } else if (option == "--tolerance") {
+            options.tolerance = std::stod(value);
+        } else if (option == "--output") {
+            options.output = value;
+        } else {
+            std::cerr << "unknown option " << option << "\n";
+            return false;
+        }
+    }
+    if (options.capture.empty()) {
+        std::cerr << "no capture file given\n";
+        return false;
+    }
+    return true;
+}
+
+// Largest difference between the replayed and captured values of an output
+double maxError(OperandType type, const uint8_t* replayed, const std::vector<uint8_t>& captured) {
+    double error = 0;
+    if (type == OperandType::TENSOR_FLOAT32) {
+        for (size_t i = 0; i + sizeof(float) <= captured.size(); i += sizeof(float)) {
+            float lhs, rhs;
+            std::memcpy(&lhs, replayed + i, sizeof(float));
+            std::memcpy(&rhs, captured.data() + i, sizeof(float));
+            error = std::max(error, double(std::fabs(lhs - rhs)));
+        }
+    } else if (type == OperandType::TENSOR_FLOAT16) {
+        for (size_t i = 0; i + sizeof(_Float16) <= captured.size(); i += sizeof(_Float16)) {
+            _Float16 lhs, rhs;
+            std::memcpy(&lhs, replayed + i, sizeof(_Float16));
+            std::memcpy(&rhs, captured.data() + i, sizeof(_Float16));
+            error = std::max(error, std::fabs(double(lhs) - double(rhs)));
+        }
+    } else {
+        for (size_t i = 0; i < captured.size(); i++) {
+            error = std::max(error, std::fabs(double(replayed[i]) - double(captured[i])));
+        }
+    }
+    return error;
+}
+
+uint64_t percentile(std::vector<uint64_t> values, double fraction) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, size_t(fraction * values.size()))];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    CaptureReader reader;
+    Model model;
+    std::vector<std::vector<uint8_t>> poolContents;
+    if (!reader.open(options.capture) || !reader.readModel(model, poolContents)) {
+        std::cerr << "failed to read the model of " << options.capture << "\n";
+        return 1;
+    }
+    std::vector<std::unique_ptr<SharedMemory>> pools;
+    model.pools.resize(poolContents.size());
+    for (size_t i = 0; i < poolContents.size(); i++) {
+        pools.push_back(std::make_unique<SharedMemory>());
+        if (!pools[i]->create(std::max<size_t>(poolContents[i].size(), 1))) return 1;
+        std::memcpy(pools[i]->data(), poolContents[i].data(), poolContents[i].size());
+        model.pools[i] = pools[i]->memory();
+    }
+
+    sp<Driver> driver = new Driver(options.device);
+    auto preparedModel = prepareModel(driver, model);
+    if (preparedModel == nullptr) {
+        std::cerr << "failed to prepare the captured model\n";
+        return 1;
+    }
+    Executor executor(preparedModel, options.mode);
+
+    std::ostringstream requests;
+    std::vector<uint64_t> originalLatencies, replayLatencies;
+    size_t failures = 0, mismatches = 0;
+    double worstError = 0;
+    const auto start = std::chrono::steady_clock::now();
+    CapturedRequest captured;
+    for (size_t index = 0; reader.next(captured); index++) {
+        if (options.originalSpeed) {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(captured.offsetNs));
+        }
+        std::vector<size_t> inputLengths, outputLengths;
+        for (const auto& input : captured.inputs) inputLengths.push_back(input.data.size());
+        for (const auto& output : captured.outputs) outputLengths.push_back(output.data.size());
+        PooledRequest request;
+        if (!request.create(inputLengths, outputLengths)) return 1;
+        for (size_t i = 0; i < captured.inputs.size(); i++) {
+            request.request.inputs[i].dimensions = captured.inputs[i].dimensions;
+            std::memcpy(request.input(i), captured.inputs[i].data.data(), inputLengths[i]);
+        }
+
+        const auto executionStart = std::chrono::steady_clock::now();
+        const bool succeeded = executor.execute(request.request);
+        const uint64_t latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                       std::chrono::steady_clock::now() - executionStart)
+                                       .count();
+        double error = 0;
+        bool match = succeeded;
+        if (succeeded) {
+            for (size_t i = 0; i < captured.outputs.size(); i++) {
+                const auto type = model.main.operands[model.main.outputIndexes[i]].type;
+                const double outputError =
+                    maxError(type, request.output(i), captured.outputs[i].data);
+                const bool isFloat = type == OperandType::TENSOR_FLOAT32 ||
+                                     type == OperandType::TENSOR_FLOAT16;
+                match = match && outputError <= (isFloat ? options.tolerance : 1.0);
+                error = std::max(error, outputError);
+            }
+            originalLatencies.push_back(captured.latencyUs);
+            replayLatencies.push_back(latencyUs);
+            worstError = std::max(worstError, error);
+        } else {
+            failures++;
+        }
+        if (!match) mismatches++;
+        requests << (index ? "," : "") << "\n{\"index\": " << index
+                 << ", \"originalUs\": " << captured.latencyUs << ", \"replayUs\": " << latencyUs
+                 << ", \"succeeded\": " << (succeeded ? "true" : "false")
+                 << ", \"maxError\": " << error << ", \"match\": " << (match ? "true" : "false")
+                 << "}";
+    }
+
+    std::ostringstream out;
+    out << "{\"capture\": \"" << options.capture << "\", \"mode\": \""
+        << executionModeName(options.mode) << "\", \"speed\": \""
+        << (options.originalSpeed ? "original" : "max")
+        << "\", \"requests\": " << replayLatencies.size() + failures
+        << ", \"failures\": " << failures << ", \"mismatches\": " << mismatches
+        << ", \"maxError\": " << worstError
+        << ", \"originalLatencyUs\": {\"p50\": " << percentile(originalLatencies, 0.5)
+        << ", \"p99\": " << percentile(originalLatencies, 0.99)
+        << "}, \"replayLatencyUs\": {\"p50\": " << percentile(replayLatencies, 0.5)
+        << ", \"p99\": " << percentile(replayLatencies, 0.99) << "}, \"perRequest\": ["
+        << requests.str() << "\n]}\n";
+
+    if (options.output.empty()) {
+        std::cout << out.str();
+    } else {
+        std::ofstream file(options.output);
+        file << out.str();
+        if (!file) {
+            std::cerr << "failed to write " << options.output << "\n";
+            return 1;
+        }
+    }
+    return mismatches == 0 ? 0 : 2;
+}